@@ -24,3 +24,24 @@ CSPointVals::CSPointVals()
     , nrg(0)
 {
 }
+
+void CSPointValsArray::resize(int n)
+{
+    const CSPointVals u;
+    valid.assign(n, 0);
+    V.assign(n, u.V);
+    D.assign(n, u.D);
+    e.assign(n, u.e);
+    E.assign(n, u.E);
+    nrg.assign(n, u.nrg);
+}
+
+void CSPointValsArray::set(int i, const CSPointVals &u)
+{
+    valid[i] = 1;
+    V[i] = u.V;
+    D[i] = u.D;
+    e[i] = u.e;
+    E[i] = u.E;
+    nrg[i] = u.nrg;
+}
@@ -19,6 +19,8 @@
 
 #include "femmcomplex.h"
 
+#include <vector>
+
 class CSPointVals
 {
 public:
@@ -31,4 +33,37 @@ public:
     double nrg;    // energy stored in the field
 };
 
+/**
+ * @brief The CSPointValsArray class holds the point values of several points as a structure of arrays.
+ * All arrays have the same size.
+ * For points outside of the mesh, \c valid is 0 and the other values are left at their defaults.
+ *
+ * \internal
+ * (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+class CSPointValsArray
+{
+public:
+    /**
+     * @brief Set the number of points and reset all values.
+     * @param n
+     */
+    void resize(int n);
+    /**
+     * @brief Store the values of a point.
+     * @param i the point index
+     * @param u
+     */
+    void set(int i, const CSPointVals &u);
+    int size() const { return (int)valid.size(); }
+
+    std::vector<char> valid;      // 1, if the point lies within the mesh
+    std::vector<double> V;        // vector potential
+    std::vector<CComplex> D;      // flux density
+    std::vector<CComplex> e;      // permeability
+    std::vector<CComplex> E;      // field intensity
+    std::vector<double> nrg;      // energy stored in the field
+};
+
 #endif
@@ -21,6 +21,7 @@
 #include "femmconstants.h"
 #include "FemmProblem.h"
 #include "FemmReader.h"
+#include "SolutionFile.h"
 #include "stringTools.h"
 #include "make_unique.h"
 
@@ -48,40 +49,69 @@ ElectrostaticsPostProcessor::~ElectrostaticsPostProcessor()
 {
 }
 
-femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &input, std::ostream &err)
+femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &input, const SolutionFormat &format, std::ostream &err)
 {
     using femmsolver::CSMeshNode;
     using femmsolver::CHSElement;
 
-    int k;
+    // read the whole solution section at once;
+    // the node and element lists are decoded in parallel
+    SolutionBuffer solution;
+    if (!solution.readFrom(input,format,problem->pathName))
+    {
+        err << "Could not read the solution section\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    SolutionTable table;
+    char s[1024];
+    const char *p;
+
     // read in meshnodes;
-    parseValue(input, k, err);
-    meshnodes.reserve(k);
-    for(int i=0;i<k;i++)
+    if (!solution.nextTable(table))
     {
-        meshnodes.push_back(MAKE_UNIQUE<CSMeshNode>(CSMeshNode::fromStream(input,err)));
+        err << "Could not read the mesh nodes\n";
+        return femm::F_FILE_MALFORMED;
     }
+    meshnodes.resize(table.size());
+    decodeRecords(table, [this](int n, SolutionTable::Record &r) {
+        // like CSMeshNode::fromStream, values missing at the end of the line keep their defaults
+        CSMeshNode node;
+        if (r.next(node.x) && r.next(node.y) && r.next(node.V))
+            r.next(node.Q);
+        meshnodes[n] = MAKE_UNIQUE<CSMeshNode>(node);
+        return true;
+    });
 
     // read in elements;
-    parseValue(input, k, err);
-    meshelems.reserve(k);
-    auto &labellist = problem->labellist;
-    for(int i=0;i<k;i++)
+    if (!solution.nextTable(table))
     {
-        CHSElement elm = CHSElement::fromStream(input,err);
-        elm.blk = labellist[elm.lbl]->BlockType;
-        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
+        err << "Could not read the mesh elements\n";
+        return femm::F_FILE_MALFORMED;
     }
+    meshelems.resize(table.size());
+    const auto &labellist = problem->labellist;
+    decodeRecords(table, [this,&labellist](int n, SolutionTable::Record &r) {
+        CHSElement elm;
+        if (r.next(elm.p[0]) && r.next(elm.p[1]) && r.next(elm.p[2]))
+            r.next(elm.lbl);
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems[n] = MAKE_UNIQUE<CHSElement>(elm);
+        return true;
+    });
 
     // read in circuit data;
     auto &circproplist = problem->circproplist;
-    parseValue(input, k, err);
+    int k=0;
+    p = solution.getLine(s,1024);
+    if (p)
+        parseNumber(p,k);
     for(int i=0;i<k;i++)
     {
         auto circuit = reinterpret_cast<CSCircuit*>(circproplist[i].get());
         // partially overwrite circuit data:
-        input >> circuit->V;
-        input >> circuit->q;
+        p = solution.getLine(s,1024);
+        if (p && parseNumber(p,circuit->V))
+            parseNumber(p,circuit->q);
     }
 
     return femm::F_FILE_OK;
@@ -231,6 +261,7 @@ bool ElectrostaticsPostProcessor::OpenDocument(std::string solutionFile)
 
     // Build adjacency information for each element.
     FindBoundaryEdges();
+    buildElementIndex();
 
     // Check to see if any regions are multiply defined
     // (i.e. tagged by more than one block label). If so,
@@ -468,6 +499,16 @@ void ElectrostaticsPostProcessor::getPointValues(double x, double y, int k, CSPo
     u.nrg=Re(u.D*conj(u.E))/2.;
 }
 
+void ElectrostaticsPostProcessor::getPointValues(int numPoints, const double *x, const double *y, CSPointValsArray &values, int numThreads) const
+{
+    values.resize(numPoints);
+    forEachPointInMesh(numPoints, x, y, [this,x,y,&values](int i, int k) {
+        CSPointVals u;
+        getPointValues(x[i], y[i], k, u);
+        values.set(i, u);
+    }, numThreads);
+}
+
 bool ElectrostaticsPostProcessor::isSelectionOnAxis() const
 {
     if (problem->problemType!=AXISYMMETRIC)
@@ -37,6 +37,9 @@
 #include "spars.h"
 //#include "fparse.h"
 #include "esolver.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
+#include "SolutionFile.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -126,6 +129,7 @@ bool ESolver::LoadProblemFile ()
  */
 LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 {
+    femm::ProfileScope profile("load");
     int i,j,k,q,n0,n1,n;
     char infile[256];
     FILE *fp;
@@ -133,7 +137,7 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
     //read meshnodes;
     std::sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADELEMENTFILE;
     }
@@ -185,7 +189,7 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
     //read in periodic boundary conditions;
     sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADPBCFILE;
     }
@@ -208,7 +212,7 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
     // read in elements;
     sprintf(infile,"%s.ele",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADELEMENTFILE;
     }
@@ -241,15 +245,15 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
             }
             return MISSINGMATPROPS;
         }
@@ -300,7 +304,7 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
         }
 
     sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADEDGEFILE;
     }
@@ -368,13 +372,13 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
     {
         // clear out temporary files
         sprintf(infile,"%s.ele",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.node",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.pbc",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.poly",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
     }
 
     return NOERROR;
@@ -395,6 +399,7 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
  */
 int ESolver::AnalyzeProblem(CBigLinProb &L)
 {
+    femm::ProfileScope profile("assemble");
     int i,j,k;
 	double Me[3][3],be[3];		// element matrices;
 	double l[3],p[3],q[3];		// element shape parameters;
@@ -726,6 +731,7 @@ bool ESolver::runSolver(bool verbose)
  */
 int ESolver::WriteResults(CBigLinProb &L)
 {
+    femm::ProfileScope profile("write");
 	// write solution to disk;
 
 	char c[1024];
@@ -735,7 +741,7 @@ int ESolver::WriteResults(CBigLinProb &L)
 	// first, echo input .fee file to the .res file;
 	sprintf(c,"%s.fee",PathName.c_str());
 
-	fz=fopen(c,"rt");
+	fz=femm::openFile(c,"rt");
 	if(fz==NULL)
     {
 		printf("Couldn't open %s.fee\n", PathName.c_str());
@@ -743,12 +749,13 @@ int ESolver::WriteResults(CBigLinProb &L)
 	}
 
     sprintf(c,"%s.res",PathName.c_str());
-    fp=fopen(c,"wt");
+    fp=femm::openFile(c,BinarySolution ? "wb" : "wt");
 	if(fp==NULL)
     {
 		printf("Couldn't write to %s.res",PathName.c_str());
         return false;
 	}
+	femm::SolutionWriter writer(fp,BinarySolution,CompressSolution);
 
 	while(fgets(c,1024,fz)!=NULL)
     {
@@ -758,22 +765,32 @@ int ESolver::WriteResults(CBigLinProb &L)
 
 	// then print out node, line, and element information
 	fprintf(fp,"[Solution]\n");
+	writer.beginSolution();
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
+	writer.beginTable(NumNodes,"dddi");
 	for(i=0;i<NumNodes;i++)
     {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
+		writer.add(meshnode[i].x/cf);
+		writer.add(meshnode[i].y/cf);
+		writer.add(L.V[i]);
+		writer.add(L.Q[i]);
+		writer.endRecord();
     }
+	writer.endTable();
 
-	fprintf(fp,"%i\n",NumEls);
-
+	writer.beginTable(NumEls,"iiii");
 	for(i=0;i<NumEls;i++)
     {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+		writer.add(meshele[i].p[0]);
+		writer.add(meshele[i].p[1]);
+		writer.add(meshele[i].p[2]);
+		writer.add(meshele[i].lbl);
+		writer.endRecord();
     }
+	writer.endTable();
+	writer.beginText();
 
 	// print out circuit info
 	fprintf(fp,"%i\n",NumCircProps);
@@ -782,6 +799,7 @@ int ESolver::WriteResults(CBigLinProb &L)
 		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
     }
 
+	writer.finish();
 	fclose(fp);
     return true;
 }
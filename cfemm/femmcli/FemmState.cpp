@@ -104,3 +104,16 @@ bool femmcli::FemmState::isValid() const
 {
     return (nullptr != current.document.get());
 }
+
+void femmcli::FemmState::setSnapshot(const std::string &name, std::shared_ptr<const femm::GeometrySnapshot> snapshot)
+{
+    snapshots[name] = std::move(snapshot);
+}
+
+std::shared_ptr<const femm::GeometrySnapshot> femmcli::FemmState::getSnapshot(const std::string &name) const
+{
+    const auto entry = snapshots.find(name);
+    if (entry == snapshots.end())
+        return nullptr;
+    return entry->second;
+}
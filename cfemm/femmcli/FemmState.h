@@ -21,11 +21,14 @@
 #include "FemmStateBase.h"
 
 #include "FemmProblem.h"
+#include "GeometrySnapshot.h"
 #include "fmesher.h"
 #include "fsolver.h"
 #include "PostProcessor.h"
 
+#include <map>
 #include <memory>
+#include <string>
 
 namespace femmcli
 {
@@ -73,6 +76,12 @@ namespace femmcli
  * ------------------
  *
  * The sections "Data model" and "Data flow" mostly handle the "single document" case.
+ *
+ * Geometry snapshots
+ * ------------------
+ *
+ * Named snapshots of the geometry (see femm::GeometrySnapshot) are kept independently of the problem sets,
+ * i.e. a snapshot taken from one document can be restored into another document of the same type.
  */
 class FemmState : public femm::FemmStateBase
 {
@@ -142,6 +151,20 @@ public:
      * @return \c true, if a problem set is active, \c false otherwise.
      */
     bool isValid() const;
+
+    /**
+     * @brief Store a geometry snapshot under the given name.
+     * An existing snapshot with the same name is replaced.
+     * @param name
+     * @param snapshot
+     */
+    void setSnapshot(const std::string &name, std::shared_ptr<const femm::GeometrySnapshot> snapshot);
+    /**
+     * @brief Get the geometry snapshot with the given name.
+     * @param name
+     * @return the snapshot, or a null pointer if there is no snapshot with that name
+     */
+    std::shared_ptr<const femm::GeometrySnapshot> getSnapshot(const std::string &name) const;
 private:
     struct ProblemSet {
         std::shared_ptr<femm::FemmProblem> document;
@@ -151,6 +174,7 @@ private:
 
     ProblemSet current;
     std::vector<ProblemSet> inactiveProblems;
+    std::map<std::string, std::shared_ptr<const femm::GeometrySnapshot>> snapshots;
 
 
 };
@@ -22,19 +22,30 @@
 #include "FemmReader.h"
 #include "FemmState.h"
 #include "LuaInstance.h"
+#include "SolutionFile.h"
 #include "fsolver.h"
 
 #include <lua.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #ifdef WIN32
 #include <direct.h> // _chdir
 #else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h> // chdir
 #endif
 
@@ -53,10 +64,12 @@ void femmcli::LuaBaseCommands::registerCommands(LuaInstance &li)
     li.addFunction("pause",LuaInstance::luaNOP);
     //li.addFunction("prompt",luaPromptBox);
     li.addFunction("open",luaOpenDocument);
+    li.addFunction("convertsolution",luaConvertSolution);
     li.addFunction("quit",LuaInstance::luaNOP);
     li.addFunction("exit",LuaInstance::luaNOP);
     li.addFunction("setcurrentdirectory",luaSetWorkingDirectory);
     li.addFunction("chdir",luaSetWorkingDirectory);
+    li.addFunction("sweep",luaSweep);
 
     li.addFunction("create",luaNewDocument);
     li.addFunction("newdocument",luaNewDocument);
@@ -77,6 +90,58 @@ void femmcli::LuaBaseCommands::registerCommands(LuaInstance &li)
     //lua_register(lua,"smartmesh",lua_smartmesh);
 }
 
+/**
+ * @brief Convert a solution file between the text and the binary format.
+ * Without a format, a text solution file is converted to a binary solution file, and vice versa.
+ * The format "text", "binary" or "compressed" selects the format of the output file explicitly;
+ * "compressed" writes a binary file with compressed tables (see SolutionFile.h).
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{convertsolution("infile","outfile")}
+ * - \lua{convertsolution("infile","outfile","format")}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaBaseCommands::luaConvertSolution(lua_State *L)
+{
+    std::string inFile = lua_tostring(L,1);
+    std::string outFile = lua_tostring(L,2);
+
+    SolutionFormat format;
+    FILE *fp = openSolutionFile(inFile, format);
+    if (fp == nullptr)
+    {
+        lua_error(L, ("convertsolution(): Couldn't read from specified file " + inFile).c_str());
+        return 0;
+    }
+    fclose(fp);
+
+    bool binary = !format.binary;
+    bool compress = false;
+    if (lua_gettop(L) >= 3 && !lua_isnil(L,3))
+    {
+        const std::string outFormat = lua_tostring(L,3);
+        binary = (outFormat == "binary" || outFormat == "compressed");
+        compress = (outFormat == "compressed");
+        if (!binary && outFormat != "text")
+        {
+            lua_error(L, ("convertsolution(): Unknown format " + outFormat).c_str());
+            return 0;
+        }
+    }
+
+    std::stringstream err;
+    if (!convertSolutionFile(inFile, outFile, binary, compress, err))
+        lua_error(L, ("convertsolution(): " + err.str()).c_str());
+    return 0;
+}
+
 /**
  * @brief Print an error message.
  * @param L
@@ -252,4 +317,373 @@ int femmcli::LuaBaseCommands::luaSetWorkingDirectory(lua_State *L)
     return 0;
 }
 
+namespace {
+
+/**
+ * @brief A value returned by the function of a parameter sweep.
+ * Numbers, strings and nil are supported; other values are returned as nil.
+ */
+struct SweepValue
+{
+    int type = LUA_TNIL;
+    CComplex number = 0;
+    std::string text;
+};
+
+/**
+ * @brief Collect the values on the Lua stack above \p base.
+ */
+std::vector<SweepValue> collectSweepValues(lua_State *L, int base)
+{
+    std::vector<SweepValue> values;
+    for (int i=base+1; i<=lua_gettop(L); i++)
+    {
+        SweepValue value;
+        if (lua_type(L,i) == LUA_TNUMBER)
+        {
+            value.type = LUA_TNUMBER;
+            value.number = lua_tonumber(L,i);
+        } else if (lua_type(L,i) == LUA_TSTRING) {
+            value.type = LUA_TSTRING;
+            value.text = std::string(lua_tostring(L,i), lua_strlen(L,i));
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+void pushSweepValue(lua_State *L, const SweepValue &value)
+{
+    switch (value.type)
+    {
+    case LUA_TNUMBER:
+        lua_pushnumber(L, value.number);
+        break;
+    case LUA_TSTRING:
+        lua_pushlstring(L, value.text.data(), value.text.size());
+        break;
+    default:
+        lua_pushnil(L);
+    }
+}
+
+/**
+ * @brief Format a value for a CSV file.
+ */
+std::string sweepValueToCsv(const SweepValue &value)
+{
+    char buf[64];
+    switch (value.type)
+    {
+    case LUA_TNUMBER:
+        if (value.number.im == 0)
+            snprintf(buf, sizeof(buf), "%.17g", value.number.re);
+        else
+            snprintf(buf, sizeof(buf), "%.17g%+.17gi", value.number.re, value.number.im);
+        return buf;
+    case LUA_TSTRING:
+        if (value.text.find_first_of(",\"\n") == std::string::npos)
+            return value.text;
+        else {
+            std::string quoted = "\"";
+            for (char c: value.text)
+            {
+                if (c == '"')
+                    quoted += '"';
+                quoted += c;
+            }
+            return quoted + "\"";
+        }
+    default:
+        return "";
+    }
+}
+
+#ifndef WIN32
+/**
+ * @brief Write the values returned by a sweep point; this is done by the worker process.
+ */
+bool writeSweepValues(const std::string &file, const std::vector<SweepValue> &values)
+{
+    FILE *fp = fopen(file.c_str(), "wb");
+    if (fp == nullptr)
+        return false;
+    for (const auto &value: values)
+    {
+        switch (value.type)
+        {
+        case LUA_TNUMBER:
+            fprintf(fp, "n %.17g %.17g\n", value.number.re, value.number.im);
+            break;
+        case LUA_TSTRING:
+            fprintf(fp, "s %lu\n", (unsigned long)value.text.size());
+            fwrite(value.text.data(), 1, value.text.size(), fp);
+            fputc('\n', fp);
+            break;
+        default:
+            fputs("x\n", fp);
+        }
+    }
+    return fclose(fp) == 0;
+}
+
+/**
+ * @brief Read the values written by writeSweepValues().
+ */
+bool readSweepValues(const std::string &file, std::vector<SweepValue> &values)
+{
+    std::ifstream input(file.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!input.is_open())
+        return false;
+    char type;
+    while (input >> type)
+    {
+        SweepValue value;
+        if (type == 'n')
+        {
+            value.type = LUA_TNUMBER;
+            input >> value.number.re >> value.number.im;
+        } else if (type == 's') {
+            unsigned long size;
+            input >> size;
+            input.ignore(1);
+            value.type = LUA_TSTRING;
+            value.text.resize(size);
+            input.read(&value.text[0], size);
+        }
+        if (!input)
+            return false;
+        values.push_back(value);
+    }
+    return true;
+}
+
+/**
+ * @brief Remove a directory and its contents.
+ */
+void removeDirectory(const std::string &dir)
+{
+    if (DIR *d = opendir(dir.c_str()))
+    {
+        while (dirent *entry = readdir(d))
+        {
+            const std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+            const std::string path = dir + "/" + name;
+            struct stat st;
+            if (lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+                removeDirectory(path);
+            else
+                unlink(path.c_str());
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+/**
+ * @brief Evaluate a sweep point in a forked worker process.
+ * The file name of the current problem is moved into \p pointDir,
+ * so that the files written by an analysis don't collide with other workers.
+ * @return the exit status of the worker
+ */
+int runSweepPoint(lua_State *L, int index, const std::string &pointDir)
+{
+    auto luaInstance = femm::LuaInstance::instance(L);
+    std::shared_ptr<femmcli::FemmState> femmState = std::dynamic_pointer_cast<femmcli::FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+    if (doc && !doc->pathName.empty())
+    {
+        const std::size_t slash = doc->pathName.find_last_of("/\\");
+        doc->pathName = pointDir + "/" + doc->pathName.substr(slash == std::string::npos ? 0 : slash+1);
+    }
+    lua_pushstring(L, pointDir.c_str());
+    lua_setglobal(L, "XFEMM_SWEEP_DIR");
+
+    const int base = lua_gettop(L);
+    lua_pushvalue(L, 1);
+    lua_rawgeti(L, 2, index);
+    lua_pushnumber(L, index);
+    int status = lua_call(L, 2, LUA_MULTRET);
+    if (status == 0 && !writeSweepValues(pointDir + "/sweep.result", collectSweepValues(L, base)))
+        status = 1;
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    return status;
+}
+#endif
+
+} // anonymous namespace
+
+/**
+ * @brief Evaluate a function for a table of parameters, using several worker processes.
+ * The function is called as function(parameter, index) for each entry of the parameter table.
+ * Each call runs in a forked copy of the current state, with its own temporary directory,
+ * so that a script can open and prepare a problem once, and then modify, analyze and evaluate it
+ * concurrently for every parameter; changes made by the function are not visible outside of it.
+ * The temporary directory is stored in the global variable "XFEMM_SWEEP_DIR",
+ * and the file name of the current problem is moved into it, so that concurrent analyses don't collide.
+ *
+ * The global variable "XFEMM_SWEEP_WORKERS" sets the number of worker processes
+ * (default: the number of processors).
+ *
+ * The result is a table that contains a table with the values returned by the function for each parameter;
+ * numbers and strings are supported. If the function fails for a parameter, the entry is nil.
+ * If a file name is given, the results are also written to it as CSV table,
+ * with the columns "index", "parameter" and the returned values.
+ *
+ * On systems without fork(), the parameters are evaluated one after the other in the current state.
+ * @param L
+ * @return 1
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{sweep(function, parameters)}
+ * - \lua{sweep(function, parameters, "file.csv")}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaBaseCommands::luaSweep(lua_State *L)
+{
+    if (!lua_isfunction(L,1) || !lua_istable(L,2))
+    {
+        lua_error(L, "sweep(): expected a function and a table of parameters");
+        return 0;
+    }
+    std::string csvFile;
+    if (lua_gettop(L) >= 3 && !lua_isnil(L,3))
+        csvFile = lua_tostring(L,3);
+    lua_settop(L, 2);
+    const int numPoints = lua_getn(L,2);
+
+    std::vector<bool> pointOk(numPoints+1, false);
+    std::vector<std::vector<SweepValue>> results(numPoints+1);
+
+#ifndef WIN32
+    auto luaInstance = LuaInstance::instance(L);
+    int numWorkers = static_cast<int>(luaInstance->getGlobal("XFEMM_SWEEP_WORKERS").re);
+    if (numWorkers < 1)
+        numWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    const char *tmpDir = getenv("TMPDIR");
+    std::string sweepDir = std::string((tmpDir && *tmpDir) ? tmpDir : "/tmp") + "/xfemm_sweep_XXXXXX";
+    if (mkdtemp(&sweepDir[0]) == nullptr)
+    {
+        lua_error(L, "sweep(): could not create temporary directory");
+        return 0;
+    }
+
+    std::map<pid_t,int> running;
+    int next = 1;
+    while (next <= numPoints || !running.empty())
+    {
+        while (next <= numPoints && (int)running.size() < numWorkers)
+        {
+            const std::string pointDir = sweepDir + "/" + std::to_string(next);
+            mkdir(pointDir.c_str(), 0700);
+            // don't let the worker repeat buffered output
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(stdout);
+            fflush(stderr);
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                // don't run the destructors of the parent's state
+                _exit(runSweepPoint(L, next, pointDir));
+            }
+            if (pid < 0)
+            {
+                std::cerr << "sweep(): could not start worker for parameter " << next << "\n";
+            } else {
+                running[pid] = next;
+            }
+            next++;
+        }
+        if (running.empty())
+            continue;
+
+        int status;
+        const pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+            break;
+        auto it = running.find(pid);
+        if (it == running.end())
+            continue;
+        const int index = it->second;
+        running.erase(it);
+        const std::string pointDir = sweepDir + "/" + std::to_string(index);
+        pointOk[index] = WIFEXITED(status) && WEXITSTATUS(status) == 0
+                && readSweepValues(pointDir + "/sweep.result", results[index]);
+        removeDirectory(pointDir);
+    }
+    removeDirectory(sweepDir);
+#else
+    for (int index=1; index<=numPoints; index++)
+    {
+        const int base = lua_gettop(L);
+        lua_pushvalue(L, 1);
+        lua_rawgeti(L, 2, index);
+        lua_pushnumber(L, index);
+        pointOk[index] = (lua_call(L, 2, LUA_MULTRET) == 0);
+        if (pointOk[index])
+            results[index] = collectSweepValues(L, base);
+        lua_settop(L, base);
+    }
+#endif
+
+    std::ofstream csv;
+    if (!csvFile.empty())
+    {
+        csv.open(csvFile.c_str());
+        if (!csv.is_open())
+        {
+            lua_error(L, ("sweep(): could not write " + csvFile).c_str());
+            return 0;
+        }
+        std::size_t numValues = 0;
+        for (const auto &values: results)
+            numValues = std::max(numValues, values.size());
+        csv << "index,parameter";
+        for (std::size_t j=1; j<=numValues; j++)
+            csv << ",value" << j;
+        csv << "\n";
+    }
+
+    lua_newtable(L);
+    for (int index=1; index<=numPoints; index++)
+    {
+        if (!pointOk[index])
+        {
+            std::cerr << "sweep(): function failed for parameter " << index << "\n";
+            continue;
+        }
+        const std::vector<SweepValue> &values = results[index];
+        lua_newtable(L);
+        for (int j=0; j<(int)values.size(); j++)
+        {
+            pushSweepValue(L, values[j]);
+            lua_rawseti(L, -2, j+1);
+        }
+        lua_rawseti(L, -2, index);
+
+        if (csv.is_open())
+        {
+            lua_rawgeti(L, 2, index);
+            csv << index << "," << sweepValueToCsv(collectSweepValues(L, lua_gettop(L)-1).front());
+            lua_pop(L, 1);
+            for (const auto &value: values)
+                csv << "," << sweepValueToCsv(value);
+            csv << "\n";
+        }
+    }
+    return 1;
+}
+
 // vi:expandtab:tabstop=4 shiftwidth=4:
@@ -44,6 +44,7 @@ namespace LuaBaseCommands
  */
 void registerCommands(femm::LuaInstance &li );
 
+int luaConvertSolution(lua_State *L);
 int luaError(lua_State *L);
 int luaExit(lua_State *L);
 int luaMessageBox(lua_State *L);
@@ -51,6 +52,7 @@ int luaNewDocument(lua_State *L);
 int luaOpenDocument(lua_State *L);
 int luaPromptBox(lua_State *L);
 int luaSetWorkingDirectory(lua_State *L);
+int luaSweep(lua_State *L);
 }
 
 } /* namespace FemmLua*/
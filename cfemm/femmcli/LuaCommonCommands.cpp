@@ -24,6 +24,8 @@
 #include "locationTools.h"
 #include "LuaInstance.h"
 #include "MatlibReader.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
 #include "stringTools.h"
 
 #include <lua.h>
@@ -34,6 +36,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #ifdef DEBUG_FEMMLUA
 #define debug std::cerr
@@ -102,6 +105,53 @@ void femmcli::luaDebugWriteFEMFile(lua_State *L)
     doc->saveFEMFile(fileName);
 }
 
+bool femmcli::luaSaveProblemForAnalysis(lua_State *L)
+{
+    femm::ProfileScope profile("save");
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    // mesher and solver need the resolved geometry
+    doc->endGeometryBatch();
+
+    // filename.fem -> filename
+    const std::string baseName = doc->pathName.substr(0,doc->pathName.find_last_of("."));
+    if (luaInstance->getGlobal("XFEMM_IN_MEMORY") != 0 && addMemoryFiles(baseName))
+    {
+        std::ostringstream problem;
+        doc->writeProblemDescription(problem);
+        return writeFile(doc->pathName, problem.str());
+    }
+    removeMemoryFiles(baseName);
+    return doc->saveFEMFile(doc->pathName);
+}
+
+bool femmcli::luaGetPointTables(lua_State *L, std::vector<double> &x, std::vector<double> &y)
+{
+    if (!lua_istable(L,1) || !lua_istable(L,2))
+        return false;
+
+    const int n = lua_getn(L,1);
+    if (lua_getn(L,2) != n)
+    {
+        std::string msg = luaCurrentFunctionName(L) + "(): X and Y must have the same number of entries";
+        lua_error(L, msg.c_str());
+        return false;
+    }
+    x.resize(n);
+    y.resize(n);
+    for (int i=0; i<n; i++)
+    {
+        lua_rawgeti(L,1,i+1);
+        x[i] = lua_tonumber(L,-1).re;
+        lua_rawgeti(L,2,i+1);
+        y[i] = lua_tonumber(L,-1).re;
+        lua_pop(L,2);
+    }
+    return true;
+}
+
 /**
  * @brief Add a new arc segment.
  * Add a new arc segment from the nearest node to (x1,y1) to the
@@ -190,23 +240,7 @@ int femmcli::LuaCommonCommands::luaAddBlocklabel(lua_State *L)
     double x = lua_todouble(L,1);
     double y = lua_todouble(L,2);
 
-    double d;
-    if (doc->nodelist.size()<2)
-        d = 1.e-08;
-    else{
-        CComplex p0,p1,p2;
-        p0 = doc->nodelist[0]->CC();
-        p1 = p0;
-        for (int i=1; i<(int)doc->nodelist.size(); i++)
-        {
-            p2 = doc->nodelist[i]->CC();
-            if(p2.re<p0.re) p0.re = p2.re;
-            if(p2.re>p1.re) p1.re = p2.re;
-            if(p2.im<p0.im) p0.im = p2.im;
-            if(p2.im>p1.im) p1.im = p2.im;
-        }
-        d = abs(p1-p0)*CLOSE_ENOUGH;
-    }
+    double d = doc->defaultTolerance();
     doc->addBlockLabel(x,y,d);
 
     //BOOL flag=thisDoc->AddBlockLabel(x,y,d);
@@ -305,6 +339,288 @@ int femmcli::LuaCommonCommands::luaAddContourPointFromNode(lua_State *L)
     return 0;
 }
 
+namespace {
+/**
+ * @brief Get entry \p i of the table at stack index \p t as number.
+ * @return the number, or \p defaultValue if the entry is nil
+ */
+double tableNumber(lua_State *L, int t, int i, double defaultValue)
+{
+    lua_rawgeti(L,t,i);
+    double value = lua_isnil(L,-1) ? defaultValue : lua_todouble(L,-1);
+    lua_pop(L,1);
+    return value;
+}
+
+/**
+ * @brief Get entry \p i of the table at stack index \p t as property name.
+ * @return the name, or "<None>" if the entry is nil
+ */
+std::string tablePropertyName(lua_State *L, int t, int i)
+{
+    lua_rawgeti(L,t,i);
+    std::string name = "<None>";
+    if (!lua_isnil(L,-1))
+        name = lua_tostring(L,-1);
+    lua_pop(L,1);
+    return name;
+}
+
+/**
+ * @brief Push field \p key of the table at stack index 1.
+ * @return \c true, if the field is a table; otherwise, nothing is pushed.
+ */
+bool pushGeometryTable(lua_State *L, const char *key)
+{
+    lua_pushstring(L,key);
+    lua_gettable(L,1);
+    if (lua_istable(L,-1))
+        return true;
+    lua_pop(L,1);
+    return false;
+}
+} // anonymous namespace
+
+/**
+ * @brief Add nodes, segments, arc segments and block labels, together with their properties, in a single call.
+ *
+ * The geometry is passed as a table with the (optional) fields \c nodes, \c segments, \c arcs and \c labels.
+ * Each of them is a list of entries, and each entry is a list of values in the same order as the
+ * parameters of the commands that add an entity and set its properties:
+ * - nodes: \c {x, y [, "propname", group [, "inconductor"]]}
+ * - segments: \c {n0, n1 [, "propname", elementsize, automesh, hide, group [, "inconductor"]]}
+ * - arcs: \c {n0, n1, angle, maxseg [, "propname", hide, group [, "inconductor"]]}
+ * - labels (magnetics): \c {x, y [, "blockname", automesh, meshsize, "incircuit", magdirection, group, turns]}
+ * - labels (electrostatics, heat flow): \c {x, y [, "blockname", automesh, meshsize, group]}
+ *
+ * \c n0 and \c n1 are 1-based indices into the \c nodes list of the same call.
+ * A node that coincides with an existing node is not added; entities referring to it use the existing node instead.
+ * The "inconductor" values are ignored for magnetics problems.
+ *
+ * The entities are added in batch mode (see mi_beginbatch()), without selecting them.
+ * Unless the caller has already started a batch, intersections are resolved before the command returns.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_addgeometry(geometry)}
+ * - \lua{ei_addgeometry(geometry)}
+ * - \lua{hi_addgeometry(geometry)}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaAddGeometry(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    if (!lua_istable(L,1))
+    {
+        std::string msg = luaCurrentFunctionName(L) + "(): expected a table";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+
+    const bool isMagnetics = (doc->filetype == FileType::MagneticsFile);
+    const double d = doc->defaultTolerance();
+    const bool ownBatch = !doc->geometryBatchActive();
+    if (ownBatch)
+        doc->beginGeometryBatch();
+
+    // index into nodelist for each entry of the nodes table
+    std::vector<int> nodeIndex;
+    std::string errorMessage;
+    auto checkEntry = [&](const char *kind, int i) {
+        if (lua_istable(L,-1))
+            return true;
+        errorMessage = luaCurrentFunctionName(L) + "(): " + kind + " entry " + std::to_string(i) + " is not a table";
+        return false;
+    };
+    auto node = [&](const char *kind, int i, int t, int col) {
+        int n = (int) tableNumber(L,t,col,0);
+        if (n >= 1 && n <= (int)nodeIndex.size())
+            return nodeIndex[n-1];
+        errorMessage = luaCurrentFunctionName(L) + "(): " + kind + " entry " + std::to_string(i)
+                + " refers to invalid node " + std::to_string(n);
+        return -1;
+    };
+
+    if (pushGeometryTable(L,"nodes"))
+    {
+        const int t = lua_gettop(L);
+        const int count = lua_getn(L,t);
+        nodeIndex.reserve(count);
+        for (int i=1; i<=count && errorMessage.empty(); i++)
+        {
+            lua_rawgeti(L,t,i);
+            const int e = lua_gettop(L);
+            if (checkEntry("node", i))
+            {
+                const double x = tableNumber(L,e,1,0);
+                const double y = tableNumber(L,e,2,0);
+                int idx = (int)doc->nodelist.size();
+                if (!doc->addNode(std::unique_ptr<CNode>(new CNode(x,y)), d))
+                    idx = doc->closestNode(x,y);
+                nodeIndex.push_back(idx);
+                if (lua_getn(L,e) > 2)
+                {
+                    CNode &n = *doc->nodelist[idx];
+                    n.BoundaryMarkerName = tablePropertyName(L,e,3);
+                    n.BoundaryMarker = FemmProblem::propertyIndex(doc->nodeMap, n.BoundaryMarkerName);
+                    n.InGroup = (int) tableNumber(L,e,4,0);
+                    if (!isMagnetics)
+                    {
+                        n.InConductorName = tablePropertyName(L,e,5);
+                        n.InConductor = FemmProblem::propertyIndex(doc->circuitMap, n.InConductorName);
+                    }
+                }
+            }
+            lua_settop(L,t);
+        }
+        lua_pop(L,1);
+    }
+
+    if (errorMessage.empty() && pushGeometryTable(L,"segments"))
+    {
+        const int t = lua_gettop(L);
+        const int count = lua_getn(L,t);
+        for (int i=1; i<=count && errorMessage.empty(); i++)
+        {
+            lua_rawgeti(L,t,i);
+            const int e = lua_gettop(L);
+            int n0, n1;
+            if (checkEntry("segment", i)
+                    && (n0 = node("segment",i,e,1)) >= 0
+                    && (n1 = node("segment",i,e,2)) >= 0)
+            {
+                CSegment segm;
+                if (lua_getn(L,e) > 2)
+                {
+                    segm.BoundaryMarkerName = tablePropertyName(L,e,3);
+                    segm.BoundaryMarker = FemmProblem::propertyIndex(doc->lineMap, segm.BoundaryMarkerName);
+                    const double elesize = tableNumber(L,e,4,0);
+                    if (tableNumber(L,e,5,1) != 0)
+                        segm.MaxSideLength = -1;
+                    else if (elesize > 0)
+                        segm.MaxSideLength = elesize;
+                    segm.Hidden = (tableNumber(L,e,6,0) != 0);
+                    segm.InGroup = (int) tableNumber(L,e,7,0);
+                    if (!isMagnetics)
+                    {
+                        segm.InConductorName = tablePropertyName(L,e,8);
+                        segm.InConductor = FemmProblem::propertyIndex(doc->circuitMap, segm.InConductorName);
+                    }
+                }
+                doc->addSegment(n0, n1, &segm);
+            }
+            lua_settop(L,t);
+        }
+        lua_pop(L,1);
+    }
+
+    if (errorMessage.empty() && pushGeometryTable(L,"arcs"))
+    {
+        const int t = lua_gettop(L);
+        const int count = lua_getn(L,t);
+        for (int i=1; i<=count && errorMessage.empty(); i++)
+        {
+            lua_rawgeti(L,t,i);
+            const int e = lua_gettop(L);
+            int n0, n1;
+            if (checkEntry("arc", i)
+                    && (n0 = node("arc",i,e,1)) >= 0
+                    && (n1 = node("arc",i,e,2)) >= 0)
+            {
+                CArcSegment asegm;
+                asegm.n0 = n0;
+                asegm.n1 = n1;
+                asegm.ArcLength = tableNumber(L,e,3,asegm.ArcLength);
+                asegm.MaxSideLength = tableNumber(L,e,4,asegm.MaxSideLength);
+                if (lua_getn(L,e) > 4)
+                {
+                    asegm.BoundaryMarkerName = tablePropertyName(L,e,5);
+                    asegm.BoundaryMarker = FemmProblem::propertyIndex(doc->lineMap, asegm.BoundaryMarkerName);
+                    asegm.Hidden = (tableNumber(L,e,6,0) != 0);
+                    asegm.InGroup = (int) tableNumber(L,e,7,0);
+                    if (!isMagnetics)
+                    {
+                        asegm.InConductorName = tablePropertyName(L,e,8);
+                        asegm.InConductor = FemmProblem::propertyIndex(doc->circuitMap, asegm.InConductorName);
+                    }
+                }
+                doc->addArcSegment(asegm);
+            }
+            lua_settop(L,t);
+        }
+        lua_pop(L,1);
+    }
+
+    if (errorMessage.empty() && pushGeometryTable(L,"labels"))
+    {
+        const int t = lua_gettop(L);
+        const int count = lua_getn(L,t);
+        for (int i=1; i<=count && errorMessage.empty(); i++)
+        {
+            lua_rawgeti(L,t,i);
+            const int e = lua_gettop(L);
+            if (checkEntry("label", i))
+            {
+                std::unique_ptr<CBlockLabel> label = doc->createBlockLabel(tableNumber(L,e,1,0), tableNumber(L,e,2,0));
+                if (lua_getn(L,e) > 2)
+                {
+                    label->BlockTypeName = tablePropertyName(L,e,3);
+                    label->BlockType = FemmProblem::propertyIndex(doc->blockMap, label->BlockTypeName);
+                    const double meshsize = tableNumber(L,e,5,0);
+                    label->MaxArea = (tableNumber(L,e,4,1) != 0) ? 0 : PI*meshsize*meshsize/4.;
+                    if (isMagnetics)
+                    {
+                        CMBlockLabel *mlabel = dynamic_cast<CMBlockLabel*>(label.get());
+                        assert(mlabel);
+                        mlabel->InCircuitName = tablePropertyName(L,e,6);
+                        mlabel->InCircuit = FemmProblem::propertyIndex(doc->circuitMap, mlabel->InCircuitName);
+                        // magdirection can either be a number, or a string containing a lua expression.
+                        lua_rawgeti(L,e,7);
+                        if (lua_isnumber(L,-1))
+                            mlabel->MagDir = lua_todouble(L,-1);
+                        else if (!lua_isnil(L,-1))
+                            mlabel->MagDirFctn = lua_tostring(L,-1);
+                        lua_pop(L,1);
+                        mlabel->InGroup = (int) tableNumber(L,e,8,0);
+                        mlabel->Turns = (int) tableNumber(L,e,9,1);
+                        if (mlabel->Turns == 0)
+                            mlabel->Turns = 1;
+                    } else {
+                        label->InGroup = (int) tableNumber(L,e,6,0);
+                    }
+                }
+                doc->addBlockLabel(std::move(label), d);
+            }
+            lua_settop(L,t);
+        }
+        lua_pop(L,1);
+    }
+
+    if (ownBatch)
+        doc->endGeometryBatch();
+
+    if (!errorMessage.empty())
+    {
+        lua_error(L, errorMessage.c_str());
+        return 0;
+    }
+
+    if (luaInstance->getDebugGeometry())
+        luaDebugWriteFEMFile(L);
+
+    return 0;
+}
+
 /**
  * @brief Add a new line segment between two given points.
  * In other words, add a new line segment from node closest to (x1,y1) to node closest to (x2,y2)
@@ -382,23 +698,7 @@ int femmcli::LuaCommonCommands::luaAddNode(lua_State *L)
     double x=lua_todouble(L,1);
     double y=lua_todouble(L,2);
 
-    double d;
-    if ((int)doc->nodelist.size()<2) {
-        d=1.e-08;
-    } else {
-        CComplex p0,p1,p2;
-        p0=doc->nodelist[0]->CC();
-        p1=p0;
-        for(int i=1; i< (int)doc->nodelist.size(); i++)
-        {
-            p2=doc->nodelist[i]->CC();
-            if(p2.re<p0.re) p0.re=p2.re;
-            if(p2.re>p1.re) p1.re=p2.re;
-            if(p2.im<p0.im) p0.im=p2.im;
-            if(p2.im>p1.im) p1.im=p2.im;
-        }
-        d=abs(p1-p0)*CLOSE_ENOUGH;
-    }
+    double d = doc->defaultTolerance();
     doc->addNode(x,y,d);
 
     //BOOL flag=doc->AddNode(x,y,d);
@@ -490,6 +790,36 @@ int femmcli::LuaCommonCommands::luaAttachOuterSpace(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Start adding geometry in batch mode.
+ * Until the batch is ended, nodes, segments and arcs are added without splitting them
+ * at intersections. This makes adding a large number of entities a lot faster.
+ * Saving, meshing, or analyzing the problem ends the batch implicitly.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_beginbatch()}
+ * - \lua{ei_beginbatch()}
+ * - \lua{hi_beginbatch()}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaBeginBatch(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 0);
+    doc->beginGeometryBatch();
+    return 0;
+}
+
 /**
  * @brief Bend the end of the contour line.
  * Replaces the straight line formed by the last two
@@ -1144,6 +1474,38 @@ int femmcli::LuaCommonCommands::luaDetachOuterSpace(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief End batch mode.
+ * Resolves all intersections and coincident points of the geometry added since the batch was started.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_endbatch()}
+ * - \lua{ei_endbatch()}
+ * - \lua{hi_endbatch()}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaEndBatch(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 0);
+    doc->endGeometryBatch();
+
+    if (luaInstance->getDebugGeometry())
+        luaDebugWriteFEMFile(L);
+
+    return 0;
+}
+
 /**
  * @brief Closes the current post-processor instance.
  * Invalidates the post-processor data of the FemmProblem.
@@ -1973,6 +2335,8 @@ int femmcli::LuaCommonCommands::luaPurgeMesh(lua_State *L)
  * @brief Explicitly calls the mesher.
  * As a side-effect, this method calls FMesher::LoadMesh() to count the number of mesh nodes.
  * This means that the memory consumption will be a little bit higher as when only luaAnalyze is called.
+ * If "XFEMM_REUSE_MESH" is set to 1, the previous mesh is reused as long as the geometry and the mesh settings don't change
+ * (see fmesher::FMesher::meshKey()). Afterwards, "XFEMM_MESH_REUSED" is 1 if the mesh has been reused, and 0 otherwise.
  *
  * \remark The femm42 documentation states that "The number of elements in the mesh is pushed back onto the lua stack.", but the implementation does not do it.
  * @param L
@@ -2013,7 +2377,7 @@ int femmcli::LuaCommonCommands::luaCreateMesh(lua_State *L)
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
         return 0;
     }
-    if (!doc->saveFEMFile(pathName))
+    if (!luaSaveProblemForAnalysis(L))
     {
         lua_error(L, "createmesh(): Could not save fem file!\n");
         return 0;
@@ -2024,23 +2388,31 @@ int femmcli::LuaCommonCommands::luaCreateMesh(lua_State *L)
         return 0;
     }
 
+    mesher->ReuseMesh = (luaInstance->getGlobal("XFEMM_REUSE_MESH") != 0);
+
     //BeginWaitCursor();
-    if (mesher->HasPeriodicBC()){
-        if (mesher->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            doc->unselectAll();
-            lua_error(L, "createmesh(): Periodic BC triangulation failed!\n");
-            return 0;
-        }
-    } else {
-        if (mesher->DoNonPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            lua_error(L, "createmesh(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+    const bool meshReused = mesher->restoreMesh(pathName);
+    if (!meshReused)
+    {
+        if (mesher->HasPeriodicBC()){
+            if (mesher->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                doc->unselectAll();
+                lua_error(L, "createmesh(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
+        } else {
+            if (mesher->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "createmesh(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
         }
+        mesher->keepMesh(pathName);
     }
+    luaInstance->setGlobal("XFEMM_MESH_REUSED", meshReused ? 1 : 0);
     bool LoadMesh=mesher->LoadMesh(pathName);
     //EndWaitCursor();
 
@@ -2158,8 +2530,57 @@ int femmcli::LuaCommonCommands::luaDefineOuterSpace(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Replace the geometry of the current document with a snapshot taken by mi_savesnapshot().
+ * The nodes, segments, arc segments and block labels are overwritten in place;
+ * properties and problem settings are not changed.
+ * Boundary conditions, materials and circuits are looked up by name in the current document,
+ * so the snapshot may also be restored into another document, or after a property has been deleted.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_restoresnapshot("name")}
+ * - \lua{ei_restoresnapshot("name")}
+ * - \lua{hi_restoresnapshot("name")}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaRestoreSnapshot(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    const std::string name = lua_tostring(L,1);
+    std::shared_ptr<const GeometrySnapshot> snapshot = femmState->getSnapshot(name);
+    if (!snapshot)
+    {
+        std::string msg = luaCurrentFunctionName(L) + "(): no snapshot named \"" + name + "\"";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+    if (!snapshot->restore(*doc))
+    {
+        std::string msg = luaCurrentFunctionName(L) + "(): snapshot \"" + name + "\" was taken from a different problem type";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+
+    if (luaInstance->getDebugGeometry())
+        luaDebugWriteFEMFile(L);
+
+    return 0;
+}
+
 /**
  * @brief Save the problem description into the given file.
+ * An open geometry batch (see mi_beginbatch()) is ended first.
  * @param L
  * @return 0
  * \ingroup LuaCommon
@@ -2182,6 +2603,7 @@ int femmcli::LuaCommonCommands::luaSaveDocument(lua_State *L)
 
     if (!lua_isnil(L,1))
     {
+        doc->endGeometryBatch();
         doc->pathName = lua_tostring(L,1);
         doc->saveFEMFile(doc->pathName);
     } else {
@@ -2191,6 +2613,48 @@ int femmcli::LuaCommonCommands::luaSaveDocument(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Take a snapshot of the geometry of the current document and store it under the given name.
+ * An existing snapshot with the same name is replaced.
+ * Each call makes a full deep copy of all nodes, segments, arc segments and block labels,
+ * so the snapshot should be saved once, and restored as often as needed.
+ *
+ * Together with mi_restoresnapshot(), this allows to create many variants of a base geometry
+ * without reading a file or drawing the geometry again:
+ * \code
+ * mi_savesnapshot("base")
+ * for i=1,n do
+ *     mi_restoresnapshot("base")
+ *     -- modify the geometry, analyze, and evaluate the result
+ * end
+ * \endcode
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_savesnapshot("name")}
+ * - \lua{ei_savesnapshot("name")}
+ * - \lua{hi_savesnapshot("name")}
+ *
+ * ### FEMM source:
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaSaveSnapshot(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    const std::string name = lua_tostring(L,1);
+    femmState->setSnapshot(name, GeometrySnapshot::take(*doc));
+
+    return 0;
+}
+
 /**
  * @brief Scale the selected objects
  * @param L
@@ -18,6 +18,8 @@
 #ifndef LUACOMMONCOMMANDS_H
 #define LUACOMMONCOMMANDS_H
 
+#include <vector>
+
 struct lua_State;
 
 namespace femm {
@@ -67,6 +69,30 @@ bool luaExpectParameterCount(lua_State *L, int expected);
  */
 void luaDebugWriteFEMFile(lua_State *L);
 
+/**
+ * @brief luaSaveProblemForAnalysis writes the active input document into its file, as input for the mesher and the solver.
+ * An open geometry batch is ended before writing the file.
+ * If the global variable "XFEMM_IN_MEMORY" is set to 1, the file is kept in memory,
+ * together with all files derived from it, i.e. the mesh files and the solution file (see MemoryFiles.h).
+ * Otherwise, or if memory files are not available (see femm::haveMemoryFiles()), the files are written to the disk, as usual.
+ *
+ * @param L
+ * @return \c true on success
+ */
+bool luaSaveProblemForAnalysis(lua_State *L);
+
+/**
+ * @brief luaGetPointTables reads the coordinates of a point command that is called with tables, e.g. mo_getpointvalues(X,Y).
+ * If the first two parameters are tables of the same size, their entries are stored in x and y.
+ * If the sizes differ, an error message is printed using lua_error().
+ *
+ * @param L
+ * @param x the x coordinates (output variable)
+ * @param y the y coordinates (output variable)
+ * @return \c true, if the points are given as tables, \c false otherwise
+ */
+bool luaGetPointTables(lua_State *L, std::vector<double> &x, std::vector<double> &y);
+
 /**
  * LuaCommonCommands provides lua commands which are shared between different modules.
  * These commands are registered by the individual module's registerCommands().
@@ -81,10 +107,12 @@ int luaAddArc(lua_State *L);
 int luaAddBlocklabel(lua_State *L);
 int luaAddContourPoint(lua_State *L);
 int luaAddContourPointFromNode(lua_State *L);
+int luaAddGeometry(lua_State *L);
 int luaAddLine(lua_State *L);
 int luaAddNode(lua_State *L);
 int luaAttachDefault(lua_State *L);
 int luaAttachOuterSpace(lua_State *L);
+int luaBeginBatch(lua_State *L);
 int luaBendContourLine(lua_State *L);
 int luaClearBlockSelection(lua_State *L);
 int luaClearContourPoint(lua_State *L);
@@ -105,6 +133,7 @@ int luaDeleteSelectedNodes(lua_State *L);
 int luaDeleteSelectedSegments(lua_State *L);
 int luaDetachDefault(lua_State *L);
 int luaDetachOuterSpace(lua_State *L);
+int luaEndBatch(lua_State *L);
 int luaExitPost(lua_State *L);
 int luaExitPre(lua_State *L);
 int luaGetBoundingBox(lua_State *L);
@@ -122,7 +151,9 @@ int luaMoveTranslate(lua_State *L);
 int luaNumElements(lua_State *L);
 int luaNumNodes(lua_State *L);
 int luaPurgeMesh(lua_State *L);
+int luaRestoreSnapshot(lua_State *L);
 int luaSaveDocument(lua_State *L);
+int luaSaveSnapshot(lua_State *L);
 int luaScaleMove(lua_State *L);
 int luaSelectArcsegment(lua_State *L);
 int luaSelectBlocklabel(lua_State *L);
@@ -36,6 +36,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #ifdef DEBUG_FEMMLUA
 #define debug std::cerr
@@ -52,6 +53,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_addarc", LuaCommonCommands::luaAddArc);
     li.addFunction("ei_add_block_label", LuaCommonCommands::luaAddBlocklabel);
     li.addFunction("ei_addblocklabel", LuaCommonCommands::luaAddBlocklabel);
+    li.addFunction("ei_add_geometry", LuaCommonCommands::luaAddGeometry);
+    li.addFunction("ei_addgeometry", LuaCommonCommands::luaAddGeometry);
     li.addFunction("ei_add_bound_prop", luaAddBoundaryProperty);
     li.addFunction("ei_addboundprop", luaAddBoundaryProperty);
     li.addFunction("ei_add_conductor_prop", luaAddConductorProperty);
@@ -70,6 +73,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("ei_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
     li.addFunction("ei_attachouterspace", LuaCommonCommands::luaAttachOuterSpace);
+    li.addFunction("ei_begin_batch", LuaCommonCommands::luaBeginBatch);
+    li.addFunction("ei_beginbatch", LuaCommonCommands::luaBeginBatch);
     li.addFunction("ei_clear_selected", LuaCommonCommands::luaClearSelected);
     li.addFunction("ei_clearselected", LuaCommonCommands::luaClearSelected);
     li.addFunction("ei_close", LuaCommonCommands::luaExitPre);
@@ -105,6 +110,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_detachdefault", LuaCommonCommands::luaDetachDefault);
     li.addFunction("ei_detach_outer_space", LuaCommonCommands::luaDetachOuterSpace);
     li.addFunction("ei_detachouterspace", LuaCommonCommands::luaDetachOuterSpace);
+    li.addFunction("ei_end_batch", LuaCommonCommands::luaEndBatch);
+    li.addFunction("ei_endbatch", LuaCommonCommands::luaEndBatch);
     li.addFunction("ei_getboundingbox", LuaCommonCommands::luaGetBoundingBox);
     li.addFunction("ei_get_material", LuaCommonCommands::luaGetMaterialFromLib);
     li.addFunction("ei_getmaterial", LuaCommonCommands::luaGetMaterialFromLib);
@@ -144,8 +151,12 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_refreshview", LuaInstance::luaNOP);
     li.addFunction("ei_resize", LuaInstance::luaNOP);
     li.addFunction("ei_restore", LuaInstance::luaNOP);
+    li.addFunction("ei_restore_snapshot", LuaCommonCommands::luaRestoreSnapshot);
+    li.addFunction("ei_restoresnapshot", LuaCommonCommands::luaRestoreSnapshot);
     li.addFunction("ei_save_as", LuaCommonCommands::luaSaveDocument);
     li.addFunction("ei_saveas", LuaCommonCommands::luaSaveDocument);
+    li.addFunction("ei_save_snapshot", LuaCommonCommands::luaSaveSnapshot);
+    li.addFunction("ei_savesnapshot", LuaCommonCommands::luaSaveSnapshot);
     li.addFunction("ei_save_bitmap", LuaInstance::luaNOP);
     li.addFunction("ei_savebitmap", LuaInstance::luaNOP);
     li.addFunction("ei_save_dxf", LuaInstance::luaNOP);
@@ -428,6 +439,14 @@ int femmcli::LuaElectrostaticsCommands::luaAddPointProperty(lua_State *L)
 /**
  * @brief Mesh the problem description, save it, and run the solver.
  * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * If "XFEMM_REUSE_MESH" is set to 1, the mesh of the previous analysis and the node numbering of its solver are reused
+ * as long as the geometry and the mesh settings don't change (see fmesher::FMesher::meshKey()).
+ * Afterwards, "XFEMM_MESH_REUSED" is 0 for a new mesh, 1 if the mesh has been reused, and 2 if the node numbering has been reused, too.
+ * If the global variable "XFEMM_BINARY_SOLUTION" is set to 1, the solution file is written in the binary format (see SolutionFile.h).
+ * If "XFEMM_COMPRESS_SOLUTION" is set to 1, the tables of the binary solution file are compressed.
+ * If "XFEMM_IN_MEMORY" is set to 1, the input file, the mesh files and the solution file are kept in memory instead of being written to the disk
+ * (they are still written and parsed as text, see MemoryFiles.h);
+ * the solution can still be loaded with loadsolution(), and saved with convertsolution().
  * @param L
  * @return 0
  * \ingroup LuaES
@@ -555,7 +574,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
         return 0;
     }
-    if (!doc->saveFEMFile(pathName))
+    if (!luaSaveProblemForAnalysis(L))
     {
         lua_error(L, "ei_analyze(): Could not save fem file!\n");
         return 0;
@@ -571,23 +590,31 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "ei_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+    // ... and whether the mesh of the previous analysis may be reused:
+    mesherDoc->ReuseMesh = (luaInstance->getGlobal("XFEMM_REUSE_MESH") != 0);
+    const bool meshReused = mesherDoc->restoreMesh(pathName);
+    if (!meshReused)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, "ei_analyze(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
         }
-    }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            lua_error(L, "ei_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "ei_analyze(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
         }
+        mesherDoc->keepMesh(pathName);
     }
+    luaInstance->setGlobal("XFEMM_MESH_REUSED", meshReused ? 1 : 0);
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
@@ -601,11 +628,16 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     theSolver.PathName = doc->pathName.substr(0,dotpos);
     theSolver.WarnMessage = &PrintWarningMsg;
     theSolver.PrintMessage = &PrintWarningMsg;
+    theSolver.CompressSolution = (luaInstance->getGlobal("XFEMM_COMPRESS_SOLUTION") != 0);
+    theSolver.BinarySolution = theSolver.CompressSolution || (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
     if (!theSolver.LoadProblemFile())
     {
         lua_error(L, "ei_analyze(): problem initializing solver!");
         return 0;
     }
+    // reuse the node numbering of the previous analysis, if the mesh has been reused:
+    theSolver.NodeNumbering = mesherDoc->NodeNumbering;
+    theSolver.BandWidth = mesherDoc->BandWidth;
     assert( doc->ACSolver == theSolver.ACSolver);
     assert( doc->lineproplist.size() == theSolver.lineproplist.size());
     assert( doc->nodeproplist.size() == theSolver.nodeproplist.size());
@@ -618,6 +650,13 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     {
         lua_error(L, "solver failed.");
     }
+    if (theSolver.NodeNumberingReused)
+        luaInstance->setGlobal("XFEMM_MESH_REUSED", 2);
+    if (mesherDoc->ReuseMesh)
+    {
+        mesherDoc->NodeNumbering = theSolver.NodeNumbering;
+        mesherDoc->BandWidth = theSolver.BandWidth;
+    }
     return 0;
 }
 
@@ -689,6 +728,12 @@ int femmcli::LuaElectrostaticsCommands::luaBlockIntegral(lua_State *L)
 
 /**
  * @brief Get the solution values for a point.
+ *
+ * If X and Y are tables of coordinates, the values of all points are computed at once
+ * and 8 tables are returned, one per value.
+ * The entries for points outside of the mesh are nil.
+ * (not present in femm42; xfemm extension)
+ *
  * @param L
  * @return 0 on error (e.g. point not in triangle), otherwise 8
  * \ingroup LuaES
@@ -713,6 +758,34 @@ int femmcli::LuaElectrostaticsCommands::luaGetPointValues(lua_State *L)
         return 0;
     }
 
+    std::vector<double> xs, ys;
+    if (luaGetPointTables(L, xs, ys))
+    {
+        const int n = xs.size();
+        CSPointValsArray values;
+        pproc->getPointValues(n, xs.data(), ys.data(), values);
+
+        auto pushTable = [&](auto getValue) {
+            lua_newtable(L);
+            for (int i=0; i<n; i++)
+            {
+                if (!values.valid[i])
+                    continue;
+                lua_pushnumber(L, getValue(i));
+                lua_rawseti(L, -2, i+1);
+            }
+        };
+        pushTable([&](int i) { return values.V[i]; });
+        pushTable([&](int i) { return values.D[i].re; });
+        pushTable([&](int i) { return values.D[i].im; });
+        pushTable([&](int i) { return values.E[i].re; });
+        pushTable([&](int i) { return values.E[i].im; });
+        pushTable([&](int i) { return values.e[i].re; });
+        pushTable([&](int i) { return values.e[i].im; });
+        pushTable([&](int i) { return values.nrg[i]; });
+        return 8;
+    }
+
     double px,py;
     px=lua_tonumber(L,1).re;
     py=lua_tonumber(L,2).re;
@@ -36,6 +36,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #ifdef DEBUG_FEMMLUA
 #define debug std::cerr
@@ -52,6 +53,8 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_addarc", LuaCommonCommands::luaAddArc);
     li.addFunction("hi_add_block_label", LuaCommonCommands::luaAddBlocklabel);
     li.addFunction("hi_addblocklabel", LuaCommonCommands::luaAddBlocklabel);
+    li.addFunction("hi_add_geometry", LuaCommonCommands::luaAddGeometry);
+    li.addFunction("hi_addgeometry", LuaCommonCommands::luaAddGeometry);
     li.addFunction("hi_add_bound_prop", luaAddBoundaryProperty);
     li.addFunction("hi_addboundprop", luaAddBoundaryProperty);
     li.addFunction("hi_add_conductor_prop", luaAddConductorProperty);
@@ -72,6 +75,8 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("hi_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
     li.addFunction("hi_attachouterspace", LuaCommonCommands::luaAttachOuterSpace);
+    li.addFunction("hi_begin_batch", LuaCommonCommands::luaBeginBatch);
+    li.addFunction("hi_beginbatch", LuaCommonCommands::luaBeginBatch);
     li.addFunction("hi_clear_selected", LuaCommonCommands::luaClearSelected);
     li.addFunction("hi_clearselected", LuaCommonCommands::luaClearSelected);
     li.addFunction("hi_clear_tk_points", luaCleartkpoints);
@@ -109,6 +114,8 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_detachdefault", LuaCommonCommands::luaDetachDefault);
     li.addFunction("hi_detach_outer_space", LuaCommonCommands::luaDetachOuterSpace);
     li.addFunction("hi_detachouterspace", LuaCommonCommands::luaDetachOuterSpace);
+    li.addFunction("hi_end_batch", LuaCommonCommands::luaEndBatch);
+    li.addFunction("hi_endbatch", LuaCommonCommands::luaEndBatch);
     li.addFunction("hi_getboundingbox", LuaCommonCommands::luaGetBoundingBox);
     li.addFunction("hi_get_material", LuaCommonCommands::luaGetMaterialFromLib);
     li.addFunction("hi_getmaterial", LuaCommonCommands::luaGetMaterialFromLib);
@@ -148,8 +155,12 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_refreshview", LuaInstance::luaNOP);
     li.addFunction("hi_resize", LuaInstance::luaNOP);
     li.addFunction("hi_restore", LuaInstance::luaNOP);
+    li.addFunction("hi_restore_snapshot", LuaCommonCommands::luaRestoreSnapshot);
+    li.addFunction("hi_restoresnapshot", LuaCommonCommands::luaRestoreSnapshot);
     li.addFunction("hi_save_as", LuaCommonCommands::luaSaveDocument);
     li.addFunction("hi_saveas", LuaCommonCommands::luaSaveDocument);
+    li.addFunction("hi_save_snapshot", LuaCommonCommands::luaSaveSnapshot);
+    li.addFunction("hi_savesnapshot", LuaCommonCommands::luaSaveSnapshot);
     li.addFunction("hi_save_bitmap", LuaInstance::luaNOP);
     li.addFunction("hi_savebitmap", LuaInstance::luaNOP);
     li.addFunction("hi_save_dxf", LuaInstance::luaNOP);
@@ -433,6 +444,14 @@ int femmcli::LuaHeatflowCommands::luaAddPointProperty(lua_State *L)
 /**
  * @brief Mesh the problem description, save it, and run the solver.
  * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * If "XFEMM_REUSE_MESH" is set to 1, the mesh of the previous analysis and the node numbering of its solver are reused
+ * as long as the geometry and the mesh settings don't change (see fmesher::FMesher::meshKey()).
+ * Afterwards, "XFEMM_MESH_REUSED" is 0 for a new mesh, 1 if the mesh has been reused, and 2 if the node numbering has been reused, too.
+ * If the global variable "XFEMM_BINARY_SOLUTION" is set to 1, the solution file is written in the binary format (see SolutionFile.h).
+ * If "XFEMM_COMPRESS_SOLUTION" is set to 1, the tables of the binary solution file are compressed.
+ * If "XFEMM_IN_MEMORY" is set to 1, the input file, the mesh files and the solution file are kept in memory instead of being written to the disk
+ * (they are still written and parsed as text, see MemoryFiles.h);
+ * the solution can still be loaded with loadsolution(), and saved with convertsolution().
  * @param L
  * @return 0
  * \ingroup LuaHF
@@ -560,7 +579,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
         return 0;
     }
-    if (!doc->saveFEMFile(pathName))
+    if (!luaSaveProblemForAnalysis(L))
     {
         lua_error(L, "hi_analyze(): Could not save fem file!\n");
         return 0;
@@ -576,23 +595,31 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "hi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+    // ... and whether the mesh of the previous analysis may be reused:
+    mesherDoc->ReuseMesh = (luaInstance->getGlobal("XFEMM_REUSE_MESH") != 0);
+    const bool meshReused = mesherDoc->restoreMesh(pathName);
+    if (!meshReused)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, "hi_analyze(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
         }
-    }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            lua_error(L, "hi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "hi_analyze(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
         }
+        mesherDoc->keepMesh(pathName);
     }
+    luaInstance->setGlobal("XFEMM_MESH_REUSED", meshReused ? 1 : 0);
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
@@ -606,6 +633,8 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     theSolver.PathName = doc->pathName.substr(0,dotpos);
     theSolver.WarnMessage = &PrintWarningMsg;
     theSolver.PrintMessage = &PrintWarningMsg;
+    theSolver.CompressSolution = (luaInstance->getGlobal("XFEMM_COMPRESS_SOLUTION") != 0);
+    theSolver.BinarySolution = theSolver.CompressSolution || (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
     theSolver.dT = doc->dT;
     theSolver.previousSolutionFile = doc->previousSolutionFile;
     if (!theSolver.LoadProblemFile())
@@ -613,6 +642,9 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
         lua_error(L, "hi_analyze(): problem initializing solver!");
         return 0;
     }
+    // reuse the node numbering of the previous analysis, if the mesh has been reused:
+    theSolver.NodeNumbering = mesherDoc->NodeNumbering;
+    theSolver.BandWidth = mesherDoc->BandWidth;
     assert( doc->ACSolver == theSolver.ACSolver);
     assert( doc->lineproplist.size() == theSolver.lineproplist.size());
     assert( doc->nodeproplist.size() == theSolver.nodeproplist.size());
@@ -625,6 +657,13 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     {
         lua_error(L, "solver failed.");
     }
+    if (theSolver.NodeNumberingReused)
+        luaInstance->setGlobal("XFEMM_MESH_REUSED", 2);
+    if (mesherDoc->ReuseMesh)
+    {
+        mesherDoc->NodeNumbering = theSolver.NodeNumbering;
+        mesherDoc->BandWidth = theSolver.BandWidth;
+    }
     return 0;
 }
 
@@ -775,8 +814,14 @@ int femmcli::LuaHeatflowCommands::luaBlockIntegral(lua_State *L)
 
 /**
  * @brief Get the solution values for a point.
+ *
+ * If X and Y are tables of coordinates, the values of all points are computed at once
+ * and 7 tables are returned, one per value.
+ * The entries for points outside of the mesh are nil.
+ * (not present in femm42; xfemm extension)
+ *
  * @param L
- * @return 0
+ * @return 0 on error (e.g. point not in triangle), otherwise 7
  * \ingroup LuaHF
  *
  * \internal
@@ -799,6 +844,33 @@ int femmcli::LuaHeatflowCommands::luaGetPointValues(lua_State *L)
         return 0;
     }
 
+    std::vector<double> xs, ys;
+    if (luaGetPointTables(L, xs, ys))
+    {
+        const int n = xs.size();
+        CHPointValsArray values;
+        pproc->getPointValues(n, xs.data(), ys.data(), values);
+
+        auto pushTable = [&](auto getValue) {
+            lua_newtable(L);
+            for (int i=0; i<n; i++)
+            {
+                if (!values.valid[i])
+                    continue;
+                lua_pushnumber(L, getValue(i));
+                lua_rawseti(L, -2, i+1);
+            }
+        };
+        pushTable([&](int i) { return values.T[i]; });
+        pushTable([&](int i) { return values.F[i].re; });
+        pushTable([&](int i) { return values.F[i].im; });
+        pushTable([&](int i) { return values.G[i].re; });
+        pushTable([&](int i) { return values.G[i].im; });
+        pushTable([&](int i) { return values.K[i].re; });
+        pushTable([&](int i) { return values.K[i].im; });
+        return 7;
+    }
+
     double px,py;
     px=lua_tonumber(L,1).re;
     py=lua_tonumber(L,2).re;
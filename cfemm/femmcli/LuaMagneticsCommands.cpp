@@ -25,17 +25,20 @@
 #include "FemmState.h"
 #include "fpproc.h"
 #include "LuaInstance.h"
+#include "MemoryFiles.h"
 #include "stringTools.h"
 #include "make_unique.h"
 
 #include <lua.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #ifdef DEBUG_FEMMLUA
 #define debug std::cerr
@@ -60,6 +63,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mo_addcontour", luaAddContourPoint);
     li.addFunction("mi_add_block_label", LuaCommonCommands::luaAddBlocklabel);
     li.addFunction("mi_addblocklabel", LuaCommonCommands::luaAddBlocklabel);
+    li.addFunction("mi_add_geometry", LuaCommonCommands::luaAddGeometry);
+    li.addFunction("mi_addgeometry", LuaCommonCommands::luaAddGeometry);
     li.addFunction("mi_add_segment", LuaCommonCommands::luaAddLine);
     li.addFunction("mi_addsegment", LuaCommonCommands::luaAddLine);
     li.addFunction("mi_add_material", luaAddMatProperty);
@@ -74,6 +79,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("mi_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
     li.addFunction("mi_attachouterspace", LuaCommonCommands::luaAttachOuterSpace);
+    li.addFunction("mi_begin_batch", LuaCommonCommands::luaBeginBatch);
+    li.addFunction("mi_beginbatch", LuaCommonCommands::luaBeginBatch);
     li.addFunction("mo_bend_contour", luaBendContourLine);
     li.addFunction("mo_bendcontour", luaBendContourLine);
     li.addFunction("mo_block_integral", luaBlockIntegral);
@@ -120,9 +127,13 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_detachdefault", LuaCommonCommands::luaDetachDefault);
     li.addFunction("mi_detach_outer_space", LuaCommonCommands::luaDetachOuterSpace);
     li.addFunction("mi_detachouterspace", LuaCommonCommands::luaDetachOuterSpace);
+    li.addFunction("mi_end_batch", LuaCommonCommands::luaEndBatch);
+    li.addFunction("mi_endbatch", LuaCommonCommands::luaEndBatch);
     li.addFunction("mo_close", LuaCommonCommands::luaExitPost);
     li.addFunction("mi_close", LuaCommonCommands::luaExitPre);
     li.addFunction("mi_getboundingbox", LuaCommonCommands::luaGetBoundingBox);
+    li.addFunction("mo_geta", luaGetA);
+    li.addFunction("mo_getb", luaGetB);
     li.addFunction("mo_get_circuit_properties", luaGetCircuitProperties);
     li.addFunction("mo_getcircuitproperties", luaGetCircuitProperties);
     li.addFunction("mo_get_element", luaGetElement);
@@ -199,6 +210,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_resize", LuaInstance::luaNOP);
     li.addFunction("mo_resize", LuaInstance::luaNOP);
     li.addFunction("mi_restore", LuaInstance::luaNOP);
+    li.addFunction("mi_restore_snapshot", LuaCommonCommands::luaRestoreSnapshot);
+    li.addFunction("mi_restoresnapshot", LuaCommonCommands::luaRestoreSnapshot);
     li.addFunction("mo_restore", LuaInstance::luaNOP);
     li.addFunction("mi_load_solution", LuaCommonCommands::luaLoadSolution);
     li.addFunction("mi_loadsolution", LuaCommonCommands::luaLoadSolution);
@@ -208,6 +221,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mo_savebitmap", LuaInstance::luaNOP);
     li.addFunction("mi_save_as", LuaCommonCommands::luaSaveDocument);
     li.addFunction("mi_saveas", LuaCommonCommands::luaSaveDocument);
+    li.addFunction("mi_save_snapshot", LuaCommonCommands::luaSaveSnapshot);
+    li.addFunction("mi_savesnapshot", LuaCommonCommands::luaSaveSnapshot);
     li.addFunction("mi_save_dxf", LuaInstance::luaNOP);
     li.addFunction("mi_savedxf", LuaInstance::luaNOP);
     li.addFunction("mi_save_metafile", LuaInstance::luaNOP);
@@ -270,6 +285,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mo_show_points", LuaInstance::luaNOP);
     li.addFunction("mo_showpoints", LuaInstance::luaNOP);
     li.addFunction("mo_smooth", luaSetSmoothing);
+    li.addFunction("mi_sweep_rotor", luaSweepRotor);
+    li.addFunction("mi_sweeprotor", luaSweepRotor);
     li.addFunction("mi_set_focus", LuaCommonCommands::luaSetFocus);
     li.addFunction("mi_setfocus", LuaCommonCommands::luaSetFocus);
     li.addFunction("mo_set_focus", LuaCommonCommands::luaSetFocus);
@@ -639,39 +656,26 @@ int femmcli::LuaMagneticsCommands::luaAddPointProperty(lua_State *L)
     return 0;
 }
 
+namespace {
 /**
- * @brief Mesh the problem description, save it, and run the solver.
- * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @brief Check the problem description, save it, and mesh it.
+ * This is the common part of mi_analyze and mi_sweeprotor.
  * @param L
- * @return 0
- * \ingroup LuaMM
- *
- * \internal
- * ### Implements:
- * - \lua{mi_analyze(flag)}
- *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
- *
- * ### FEMM source:
- * - \femm42{femm/femmeLua.cpp,lua_analyze()}
- *
- * #### Additional source:
- * - \femm42{femm/femmeLua.cpp,lua_analyze()}: extracts thisDoc (=mesherDoc) and the accompanying FemmeViewDoc, calls CFemmeView::lnu_analyze(flag)
- * - \femm42{femm/FemmeView.cpp,CFemmeView::OnMenuAnalyze()}: does the things we do here directly...
- * \endinternal
+ * @param caller name of the lua command, used in error messages
+ * @return \c true on success. On error, a lua error is raised.
  */
-int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
+bool saveAndMeshProblem(lua_State *L, const std::string &caller)
 {
     auto luaInstance = LuaInstance::instance(L);
-    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femmcli::FemmState> femmState = std::dynamic_pointer_cast<femmcli::FemmState>(luaInstance->femmState());
     std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
 
-    luaExpectParameterCount(L, 0,1);
     // check to see if all blocklabels are kosher...
     if (doc->labellist.size()==0){
         std::string msg = "No block information has been defined\n"
                           "Cannot analyze the problem";
         lua_error(L, msg.c_str());
-        return 0;
+        return false;
     }
 
     bool hasMissingBlockProps = false;
@@ -702,7 +706,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                             "been defined for all block labels.\n"
                             "Cannot analyze the problem";
         lua_error(L,ermsg.c_str());
-        return 0;
+        return false;
     }
 
 
@@ -718,7 +722,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                     "r>=0 for axisymmetric problems.\n"
                                     "Cannot analyze the problem.";
                 lua_error(L,ermsg.c_str());
-                return 0;
+                return false;
             }
         }
 
@@ -753,7 +757,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                 "allowed in axisymmetric external regions.\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return false;
         }
 
         if (!hasExteriorProps)
@@ -764,7 +768,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                 "have been adequately defined for the exterior region\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return false;
         }
     }
 
@@ -772,17 +776,17 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     if (pathName.empty())
     {
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
-        return 0;
+        return false;
     }
-    if (!doc->saveFEMFile(pathName))
+    if (!femmcli::luaSaveProblemForAnalysis(L))
     {
-        lua_error(L, "mi_analyze(): Could not save fem file!\n");
-        return 0;
+        lua_error(L, (caller + "(): Could not save fem file!\n").c_str());
+        return false;
     }
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"mi_analyze(): consistency check failed before meshing!\n");
-        return 0;
+        lua_error(L,(caller + "(): consistency check failed before meshing!\n").c_str());
+        return false;
     }
 
     //BeginWaitCursor();
@@ -790,29 +794,79 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "mi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+    // ... and whether the mesh of the previous analysis may be reused:
+    mesherDoc->ReuseMesh = (luaInstance->getGlobal("XFEMM_REUSE_MESH") != 0);
+    const bool meshReused = mesherDoc->restoreMesh(pathName);
+    if (!meshReused)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, (caller + "(): Periodic BC triangulation failed!\n").c_str());
+                return false;
+            }
         }
-    }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            lua_error(L, "mi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, (caller + "(): Nonperiodic BC triangulation failed!\n").c_str());
+                return false;
+            }
         }
+        mesherDoc->keepMesh(pathName);
     }
+    luaInstance->setGlobal("XFEMM_MESH_REUSED", meshReused ? 1 : 0);
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"mi_analyze(): consistency check failed after meshing!\n");
-        return 0;
+        lua_error(L,(caller + "(): consistency check failed after meshing!\n").c_str());
+        return false;
     }
+    return true;
+}
+} // namespace
+
+/**
+ * @brief Mesh the problem description, save it, and run the solver.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * If "XFEMM_REUSE_MESH" is set to 1, the mesh of the previous analysis and the node numbering of its solver are reused
+ * as long as the geometry and the mesh settings don't change (see fmesher::FMesher::meshKey()).
+ * Afterwards, "XFEMM_MESH_REUSED" is 0 for a new mesh, 1 if the mesh has been reused, and 2 if the node numbering has been reused, too.
+ * If the global variable "XFEMM_BINARY_SOLUTION" is set to 1, the solution file is written in the binary format (see SolutionFile.h).
+ * If "XFEMM_COMPRESS_SOLUTION" is set to 1, the tables of the binary solution file are compressed.
+ * If "XFEMM_IN_MEMORY" is set to 1, the input file, the mesh files and the solution file are kept in memory instead of being written to the disk
+ * (they are still written and parsed as text, see MemoryFiles.h);
+ * the solution can still be loaded with loadsolution(), and saved with convertsolution().
+ * @param L
+ * @return 0
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_analyze(flag)}
+ *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
+ *
+ * ### FEMM source:
+ * - \femm42{femm/femmeLua.cpp,lua_analyze()}
+ *
+ * #### Additional source:
+ * - \femm42{femm/femmeLua.cpp,lua_analyze()}: extracts thisDoc (=mesherDoc) and the accompanying FemmeViewDoc, calls CFemmeView::lnu_analyze(flag)
+ * - \femm42{femm/FemmeView.cpp,CFemmeView::OnMenuAnalyze()}: does the things we do here directly...
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 0,1);
+    if (!saveAndMeshProblem(L, "mi_analyze"))
+        return 0;
+    const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
 
     FSolver theFSolver;
     // filename.fem -> filename
@@ -820,6 +874,8 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     theFSolver.PathName = doc->pathName.substr(0,dotpos);
     theFSolver.WarnMessage = &PrintWarningMsg;
     theFSolver.PrintMessage = &PrintWarningMsg;
+    theFSolver.CompressSolution = (luaInstance->getGlobal("XFEMM_COMPRESS_SOLUTION") != 0);
+    theFSolver.BinarySolution = theFSolver.CompressSolution || (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
     // not supported yet, but set the previous solution so that we can detect this case afterwards:
     theFSolver.previousSolutionFile = doc->previousSolutionFile;
     if (!theFSolver.LoadProblemFile())
@@ -827,6 +883,10 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
         lua_error(L, "mi_analyze(): problem initializing solver!");
         return 0;
     }
+    // reuse the node numbering of the previous analysis, if the mesh has been reused:
+    std::shared_ptr<fmesher::FMesher> mesher = femmState->getMesher();
+    theFSolver.NodeNumbering = mesher->NodeNumbering;
+    theFSolver.BandWidth = mesher->BandWidth;
     assert( doc->ACSolver == theFSolver.ACSolver);
     assert( doc->Frequency == theFSolver.Frequency);
     assert( doc->lineproplist.size() == theFSolver.lineproplist.size());
@@ -840,6 +900,13 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     {
         lua_error(L, "solver failed.");
     }
+    if (theFSolver.NodeNumberingReused)
+        luaInstance->setGlobal("XFEMM_MESH_REUSED", 2);
+    if (mesher->ReuseMesh)
+    {
+        mesher->NodeNumbering = theFSolver.NodeNumbering;
+        mesher->BandWidth = theFSolver.BandWidth;
+    }
     return 0;
 }
 
@@ -884,8 +951,16 @@ int femmcli::LuaMagneticsCommands::luaBendContourLine(lua_State *L)
 
 /**
  * @brief Calculate a block integral for the selected blocks.
+ *
+ * Several integral types can be given at once, e.g. \c mo_blockintegral(2,11,12).
+ * In that case, all integrals are computed in a single pass over the mesh,
+ * and one value is returned per type.
+ * Large meshes are integrated by several threads; the global variable "XFEMM_INTEGRAL_THREADS"
+ * limits the number of threads (e.g. set it to 1 to integrate serially).
+ * (not present in femm42; xfemm extension)
+ *
  * @param L
- * @return 1 on success, 0 otherwise
+ * @return the number of integrals on success, 0 otherwise
  * \ingroup LuaMM
  *
  * \internal
@@ -913,12 +988,20 @@ int femmcli::LuaMagneticsCommands::luaBlockIntegral(lua_State *L)
         return 0;
     }
 
-    luaExpectParameterCount(L, 1);
-    int type = (int) lua_todouble(L,1);
-    if((type<0) || (type>24))
+    const int numTypes = std::max(lua_gettop(L), 1);
+    std::vector<int> types;
+    bool needsMask = false;
+    for (int i=1; i<=numTypes; i++)
     {
-        lua_error(L, "Invalid block integral type selected");
-        return 0;
+        int type = (int) lua_todouble(L,i);
+        if((type<0) || (type>24))
+        {
+            lua_error(L, "Invalid block integral type selected");
+            return 0;
+        }
+        if ((type>=18) && (type<=23))
+            needsMask = true;
+        types.push_back(type);
     }
 
     bool hasSelectedBlocks = false;
@@ -937,15 +1020,21 @@ int femmcli::LuaMagneticsCommands::luaBlockIntegral(lua_State *L)
         return 0;
     }
 
-    if ((type>=18) && (type<=23))
+    if (needsMask)
     {
         fpproc->MakeMask();
     }
 
-    CComplex z = fpproc->BlockIntegral(type);
+    std::vector<CComplex> z;
+    // 0 (or unset) means: as many threads as the mesh size warrants
+    const int numThreads = (int) luaInstance->getGlobal("XFEMM_INTEGRAL_THREADS").re;
+    fpproc->BlockIntegrals(types, z, numThreads);
 
-    lua_pushnumber(L,z);
-    return 1;
+    // make room for the results
+    lua_settop(L,0);
+    for (const CComplex &value: z)
+        lua_pushnumber(L,value);
+    return numTypes;
 }
 
 /**
@@ -1225,6 +1314,120 @@ int femmcli::LuaMagneticsCommands::luaClearContourPoint(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Get the vector potential A at a point.
+ *
+ * If X and Y are tables of coordinates, the values of all points are computed at once
+ * and a table is returned.
+ * The entries for points outside of the mesh are nil.
+ * @param L
+ * @return 0 on error, otherwise 1
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mo_geta(X,Y)}
+ *
+ * ### FEMM source:
+ * - (not present in femm42 sources; femm42 defines mo_geta() in init.lua)
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaGetA(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    auto femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FPProc> fpproc = std::dynamic_pointer_cast<FPProc>(femmState->getPostProcessor());
+    if (!fpproc)
+    {
+        lua_error(L,"No magnetics output in focus");
+        return 0;
+    }
+
+    luaExpectParameterCount(L, 2);
+    std::vector<double> xs, ys;
+    if (luaGetPointTables(L, xs, ys))
+    {
+        CMPointValsArray values;
+        fpproc->GetPointValues(xs.size(), xs.data(), ys.data(), values);
+        lua_newtable(L);
+        for (int i=0; i<values.size(); i++)
+        {
+            if (!values.valid[i])
+                continue;
+            lua_pushnumber(L, values.A[i]);
+            lua_rawseti(L, -2, i+1);
+        }
+        return 1;
+    }
+
+    CMPointVals u;
+    if (fpproc->GetPointValues(lua_tonumber(L,1).re, lua_tonumber(L,2).re, u))
+    {
+        lua_pushnumber(L,u.A);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the flux density B at a point.
+ *
+ * If X and Y are tables of coordinates, the values of all points are computed at once
+ * and two tables are returned, one per component.
+ * The entries for points outside of the mesh are nil.
+ * @param L
+ * @return 0 on error, otherwise 2
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mo_getb(X,Y)}
+ *
+ * ### FEMM source:
+ * - (not present in femm42 sources; femm42 defines mo_getb() in init.lua)
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaGetB(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    auto femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FPProc> fpproc = std::dynamic_pointer_cast<FPProc>(femmState->getPostProcessor());
+    if (!fpproc)
+    {
+        lua_error(L,"No magnetics output in focus");
+        return 0;
+    }
+
+    luaExpectParameterCount(L, 2);
+    std::vector<double> xs, ys;
+    if (luaGetPointTables(L, xs, ys))
+    {
+        CMPointValsArray values;
+        fpproc->GetPointValues(xs.size(), xs.data(), ys.data(), values);
+        for (const std::vector<CComplex> *B: {&values.B1, &values.B2})
+        {
+            lua_newtable(L);
+            for (int i=0; i<values.size(); i++)
+            {
+                if (!values.valid[i])
+                    continue;
+                lua_pushnumber(L, (*B)[i]);
+                lua_rawseti(L, -2, i+1);
+            }
+        }
+        return 2;
+    }
+
+    CMPointVals u;
+    if (fpproc->GetPointValues(lua_tonumber(L,1).re, lua_tonumber(L,2).re, u))
+    {
+        lua_pushnumber(L,u.B1);
+        lua_pushnumber(L,u.B2);
+        return 2;
+    }
+    return 0;
+}
+
 /**
  * @brief Get information about a circuit property.
  * Used primarily to obtain impedance information associated with circuit properties.
@@ -1376,6 +1579,12 @@ int femmcli::LuaMagneticsCommands::luaGetMeshNode(lua_State *L)
 
 /**
  * @brief Get the values for a point.
+ *
+ * If X and Y are tables of coordinates, the values of all points are computed at once
+ * and 14 tables are returned, one per value.
+ * The entries for points outside of the mesh are nil.
+ * (not present in femm42; xfemm extension)
+ *
  * @param L
  * @return 0 on error, otherwise 14
  * \ingroup LuaMM
@@ -1408,6 +1617,40 @@ int femmcli::LuaMagneticsCommands::luaGetPointValues(lua_State *L)
     }
 
     luaExpectParameterCount(L, 2);
+    std::vector<double> xs, ys;
+    if (luaGetPointTables(L, xs, ys))
+    {
+        const int n = xs.size();
+        CMPointValsArray values;
+        fpproc->GetPointValues(n, xs.data(), ys.data(), values);
+
+        auto pushTable = [&](auto getValue) {
+            lua_newtable(L);
+            for (int i=0; i<n; i++)
+            {
+                if (!values.valid[i])
+                    continue;
+                lua_pushnumber(L, getValue(i));
+                lua_rawseti(L, -2, i+1);
+            }
+        };
+        pushTable([&](int i) { return values.A[i]; });
+        pushTable([&](int i) { return values.B1[i]; });
+        pushTable([&](int i) { return values.B2[i]; });
+        pushTable([&](int i) { return values.c[i]; });
+        pushTable([&](int i) { return values.E[i]; });
+        pushTable([&](int i) { return values.H1[i]; });
+        pushTable([&](int i) { return values.H2[i]; });
+        pushTable([&](int i) { return values.Je[i]; });
+        pushTable([&](int i) { return values.Js[i]; });
+        pushTable([&](int i) { return values.mu1[i]; });
+        pushTable([&](int i) { return values.mu2[i]; });
+        pushTable([&](int i) { return values.Pe[i]; });
+        pushTable([&](int i) { return values.Ph[i]; });
+        pushTable([&](int i) { return values.ff[i]; });
+        return 14;
+    }
+
     double px,py;
     px=lua_tonumber(L,1).re;
     py=lua_tonumber(L,2).re;
@@ -2642,6 +2885,136 @@ int femmcli::LuaMagneticsCommands::luaSetSmoothing(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Solve the problem for a sequence of rotor positions without remeshing.
+ * The problem is saved and meshed once. For each rotor position, the InnerAngle of the air gap element
+ * is changed, and the solver continues from the solution of the previous position.
+ * The solution for the k-th position (counting from 0) is written to "<name>_<k>.ans",
+ * in the binary format if the global variable "XFEMM_BINARY_SOLUTION" is set to 1,
+ * with compressed tables if "XFEMM_COMPRESS_SOLUTION" is set to 1.
+ * If "XFEMM_IN_MEMORY" is set to 1, these solution files are kept in memory (see mi_analyze()).
+ * "XFEMM_REUSE_MESH" and "XFEMM_MESH_REUSED" work as for mi_analyze().
+ *
+ * The result is a table with one entry per rotor position.
+ * Each entry holds the fields \c angle, \c torque (DC torque from the air gap element),
+ * and \c flux, a table of flux linkages indexed by circuit name.
+ *
+ * Only planar magnetostatic problems are supported.
+ * @param L
+ * @return 1
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_sweeprotor("BdryName", startangle, anglestep, count)}
+ * - (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaSweepRotor(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 4);
+    std::string bdryName = lua_tostring(L,1);
+    const double start = lua_todouble(L,2);
+    const double step = lua_todouble(L,3);
+    const int count = (int) lua_todouble(L,4);
+    if (count < 1)
+    {
+        lua_error(L, "mi_sweeprotor(): at least one rotor position is needed");
+        return 0;
+    }
+    std::vector<double> angles;
+    for (int k=0; k<count; k++)
+        angles.push_back(start + k*step);
+
+    if (!saveAndMeshProblem(L, "mi_sweeprotor"))
+        return 0;
+    const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
+
+    FSolver theFSolver;
+    // filename.fem -> filename
+    std::size_t dotpos = doc->pathName.find_last_of(".");
+    theFSolver.PathName = doc->pathName.substr(0,dotpos);
+    theFSolver.WarnMessage = &PrintWarningMsg;
+    theFSolver.PrintMessage = &PrintWarningMsg;
+    theFSolver.CompressSolution = (luaInstance->getGlobal("XFEMM_COMPRESS_SOLUTION") != 0);
+    theFSolver.BinarySolution = theFSolver.CompressSolution || (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+    theFSolver.previousSolutionFile = doc->previousSolutionFile;
+    if (!theFSolver.LoadProblemFile())
+    {
+        lua_error(L, "mi_sweeprotor(): problem initializing solver!");
+        return 0;
+    }
+    // reuse the node numbering of the previous analysis, if the mesh has been reused:
+    std::shared_ptr<fmesher::FMesher> mesher = femmState->getMesher();
+    theFSolver.NodeNumbering = mesher->NodeNumbering;
+    theFSolver.BandWidth = mesher->BandWidth;
+    const bool inMemory = isMemoryFile(doc->pathName);
+    for (int k=0; k<(int)angles.size(); k++)
+    {
+        const std::string file = theFSolver.sweepSolutionFile(k);
+        const std::string baseName = file.substr(0,file.find_last_of("."));
+        if (inMemory)
+            addMemoryFiles(baseName);
+        else
+            removeMemoryFiles(baseName);
+    }
+
+    lua_newtable(L);
+    const int resultTable = lua_gettop(L);
+    std::string error;
+    auto evaluate = [&](int k) {
+        FPProc pproc;
+        if (!pproc.OpenDocument(theFSolver.sweepSolutionFile(k)))
+        {
+            error = "mi_sweeprotor(): could not open " + theFSolver.sweepSolutionFile(k);
+            return false;
+        }
+        double torque = 0;
+        pproc.gapDCTorqueIntegral(bdryName, torque);
+
+        lua_newtable(L);
+        lua_pushstring(L, "angle");
+        lua_pushnumber(L, angles[k]);
+        lua_settable(L, -3);
+        lua_pushstring(L, "torque");
+        lua_pushnumber(L, torque);
+        lua_settable(L, -3);
+        lua_pushstring(L, "flux");
+        lua_newtable(L);
+        for (int i=0; i<(int)pproc.circproplist.size(); i++)
+        {
+            lua_pushstring(L, pproc.circproplist[i].CircName.c_str());
+            lua_pushnumber(L, pproc.GetFluxLinkage(i));
+            lua_settable(L, -3);
+        }
+        lua_settable(L, -3);
+        lua_rawseti(L, resultTable, k+1);
+        return true;
+    };
+    if (!theFSolver.runRotorSweep(bdryName, angles, evaluate, verbose))
+    {
+        lua_error(L, "mi_sweeprotor(): solver failed.");
+        return 0;
+    }
+    if (theFSolver.NodeNumberingReused)
+        luaInstance->setGlobal("XFEMM_MESH_REUSED", 2);
+    if (mesher->ReuseMesh)
+    {
+        mesher->NodeNumbering = theFSolver.NodeNumbering;
+        mesher->BandWidth = theFSolver.BandWidth;
+    }
+    if (!error.empty())
+    {
+        lua_error(L, error.c_str());
+        return 0;
+    }
+    return 1;
+}
+
 /**
  * @brief Get the value of the flux density in the air gap region.
  *
@@ -54,6 +54,8 @@ int luaGapIntegral(lua_State *L);
 int luaClearBHPoints(lua_State *L);
 int luaClearBlock(lua_State *L);
 int luaClearContourPoint(lua_State *L);
+int luaGetA(lua_State *L);
+int luaGetB(lua_State *L);
 int luaGetCircuitProperties(lua_State *L);
 int luaGetElement(lua_State *L);
 int luaGetMeshNode(lua_State *L);
@@ -75,6 +77,7 @@ int luaSetNodeProperty(lua_State *L);
 int luaSetPrevious(lua_State *L);
 int luaSetSmoothing(lua_State *L);
 int luaSetSegmentProperty(lua_State *L);
+int luaSweepRotor(lua_State *L);
 int luaGetGapB(lua_State *L);
 int luaGetGapA(lua_State *L);
 int luaGetGapHarmonics(lua_State *L);
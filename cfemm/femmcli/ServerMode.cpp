@@ -0,0 +1,497 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "ServerMode.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+
+volatile sig_atomic_t stopRequested = 0;
+
+void handleStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+bool writeAll(int fd, const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = write(fd, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const std::string &data)
+{
+    return writeAll(fd, data.data(), data.size());
+}
+
+/**
+ * @brief Send a frame "<channel> <length>\n<data>".
+ */
+bool sendFrame(int fd, char channel, const char *data, std::size_t size)
+{
+    std::string header(1, channel);
+    header += " " + std::to_string(size) + "\n";
+    return writeAll(fd, header) && writeAll(fd, data, size);
+}
+
+/**
+ * @brief Buffered reading of lines and blocks from a socket.
+ */
+class SocketReader
+{
+public:
+    explicit SocketReader(int fd) : fd(fd) {}
+
+    /**
+     * @brief Read a line, without the trailing newline.
+     * @return \c false, if the connection was closed before the end of the line
+     */
+    bool readLine(std::string &line)
+    {
+        line.clear();
+        while (true)
+        {
+            const std::size_t eol = buffer.find('\n', pos);
+            if (eol != std::string::npos)
+            {
+                line = buffer.substr(pos, eol-pos);
+                pos = eol+1;
+                return true;
+            }
+            if (!fill())
+                return false;
+        }
+    }
+
+    /**
+     * @brief Read exactly \p size bytes.
+     * @return \c false, if the connection was closed before
+     */
+    bool readBytes(std::size_t size, std::string &data)
+    {
+        while (buffer.size()-pos < size)
+        {
+            if (!fill())
+                return false;
+        }
+        data = buffer.substr(pos, size);
+        pos += size;
+        return true;
+    }
+
+private:
+    bool fill()
+    {
+        buffer.erase(0, pos);
+        pos = 0;
+        char chunk[65536];
+        ssize_t n;
+        do {
+            n = read(fd, chunk, sizeof(chunk));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, n);
+        return true;
+    }
+
+    int fd;
+    std::string buffer;
+    std::size_t pos = 0;
+};
+
+bool makeAddress(const std::string &socketPath, sockaddr_un &addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "Socket path too long: " << socketPath << "\n";
+        return false;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    return true;
+}
+
+int connectTo(const std::string &socketPath)
+{
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr))
+        return -1;
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Copy the output pipes to the socket until both are closed by the writer.
+ */
+void relayOutput(int socketFd, int outFd, int errFd)
+{
+    pollfd fds[2] = { {outFd, POLLIN, 0}, {errFd, POLLIN, 0} };
+    const char channels[2] = { 'o', 'e' };
+    int openPipes = 2;
+    char chunk[65536];
+    while (openPipes > 0)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i=0; i<2; i++)
+        {
+            if (fds[i].fd < 0 || fds[i].revents == 0)
+                continue;
+            const ssize_t n = read(fds[i].fd, chunk, sizeof(chunk));
+            if (n > 0)
+            {
+                // if the client went away, keep draining the pipe so that the chunk can finish
+                sendFrame(socketFd, channels[i], chunk, n);
+            } else if (n == 0 || errno != EINTR) {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+                openPipes--;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check whether the peer of a connected socket runs as the same user as the server.
+ */
+bool peerIsOwner(int fd)
+{
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+        return false;
+    return cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) != 0)
+        return false;
+    return uid == getuid();
+#endif
+}
+
+/**
+ * @brief Serve a single request; this runs in the forked child process.
+ * @return the exit status of the child process
+ */
+int serveRequest(int clientFd, const femmcli::ChunkExecutor &execChunk)
+{
+    // a request runs arbitrary Lua code as the server user
+    if (!peerIsOwner(clientFd))
+    {
+        const std::string msg = "Permission denied\n";
+        sendFrame(clientFd, 'e', msg.data(), msg.size());
+        writeAll(clientFd, "x 1\n");
+        return 1;
+    }
+
+    SocketReader reader(clientFd);
+    std::string command;
+    if (!reader.readLine(command))
+        return 1;
+    if (command == "stop")
+    {
+        kill(getppid(), SIGTERM);
+        writeAll(clientFd, "x 0\n");
+        return 0;
+    }
+
+    std::string workDir;
+    std::string chunkName;
+    std::string sizeLine;
+    std::string chunk;
+    if (command != "run"
+            || !reader.readLine(workDir)
+            || !reader.readLine(chunkName)
+            || !reader.readLine(sizeLine)
+            || !reader.readBytes(std::strtoul(sizeLine.c_str(), nullptr, 10), chunk))
+    {
+        const std::string msg = "Invalid request\n";
+        sendFrame(clientFd, 'e', msg.data(), msg.size());
+        writeAll(clientFd, "x 1\n");
+        return 1;
+    }
+    if (chdir(workDir.c_str()) != 0)
+    {
+        const std::string msg = "Could not change to directory " + workDir + "\n";
+        sendFrame(clientFd, 'e', msg.data(), msg.size());
+        writeAll(clientFd, "x 1\n");
+        return 1;
+    }
+
+    // redirect stdout and stderr through pipes, so that the output can be framed
+    int outPipe[2];
+    int errPipe[2];
+    if (pipe(outPipe) != 0 || pipe(errPipe) != 0)
+    {
+        const std::string msg = std::string("Could not create pipes: ") + std::strerror(errno) + "\n";
+        sendFrame(clientFd, 'e', msg.data(), msg.size());
+        writeAll(clientFd, "x 1\n");
+        return 1;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    dup2(outPipe[1], STDOUT_FILENO);
+    dup2(errPipe[1], STDERR_FILENO);
+    close(outPipe[1]);
+    close(errPipe[1]);
+    std::thread relay(relayOutput, clientFd, outPipe[0], errPipe[0]);
+
+    const int result = execChunk(chunk, chunkName);
+
+    // closing the write ends of the pipes ends the relay
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    const int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    dup2(devNull, STDERR_FILENO);
+    close(devNull);
+    relay.join();
+
+    writeAll(clientFd, "x " + std::to_string(result) + "\n");
+    return 0;
+}
+
+#endif
+
+} // anonymous namespace
+
+bool femmcli::haveServerMode()
+{
+#ifndef _WIN32
+    return true;
+#else
+    return false;
+#endif
+}
+
+int femmcli::runServer(const std::string &socketPath, const ChunkExecutor &execChunk)
+{
+#ifndef _WIN32
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr))
+        return 1;
+    // replace a socket left over by a server that was killed, but never a running server or another file
+    struct stat st;
+    if (lstat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        const int fd = connectTo(socketPath);
+        if (fd >= 0)
+        {
+            close(fd);
+            std::cerr << "A femmcli server is already running on " << socketPath << "\n";
+            return 1;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    const int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    // only the owner may connect to the socket
+    const mode_t oldMask = umask(0077);
+    const bool bound = (listenFd >= 0
+            && bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    umask(oldMask);
+    if (!bound || listen(listenFd, SOMAXCONN) != 0)
+    {
+        std::cerr << "Could not listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        if (listenFd >= 0)
+            close(listenFd);
+        return 1;
+    }
+
+    // no SA_RESTART: a stop signal interrupts poll()
+    struct sigaction stopAction;
+    std::memset(&stopAction, 0, sizeof(stopAction));
+    stopAction.sa_handler = handleStopSignal;
+    sigemptyset(&stopAction.sa_mask);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    sigaction(SIGINT, &stopAction, nullptr);
+    // request processes are not waited for
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    while (!stopRequested)
+    {
+        pollfd pfd = { listenFd, POLLIN, 0 };
+        // the timeout covers a stop signal arriving right before poll()
+        if (poll(&pfd, 1, 500) <= 0)
+            continue;
+        const int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0)
+            continue;
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(listenFd);
+            signal(SIGCHLD, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            signal(SIGINT, SIG_DFL);
+            const int status = serveRequest(clientFd, execChunk);
+            close(clientFd);
+            // don't run the destructors of the server's state
+            _exit(status);
+        }
+        if (pid < 0)
+            std::cerr << "Could not fork request process: " << std::strerror(errno) << "\n";
+        close(clientFd);
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+#else
+    (void)socketPath;
+    (void)execChunk;
+    std::cerr << "Server mode is not available on this system.\n";
+    return 1;
+#endif
+}
+
+int femmcli::runClient(const std::string &socketPath, const std::string &inputFile)
+{
+#ifndef _WIN32
+    std::ifstream input(inputFile.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Error reading file " << inputFile << std::endl;
+        return 1;
+    }
+    std::string chunk { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    // like lua_dofile(), ignore a first line starting with '#' (but keep the line numbers)
+    if (!chunk.empty() && chunk[0] == '#')
+        chunk.erase(0, chunk.find('\n'));
+
+    char workDir[4096];
+    if (getcwd(workDir, sizeof(workDir)) == nullptr)
+    {
+        std::cerr << "Could not determine the working directory\n";
+        return 1;
+    }
+    const int fd = connectTo(socketPath);
+    if (fd < 0)
+    {
+        std::cerr << "Could not connect to femmcli server on " << socketPath << "\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    std::string request = "run\n";
+    request += std::string(workDir) + "\n";
+    // chunk names starting with "@" are file names in Lua error messages
+    request += "@" + inputFile + "\n";
+    request += std::to_string(chunk.size()) + "\n";
+    request += chunk;
+    if (!writeAll(fd, request))
+    {
+        std::cerr << "Could not send request to femmcli server\n";
+        close(fd);
+        return 1;
+    }
+
+    SocketReader reader(fd);
+    std::string header;
+    std::string data;
+    while (reader.readLine(header))
+    {
+        if (header.size() < 3 || header[1] != ' ')
+            break;
+        const unsigned long value = std::strtoul(header.c_str()+2, nullptr, 10);
+        if (header[0] == 'x')
+        {
+            close(fd);
+            return static_cast<int>(value);
+        }
+        if (!reader.readBytes(value, data))
+            break;
+        FILE *out = (header[0] == 'e') ? stderr : stdout;
+        fwrite(data.data(), 1, data.size(), out);
+        fflush(out);
+    }
+    close(fd);
+    std::cerr << "Connection to femmcli server closed unexpectedly\n";
+    return 1;
+#else
+    (void)socketPath;
+    (void)inputFile;
+    std::cerr << "Server mode is not available on this system.\n";
+    return 1;
+#endif
+}
+
+int femmcli::stopServer(const std::string &socketPath)
+{
+#ifndef _WIN32
+    const int fd = connectTo(socketPath);
+    if (fd < 0)
+    {
+        std::cerr << "Could not connect to femmcli server on " << socketPath << "\n";
+        return 1;
+    }
+    std::string reply;
+    SocketReader reader(fd);
+    const bool ok = writeAll(fd, "stop\n") && reader.readLine(reply) && reply == "x 0";
+    close(fd);
+    return ok ? 0 : 1;
+#else
+    (void)socketPath;
+    std::cerr << "Server mode is not available on this system.\n";
+    return 1;
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMMCLI_SERVERMODE_H
+#define FEMMCLI_SERVERMODE_H
+
+#include <functional>
+#include <string>
+
+/**
+ * \file ServerMode.h
+ * A long-lived femmcli process that runs Lua chunks sent over a Unix domain socket (not present in femm42; xfemm extension).
+ *
+ * Starting femmcli means creating the Lua state, registering the commands and running init.lua
+ * (and any script that loads problems or solutions) before the actual work can begin.
+ * In server mode, this is done once; afterwards, every request is served by a forked copy of the server process,
+ * so that each chunk runs in its own copy of the warm LuaInstance and FemmState,
+ * and no request can change the state seen by the next one.
+ *
+ * Protocol
+ * --------
+ * The client sends one request per connection:
+ *
+ *     run\n<working directory>\n<chunk name>\n<chunk length>\n<chunk>
+ *     stop\n
+ *
+ * The server answers with a sequence of frames "<channel> <length>\n<data>",
+ * where the channel is "o" (standard output) or "e" (standard error),
+ * followed by the final frame "x <status>\n" with the result of the chunk (0 for success).
+ *
+ * Since a chunk can do anything the server user can do, the socket is created with access for its owner only,
+ * and requests from other users are rejected.
+ *
+ * Server mode is only available on POSIX systems.
+ */
+namespace femmcli {
+
+/**
+ * @brief A function that executes a Lua chunk.
+ * The arguments are the chunk and its name; the return value is the Lua error code.
+ */
+using ChunkExecutor = std::function<int(const std::string &chunk, const std::string &chunkName)>;
+
+/**
+ * @brief Check whether server mode is available.
+ * @return \c false, if runServer() and runClient() are not supported on this system
+ */
+bool haveServerMode();
+
+/**
+ * @brief Serve requests on a Unix domain socket until a "stop" request is received.
+ * Each request is executed in a child process that has its own copy of the caller's state.
+ * @param socketPath the socket file; a stale socket file is replaced
+ * @param execChunk the function that executes a chunk
+ * @return the exit status for femmcli
+ */
+int runServer(const std::string &socketPath, const ChunkExecutor &execChunk);
+
+/**
+ * @brief Send a Lua file to a server and copy its output to stdout and stderr.
+ * @param socketPath the socket file of the server
+ * @param inputFile the Lua file
+ * @return the result of the chunk, or 1 if the request failed
+ */
+int runClient(const std::string &socketPath, const std::string &inputFile);
+
+/**
+ * @brief Ask a server to shut down.
+ * @param socketPath the socket file of the server
+ * @return 0 on success
+ */
+int stopServer(const std::string &socketPath);
+
+} // namespace femmcli
+
+#endif
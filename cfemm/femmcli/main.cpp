@@ -19,6 +19,8 @@
 #include "LuaElectrostaticsCommands.h"
 #include "LuaHeatflowCommands.h"
 #include "LuaMagneticsCommands.h"
+#include "Profiler.h"
+#include "ServerMode.h"
 #include "stringTools.h"
 
 #include <cassert>
@@ -43,18 +45,27 @@ using namespace femmcli;
 bool quiet = false;
 
 /**
- * \brief Execute a Lua File
- * \param inputFile the lua file
+ * @brief luaProfile if true, profile the lua commands and the analysis phases
+ */
+bool luaProfile = false;
+/**
+ * @brief luaProfileTrace if not empty, write the profile in the Chrome trace format to this file
+ */
+std::string luaProfileTrace;
+/**
+ * @brief luaCacheDir if not empty, cache the precompiled lua chunks in this directory
+ */
+std::string luaCacheDir;
+
+/**
+ * \brief Register the femm commands and run the initialization code
+ * \param li the lua instance
  * \param luaInit a lua file containing initialization code
  * \param luaTrace enable function tracing for lua
  * \param luaBaseDir base directory for lua
- * \return the result of lua_dostring()
  */
-int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
+void initLuaInstance(LuaInstance &li, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
 {
-    // initialize interpreter
-    shared_ptr<FemmState> state = make_shared<FemmState>();
-    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
     LuaBaseCommands::registerCommands(li);
     LuaMagneticsCommands::registerCommands(li);
     LuaElectrostaticsCommands::registerCommands(li);
@@ -63,6 +74,7 @@ int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool
     li.setPedanticMode(luaPedanticMode);
     li.setDebugGeometry(luaDebugGeometry);
     li.setBaseDir(luaBaseDir);
+    li.setChunkCacheDir(luaCacheDir);
     // canned initialization
     if (!luaInit.empty())
     {
@@ -83,8 +95,15 @@ int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool
             }
         }
     }
+}
 
-    int err = li.doFile(inputFile);
+/**
+ * \brief Print the result of a Lua chunk
+ * \param err the return value of lua_dofile() or lua_dobuffer()
+ * \param inputFile the lua file
+ */
+void reportLuaResult(int err, const std::string &inputFile)
+{
     switch(err)
     {
         case 0:
@@ -112,9 +131,96 @@ int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool
             // this should really not happen
             std::cerr << "Unknown error!\n";
     }
+}
+
+/**
+ * \brief Print the profile of a Lua chunk, if profiling is enabled
+ */
+void reportProfile()
+{
+    if (!luaProfile)
+        return;
+    std::cerr << "Profile:\n";
+    profiler::writeSummary(std::cerr);
+    if (!luaProfileTrace.empty() && !profiler::writeChromeTrace(luaProfileTrace))
+        std::cerr << "Could not write profile to " << luaProfileTrace << "\n";
+}
+
+/**
+ * \brief Execute a Lua File
+ * \param inputFile the lua file
+ * \param luaInit a lua file containing initialization code
+ * \param luaTrace enable function tracing for lua
+ * \param luaBaseDir base directory for lua
+ * \return the result of lua_dostring()
+ */
+int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
+{
+    // initialize interpreter
+    shared_ptr<FemmState> state = make_shared<FemmState>();
+    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
+    initLuaInstance(li, luaInit, luaTrace, luaBaseDir, luaPedanticMode, luaDebugGeometry);
+
+    li.enableProfiling(luaProfile);
+    int err = li.doFile(inputFile);
+    reportLuaResult(err, inputFile);
+    reportProfile();
+    return err;
+}
+
+/**
+ * \brief Compile a Lua file to a precompiled chunk
+ * \param inputFile the lua file
+ * \param outputFile the precompiled chunk
+ * \return the Lua error code
+ */
+int compileLuaFile( const std::string &inputFile, const std::string &outputFile)
+{
+    LuaInstance li;
+    int err = li.compileFile(inputFile, outputFile);
+    if (err == LUA_ERRFILE)
+        std::cerr << "Error compiling " << inputFile << " to " << outputFile << std::endl;
+    else
+        reportLuaResult(err, inputFile);
     return err;
 }
 
+/**
+ * \brief Run femmcli as server (see ServerMode.h)
+ * \param socketPath the socket file
+ * \param inputFile an optional lua file that is executed once before serving requests,
+ * e.g. to load problems or solutions that are used by all requests
+ * \return the exit status
+ */
+int execServer( const std::string &socketPath, const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
+{
+    shared_ptr<FemmState> state = make_shared<FemmState>();
+    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
+    initLuaInstance(li, luaInit, luaTrace, luaBaseDir, luaPedanticMode, luaDebugGeometry);
+
+    if (!inputFile.empty())
+    {
+        int err = li.doFile(inputFile);
+        if (err != 0)
+        {
+            reportLuaResult(err, inputFile);
+            return err;
+        }
+    }
+    if (!quiet)
+        std::cerr << "Serving requests on " << socketPath << "\n";
+
+    // every request is executed in a forked copy of li
+    return runServer(socketPath, [&li](const std::string &chunk, const std::string &chunkName) {
+        li.enableProfiling(luaProfile);
+        int err = li.doBuffer(chunk, chunkName);
+        // chunkName is "@<file>"
+        reportLuaResult(err, chunkName.substr(chunkName.empty() ? 0 : 1));
+        reportProfile();
+        return err;
+    });
+}
+
 int main(int argc, char ** argv)
 {
     std::string exe { argv[0] };
@@ -126,6 +232,10 @@ int main(int argc, char ** argv)
     bool luaTrace = false;
     bool luaPedanticMode = false;
     bool luaDebugGeometry = false;
+    std::string serverSocket;
+    std::string connectSocket;
+    std::string compileOutput;
+    bool stopServerRequested = false;
 
     for(int i=1; i<argc; i++)
     {
@@ -164,6 +274,26 @@ int main(int argc, char ** argv)
             luaTrace = true;
             continue;
         }
+        if (arg == "--lua-profile" )
+        {
+            // only "--lua-profile=<file>", since the file is optional
+            luaProfile = true;
+            luaProfileTrace = value;
+            continue;
+        }
+        if (arg == "--lua-cache-dir" || arg == "--lua-compile")
+        {
+            std::string &target = (arg == "--lua-cache-dir") ? luaCacheDir : compileOutput;
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    target = argv[i];
+            } else {
+                target = value;
+            }
+            continue;
+        }
         if (arg == "--lua-base-dir")
         {
             if (value.empty())
@@ -178,6 +308,24 @@ int main(int argc, char ** argv)
                 std::cerr << "Using custom base directory " << baseDir << std::endl;
             continue;
         }
+        if (arg == "--server" || arg == "--connect")
+        {
+            std::string &socketPath = (arg == "--server") ? serverSocket : connectSocket;
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    socketPath = argv[i];
+            } else {
+                socketPath = value;
+            }
+            continue;
+        }
+        if (arg == "--stop-server" )
+        {
+            stopServerRequested = true;
+            continue;
+        }
         if (arg == "--version" )
         {
             std::cout << "femmcli version " << FEMM_VERSION_STRING << "\n"
@@ -211,19 +359,37 @@ int main(int argc, char ** argv)
         }
         std::cout << "Command-line interpreter for FEMM-specific lua files.\n";
         std::cout << "\n";
-        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] --lua-script=<file.lua>\n";
+        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-profile[=<trace.json>]] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] [--lua-cache-dir=<dir>] --lua-script=<file.lua>\n";
+        std::cout << "       " << exe << " --lua-compile=<file.luac> --lua-script=<file.lua>\n";
+        std::cout << "       " << exe << " [options] --server=<socket> [--lua-script=<file.lua>]\n";
+        std::cout << "       " << exe << " --connect=<socket> (--lua-script=<file.lua>|--stop-server)\n";
         std::cout << "       " << exe << " [-h|--help] [--version]\n";
         std::cout << "\n";
         std::cout << "Command line arguments:\n";
         std::cout << " --lua-base-dir=<dir>     Set base directory for matlib.dat.\n";
         std::cout << "                          [default: " << baseDir << "]\n";
+        std::cout << " --lua-cache-dir=<dir>    Keep the precompiled lua files (including init.lua) in this existing directory,\n";
+        std::cout << "                          so that unchanged files are not parsed again.\n";
+        std::cout << " --lua-compile=<file.luac>\n";
+        std::cout << "                          Precompile the lua script to the given file instead of executing it;\n";
+        std::cout << "                          the precompiled file can be executed with --lua-script.\n";
         std::cout << " --lua-debug-geometry     Debug lua functions that change the geometry of the model\n";
         std::cout << " --lua-init=<init.lua>    Initialize the lua state with a custom lua script.\n";
         std::cout << "                          [default: " << luaInit <<"]\n";
         std::cout << " --lua-pedantic-mode      Additional checks for lua scripts.\n";
+        std::cout << " --lua-profile[=<trace.json>]\n";
+        std::cout << "                          Show the time spent in each lua command and analysis phase;\n";
+        std::cout << "                          optionally write a trace file for chrome://tracing or ui.perfetto.dev.\n";
         std::cout << " --lua-script=<file.lua>  Execute the lua file.\n";
         std::cout << " --lua-trace-functions    Show what lua functions are being executed.\n";
         std::cout << "\n";
+        std::cout << "Server mode:\n";
+        std::cout << " --server=<socket>        Keep running and execute the lua files sent to the unix domain socket;\n";
+        std::cout << "                          each file runs in a copy of the initialized state.\n";
+        std::cout << "                          A lua script given with --lua-script is executed once before, e.g. to load problems.\n";
+        std::cout << " --connect=<socket>       Send the lua script to a femmcli server and show its output.\n";
+        std::cout << " --stop-server            Together with --connect: stop the server.\n";
+        std::cout << "\n";
         std::cout << "Additional options:\n";
         std::cout << " -h, --help               Show this help message and exit.\n";
         std::cout << " -q, --quiet              Be somewhat less verbose.\n";
@@ -239,13 +405,46 @@ int main(int argc, char ** argv)
         std::cout << "is the same as:\n";
         std::cout << " \"femmcli --lua-script file.lua\"\n";
         std::cout << "\n";
+        std::cout << "To find out where the time of a script is spent:\n";
+        std::cout << " \"femmcli --lua-profile=trace.json --lua-script=file.lua\"\n";
+        std::cout << "\n";
+        std::cout << "To skip parsing a script that is run many times:\n";
+        std::cout << " \"femmcli --lua-compile=file.luac --lua-script=file.lua\"\n";
+        std::cout << " \"femmcli --lua-script=file.luac\"\n";
+        std::cout << "\n";
+        std::cout << "To run many short scripts without starting femmcli for each of them:\n";
+        std::cout << " \"femmcli --server=/tmp/femmcli.sock &\"\n";
+        std::cout << " \"femmcli --connect=/tmp/femmcli.sock --lua-script=file.lua\"\n";
+        std::cout << " \"femmcli --connect=/tmp/femmcli.sock --stop-server\"\n";
+        std::cout << "\n";
         return exitval;
     }
+    if (!compileOutput.empty())
+    {
+        if (inputFile.empty())
+        {
+            std::cerr << "No file name given! Try \"femmcli --help\"...\n";
+            return 1;
+        }
+        return compileLuaFile(inputFile, compileOutput);
+    }
+    if (!serverSocket.empty())
+    {
+        return execServer(serverSocket, inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry);
+    }
+    if (!connectSocket.empty() && stopServerRequested)
+    {
+        return stopServer(connectSocket);
+    }
     if (inputFile.empty())
     {
         std::cerr << "No file name given! Try \"femmcli --help\"...\n";
         return 1;
     }
+    if (!connectSocket.empty())
+    {
+        return runClient(connectSocket, inputFile);
+    }
 
     return execLuaFile(inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry);
 }
@@ -0,0 +1,214 @@
+-- femmcli_addgeometry.lua
+-- Build a problem with single mi_add* commands and with a single mi_addgeometry() call,
+-- and check that both give the same results; likewise for an electrostatics problem with ei_addgeometry().
+-- Invalid tables must raise an error.
+-- Output:
+-- SUCCESS
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+function setup(name)
+	newdocument(0)
+	mi_probdef(0,"millimeters","planar",1e-8,10,30)
+	mi_addmaterial("Air",1,1,0)
+	mi_addmaterial("Iron",1000,1000,0)
+	mi_addmaterial("Coil",1,1,0)
+	mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+	mi_addcircprop("I",1,1)
+	mi_saveas(name)
+end
+
+function solve()
+	mi_analyze(1)
+	mi_loadsolution()
+	local A,B1,B2 = mo_getpointvalues(0,6)
+	mo_groupselectblock()
+	local W = mo_blockintegral(2)
+	mo_clearblock()
+	mo_close()
+	return A,B1,B2,W
+end
+
+function readfile(name)
+	readfrom(name)
+	local text = read("*a")
+	readfrom()
+	return text
+end
+
+-- number of entities of the given kind (e.g. "NumPoints") in a saved problem file
+function entityCount(file, kind)
+	local _,_,n = strfind(readfile(file), "%[" .. kind .. "%] = (%d+)")
+	return tonumber(n)
+end
+
+-- check that calling f with the given arguments raises an error
+function checkError(name, f, args)
+	if call(f, args, "x", function(msg) end) ~= nil then
+		print("[FAILED] " .. name .. " did not raise an error")
+		return 1
+	end
+	print("[  ok  ] " .. name .. " raised an error")
+	return 0
+end
+
+showconsole()
+
+-- reference: single commands
+setup("femmcli_addgeometry.ref.fem")
+mi_addnode(-20,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(-20,20)
+mi_addsegment(-20,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,-20,20)
+mi_addsegment(-20,20,-20,-20)
+for i=0,3 do
+	mi_selectsegment(20*cos(i*PI/2),20*sin(i*PI/2))
+end
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+mi_addnode(-4,0)
+mi_addnode(4,0)
+mi_addarc(-4,0,4,0,180,5)
+mi_addarc(4,0,-4,0,180,5)
+-- same order as in the tables below, so that both problems get the same mesh
+for s=1,-1,-2 do
+	mi_addnode(s*8,-3)
+	mi_addnode(s*11,-3)
+	mi_addnode(s*11,3)
+	mi_addnode(s*8,3)
+	mi_addsegment(s*8,-3,s*11,-3)
+	mi_addsegment(s*11,-3,s*11,3)
+	mi_addsegment(s*11,3,s*8,3)
+	mi_addsegment(s*8,3,s*8,-3)
+end
+mi_addblocklabel(0,15)
+mi_selectlabel(0,15)
+mi_setblockprop("Air",0,0.5,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0,0)
+mi_selectlabel(0,0)
+mi_setblockprop("Iron",0,0.3,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(9.5,0)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.3,"I",0,0,10)
+mi_clearselected()
+mi_addblocklabel(-9.5,0)
+mi_selectlabel(-9.5,0)
+mi_setblockprop("Coil",0,0.3,"I",0,0,-10)
+mi_clearselected()
+A,B1,B2,W = solve()
+
+-- the same geometry from tables
+setup("femmcli_addgeometry.result.fem")
+nodes = {
+	{-20,-20}, {20,-20}, {20,20}, {-20,20},
+	{-4,0}, {4,0},
+	{8,-3}, {11,-3}, {11,3}, {8,3},
+	{-8,-3}, {-11,-3}, {-11,3}, {-8,3},
+	{20,-20}, -- coincides with node 2
+}
+segments = {
+	{1,15,"A=0",0,1,0,0}, {2,3,"A=0",0,1,0,0}, {3,4,"A=0",0,1,0,0}, {4,1,"A=0",0,1,0,0},
+	{7,8}, {8,9}, {9,10}, {10,7},
+	{11,12}, {12,13}, {13,14}, {14,11},
+}
+arcs = {
+	{5,6,180,5}, {6,5,180,5},
+}
+labels = {
+	{0,15,"Air",0,0.5,"",0,0,0},
+	{0,0,"Iron",0,0.3,"",0,0,0},
+	{9.5,0,"Coil",0,0.3,"I",0,0,10},
+	{-9.5,0,"Coil",0,0.3,"I",0,0,-10},
+}
+mi_addgeometry({nodes=nodes, segments=segments, arcs=arcs, labels=labels})
+A2,B12,B22,W2 = solve()
+
+failed=0
+failed= failed +check("A", A2, A, 1e-6)
+failed= failed +check("B2", B22, B2, 1e-6)
+failed= failed +check("W", W2, W, 1e-6)
+-- the duplicate of node 2 was not added:
+failed= failed +check("number of nodes", entityCount("femmcli_addgeometry.result.fem", "NumPoints"), 14, 0)
+failed= failed +check("number of segments", entityCount("femmcli_addgeometry.result.fem", "NumSegments"), 12, 0)
+
+-- invalid tables
+failed= failed +checkError("invalid node index", mi_addgeometry, {{nodes={{0,0},{1,0}}, segments={{1,3}}}})
+failed= failed +checkError("entry that is not a table", mi_addgeometry, {{nodes={{0,0},5}}})
+mi_close()
+
+-- electrostatics: a plate capacitor
+function esetup(name)
+	newdocument(1)
+	ei_probdef("millimeters","planar",1e-8,1,30)
+	ei_addmaterial("Air",1,1,0)
+	ei_addconductorprop("V0",0,0,1)
+	ei_addconductorprop("V1",1,0,1)
+	ei_saveas(name)
+end
+
+function esolve()
+	ei_analyze(1)
+	ei_loadsolution()
+	local V = eo_getpointvalues(5,3)
+	eo_groupselectblock()
+	local W = eo_blockintegral(0)
+	eo_close()
+	return V,W
+end
+
+esetup("femmcli_addgeometry.ref.fee")
+ei_addnode(0,0)
+ei_addnode(10,0)
+ei_addnode(10,5)
+ei_addnode(0,5)
+ei_addsegment(0,0,10,0)
+ei_addsegment(10,0,10,5)
+ei_addsegment(10,5,0,5)
+ei_addsegment(0,5,0,0)
+ei_selectsegment(5,0)
+ei_setsegmentprop("",0,1,0,0,"V0")
+ei_clearselected()
+ei_selectsegment(5,5)
+ei_setsegmentprop("",0,1,0,0,"V1")
+ei_clearselected()
+ei_addblocklabel(5,2.5)
+ei_selectlabel(5,2.5)
+ei_setblockprop("Air",0,0.2,0)
+ei_clearselected()
+V,W = esolve()
+
+esetup("femmcli_addgeometry.result.fee")
+ei_addgeometry({
+	nodes = { {0,0}, {10,0}, {10,5}, {0,5} },
+	segments = {
+		{1,2,"",0,1,0,0,"V0"}, {2,3}, {3,4,"",0,1,0,0,"V1"}, {4,1},
+	},
+	labels = { {5,2.5,"Air",0,0.2,0} },
+})
+V2,W2 = esolve()
+failed= failed +check("V (electrostatics)", V2, V, 1e-6)
+failed= failed +check("W (electrostatics)", W2, W, 1e-6)
+failed= failed +check("number of nodes (electrostatics)", entityCount("femmcli_addgeometry.result.fee", "NumPoints"), 4, 0)
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
@@ -0,0 +1,70 @@
+-- femmcli_batch.lua
+-- Add a grid of crossing lines in batch mode and check that the intersections are resolved afterwards.
+-- OUTPUT:
+-- SUCCESS
+
+newdocument(0)
+n = 8
+
+mi_beginbatch()
+for i=0,n do
+	mi_addnode(0,i)
+	mi_addnode(n,i)
+	mi_addsegment(0,i,n,i)
+	mi_addnode(i,0)
+	mi_addnode(i,n)
+	mi_addsegment(i,0,i,n)
+end
+
+-- while the batch is active, the lines are not split:
+x,y = mi_selectnode(n/2+0.1,n/2+0.1)
+assert(abs(x-n/2) > 1e-6 or abs(y-n/2) > 1e-6)
+mi_clearselected()
+
+mi_endbatch()
+
+failed = 0
+for i=0,n do
+	for j=0,n do
+		x,y = mi_selectnode(i+0.1,j+0.1)
+		if abs(x-i) > 1e-6 or abs(y-j) > 1e-6 then
+			print("[FAILED] no node at (" .. i .. "," .. j .. ")")
+			failed = failed + 1
+		end
+	end
+end
+mi_clearselected()
+
+-- every intersection splits the lines, so the geometry can be meshed:
+mi_addblocklabel(n/2+0.5,n/2+0.5)
+mi_saveas("femmcli_batch.result.fem")
+mi_createmesh()
+
+-- saving the document ends an open batch, so the saved geometry is resolved:
+mi_beginbatch()
+mi_addnode(0.5,0)
+mi_addnode(0.5,n)
+mi_addsegment(0.5,0,0.5,n)
+mi_saveas("femmcli_batch.result.fem")
+x,y = mi_selectnode(0.6,n/2+0.1)
+if abs(x-0.5) > 1e-6 or abs(y-n/2) > 1e-6 then
+	print("[FAILED] mi_saveas did not end the batch")
+	failed = failed + 1
+end
+mi_clearselected()
+
+-- ... and so does meshing it:
+mi_beginbatch()
+mi_addnode(1.5,0)
+mi_addnode(1.5,n)
+mi_addsegment(1.5,0,1.5,n)
+mi_createmesh()
+x,y = mi_selectnode(1.6,n/2+0.1)
+if abs(x-1.5) > 1e-6 or abs(y-n/2) > 1e-6 then
+	print("[FAILED] mi_createmesh did not end the batch")
+	failed = failed + 1
+end
+mi_clearselected()
+
+assert(failed==0)
+write("SUCCESS\n")
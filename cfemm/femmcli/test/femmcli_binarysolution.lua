@@ -0,0 +1,152 @@
+-- femmcli_binarysolution.lua
+-- Solve a problem with a binary solution file (XFEMM_BINARY_SOLUTION),
+-- convert it to the text format, back, and to the compressed binary format with convertsolution,
+-- and check that all formats give the same results.
+-- Output:
+-- SUCCESS
+
+showconsole()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0)
+mi_addmaterial("Coil",1,1,0,2)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+
+-- air box
+mi_addnode(-20,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(-20,20)
+mi_addsegment(-20,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,-20,20)
+mi_addsegment(-20,20,-20,-20)
+for i=0,3 do
+	mi_selectsegment(20*cos(i*PI/2),20*sin(i*PI/2))
+end
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+
+-- iron disc
+mi_addnode(-4,0)
+mi_addnode(4,0)
+mi_addarc(-4,0,4,0,180,5)
+mi_addarc(4,0,-4,0,180,5)
+
+-- coil
+mi_addnode(8,-3)
+mi_addnode(11,-3)
+mi_addnode(11,3)
+mi_addnode(8,3)
+mi_addsegment(8,-3,11,-3)
+mi_addsegment(11,-3,11,3)
+mi_addsegment(11,3,8,3)
+mi_addsegment(8,3,8,-3)
+
+mi_addblocklabel(0,15)
+mi_selectlabel(0,15)
+mi_setblockprop("Air",0,1,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0,0)
+mi_selectlabel(0,0)
+mi_setblockprop("Iron",0,0.5,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(9.5,0)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.5,"",0,0,0)
+mi_clearselected()
+
+mi_saveas("femmcli_binarysolution.result.fem")
+
+function evaluate()
+	mi_loadsolution()
+	local A,B1,B2 = mo_getpointvalues(1.3,2.1)
+	mo_groupselectblock()
+	local W = mo_blockintegral(2)
+	mo_clearblock()
+	mo_close()
+	return A,B1,B2,W
+end
+
+function readfile(name)
+	readfrom(name)
+	local text = read("*a")
+	readfrom()
+	return text
+end
+
+failed=0
+function compare(name, value, expected)
+	if value ~= expected then
+		print("[FAILED] " .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+		failed = failed+1
+	end
+end
+
+ansFile = "femmcli_binarysolution.result.ans"
+textFile = "femmcli_binarysolution.result.txt.ans"
+binFile = "femmcli_binarysolution.result.bin.ans"
+
+XFEMM_BINARY_SOLUTION = 1
+mi_analyze(1)
+if strsub(readfile(ansFile),2,4) ~= "xfs" then
+	print("[FAILED] solution file is not binary")
+	failed = failed+1
+end
+A,B1,B2,W = evaluate()
+
+-- binary -> text
+convertsolution(ansFile, textFile)
+textSolution = readfile(textFile)
+if strsub(textSolution,2,4) == "xfs" then
+	print("[FAILED] converted solution file is not a text file")
+	failed = failed+1
+end
+-- text -> binary -> text gives the same file
+convertsolution(textFile, binFile)
+convertsolution(binFile, ansFile)
+if readfile(ansFile) ~= textSolution then
+	print("[FAILED] text -> binary -> text conversion changed the solution file")
+	failed = failed+1
+end
+
+-- values are stored exactly, so the text solution gives identical results
+At,B1t,B2t,Wt = evaluate()
+compare("A", At, A)
+compare("B1", B1t, B1)
+compare("B2", B2t, B2)
+compare("W", Wt, W)
+
+-- compressed tables are smaller, and give the same text file and results
+compFile = "femmcli_binarysolution.result.z.ans"
+convertsolution(textFile, compFile, "compressed")
+if strlen(readfile(compFile)) >= strlen(readfile(binFile)) then
+	print("[FAILED] compressed solution file is not smaller than the binary file")
+	failed = failed+1
+end
+convertsolution(compFile, ansFile, "text")
+if readfile(ansFile) ~= textSolution then
+	print("[FAILED] text -> compressed -> text conversion changed the solution file")
+	failed = failed+1
+end
+convertsolution(textFile, ansFile, "compressed")
+Az,B1z,B2z,Wz = evaluate()
+compare("A", Az, A)
+compare("B1", B1z, B1)
+compare("B2", B2z, B2)
+compare("W", Wz, W)
+
+-- the solver writes compressed files, too
+XFEMM_COMPRESS_SOLUTION = 1
+mi_analyze(1)
+convertsolution(ansFile, textFile, "text")
+if strsub(readfile(ansFile),2,4) ~= "xfs" or strlen(readfile(ansFile)) >= strlen(readfile(binFile)) then
+	print("[FAILED] solution file is not compressed")
+	failed = failed+1
+end
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
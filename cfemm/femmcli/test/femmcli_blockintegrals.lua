@@ -0,0 +1,169 @@
+-- femmcli_blockintegrals.lua
+-- Compute several block integrals with a single mo_blockintegral call,
+-- and check that the results match the values of single integral calls.
+-- Output:
+-- SUCCESS
+
+showconsole()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0,0,5)
+mi_addmaterial("Coil",1,1,0,2,58)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+
+-- air box
+mi_addnode(-20,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(-20,20)
+mi_addsegment(-20,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,-20,20)
+mi_addsegment(-20,20,-20,-20)
+for i=0,3 do
+	mi_selectsegment(20*cos(i*PI/2),20*sin(i*PI/2))
+end
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+
+-- iron disc
+mi_addnode(-4,0)
+mi_addnode(4,0)
+mi_addarc(-4,0,4,0,180,5)
+mi_addarc(4,0,-4,0,180,5)
+
+-- coil
+mi_addnode(8,-3)
+mi_addnode(11,-3)
+mi_addnode(11,3)
+mi_addnode(8,3)
+mi_addsegment(8,-3,11,-3)
+mi_addsegment(11,-3,11,3)
+mi_addsegment(11,3,8,3)
+mi_addsegment(8,3,8,-3)
+
+mi_addblocklabel(0,15)
+mi_selectlabel(0,15)
+mi_setblockprop("Air",0,1,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0,0)
+mi_selectlabel(0,0)
+mi_setblockprop("Iron",0,0.5,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(9.5,0)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.5,"",0,0,0)
+mi_clearselected()
+
+mi_saveas("femmcli_blockintegrals.result.fem")
+mi_analyze(1)
+mi_loadsolution()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+failed=0
+
+-- iron disc and coil
+mo_selectblock(0,0)
+mo_selectblock(9.5,0)
+W,S,P,Itot,V,Fx,Fy,Fhy = mo_blockintegral(2,5,6,7,10,11,12,19)
+failed = failed + check("energy", W, mo_blockintegral(2), 1e-8)
+failed = failed + check("area", S, mo_blockintegral(5), 1e-8)
+failed = failed + check("losses", P, mo_blockintegral(6), 1e-8)
+failed = failed + check("current", Itot, mo_blockintegral(7), 1e-8)
+failed = failed + check("volume", V, mo_blockintegral(10), 1e-8)
+failed = failed + check("Lorentz force x", Fx, mo_blockintegral(11), 1e-8)
+failed = failed + check("Lorentz force y", Fy+1, mo_blockintegral(12)+1, 1e-8)
+failed = failed + check("stress tensor force y", Fhy, mo_blockintegral(19), 1e-8)
+
+-- compare against the exact values for quantities that don't depend on the solution
+failed = failed + check("area (exact)", S, (PI*16 + 18)*1e-6, 0.5)
+failed = failed + check("current (exact)", Itot, 2e6*18e-6, 1e-6)
+
+mo_close()
+mi_close()
+
+-- axisymmetric integrals with a mesh that is large enough to be integrated by several threads;
+-- the result must not depend on the number of threads
+newdocument(0)
+mi_probdef(0,"millimeters","axi",1e-8,0,30)
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0,0,5)
+mi_addmaterial("Coil",1,1,0,2,58)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+mi_addnode(0,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(0,20)
+mi_addsegment(0,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,0,20)
+mi_addsegment(0,20,0,-20)
+mi_selectsegment(10,-20)
+mi_selectsegment(20,0)
+mi_selectsegment(10,20)
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+-- iron core
+mi_addnode(0,-6)
+mi_addnode(3,-6)
+mi_addnode(3,6)
+mi_addnode(0,6)
+mi_addsegment(0,-6,3,-6)
+mi_addsegment(3,-6,3,6)
+mi_addsegment(3,6,0,6)
+-- coil
+mi_addnode(6,-4)
+mi_addnode(9,-4)
+mi_addnode(9,4)
+mi_addnode(6,4)
+mi_addsegment(6,-4,9,-4)
+mi_addsegment(9,-4,9,4)
+mi_addsegment(9,4,6,4)
+mi_addsegment(6,4,6,-4)
+mi_addblocklabel(15,15)
+mi_selectlabel(15,15)
+mi_setblockprop("Air",0,0.1,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(1.5,0)
+mi_selectlabel(1.5,0)
+mi_setblockprop("Iron",0,0.1,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(7.5,0)
+mi_selectlabel(7.5,0)
+mi_setblockprop("Coil",0,0.1,"",0,0,0)
+mi_clearselected()
+mi_saveas("femmcli_blockintegrals.axi.result.fem")
+mi_analyze(1)
+mi_loadsolution()
+
+mo_groupselectblock()
+XFEMM_INTEGRAL_THREADS = 1
+W1,P1,V1,Fy1 = mo_blockintegral(2,0,10,12)
+XFEMM_INTEGRAL_THREADS = 4
+W4,P4,V4,Fy4 = mo_blockintegral(2,0,10,12)
+failed = failed + check("axisymmetric energy (4 threads)", W4, W1, 1e-10)
+failed = failed + check("axisymmetric A.J (4 threads)", P4, P1, 1e-10)
+failed = failed + check("axisymmetric volume (4 threads)", V4, V1, 1e-10)
+failed = failed + check("axisymmetric Lorentz force y (4 threads)", Fy4+1, Fy1+1, 1e-10)
+XFEMM_INTEGRAL_THREADS = nil
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
@@ -0,0 +1,94 @@
+# femmcli_bytecode.cmake
+# Check that femmcli_bytecode.lua can be precompiled with --lua-compile,
+# and that --lua-cache-dir keeps a precompiled copy that is used by the next run,
+# unless the script has been edited or the cached copy is corrupt.
+#
+# Usage: cmake -DFEMMCLI=<femmcli executable> -DSCRIPT_DIR=<test source directory> -P femmcli_bytecode.cmake
+
+set(workdir "${CMAKE_CURRENT_BINARY_DIR}/femmcli_bytecode")
+set(compiled "${workdir}/femmcli_bytecode.luac")
+set(cachedir "${workdir}/cache")
+file(REMOVE_RECURSE "${workdir}")
+file(MAKE_DIRECTORY "${cachedir}")
+
+set(failure "")
+macro(run_femmcli)
+    execute_process(COMMAND "${FEMMCLI}" -q --lua-base-dir "${SCRIPT_DIR}/../debug" ${ARGN}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE error
+        )
+    if(NOT result EQUAL 0 OR NOT output MATCHES "SUCCESS")
+        string(APPEND failure "femmcli ${ARGN} failed (${result}):\n${output}${error}\n")
+    endif()
+endmacro()
+
+# precompile, then run the precompiled file:
+execute_process(COMMAND "${FEMMCLI}" -q --lua-compile "${compiled}" --lua-script "${SCRIPT_DIR}/femmcli_bytecode.lua"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE error
+    )
+if(NOT result EQUAL 0 OR NOT EXISTS "${compiled}")
+    string(APPEND failure "--lua-compile failed (${result}):\n${output}${error}\n")
+else()
+    if(output MATCHES "SUCCESS")
+        string(APPEND failure "--lua-compile executed the script\n")
+    endif()
+    file(READ "${compiled}" header LIMIT 4 HEX)
+    if(NOT header STREQUAL "1b4c7561")
+        string(APPEND failure "${compiled} is not a precompiled chunk (header: ${header})\n")
+    endif()
+    run_femmcli(--lua-script "${compiled}")
+endif()
+
+# the first run fills the cache:
+set(script "${workdir}/femmcli_bytecode.lua")
+configure_file("${SCRIPT_DIR}/femmcli_bytecode.lua" "${script}" COPYONLY)
+run_femmcli(--lua-cache-dir "${cachedir}" --lua-script "${script}")
+file(GLOB cached "${cachedir}/*.luac")
+list(LENGTH cached numCached)
+if(NOT numCached EQUAL 1)
+    string(APPEND failure "expected one precompiled chunk in ${cachedir}, got: ${cached}\n")
+else()
+    # the next run uses the cache: replace the cached chunk by a different one, and check that it is executed
+    file(WRITE "${workdir}/marker.lua" "write(\"SUCCESS (from the cache)\\n\")\n")
+    execute_process(COMMAND "${FEMMCLI}" -q --lua-compile "${cached}" --lua-script "${workdir}/marker.lua"
+        RESULT_VARIABLE result
+        )
+    if(NOT result EQUAL 0)
+        string(APPEND failure "--lua-compile of marker.lua failed (${result})\n")
+    endif()
+    run_femmcli(--lua-cache-dir "${cachedir}" --lua-script "${script}")
+    if(NOT output MATCHES "from the cache")
+        string(APPEND failure "the second run did not use the cache:\n${output}\n")
+    endif()
+
+    # an edited script doesn't match the cached chunk:
+    file(APPEND "${script}" "-- edited\n")
+    run_femmcli(--lua-cache-dir "${cachedir}" --lua-script "${script}")
+    if(output MATCHES "from the cache")
+        string(APPEND failure "the edited script used the outdated cache entry\n")
+    endif()
+    file(GLOB cachedEdited "${cachedir}/*.luac")
+    list(LENGTH cachedEdited numCached)
+    if(NOT numCached EQUAL 2)
+        string(APPEND failure "the edited script was not cached: ${cachedEdited}\n")
+    else()
+        # a corrupt cache file is ignored, and replaced:
+        set(editedCache ${cachedEdited})
+        list(REMOVE_ITEM editedCache ${cached})
+        string(ASCII 27 escape)
+        file(WRITE "${editedCache}" "${escape}Lua (corrupt)")
+        run_femmcli(--lua-cache-dir "${cachedir}" --lua-script "${script}")
+        file(READ "${editedCache}" content HEX)
+        if(NOT content MATCHES "^1b4c7561" OR content STREQUAL "1b4c75612028636f727275707429")
+            string(APPEND failure "the corrupt cache file ${editedCache} was not replaced\n")
+        endif()
+    endif()
+endif()
+
+if(failure)
+    message(FATAL_ERROR "${failure}")
+endif()
+message("SUCCESS")
@@ -0,0 +1,30 @@
+-- femmcli_bytecode.lua
+-- run by femmcli_bytecode.cmake, both as source and precompiled
+-- OUTPUT:
+-- 3+I
+-- SUCCESS
+
+local z = Complex(2,1) + 1
+write(z .. "\n")
+assert( z == Complex(3,1) )
+
+-- nested functions, upvalues and string constants survive precompilation:
+function makeCounter(start)
+    local state = { count = start }
+    return function(step)
+        %state.count = %state.count + step
+        return %state.count
+    end
+end
+local counter = makeCounter(0.5)
+assert( counter(1) == 1.5 )
+
+local t = { name = "bytecode", values = {1, 2, 3} }
+local sum = 0
+for i = 1, getn(t.values) do
+    sum = sum + t.values[i]
+end
+assert( sum == 6 )
+assert( strupper(t.name) == "BYTECODE" )
+
+write("SUCCESS\n")
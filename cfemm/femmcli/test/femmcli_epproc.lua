@@ -41,5 +41,15 @@ failed= failed +check("ex", ex, 4, 0.1)
 failed= failed +check("ey", ey, 4, 0.1)
 failed= failed +check("nrg", nrg, 1.900419790445539e-008, 3)
 
+-- the same values for tables of points; the second point is outside of the mesh
+X = {0.250, 1e6, 0.3}
+Y = {0, 1e6, 0.1}
+V_,Dx_,Dy_,Ex_,Ey_,ex_,ey_,nrg_ = eo_getpointvalues(X,Y)
+assert(V_[1]==V and Dx_[1]==Dx and Dy_[1]==Dy and Ex_[1]==Ex and Ey_[1]==Ey)
+assert(ex_[1]==ex and ey_[1]==ey and nrg_[1]==nrg)
+assert(V_[2]==nil and nrg_[2]==nil)
+V3,Dx3,Dy3,Ex3,Ey3,ex3,ey3,nrg3 = eo_getpointvalues(0.3, 0.1)
+assert(V_[3]==V3 and Ex_[3]==Ex3 and nrg_[3]==nrg3)
+
 assert(failed==0)
 write("SUCCESS\n")
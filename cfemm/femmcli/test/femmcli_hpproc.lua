@@ -42,5 +42,15 @@ failed = failed + check("Gy", Gy, 5.399252187839117, 4)
 failed = failed + check("kx", kx, 0.02645021728882154, 2)
 failed = failed + check("ky", ky, 0.02645021728882154, 2)
 
+-- the same values for tables of points; the second point is outside of the mesh
+X = {1.1, 1e6, 1.2}
+Y = {1.1, 1e6, 1.0}
+T_,Fx_,Fy_,Gx_,Gy_,kx_,ky_ = ho_getpointvalues(X,Y)
+assert(T_[1]==T and Fx_[1]==Fx and Fy_[1]==Fy and Gx_[1]==Gx and Gy_[1]==Gy)
+assert(kx_[1]==kx and ky_[1]==ky)
+assert(T_[2]==nil and ky_[2]==nil)
+T3,Fx3,Fy3,Gx3,Gy3,kx3,ky3 = ho_getpointvalues(1.2, 1.0)
+assert(T_[3]==T3 and Fx_[3]==Fx3 and ky_[3]==ky3)
+
 assert(failed==0)
 write("SUCCESS\n")
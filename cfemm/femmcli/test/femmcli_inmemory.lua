@@ -0,0 +1,77 @@
+-- femmcli_inmemory.lua
+-- Solve a magnetics, an electrostatics and a heat flow problem with XFEMM_IN_MEMORY,
+-- check that the results are the same as with files on the disk,
+-- and that no solution file is written until it is saved with convertsolution.
+-- Output:
+-- SUCCESS
+showconsole()
+
+failed=0
+function compare(name, value, expected)
+	if value ~= expected then
+		print("[FAILED] " .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+		failed = failed+1
+	end
+end
+
+function exists(name)
+	if readfrom(name) then
+		readfrom()
+		return 1
+	end
+	return nil
+end
+
+-- solve the problem in <inputFile> twice, on the disk and in memory,
+-- and compare the values returned by evaluate();
+-- <p> is the command prefix ("m", "e" or "h")
+function check(p, inputFile, ext, ansExt, evaluate)
+	local femFile = "femmcli_inmemory.result" .. ext
+	local ansFile = "femmcli_inmemory.result" .. ansExt
+	local savedFile = "femmcli_inmemory.saved" .. ansExt
+	open(inputFile)
+	getglobal(p .. "i_saveas")(femFile)
+	remove(savedFile)
+
+	XFEMM_IN_MEMORY = nil
+	getglobal(p .. "i_analyze")(1)
+	getglobal(p .. "i_loadsolution")()
+	local v1,v2 = evaluate()
+	remove(ansFile)
+
+	XFEMM_IN_MEMORY = 1
+	getglobal(p .. "i_analyze")(1)
+	getglobal(p .. "i_loadsolution")()
+	local m1,m2 = evaluate()
+	compare(inputFile .. " value 1", m1, v1)
+	compare(inputFile .. " value 2", m2, v2)
+	if exists(ansFile) then
+		print("[FAILED] " .. inputFile .. ": in-memory solution was written to " .. ansFile)
+		failed = failed+1
+	end
+
+	-- the in-memory solution can be saved explicitly
+	convertsolution(ansFile, savedFile)
+	if not exists(savedFile) then
+		print("[FAILED] " .. inputFile .. ": in-memory solution could not be saved")
+		failed = failed+1
+	end
+	XFEMM_IN_MEMORY = nil
+end
+
+check("m", "femmcli_fpproc.fem", ".fem", ".ans", function()
+	local A,B1 = mo_getpointvalues(0.250, 0)
+	return A,B1
+end)
+check("e", "femmcli_epproc.fee", ".fee", ".res", function()
+	local V,Dx = eo_getpointvalues(0.250, 0)
+	return V,Dx
+end)
+check("h", "femmcli_hpproc.feh", ".feh", ".anh", function()
+	local T,Fx = ho_getpointvalues(1.1, 1.1)
+	return T,Fx
+end)
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
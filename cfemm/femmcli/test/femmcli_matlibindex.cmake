@@ -0,0 +1,59 @@
+# femmcli_matlibindex.cmake
+# Check that mi_getmaterial() creates an index next to the material library,
+# and that the index is rebuilt when the library changes, or is not used when it misses a material.
+#
+# Usage: cmake -DFEMMCLI=<femmcli executable> -DSCRIPT_DIR=<test source directory> -P femmcli_matlibindex.cmake
+
+set(libdir "${CMAKE_CURRENT_BINARY_DIR}/femmcli_matlibindex")
+set(matlib "${libdir}/matlib.dat")
+set(index "${matlib}.idx")
+file(REMOVE_RECURSE "${libdir}")
+file(MAKE_DIRECTORY "${libdir}")
+configure_file("${SCRIPT_DIR}/../debug/matlib.dat" "${matlib}" COPYONLY)
+
+set(failure "")
+macro(run_femmcli script)
+    execute_process(COMMAND "${FEMMCLI}" -q --lua-base-dir "${libdir}" --lua-script "${script}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE error
+        )
+    if(NOT result EQUAL 0 OR NOT output MATCHES "SUCCESS")
+        string(APPEND failure "${script} failed (${result}):\n${output}${error}\n")
+    endif()
+endmacro()
+
+run_femmcli("${SCRIPT_DIR}/femmcli_matlibindex.lua")
+if(NOT EXISTS "${index}")
+    string(APPEND failure "index ${index} was not written\n")
+else()
+    file(READ "${index}" content)
+    if(NOT content MATCHES "\n[0-9]+ 1010 Steel\n")
+        string(APPEND failure "\"1010 Steel\" is missing in the index:\n${content}\n")
+    endif()
+endif()
+
+# the index must not hide materials added to the library later on:
+file(APPEND "${matlib}" "<BeginBlock>\n<BlockName> = \"Index Test\"\n<Mu_x> = 7\n<Mu_y> = 7\n<EndBlock>\n")
+set(script "${libdir}/femmcli_matlibindex_added.lua")
+file(WRITE "${script}" "newdocument(0)\nmi_getmaterial(\"Index Test\")\nmi_getmaterial(\"Air\")\nwrite(\"SUCCESS\\n\")\n")
+run_femmcli("${script}")
+file(READ "${index}" content)
+if(NOT content MATCHES "\n[0-9]+ Index Test\n")
+    string(APPEND failure "the index was not updated:\n${content}\n")
+endif()
+
+# a material that the index does not list is searched in the library, even if its size and time stamp are unchanged:
+if(UNIX)
+    file(TIMESTAMP "${matlib}" mtime "%s" UTC)
+    execute_process(COMMAND sed -e "s/\"Index Test\"/\"Index Tesu\"/" "${matlib}" OUTPUT_FILE "${matlib}.new")
+    file(RENAME "${matlib}.new" "${matlib}")
+    execute_process(COMMAND touch -d "@${mtime}" "${matlib}")
+    file(WRITE "${script}" "newdocument(0)\nmi_getmaterial(\"Index Tesu\")\nwrite(\"SUCCESS\\n\")\n")
+    run_femmcli("${script}")
+endif()
+
+if(failure)
+    message(FATAL_ERROR "${failure}")
+endif()
+message("SUCCESS")
@@ -0,0 +1,12 @@
+-- femmcli_matlibindex.lua
+-- Load some materials from the library; run by femmcli_matlibindex.cmake, which checks the library index.
+-- OUTPUT:
+-- SUCCESS
+
+newdocument(0)
+mi_getmaterial("Air")
+mi_getmaterial("1010 Steel")
+mi_getmaterial("Copper")
+mi_saveas("femmcli_matlibindex.result.fem")
+
+write("SUCCESS\n")
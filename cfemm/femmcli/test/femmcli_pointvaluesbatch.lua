@@ -0,0 +1,135 @@
+-- femmcli_pointvaluesbatch.lua
+-- Evaluate mo_getpointvalues, mo_geta and mo_getb for tables of coordinates,
+-- and check that the results match the values of single point calls.
+-- Output:
+-- SUCCESS
+
+showconsole()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0)
+mi_addmaterial("Coil",1,1,0,2)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+
+-- air box
+mi_addnode(-20,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(-20,20)
+mi_addsegment(-20,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,-20,20)
+mi_addsegment(-20,20,-20,-20)
+for i=0,3 do
+	mi_selectsegment(20*cos(i*PI/2),20*sin(i*PI/2))
+end
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+
+-- iron disc
+mi_addnode(-4,0)
+mi_addnode(4,0)
+mi_addarc(-4,0,4,0,180,5)
+mi_addarc(4,0,-4,0,180,5)
+
+-- coil
+mi_addnode(8,-3)
+mi_addnode(11,-3)
+mi_addnode(11,3)
+mi_addnode(8,3)
+mi_addsegment(8,-3,11,-3)
+mi_addsegment(11,-3,11,3)
+mi_addsegment(11,3,8,3)
+mi_addsegment(8,3,8,-3)
+
+mi_addblocklabel(0,15)
+mi_selectlabel(0,15)
+mi_setblockprop("Air",0,1,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0,0)
+mi_selectlabel(0,0)
+mi_setblockprop("Iron",0,0.5,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(9.5,0)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.5,"",0,0,0)
+mi_clearselected()
+
+mi_saveas("femmcli_pointvaluesbatch.result.fem")
+mi_analyze(1)
+mi_loadsolution()
+
+-- a grid of points; the last row is outside of the problem region
+X = {}
+Y = {}
+n = 0
+for i=0,40 do
+	for j=0,40 do
+		n = n+1
+		X[n] = -19.73 + 0.9731*i
+		Y[n] = -19.87 + 0.9917*j
+	end
+end
+for i=1,10 do
+	n = n+1
+	X[n] = 25 + i
+	Y[n] = 0.5
+end
+
+A,B1,B2,Sig,E,H1,H2,Je,Js,Mu1,Mu2,Pe,Ph,ff = mo_getpointvalues(X,Y)
+
+failed=0
+function compare(name, value, expected, i)
+	if expected == nil then
+		if value ~= nil then
+			print("[FAILED] " .. name .. "[" .. i .. "]: " .. value .. " (expected: nil)")
+			failed = failed+1
+		end
+		return
+	end
+	if value == nil or abs(value - expected) > 1e-9*abs(expected) then
+		print("[FAILED] " .. name .. "[" .. i .. "]: " .. tostring(value) .. " (expected: " .. expected .. ")")
+		failed = failed+1
+	end
+end
+
+outside=0
+for i=1,n do
+	a,b1,b2,sig,e,h1,h2,je,js,mu1,mu2,pe,ph,f = mo_getpointvalues(X[i],Y[i])
+	if a == nil then
+		outside = outside+1
+	end
+	compare("A", A[i], a, i)
+	compare("B1", B1[i], b1, i)
+	compare("B2", B2[i], b2, i)
+	compare("E", E[i], e, i)
+	compare("H1", H1[i], h1, i)
+	compare("H2", H2[i], h2, i)
+	compare("Je", Je[i], je, i)
+	compare("Mu1", Mu1[i], mu1, i)
+	compare("Mu2", Mu2[i], mu2, i)
+	compare("ff", ff[i], f, i)
+end
+
+-- mo_geta and mo_getb select values of mo_getpointvalues
+AA = mo_geta(X,Y)
+BB1,BB2 = mo_getb(X,Y)
+for i=1,n do
+	compare("mo_geta", AA[i], A[i], i)
+	compare("mo_getb B1", BB1[i], B1[i], i)
+	compare("mo_getb B2", BB2[i], B2[i], i)
+end
+a,b1,b2 = mo_getpointvalues(X[1],Y[1])
+compare("mo_geta", mo_geta(X[1],Y[1]), a, 1)
+bb1,bb2 = mo_getb(X[1],Y[1])
+compare("mo_getb B1", bb1, b1, 1)
+compare("mo_getb B2", bb2, b2, 1)
+
+print("points: " .. n .. ", outside: " .. outside .. ", mismatches: " .. failed)
+
+assert(outside==10)
+assert(failed==0)
+write("SUCCESS\n")
+quit()
@@ -0,0 +1,38 @@
+# femmcli_profile.cmake
+# Run femmcli_profile.lua with profiling enabled, and check the summary and the trace file.
+#
+# Usage: cmake -DFEMMCLI=<femmcli executable> -DSCRIPT_DIR=<test source directory> -P femmcli_profile.cmake
+
+set(trace "femmcli_profile.result.json")
+file(REMOVE "${trace}")
+
+execute_process(COMMAND "${FEMMCLI}" -q --lua-base-dir "${SCRIPT_DIR}/../debug"
+    --lua-profile=${trace} --lua-script "${SCRIPT_DIR}/femmcli_profile.lua"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE error
+    )
+
+set(failure "")
+if(NOT result EQUAL 0 OR NOT output MATCHES "SUCCESS")
+    string(APPEND failure "script failed (${result}):\n${output}${error}\n")
+endif()
+# the summary lists the lua commands and the analysis phases:
+foreach(name ei_analyze eo_getpointvalues save mesh load renumber assemble solve write)
+    if(NOT error MATCHES "\n${name} ")
+        string(APPEND failure "\"${name}\" is missing in the profile summary\n")
+    endif()
+endforeach()
+if(NOT EXISTS "${trace}")
+    string(APPEND failure "trace file ${trace} was not written\n")
+else()
+    file(READ "${trace}" json)
+    if(NOT json MATCHES "^{\"traceEvents\":\\[" OR NOT json MATCHES "\"name\":\"ei_analyze\",\"cat\":\"lua\",\"ph\":\"X\"")
+        string(APPEND failure "unexpected trace file content:\n${json}\n")
+    endif()
+endif()
+
+if(failure)
+    message(FATAL_ERROR "${failure}\nprofile summary:\n${error}")
+endif()
+message("SUCCESS")
@@ -0,0 +1,14 @@
+-- femmcli_profile.lua
+-- Run an electrostatics analysis; femmcli_profile.cmake runs this with --lua-profile
+-- and checks the profile.
+-- SUCCESS
+
+open("femmcli_epproc.fee")
+ei_analyze(0)
+ei_loadsolution()
+V = eo_getpointvalues(0.250, 0)
+print("V = " .. V)
+if V == nil then
+	error("no point value")
+end
+print("SUCCESS")
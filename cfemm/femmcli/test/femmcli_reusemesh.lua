@@ -0,0 +1,149 @@
+-- femmcli_reusemesh.lua
+-- Solve a problem with XFEMM_REUSE_MESH after changing a material and after changing a mesh size,
+-- and check that the results are the same as with a new mesh,
+-- and that XFEMM_MESH_REUSED reports whether the mesh and the node numbering have been reused.
+-- Output:
+-- SUCCESS
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+-- check that XFEMM_MESH_REUSED has the <expected> value
+function checkReused(name, expected)
+	if XFEMM_MESH_REUSED ~= expected then
+		print("[FAILED] " .. name .. ": XFEMM_MESH_REUSED is " .. XFEMM_MESH_REUSED .. " (expected: " .. expected .. ")")
+		return 1
+	end
+	print("[  ok  ] " .. name .. ": XFEMM_MESH_REUSED is " .. expected)
+	return 0
+end
+
+showconsole()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0)
+mi_addmaterial("Coil",1,1,0,2)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+
+-- air box
+mi_addnode(-20,-20)
+mi_addnode(20,-20)
+mi_addnode(20,20)
+mi_addnode(-20,20)
+mi_addsegment(-20,-20,20,-20)
+mi_addsegment(20,-20,20,20)
+mi_addsegment(20,20,-20,20)
+mi_addsegment(-20,20,-20,-20)
+for i=0,3 do
+	mi_selectsegment(20*cos(i*PI/2),20*sin(i*PI/2))
+end
+mi_setsegmentprop("A=0",0,1,0,0)
+mi_clearselected()
+
+-- iron disc
+mi_addnode(-4,0)
+mi_addnode(4,0)
+mi_addarc(-4,0,4,0,180,5)
+mi_addarc(4,0,-4,0,180,5)
+
+-- coil side
+mi_addnode(8,-3)
+mi_addnode(11,-3)
+mi_addnode(11,3)
+mi_addnode(8,3)
+mi_addsegment(8,-3,11,-3)
+mi_addsegment(11,-3,11,3)
+mi_addsegment(11,3,8,3)
+mi_addsegment(8,3,8,-3)
+
+mi_addblocklabel(0,15)
+mi_selectlabel(0,15)
+mi_setblockprop("Air",0,0.5,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0,0)
+mi_selectlabel(0,0)
+mi_setblockprop("Iron",0,0.3,"",0,0,0)
+mi_clearselected()
+mi_addblocklabel(9.5,0)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.3,"",0,0,0)
+mi_clearselected()
+
+mi_saveas("femmcli_reusemesh.result.fem")
+
+function solve(reuse)
+	XFEMM_REUSE_MESH = reuse
+	mi_analyze(1)
+	mi_loadsolution()
+	local A = mo_getpointvalues(0,6)
+	mo_groupselectblock()
+	local W = mo_blockintegral(2)
+	mo_clearblock()
+	mo_close()
+	return A,W
+end
+
+failed=0
+A1,W1 = solve(1)
+failed= failed +checkReused("first analysis", 0)
+
+-- a new material doesn't change the mesh:
+mi_modifymaterial("Iron",1,200)
+mi_modifymaterial("Iron",2,200)
+A2,W2 = solve(1)
+failed= failed +checkReused("material changed", 2)
+A2new,W2new = solve(0)
+failed= failed +checkReused("without XFEMM_REUSE_MESH", 0)
+failed= failed +check("A (material changed)", A2, A2new, 1e-6)
+failed= failed +check("W (material changed)", W2, W2new, 1e-6)
+if A2 == A1 then
+	print("[FAILED] the result did not change with the material")
+	failed= failed +1
+end
+
+-- a new mesh size does:
+A3,W3 = solve(1)
+mi_selectlabel(9.5,0)
+mi_setblockprop("Coil",0,0.2,"",0,0,0)
+mi_clearselected()
+A4,W4 = solve(1)
+failed= failed +checkReused("mesh size changed", 0)
+A4new,W4new = solve(0)
+failed= failed +check("A (mesh size changed)", A4, A4new, 1e-6)
+failed= failed +check("W (mesh size changed)", W4, W4new, 1e-6)
+if W4 == W3 then
+	print("[FAILED] the mesh did not change with the mesh size")
+	failed= failed +1
+end
+
+-- a mesh kept by mi_createmesh() has no node numbering yet; the first analysis computes it, the next one reuses it
+XFEMM_REUSE_MESH = 1
+mi_createmesh()
+failed= failed +checkReused("mi_createmesh", 0)
+mi_createmesh()
+failed= failed +checkReused("mi_createmesh again", 1)
+A5,W5 = solve(1)
+failed= failed +checkReused("analysis after mi_createmesh", 1)
+A6,W6 = solve(1)
+failed= failed +checkReused("second analysis after mi_createmesh", 2)
+failed= failed +check("A (node numbering reused)", A6, A4new, 1e-6)
+failed= failed +check("W (node numbering reused)", W6, W4new, 1e-6)
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
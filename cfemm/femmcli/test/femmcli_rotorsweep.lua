@@ -0,0 +1,57 @@
+-- femmcli_rotorsweep.lua
+-- Checks that mi_sweeprotor gives the same torques as
+-- running mi_analyze separately for each rotor position.
+-- Output:
+-- SUCCESS
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the absolute or relative difference is greater than the margin, complain and return 1
+-- if the expected value is 0, the relative margin is ignored
+-- relative margin is in percent
+function check(name, value, expected, marginAbs, marginRel)
+   diff=value - expected
+   diffRel=0
+   if (expected~=0) then
+      diffRel=100*diff/expected
+   end
+   if abs(diff) > marginAbs or abs(diffRel) > marginRel then
+      fail=1
+      result="[FAILED] "
+   else
+      fail=0
+      result="[  ok  ] "
+   end
+   print(result .. name .. ": " .. value .. " (expected: " .. expected
+   .. ", diff: " .. diff .. " [" .. diffRel .. "%]"
+      .. ", margin: " .. marginAbs .. " [" .. marginRel .. "%])")
+   return fail
+end
+
+show_console()
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+
+mi_saveas("femmcli_rotorsweep.result.fem")
+mi_modifyboundprop("AGE", 11, 0);
+
+tolerance = 1e-4
+tolerance_rel = 0.1
+
+failed=0
+sweep = mi_sweeprotor("AGE", 0, 30, 4)
+for idx = 1, 4, 1 do
+    angle = (idx-1)*30
+    failed = failed + check("angle @ " .. angle .. " degrees", sweep[idx].angle, angle, 0, 0)
+
+    mi_modifyboundprop("AGE", 10, angle);
+    mi_analyze(1)
+    mi_loadsolution()
+    expected = mo_gapintegral("AGE", 0)
+    mo_close()
+
+    failed = failed + check("|T| @ " .. angle .. " degrees", sweep[idx].torque, expected, tolerance, tolerance_rel)
+end
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
@@ -0,0 +1,59 @@
+# femmcli_server.cmake
+# Start a femmcli server, run femmcli_server.lua twice and a failing script once through it,
+# and stop the server again.
+#
+# Usage: cmake -DFEMMCLI=<femmcli executable> -DSCRIPT_DIR=<test source directory> -P femmcli_server.cmake
+
+set(socket "femmcli_server.sock")
+set(femmcli_args -q --lua-base-dir "${SCRIPT_DIR}/../debug")
+file(REMOVE "${socket}")
+
+execute_process(COMMAND sh -c "exec \"$0\" \"$@\" > femmcli_server.log 2>&1 &"
+    "${FEMMCLI}" ${femmcli_args} --server=${socket} --lua-script "${SCRIPT_DIR}/femmcli_server_preload.lua"
+    )
+foreach(i RANGE 100)
+    if(EXISTS "${socket}")
+        break()
+    endif()
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+
+set(failure "")
+if(NOT EXISTS "${socket}")
+    file(READ femmcli_server.log log)
+    message(FATAL_ERROR "femmcli server did not start:\n${log}")
+endif()
+
+foreach(run 1 2)
+    execute_process(COMMAND "${FEMMCLI}" --connect=${socket} --lua-script "${SCRIPT_DIR}/femmcli_server.lua"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE error
+        )
+    if(NOT result EQUAL 0 OR NOT output MATCHES "SUCCESS")
+        string(APPEND failure "request ${run} failed (${result}):\n${output}${error}\n")
+    endif()
+endforeach()
+
+# the exit status and error messages of a failing script are passed on
+file(WRITE femmcli_server_error.lua "error(\"expected failure\")\n")
+execute_process(COMMAND "${FEMMCLI}" --connect=${socket} --lua-script femmcli_server_error.lua
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE error
+    )
+if(result EQUAL 0 OR NOT error MATCHES "expected failure")
+    string(APPEND failure "failing request was not reported (${result}):\n${output}${error}\n")
+endif()
+
+execute_process(COMMAND "${FEMMCLI}" --connect=${socket} --stop-server
+    RESULT_VARIABLE result
+    )
+if(NOT result EQUAL 0)
+    string(APPEND failure "stopping the server failed (${result})\n")
+endif()
+
+if(failure)
+    message(FATAL_ERROR "${failure}")
+endif()
+message("SUCCESS")
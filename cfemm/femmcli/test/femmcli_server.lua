@@ -0,0 +1,19 @@
+-- femmcli_server.lua
+-- Executed twice by the femmcli server started by femmcli_server.cmake:
+-- each request must see the state of the preload script,
+-- but not the changes made by an earlier request.
+-- Output:
+-- SUCCESS
+
+assert(preloaded == 42)
+assert(requestSeen == nil)
+requestSeen = 1
+
+-- the problem opened by the preload script is still unchanged
+local xmin,xmax,ymin,ymax = mi_getboundingbox()
+assert(xmax < 1)
+mi_addnode(2,0)
+xmin,xmax,ymin,ymax = mi_getboundingbox()
+assert(xmax >= 2)
+
+write("SUCCESS\n")
@@ -0,0 +1,5 @@
+-- femmcli_server_preload.lua
+-- Executed once by the femmcli server started by femmcli_server.cmake,
+-- before it serves any request.
+open("femmcli_fpproc.fem")
+preloaded = 42
@@ -0,0 +1,121 @@
+-- femmcli_snapshot.lua
+-- Take a snapshot of a geometry, modify the geometry and restore it again,
+-- and check that the restored geometry gives the same results as the original one.
+-- Output:
+-- SUCCESS
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+function solve()
+	mi_analyze(1)
+	mi_loadsolution()
+	mo_groupselectblock()
+	local W = mo_blockintegral(2)
+	mo_clearblock()
+	mo_close()
+	return W
+end
+
+showconsole()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+mi_addmaterial("Air",1,1,0)
+mi_addmaterial("Iron",1000,1000,0)
+mi_addmaterial("Coil",1,1,0)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+mi_addcircprop("I",1,1)
+mi_saveas("femmcli_snapshot.result.fem")
+
+mi_addgeometry({
+	nodes = {
+		{-20,-20}, {20,-20}, {20,20}, {-20,20},
+		{-4,0}, {4,0},
+		{8,-3}, {11,-3}, {11,3}, {8,3},
+		{-8,-3}, {-11,-3}, {-11,3}, {-8,3},
+	},
+	segments = {
+		{1,2,"A=0",0,1,0,0}, {2,3,"A=0",0,1,0,0}, {3,4,"A=0",0,1,0,0}, {4,1,"A=0",0,1,0,0},
+		{7,8}, {8,9}, {9,10}, {10,7},
+		{11,12}, {12,13}, {13,14}, {14,11},
+	},
+	arcs = {
+		{5,6,180,5,"",0,1}, {6,5,180,5,"",0,1},
+	},
+	labels = {
+		{0,15,"Air",0,0.5,"",0,0,0},
+		{0,0,"Iron",0,0.3,"",0,1,0},
+		{9.5,0,"Coil",0,0.3,"I",0,0,10},
+		{-9.5,0,"Coil",0,0.3,"I",0,0,-10},
+	},
+})
+mi_savesnapshot("base")
+W0 = solve()
+
+-- move the iron disc (group 1) to the right
+failed=0
+for i=1,3 do
+	mi_restoresnapshot("base")
+	mi_selectgroup(1)
+	mi_movetranslate(i,0)
+	mi_clearselected()
+	x,y = mi_selectnode(i-4,0)
+	mi_clearselected()
+	failed= failed +check("moved node x", x, i-4, 1e-6)
+	W = solve()
+	if W == W0 then
+		print("[FAILED] moving the disc does not change the energy")
+		failed= failed +1
+	end
+end
+
+-- the restored base geometry gives the original result
+mi_restoresnapshot("base")
+x,y = mi_selectnode(-3,0)
+mi_clearselected()
+failed= failed +check("restored node x", x, -4, 1e-6)
+failed= failed +check("W", solve(), W0, 1e-6)
+
+-- properties are resolved by name: delete and re-add a material, which changes the material indices
+mi_deletematerial("Air")
+mi_addmaterial("Air",1,1,0)
+mi_restoresnapshot("base")
+failed= failed +check("W (after changing the materials)", solve(), W0, 1e-6)
+
+-- ... and the snapshot can be restored into another document with a different property order
+mi_close()
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30)
+mi_addcircprop("J",0,1)
+mi_addcircprop("I",1,1)
+mi_addmaterial("Coil",1,1,0)
+mi_addmaterial("Iron",1000,1000,0)
+mi_addmaterial("Air",1,1,0)
+mi_addboundprop("unused",0,0,0,0,0,0,0,0,0)
+mi_addboundprop("A=0",0,0,0,0,0,0,0,0,0)
+mi_saveas("femmcli_snapshot.other.result.fem")
+mi_restoresnapshot("base")
+failed= failed +check("W (other document)", solve(), W0, 1e-6)
+
+-- unknown snapshots are an error
+if call(mi_restoresnapshot, {"unknown"}, "x", function(msg) end) ~= nil then
+	print("[FAILED] restoring an unknown snapshot did not fail")
+	failed= failed +1
+end
+
+assert(failed==0)
+write("SUCCESS\n")
+quit()
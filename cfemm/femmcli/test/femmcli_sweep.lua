@@ -0,0 +1,51 @@
+-- femmcli_sweep.lua
+-- Evaluate an electrostatics problem for several conductor voltages with sweep(),
+-- and compare the results with a sequential evaluation.
+-- Output:
+-- SUCCESS
+showconsole()
+
+open("femmcli_epproc.fee")
+ei_saveas("femmcli_sweep.result.fee")
+
+voltages = {10, 25, 50, 75}
+
+function evaluate(voltage, index)
+	ei_modifyconductorprop("m1t", 1, voltage)
+	ei_analyze(1)
+	ei_loadsolution()
+	local V,Dx = eo_getpointvalues(0.250, 0)
+	changedBySweep = 1
+	return V, Dx, "point" .. index
+end
+
+XFEMM_SWEEP_WORKERS = 2
+results = sweep(evaluate, voltages, "femmcli_sweep.result.csv")
+
+-- the function ran in separate processes
+assert(changedBySweep == nil)
+
+for i=1,getn(voltages) do
+	local V,Dx,name = evaluate(voltages[i], i)
+	assert(results[i][1] == V)
+	assert(results[i][2] == Dx)
+	assert(results[i][3] == name)
+end
+
+-- a failing function leaves a hole in the results
+results = sweep(function(p) if p == 2 then error("expected failure") end return p end, {1, 2, 3})
+assert(results[1][1] == 1)
+assert(results[2] == nil)
+assert(results[3][1] == 3)
+
+-- the CSV file has a header line and a line per parameter
+csv = openfile("femmcli_sweep.result.csv", "r")
+lines = 0
+while read(csv, "*l") do
+	lines = lines+1
+end
+closefile(csv)
+assert(lines == 5)
+
+write("SUCCESS\n")
+quit()
@@ -32,6 +32,7 @@
 #include "fparse.h"
 #include "IntPoint.h"
 #include "make_unique.h"
+#include "MemoryFiles.h"
 
 #include "triangle_version.h"
 
@@ -41,6 +42,7 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -51,6 +53,32 @@ using namespace fmesher;
 namespace {
 // set up some default behaviors
 constexpr double DEFAULT_MINANGLE=30.;
+
+/// the files written by the triangulation
+const char *meshFileExtensions[] = { ".node", ".ele", ".edge", ".pbc", ".poly" };
+
+/**
+ * @brief FNV-1a hash of the values that determine a mesh.
+ */
+class MeshKeyBuilder
+{
+public:
+    void add(const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i=0; i<size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    void add(double value) { add(&value, sizeof(value)); }
+    void add(int value) { add(&value, sizeof(value)); }
+    void add(const std::string &value) { add(value.c_str(), value.size()+1); }
+    std::uint64_t key() const { return hash; }
+private:
+    std::uint64_t hash = 14695981039346656037ULL;
+};
 }
 
 FMesher::FMesher()
@@ -280,7 +308,7 @@ bool FMesher::LoadMesh(string PathName)
 
     //read meshnodes;
     infile = rootname + ".node";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         WarnMessage("No mesh to display");
         return false;
@@ -299,7 +327,7 @@ bool FMesher::LoadMesh(string PathName)
 
     //read meshlines;
     infile = rootname + ".edge";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         WarnMessage("No mesh to display");
         return false;
@@ -310,7 +338,7 @@ bool FMesher::LoadMesh(string PathName)
     fclose(fp);
 
     infile = rootname + ".ele";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         WarnMessage("No mesh to display");
         return false;
@@ -349,15 +377,15 @@ bool FMesher::LoadMesh(string PathName)
 
     // clear out temporary files
     infile = rootname + ".ele";
-    remove(infile.c_str());
+    femm::removeFile(infile);
     infile = rootname + ".node";
-    remove(infile.c_str());
+    femm::removeFile(infile);
     infile = rootname + ".edge";
-    remove(infile.c_str());
+    femm::removeFile(infile);
     infile = rootname + ".pbc";
-    remove(infile.c_str());
+    femm::removeFile(infile);
     infile = rootname + ".poly";
-    remove(infile.c_str());
+    femm::removeFile(infile);
 
     return true;
 }
@@ -903,3 +931,110 @@ string fmesher::triangleVersionString()
 {
     return TRIANGLE_VERSION;
 }
+
+std::uint64_t FMesher::meshKey() const
+{
+    MeshKeyBuilder key;
+    key.add((int)problem->filetype);
+    key.add(problem->MinAngle);
+    key.add((int)problem->DoSmartMesh);
+    key.add((int)problem->DoForceMaxMeshArea);
+
+    // the markers in the mesh files are indices into the property lists
+    key.add((int)problem->nodeproplist.size());
+    for (const auto &prop: problem->nodeproplist)
+        key.add(prop->PointName);
+    key.add((int)problem->lineproplist.size());
+    for (const auto &prop: problem->lineproplist)
+    {
+        key.add(prop->BdryName);
+        key.add(prop->BdryFormat);
+        // periodic boundaries and air gap elements are written to the .pbc file
+        key.add(prop->InnerAngle);
+        key.add(prop->OuterAngle);
+    }
+    key.add((int)problem->circproplist.size());
+    for (const auto &prop: problem->circproplist)
+        key.add(prop->CircName);
+
+    key.add((int)problem->nodelist.size());
+    for (const auto &node: problem->nodelist)
+    {
+        key.add(node->x);
+        key.add(node->y);
+        key.add(node->BoundaryMarkerName);
+        key.add(node->InConductorName);
+    }
+    key.add((int)problem->linelist.size());
+    for (const auto &line: problem->linelist)
+    {
+        key.add(line->n0);
+        key.add(line->n1);
+        key.add(line->MaxSideLength);
+        key.add(line->BoundaryMarkerName);
+        key.add(line->InConductorName);
+    }
+    key.add((int)problem->arclist.size());
+    for (const auto &arc: problem->arclist)
+    {
+        key.add(arc->n0);
+        key.add(arc->n1);
+        key.add(arc->ArcLength);
+        key.add(arc->MaxSideLength);
+        key.add(arc->BoundaryMarkerName);
+        key.add(arc->InConductorName);
+    }
+    // the materials of the labels don't matter, but holes do
+    key.add((int)problem->labellist.size());
+    for (const auto &label: problem->labellist)
+    {
+        key.add(label->x);
+        key.add(label->y);
+        key.add(label->MaxArea);
+        key.add((int)label->isHole());
+    }
+    return key.key();
+}
+
+bool FMesher::restoreMesh(string PathName)
+{
+    if (!ReuseMesh || !hasKeptMesh || keptMeshKey != meshKey())
+        return false;
+
+    const string baseName = PathName.substr(0,PathName.find_last_of('.'));
+    for (const auto &file: keptMeshFiles)
+    {
+        if (!femm::writeFile(baseName + file.first, file.second))
+            return false;
+    }
+    return true;
+}
+
+void FMesher::keepMesh(string PathName)
+{
+    hasKeptMesh = false;
+    keptMeshFiles.clear();
+    NodeNumbering.clear();
+    BandWidth = 0;
+    if (!ReuseMesh)
+        return;
+
+    const string baseName = PathName.substr(0,PathName.find_last_of('.'));
+    for (const char *extension: meshFileExtensions)
+    {
+        std::unique_ptr<std::istream> input = femm::openInputFile(baseName + extension, std::ios_base::binary);
+        if (!input)
+        {
+            // the .poly file is optional
+            if (string(extension) == ".poly")
+                continue;
+            keptMeshFiles.clear();
+            return;
+        }
+        std::ostringstream content;
+        content << input->rdbuf();
+        keptMeshFiles.push_back(std::make_pair(string(extension), content.str()));
+    }
+    keptMeshKey = meshKey();
+    hasKeptMesh = true;
+}
@@ -41,9 +41,11 @@
 #include "femmenums.h"
 #include "FemmProblem.h"
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
 
 #ifndef LineFraction
 #define LineFraction 500.0
@@ -90,6 +92,17 @@ public:
     std::shared_ptr<femm::FemmProblem> problem;
     bool Verbose = true;
     bool writePolyFiles = false; ///< write .poly files when calling triangle
+    /**
+     * @brief Keep the mesh files of a triangulation in memory, and reuse them while meshKey() does not change.
+     * @see restoreMesh(), keepMesh()
+     */
+    bool ReuseMesh = false;
+    /**
+     * @brief The node numbering that the solver computed for the kept mesh (see FEASolver::NodeNumbering).
+     * The numbering is dropped whenever a new mesh is kept.
+     */
+    std::vector<int> NodeNumbering;
+    int BandWidth = 0; ///< the band width that belongs to NodeNumbering
 
 	std::string BinDir;
 
@@ -136,6 +149,36 @@ public:
 	int DoPeriodicBCTriangulation(std::string PathName);
 	bool HasPeriodicBC();
 
+    /**
+     * @brief Compute a hash of everything in the problem that determines the mesh.
+     * This includes the nodes, segments, arcs and their boundary and conductor properties,
+     * the positions and mesh sizes of the block labels, the mesh settings, and the periodic boundaries,
+     * but not the materials and sources of the block labels.
+     * @return the hash
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    std::uint64_t meshKey() const;
+    /**
+     * @brief Write the mesh files kept by keepMesh(), if the problem still has the same meshKey().
+     * This replaces DoPeriodicBCTriangulation() or DoNonPeriodicBCTriangulation().
+     * @param PathName the problem file name
+     * @return \c true, if the mesh files have been written, \c false if the problem needs to be triangulated.
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    bool restoreMesh(std::string PathName);
+    /**
+     * @brief Keep a copy of the mesh files written by the triangulation, if ReuseMesh is set.
+     * @param PathName the problem file name
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void keepMesh(std::string PathName);
+
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
 
@@ -146,6 +189,11 @@ private:
 
     virtual bool Initialize(femm::FileType t);
 	void addFileStr (char * q);
+
+    bool hasKeptMesh = false;
+    std::uint64_t keptMeshKey = 0;
+    /// the kept mesh files: extension and content
+    std::vector<std::pair<std::string,std::string>> keptMeshFiles;
 };
 
 /**
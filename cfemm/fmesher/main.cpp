@@ -14,6 +14,7 @@ int main(int argc, char ** argv)
 
     std::string FilePath;
     bool writePoly = false;
+    bool enforcePSLG = false;
 
     if (argc < 2)
     {
@@ -38,6 +39,8 @@ int main(int argc, char ** argv)
             } else {
                 if ( arg == "--write-poly")
                     writePoly = true;
+                if ( arg == "--enforce-pslg")
+                    enforcePSLG = true;
                 if ( arg == "--version" )
                 {
                     std::cout << "fmesher version " << FEMM_VERSION_STRING << "\n";
@@ -49,9 +52,12 @@ int main(int argc, char ** argv)
                 }
                 if ( arg == "--help" || arg == "-h" )
                 {
-                    std::cout << "Usage: " << argv[0] << " [--write-poly] <femfile>\n";
+                    std::cout << "Usage: " << argv[0] << " [--write-poly] [--enforce-pslg] <femfile>\n";
                     std::cout << "       " << argv[0] << " [-h|--help] [--version]\n";
                     std::cout << "\n";
+                    std::cout << "  --enforce-pslg  split intersecting segments and merge coincident nodes\n";
+                    std::cout << "                  before meshing, and update <femfile> accordingly\n";
+                    std::cout << "\n";
                     return 0;
                 }
             }
@@ -85,6 +91,18 @@ int main(int argc, char ** argv)
         return status;
     }
 
+    if (enforcePSLG)
+    {
+        // the geometry was written without intersection checks (e.g. by a script generator);
+        // the solver reads the block labels from the fem file, so it has to match the mesh
+        MeshObj.problem->enforcePSLG();
+        if (!MeshObj.problem->saveFEMFile(FilePath))
+        {
+            std::cout << "Could not write " << FilePath << std::endl;
+            return -5;
+        }
+    }
+
     if (MeshObj.HasPeriodicBC() == true)
     {
         if (MeshObj.DoPeriodicBCTriangulation(FilePath) != 0)
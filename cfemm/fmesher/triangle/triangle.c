@@ -14850,6 +14850,7 @@ char **argv;
   struct otri triangleloop, trisym;
   struct osub checkmark;
   vertex p1, p2;
+  vertex apex1, apex2;
   long edgenumber;
   triangle ptr;                         /* Temporary variable used by sym(). */
   subseg sptr;                      /* Temporary variable used by tspivot(). */
@@ -14888,14 +14889,21 @@ char **argv;
   /* To loop over the set of edges, loop over all triangles, and look at   */
   /*   the three edges of each triangle.  If there isn't another triangle  */
   /*   adjacent to the edge, operate on the edge.  If there is another     */
-  /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
+  /*   adjacent triangle, operate on the edge only if the apex of the      */
+  /*   current triangle has a smaller number than the apex of its          */
+  /*   neighbor.  This way, each edge is considered only once.             */
+  /* xfemm: the original code compared the triangle pointers, which made   */
+  /*   the order of the edges depend on the memory layout of the process.  */
   while (triangleloop.tri != (triangle *) NULL) {
     for (triangleloop.orient = 0; triangleloop.orient < 3;
          triangleloop.orient++) {
       sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+      if (trisym.tri != m->dummytri) {
+        apex(triangleloop, apex1);
+        apex(trisym, apex2);
+      }
+      if ((trisym.tri == m->dummytri) ||
+          (vertexmark(apex1) < vertexmark(apex2))) {
         org(triangleloop, p1);
         dest(triangleloop, p2);
 #ifdef TRILIBRARY
@@ -33,6 +33,9 @@
 #include "femmconstants.h"
 #include "CCommonPoint.h"
 #include "CAirGapElement.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
+#include "SpatialGrid.h"
 //extern "C" {
 #include "triangle.h"
 #ifndef XFEMM_BUILTIN_TRIANGLE
@@ -40,12 +43,15 @@
 #endif
 //}
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <iomanip>
+#include <limits>
+#include <map>
 //#include <malloc.h>
 #include <stdexcept>
 #include <string>
@@ -222,6 +228,386 @@ void initialize(triangleio &io)
     io.numberofedges = 0;
 }
 
+/**
+ * @brief The BoundaryClassifier class finds the input segments and arc segments that lie on the boundary of the meshed domain.
+ *
+ * The classification is done on the discretized input geometry (i.e. the same nodes and segments that are passed to triangle),
+ * so that the periodic boundary triangulation does not need a trial run of triangle to gather this information.
+ *
+ * The faces of the planar straight line graph are traced using half-edges.
+ * A counter-clockwise face cycle bounds a face; a clockwise cycle is the outer boundary of a connected component
+ * and belongs to the smallest face of another component that encloses it.
+ * A face is meshed by triangle unless it is unbounded or contains a hole (\c "<No Mesh>") block label.
+ */
+class BoundaryClassifier {
+    using nodelist_t = std::vector<std::unique_ptr<CNode> >;
+    using linelist_t = std::vector<std::unique_ptr<CSegment> >;
+public:
+    struct EntityInfo {
+        bool onBoundary = false; ///< \c true, if the meshed domain is only on one side of the entity
+        bool domainOnLeft = false; ///< \c true, if the meshed domain is left of the entity (going from n0 to n1)
+        int face = -1; ///< the meshed face adjacent to the entity (only valid for boundary entities)
+    };
+
+    /**
+     * @brief Build the face structure of the discretized geometry.
+     * @param nodelst the discretized node list
+     * @param linelst the discretized segment list; the \c cnt field must contain the index of the original entity (segments first, then arc segments)
+     * @param problem
+     */
+    BoundaryClassifier(const nodelist_t &nodelst, const linelist_t &linelst, const FemmProblem &problem);
+
+    /**
+     * @brief Classify an input entity.
+     * @param entity the index of the entity, as stored in the \c cnt field of the discretized segments
+     * @return the classification result
+     */
+    EntityInfo classify(int entity) const;
+
+    /**
+     * @brief Estimate the side length of elements within a face.
+     * The area constraint of the face's block label is limited by \p defaultMeshSize, as done by TriangulateHelper::initHolesAndRegions().
+     * @param face a face index (as returned by classify())
+     * @param defaultMeshSize the default area constraint
+     * @return the side length of an equilateral triangle that satisfies the area constraint
+     */
+    double elementSideLength(int face, double defaultMeshSize) const;
+
+    /**
+     * @brief Estimate the number of elements triangle would place along an input segment.
+     * The element size along the segment is bounded by \p maxSideLength,
+     * and grows with the distance from nodes of other entities,
+     * mimicking the refinement that triangle does close to small features.
+     * @param entity the index of the segment
+     * @param maxSideLength upper bound for the element side length
+     * @param minSideLength lower bound for the element side length
+     * @return the number of parts the segment should be split into
+     */
+    int estimateDivisions(int entity, double maxSideLength, double minSideLength) const;
+
+private:
+    int origin(int he) const { return (he%2==0) ? edges[he/2].first : edges[he/2].second; }
+    int target(int he) const { return origin(he^1); }
+    bool cycleContains(int cycle, CComplex p) const;
+    int enclosingFace(CComplex p, int excludedComponent) const;
+    int faceOfCycle(int cycle) const;
+    bool isMeshed(int face) const { return face>=0 && !faceIsHole[face]; }
+    double nodeSize(int node, int entity, double maxSideLength) const;
+
+    const FemmProblem &problem;
+    const linelist_t &linelst;
+    std::vector<CComplex> pts;
+    std::vector<std::pair<int,int>> edges;
+    std::vector<int> entityHalfEdge; ///< half-edge running along the first part of an entity, from its n0 node
+    std::vector<int> cycleOfHalfEdge;
+    std::vector<std::vector<int>> cycleNodes;
+    std::vector<double> cycleArea;
+    std::vector<int> cycleComponent;
+    std::vector<CComplex> cycleMin;
+    std::vector<CComplex> cycleMax;
+    std::vector<bool> faceIsHole;
+    std::vector<int> faceLabel;
+    std::vector<std::vector<int>> entitySegments; ///< the discretized segments of each entity
+    // the size of a feature node is the length of its shortest edge that doesn't belong to the entity being split;
+    // for that, the shortest edge and the shortest edge of any other entity are stored
+    std::vector<double> shortestEdge;
+    std::vector<int> shortestEdgeEntity;
+    std::vector<double> shortestOtherEdge;
+    SpatialGrid nodeGrid;
+};
+
+BoundaryClassifier::BoundaryClassifier(const nodelist_t &nodelst, const linelist_t &linelst, const FemmProblem &problem)
+    : problem(problem)
+    , linelst(linelst)
+{
+    pts.reserve(nodelst.size());
+    for (const auto &node: nodelst)
+        pts.push_back(node->CC());
+
+    // collect edges, skipping degenerate and duplicate segments
+    std::map<std::pair<int,int>,int> edgeMap;
+    entityHalfEdge.assign(problem.linelist.size()+problem.arclist.size(), -1);
+    for (const auto &segm: linelst)
+    {
+        if (segm->n0 == segm->n1)
+            continue;
+        std::pair<int,int> key = std::minmax(segm->n0, segm->n1);
+        auto it = edgeMap.find(key);
+        if (it == edgeMap.end())
+        {
+            it = edgeMap.insert(std::make_pair(key, (int)edges.size())).first;
+            edges.push_back(std::make_pair(segm->n0, segm->n1));
+        }
+        int he = 2*it->second + ((edges[it->second].first == segm->n0) ? 0 : 1);
+        if (segm->cnt >= 0 && segm->cnt < (int)entityHalfEdge.size() && entityHalfEdge[segm->cnt] < 0)
+            entityHalfEdge[segm->cnt] = he;
+    }
+
+    // feature sizes for estimateDivisions()
+    entitySegments.resize(entityHalfEdge.size());
+    shortestEdge.assign(pts.size(), std::numeric_limits<double>::infinity());
+    shortestEdgeEntity.assign(pts.size(), -1);
+    shortestOtherEdge.assign(pts.size(), std::numeric_limits<double>::infinity());
+    for (int i=0; i<(int)linelst.size(); i++)
+    {
+        const CSegment &segm = *linelst[i];
+        if (segm.cnt >= 0 && segm.cnt < (int)entitySegments.size())
+            entitySegments[segm.cnt].push_back(i);
+        if (segm.n0 == segm.n1)
+            continue;
+        const double l = abs(pts[segm.n1]-pts[segm.n0]);
+        for (int n: { segm.n0, segm.n1 })
+        {
+            if (l < shortestEdge[n])
+            {
+                if (shortestEdgeEntity[n] != segm.cnt)
+                    shortestOtherEdge[n] = shortestEdge[n];
+                shortestEdge[n] = l;
+                shortestEdgeEntity[n] = segm.cnt;
+            } else if (segm.cnt != shortestEdgeEntity[n]) {
+                shortestOtherEdge[n] = std::min(shortestOtherEdge[n], l);
+            }
+        }
+    }
+    CComplex pmin(0,0);
+    CComplex pmax(0,0);
+    if (!pts.empty())
+        pmin = pmax = pts[0];
+    for (const CComplex &p: pts)
+    {
+        pmin.re = std::min(pmin.re, p.re); pmin.im = std::min(pmin.im, p.im);
+        pmax.re = std::max(pmax.re, p.re); pmax.im = std::max(pmax.im, p.im);
+    }
+    const double extent = std::max(pmax.re-pmin.re, pmax.im-pmin.im);
+    nodeGrid.clear((extent > 0) ? extent / std::sqrt((double)pts.size()) : 1.);
+    for (const CComplex &p: pts)
+        nodeGrid.appendBox(p, p);
+
+    // sort the outgoing half-edges of each node counter-clockwise
+    const int numHalfEdges = 2*edges.size();
+    std::vector<std::vector<int>> outgoing(pts.size());
+    std::vector<double> angle(numHalfEdges);
+    for (int he=0; he<numHalfEdges; he++)
+    {
+        angle[he] = arg(pts[target(he)]-pts[origin(he)]);
+        outgoing[origin(he)].push_back(he);
+    }
+    std::vector<int> position(numHalfEdges);
+    for (auto &out: outgoing)
+    {
+        std::sort(out.begin(), out.end(), [&angle](int a, int b) { return angle[a] < angle[b]; });
+        for (int i=0; i<(int)out.size(); i++)
+            position[out[i]] = i;
+    }
+
+    // connected components
+    std::vector<int> parent(pts.size());
+    for (int i=0; i<(int)parent.size(); i++)
+        parent[i] = i;
+    auto findRoot = [&parent](int n) {
+        while (parent[n] != n)
+            n = parent[n] = parent[parent[n]];
+        return n;
+    };
+    for (const auto &edge: edges)
+        parent[findRoot(edge.first)] = findRoot(edge.second);
+
+    // trace the face cycles; the face of a half-edge is on its left side
+    cycleOfHalfEdge.assign(numHalfEdges, -1);
+    for (int start=0; start<numHalfEdges; start++)
+    {
+        if (cycleOfHalfEdge[start] >= 0)
+            continue;
+        const int cycle = cycleNodes.size();
+        cycleNodes.push_back(std::vector<int>());
+        double area = 0;
+        CComplex cmin = pts[origin(start)];
+        CComplex cmax = cmin;
+        int he = start;
+        do {
+            cycleOfHalfEdge[he] = cycle;
+            const CComplex p0 = pts[origin(he)];
+            const CComplex p1 = pts[target(he)];
+            area += (p0.re*p1.im - p1.re*p0.im) / 2.;
+            cycleNodes[cycle].push_back(origin(he));
+            cmin.re = std::min(cmin.re, p0.re); cmin.im = std::min(cmin.im, p0.im);
+            cmax.re = std::max(cmax.re, p0.re); cmax.im = std::max(cmax.im, p0.im);
+            // continue with the next outgoing half-edge clockwise of the twin
+            const std::vector<int> &out = outgoing[target(he)];
+            he = out[(position[he^1] + out.size() - 1) % out.size()];
+        } while (he != start);
+        cycleArea.push_back(area);
+        cycleComponent.push_back(findRoot(origin(start)));
+        cycleMin.push_back(cmin);
+        cycleMax.push_back(cmax);
+    }
+
+    // assign block labels to faces
+    faceIsHole.assign(cycleNodes.size(), false);
+    faceLabel.assign(cycleNodes.size(), -1);
+    for (int i=0; i<(int)problem.labellist.size(); i++)
+    {
+        const CBlockLabel &label = *problem.labellist[i];
+        int face = enclosingFace(CComplex(label.x,label.y), -1);
+        if (face < 0)
+            continue;
+        if (label.isHole())
+            faceIsHole[face] = true;
+        else if (faceLabel[face] < 0)
+            faceLabel[face] = i;
+    }
+}
+
+BoundaryClassifier::EntityInfo BoundaryClassifier::classify(int entity) const
+{
+    EntityInfo info;
+    if (entity < 0 || entity >= (int)entityHalfEdge.size() || entityHalfEdge[entity] < 0)
+        return info;
+
+    const int he = entityHalfEdge[entity];
+    const int leftFace = faceOfCycle(cycleOfHalfEdge[he]);
+    const int rightFace = faceOfCycle(cycleOfHalfEdge[he^1]);
+    const bool leftMeshed = isMeshed(leftFace);
+    const bool rightMeshed = isMeshed(rightFace);
+
+    info.onBoundary = (leftMeshed != rightMeshed);
+    info.domainOnLeft = leftMeshed;
+    info.face = leftMeshed ? leftFace : rightFace;
+    return info;
+}
+
+double BoundaryClassifier::elementSideLength(int face, double defaultMeshSize) const
+{
+    double area = defaultMeshSize;
+    if (face >= 0 && faceLabel[face] >= 0)
+    {
+        const double maxArea = problem.labellist[faceLabel[face]]->MaxArea;
+        if (maxArea > 0 && maxArea < defaultMeshSize)
+            area = maxArea;
+    }
+    return sqrt(4.*area/sqrt(3.));
+}
+
+double BoundaryClassifier::nodeSize(int node, int entity, double maxSideLength) const
+{
+    const double size = (shortestEdgeEntity[node] != entity) ? shortestEdge[node] : shortestOtherEdge[node];
+    return std::min(size, maxSideLength);
+}
+
+int BoundaryClassifier::estimateDivisions(int entity, double maxSideLength, double minSideLength) const
+{
+    // how fast the element size may grow with the distance to a feature
+    constexpr double grading = 0.3;
+
+    const CSegment &line = *problem.linelist[entity];
+    const CComplex a0 = pts[line.n0];
+    const CComplex a1 = pts[line.n1];
+    const double length = abs(a1-a0);
+    if (length <= 0 || maxSideLength <= 0)
+        return 1;
+    minSideLength = std::max(minSideLength, 1.e-06*length);
+    if (minSideLength > maxSideLength)
+        minSideLength = maxSideLength;
+
+    // nodes belonging to the segment itself don't count as features
+    std::vector<int> ownNodes;
+    for (int i: entitySegments[entity])
+    {
+        ownNodes.push_back(linelst[i]->n0);
+        ownNodes.push_back(linelst[i]->n1);
+    }
+    std::sort(ownNodes.begin(), ownNodes.end());
+
+    // collect the features that may restrict the element size along the segment,
+    // in a coordinate system where the segment runs from 0 to length along the real axis
+    struct Feature {
+        CComplex q;
+        double size;
+        bool onSegment;
+    };
+    std::vector<Feature> features;
+    const CComplex dir = (a1-a0)/length;
+    const double reach = maxSideLength/grading;
+    // the query box contains every point within reach of the segment
+    const double margin = std::sqrt(2.)*reach;
+    std::vector<int> candidates;
+    nodeGrid.query(CComplex(std::min(a0.re,a1.re)-margin, std::min(a0.im,a1.im)-margin),
+                   CComplex(std::max(a0.re,a1.re)+margin, std::max(a0.im,a1.im)+margin),
+                   candidates);
+    for (int i: candidates)
+    {
+        const bool isEndPoint = (i==line.n0 || i==line.n1);
+        if (!isEndPoint && std::binary_search(ownNodes.begin(), ownNodes.end(), i))
+            continue;
+        const CComplex q = (pts[i]-a0)/dir;
+        const double ds = (q.re < 0) ? -q.re : ((q.re > length) ? q.re-length : 0);
+        if (isEndPoint || (ds < reach && fabs(q.im) < reach))
+            features.push_back(Feature{q, nodeSize(i, entity, maxSideLength), isEndPoint});
+    }
+
+    // integrate 1/h along the segment
+    double parts = 0;
+    double s = 0;
+    while (s < length)
+    {
+        double h = maxSideLength;
+        for (const auto &f: features)
+        {
+            const double d = abs(f.q-s);
+            h = std::min(h, f.size + grading*d);
+            if (!f.onSegment)
+                h = std::min(h, d);
+        }
+        h = std::max(h, minSideLength);
+        const double step = std::min(h/4., length-s);
+        parts += step/h;
+        s += step;
+    }
+    return std::max(1, (int) std::ceil(parts - 1.e-06));
+}
+
+bool BoundaryClassifier::cycleContains(int cycle, CComplex p) const
+{
+    if (p.re < cycleMin[cycle].re || p.re > cycleMax[cycle].re
+            || p.im < cycleMin[cycle].im || p.im > cycleMax[cycle].im)
+        return false;
+
+    // crossing number test
+    const std::vector<int> &nodes = cycleNodes[cycle];
+    bool inside = false;
+    for (int i=0, j=nodes.size()-1; i<(int)nodes.size(); j=i++)
+    {
+        const CComplex a = pts[nodes[i]];
+        const CComplex b = pts[nodes[j]];
+        if ((a.im > p.im) != (b.im > p.im)
+                && p.re < (b.re-a.re)*(p.im-a.im)/(b.im-a.im) + a.re)
+            inside = !inside;
+    }
+    return inside;
+}
+
+int BoundaryClassifier::enclosingFace(CComplex p, int excludedComponent) const
+{
+    int face = -1;
+    for (int cycle=0; cycle<(int)cycleNodes.size(); cycle++)
+    {
+        if (cycleArea[cycle] <= 0 || cycleComponent[cycle] == excludedComponent)
+            continue;
+        if ((face < 0 || cycleArea[cycle] < cycleArea[face]) && cycleContains(cycle, p))
+            face = cycle;
+    }
+    return face;
+}
+
+int BoundaryClassifier::faceOfCycle(int cycle) const
+{
+    // counter-clockwise cycles bound their own face
+    if (cycleArea[cycle] > 0)
+        return cycle;
+    // clockwise cycles are enclosed by a face of some other component (or by the unbounded face)
+    return enclosingFace(pts[cycleNodes[cycle][0]], cycleComponent[cycle]);
+}
+
 }
 
 double FMesher::averageLineLength() const
@@ -560,7 +946,7 @@ bool TriangulateHelper::writeTriangulationFiles(string PathName) const
     // check to see if we are ready to write a .node datafile containing
     // the nodes
 
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
+    if ((fp = femm::openFile(plyname,"wt"))==NULL){
         WarnMessage("Couldn't write to specified .node file");
         return false;
     }
@@ -596,7 +982,7 @@ bool TriangulateHelper::writeTriangulationFiles(string PathName) const
 
     // check to see if we are ready to write an edge datafile;
 
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
+    if ((fp = femm::openFile(plyname,"wt"))==NULL){
         msg = "Couldn't write to specified .edge file\n";
         WarnMessage(msg.c_str());
         return false;
@@ -639,7 +1025,7 @@ bool TriangulateHelper::writeTriangulationFiles(string PathName) const
     // check to see if we are ready to write a .ele datafile containing
     // thr triangle elements
 
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
+    if ((fp = femm::openFile(plyname,"wt"))==NULL){
         WarnMessage("Couldn't write to specified .ele file");
         return false;
     }
@@ -710,6 +1096,7 @@ bool TriangulateHelper::writeTriangulationFiles(string PathName) const
  */
 int FMesher::DoNonPeriodicBCTriangulation(string PathName)
 {
+    femm::ProfileScope profile("mesh");
     // // if incremental permeability solution, we crib mesh from the previous problem.
     // // we can just bail out in that case.
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
@@ -773,7 +1160,7 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
 
     // write out a trivial pbc file
     plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
+    if ((fp=femm::openFile(plyname,"wt"))==NULL){
         WarnMessage("Couldn't write to specified .pbc file");
         return -1;
     }
@@ -812,8 +1199,10 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
 
 
 /**
- * \brief Call triangle twice to order segments on the boundary properly
- * for periodic or antiperiodic boundary conditions
+ * \brief Triangulate a problem with periodic or antiperiodic boundary conditions.
+ * Segments on the boundary are ordered and discretized up front,
+ * so that matching nodes exist on both sides of each (anti)periodic boundary
+ * and triangle only needs to be called once.
  *
  * Original function name:
  *  * \femm42{femm/writepoly.cpp,CFemmeDoc::FunnyOnWritePoly()}
@@ -822,17 +1211,17 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
  */
 int FMesher::DoPeriodicBCTriangulation(string PathName)
 {
+    femm::ProfileScope profile("mesh");
     // // if incremental permeability solution, we crib mesh from the previous problem.
     // // we can just bail out in that case.
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
     //     return true;
     FILE *fp;
     int i, j, k, n;
-    int l,n0,n1,n2;
+    int l,n0,n1;
     double z,R,dL;
     CComplex a0,a1,a2,c;
     CComplex b0,b1,b2;
-    char instring[1024];
     //string s;
     string plyname;
     std::vector < std::unique_ptr<CNode> >              nodelst;
@@ -875,227 +1264,45 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     // mesh size isn't explicitly specified
     double DefaultMeshSize = defaultMeshSizeHeuristics(nodelst, problem->DoSmartMesh);
 
-#ifdef DEBUG
-    WarnMessage("writepoly: about to call triangle\n");
-#endif // DEBUG
-
-    // **********         call triangle       ***********
-
+    // Find out which segments and arc segments are on the boundary of the meshed
+    // domain, and on which side of them the domain lies. This used to be done by
+    // calling triangle once and reading back the .edge and .ele files. Instead, the
+    // faces of the discretized geometry are classified directly.
+    // Boundary entities are oriented such that the domain is on their left side,
+    // and segments without explicit discretization get a MaxSideLength that fits
+    // the mesh size of the adjacent region. This way, periodic boundaries get
+    // matching nodes on both sides before the (only) call to triangle.
     {
-        TriangulateHelper triHelper;
-        triHelper.WarnMessage = WarnMessage;
-        triHelper.TriMessage = this->TriMessage;
-
-        if (!triHelper.initPointsWithMarkers(nodelst,*problem, PointMarkerInfo::None))
-            return -1;
-        if (!triHelper.initSegmentsWithMarkers(linelst,*problem,SegmentMarkerInfo::FromCnt))
-            return -1;
-        if (!triHelper.initHolesAndRegions(*problem, true, DefaultMeshSize))
-            return -1;
-
-        triHelper.setMinAngle(problem->MinAngle);
-        if (writePolyFiles)
+        BoundaryClassifier classifier(nodelst, linelst, *problem);
+        const int numLines = (int)problem->linelist.size();
+        for(i=0; i < numLines; i++)
         {
-            string plyname = PathName.substr(0, PathName.find_last_of('.')) + ".raw.poly";
-            triHelper.writePolyFile(plyname, triHelper.triangulateParams());
+            CSegment &line = *problem->linelist[i];
+            BoundaryClassifier::EntityInfo info = classifier.classify(i);
+            if (!info.onBoundary)
+                continue;
+
+            if (!info.domainOnLeft)
+                std::swap(line.n0, line.n1);
+
+            z = classifier.elementSideLength(info.face, DefaultMeshSize);
+            if (line.MaxSideLength > 0 && line.MaxSideLength < z)
+                z = line.MaxSideLength;
+            k = classifier.estimateDivisions(i, z, dL);
+            line.MaxSideLength = problem->lengthOfLine(line) / (double) k;
         }
-        int tristatus = triHelper.triangulate(Verbose);
-        if (tristatus != 0)
-            return tristatus;
-
-        triHelper.writeTriangulationFiles(PathName);
-    }
-
-#ifdef DEBUG
-    WarnMessage("writepoly: finished calling triangle\n");
-#endif // DEBUG
-
-    // So far, so good.  Now, read back in the .edge file
-    // to make sure the points in the segments and arc
-    // segments are ordered in a consistent way so that
-    // the (anti)periodic boundary conditions can be applied.
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 876\n");
-#endif // DEBUG
-
-    // read meshlines;
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".edge";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful\n");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
-    problem->clearNotationTags();
-    // use cnt again to keep a
-    // tally of how many subsegments each
-    // entity is sliced into.
-    for(auto &arc: problem->arclist) arc->cnt=0;
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 898\n");
-#endif // DEBUG
-
-    // resize initializes the new elements using the default ctor:
-    ptlst.clear();
-    ptlst.shrink_to_fit();
-    int npt = problem->linelist.size()+problem->arclist.size();
-    ptlst.reserve(npt);
-    for(i=0; i<npt; i++)
-        ptlst.push_back(std::unique_ptr <CCommonPoint> (new CCommonPoint()));
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 910\n");
-#endif // DEBUG
 
-    for(i=0;i<k;i++)
-    {
-        // get the next edge from the file
-        fgets(instring,1024,fp);
-        // get the edge number, start and end points (n0 and n1) and the
-        // segment/arc marker j
-        sscanf(instring,"%i    %i    %i    %i",&l,&n0,&n1,&j);
-        // if j != 0, this edge is part of a segment/arc
-        if(j!=0)
-        {
-            // convert back to the `right' numbering
-            j=-(j+2);
-            assert(j>=0);
-
-            // store a reference line that we can use to
-            // determine whether or not this is a
-            // boundary segment w/out re-running triangle.
-            if (ptlst[j]->t==0)
-            {
-                ptlst[j]->t=1;
-                ptlst[j]->setSortedValues(n0,n1);
-            }
-
-            if(j<(int)problem->linelist.size())
-            {
-                // deal with segments
-
-                // increment cnt for the segment which the edge we are
-                // examining is a part of to get a tally of how many edges
-                // are a part of the segment/boundary
-                problem->linelist[j]->cnt++;
-                // check if the end n0 of the segment is the same node as the
-                // end n1 of the edge, or if the end n1 of the segment is the
-                // same node and end n0 of the edge. If so, flip the direction
-                // of the segment
-                if((problem->linelist[j]->n0 == n1) || (problem->linelist[j]->n1 == n0))
-                {
-                    // flip the end points of the segment
-                    std::swap(problem->linelist[j]->n0,problem->linelist[j]->n1);
-                }
-            }
-            else{
-                // deal with arc segments;
-                // Can't just flip the point order with
-                // impunity in the arc segments, so we flip
-                // a marker which denotes which side the
-                // normal is on.
-
-                j=j-(int)problem->linelist.size();
-                problem->arclist[j]->cnt++;
-                // Note(ZaJ): I assume that the second if statement should just be the else branch of the first if statement...
-                if((problem->arclist[j]->n0==n1) || (problem->arclist[j]->n1==n0))
-                    problem->arclist[j]->NormalDirection=false;
-                if((problem->arclist[j]->n0==n0) || (problem->arclist[j]->n1==n1))
-                    problem->arclist[j]->NormalDirection=true;
-            }
-        }
-    }
-    fclose(fp);
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 974\n");
-#endif // DEBUG
-
-    // figure out which segments / arcsegments are on the
-    // boundary and force an appropriate mesh density on
-    // these based on how many divisions are in the first
-    // trial meshing of the domain.
-
-    // paw through the element list to find out how many
-    // elements each reference segment appears in.  If a
-    // segment is on the boundary, it ought to appear in just
-    // one element.  Otherwise, it appears in two.
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".ele";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 996\n");
-#endif // DEBUG
-
-    for(i=0;i<k;i++)
-    {
-        fgets(instring,1024,fp);
-        sscanf(instring,"%i    %i    %i    %i",&j,&n0,&n1,&n2);
-
-        // Sort out the three nodes...
-        if (n0>n1) { n=n0; n0=n1; n1=n; }
-        if (n1>n2) { n=n1; n1=n2; n2=n; }
-        if (n0>n1) { n=n0; n0=n1; n1=n; }
-
-        // now, check to see if any of the test segments
-        // are sides of this node...
-        for(j=0;j<(int)ptlst.size();j++)
-        {
-            if ((n0==ptlst[j]->x) && (n1==ptlst[j]->y)) ptlst[j]->t--;
-            if ((n0==ptlst[j]->x) && (n2==ptlst[j]->y)) ptlst[j]->t--;
-            if ((n1==ptlst[j]->x) && (n2==ptlst[j]->y)) ptlst[j]->t--;
-        }
-    }
-    fclose(fp);
-
-#ifdef DEBUG
-    WarnMessage("writepoly: 1021\n");
-#endif // DEBUG
-
-    // impose "new" mesh constraints on bdry arcs and segments....
-    for(i=0; i < (int)problem->linelist.size(); i++)
-    {
-        if (ptlst[i]->t == 0)
+        // Unlike the former trial run of triangle, which also reduced the MaxSideLength of boundary arc segments
+        // to the size of the elements triangle placed on them, arc segments keep their own discretization:
+        // their pieces are input segments that triangle splits as needed.
+        for(i=0; i < (int)problem->arclist.size(); i++)
         {
-            // simply make the max side length equal to the
-            // length of the boundary divided by the number
-            // of elements that were created in the first
-            // attempt at meshing
-            problem->linelist[i]->MaxSideLength = problem->lengthOfLine(i) / ((double) problem->linelist[i]->cnt);
+            BoundaryClassifier::EntityInfo info = classifier.classify(i+numLines);
+            if (info.onBoundary)
+                problem->arclist[i]->NormalDirection = info.domainOnLeft;
         }
     }
-
-    for(i=0; i < (int)problem->arclist.size(); i++)
-    {
-        if (ptlst[i+problem->linelist.size()]->t == 0)
-        {
-            // alter maxsidelength, but do it in such
-            // a way that it carries only 4 significant
-            // digits.  There's no use in carrying double
-            // precision here, because it looks crappy
-            // when you open up the arc segment to see
-            // its properties.
-            char kludge[32];
-            double newMaxSideLength;
-            newMaxSideLength = problem->arclist[i]->ArcLength/((double) problem->arclist[i]->cnt);
-            sprintf(kludge,"%.1e",newMaxSideLength);
-            sscanf(kludge,"%lf",&newMaxSideLength);
-
-            problem->arclist[i]->MaxSideLength = newMaxSideLength;
-        }
-    }
-
-    ptlst.clear();
-    ptlst.shrink_to_fit();
+    problem->clearNotationTags();
 
 #ifdef DEBUG
     {
@@ -1830,7 +2037,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 */
     // write out a pbc file containing a list of linked nodes
     plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
+    if ((fp=femm::openFile(plyname,"wt"))==NULL){
         WarnMessage("Couldn't write to specified .pbc file");
         problem->undo();  problem->unselectAll();
         return -1;
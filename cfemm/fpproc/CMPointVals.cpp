@@ -44,3 +44,46 @@ CMPointVals::CMPointVals()
     , ff(1)
 {
 }
+
+void CMPointValsArray::resize(int n)
+{
+    const CMPointVals u;
+    valid.assign(n, 0);
+    A.assign(n, u.A);
+    B1.assign(n, u.B1);
+    B2.assign(n, u.B2);
+    mu1.assign(n, u.mu1);
+    mu2.assign(n, u.mu2);
+    mu12.assign(n, u.mu12);
+    H1.assign(n, u.H1);
+    H2.assign(n, u.H2);
+    Je.assign(n, u.Je);
+    Js.assign(n, u.Js);
+    Hc.assign(n, 0);
+    c.assign(n, u.c);
+    E.assign(n, u.E);
+    Ph.assign(n, u.Ph);
+    Pe.assign(n, u.Pe);
+    ff.assign(n, u.ff);
+}
+
+void CMPointValsArray::set(int i, const CMPointVals &u)
+{
+    valid[i] = 1;
+    A[i] = u.A;
+    B1[i] = u.B1;
+    B2[i] = u.B2;
+    mu1[i] = u.mu1;
+    mu2[i] = u.mu2;
+    mu12[i] = u.mu12;
+    H1[i] = u.H1;
+    H2[i] = u.H2;
+    Je[i] = u.Je;
+    Js[i] = u.Js;
+    Hc[i] = u.Hc;
+    c[i] = u.c;
+    E[i] = u.E;
+    Ph[i] = u.Ph;
+    Pe[i] = u.Pe;
+    ff[i] = u.ff;
+}
@@ -29,6 +29,8 @@
 
 #include "femmcomplex.h"
 
+#include <vector>
+
 class CMPointVals
 {
 public:
@@ -49,4 +51,44 @@ public:
 private:
 };
 
+/**
+ * @brief The CMPointValsArray class holds the point values of several points as a structure of arrays.
+ * All arrays have the same size.
+ * For points outside of the mesh, \c valid is 0 and the other values are left at their defaults.
+ *
+ * \internal
+ * (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+class CMPointValsArray
+{
+public:
+    /**
+     * @brief Set the number of points and reset all values.
+     * @param n
+     */
+    void resize(int n);
+    /**
+     * @brief Store the values of a point.
+     * @param i the point index
+     * @param u
+     */
+    void set(int i, const CMPointVals &u);
+    int size() const { return (int)valid.size(); }
+
+    std::vector<char> valid;        // 1, if the point lies within the mesh
+    std::vector<CComplex> A;        // vector potential
+    std::vector<CComplex> B1,B2;    // flux density
+    std::vector<CComplex> mu1,mu2;  // permeability
+    std::vector<CComplex> mu12;     // incremental permeability
+    std::vector<CComplex> H1,H2;    // field intensity
+    std::vector<CComplex> Je,Js;    // eddy current and source current densities
+    std::vector<CComplex> Hc;       // Magnetization for regions with a PM.
+    std::vector<double> c;          // conductivity
+    std::vector<double> E;          // energy stored in the magnetic field
+    std::vector<double> Ph;         // power dissipated by hysteresis
+    std::vector<double> Pe;         // power dissipated by eddy currents
+    std::vector<double> ff;         // winding fill factor
+};
+
 #endif
@@ -22,9 +22,10 @@
 #include "CPostProcMElement.h"
 
 femmpostproc::CPostProcMElement::CPostProcMElement()
-    : femmsolver::CMElement()
-    , B1p(0.)
-    , B2p(0.)
+    : femmsolver::CElement()
+    , B1(0)
+    , B2(0)
+    , magdir(0.)
 {
 }
 
@@ -29,23 +29,26 @@
 
 namespace femmpostproc {
 
-class CPostProcMElement : public femmsolver::CMElement
+/**
+ * @brief The CPostProcMElement class holds the mesh elements of the magnetics post-processor.
+ *
+ * In contrast to the solver's CMElement, only the values needed for post-processing are stored;
+ * the permeability is computed from the flux density when needed (see FPProc::GetMu()).
+ * Data that is only needed by some problems or some commands is kept outside of the element
+ * (FPProc::nodalB1, FPProc::nodalB2, FPProc::elementB1p, FPProc::elementB2p).
+ *
+ * \internal
+ * xfemm: femm42 uses the same element class as the solver (including mu1, mu2, v12 and the nodal flux densities).
+ * \endinternal
+ */
+class CPostProcMElement : public femmsolver::CElement
 {
 public:
     CPostProcMElement();
     virtual ~CPostProcMElement();
 
-//    /**
-//     * @brief fromStream constructs a CMElement from an input stream (usually an input file stream)
-//     * @param input
-//     * @param err output stream for error messages
-//     * @return a CMElement
-//     */
-//    static CMElement fromStream( std::istream &input, std::ostream &err = std::cerr );
-
-
-    double B1p;  /// < previous value of B1
-    double B2p;  /// < previous value of B2
+    CComplex B1,B2; ///< flux density of the element
+    double magdir;  ///< magnetization direction of the element
 };
 
 }
@@ -27,6 +27,7 @@
 // fpproc.cpp : implementation of the FPProc class
 //
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <cstring>
@@ -36,9 +37,12 @@
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fparse.h"
+#include "SolutionFile.h"
 #include "lua.h"
 #include "lualib.h"
 #include "fpproc.h"
+#include "spars.h"
+#include "threadTools.h"
 
 //#define DEBUG_FPPROC 1
 
@@ -75,6 +79,61 @@ double sqr(double x)
 {
     return x*x;
 }
+
+/**
+ * @brief Decode a record of the node list of the solution section.
+ * @return the number of values that were read (like sscanf)
+ */
+int scanMeshNode(SolutionTable::Record &r, CMMeshNode &node, bool isAC, bool isIncremental)
+{
+    if (!r.next(node.x))
+        return 0;
+    if (!r.next(node.y))
+        return 1;
+    if (!r.next(node.A.re))
+        return 2;
+    int count = 3;
+    if (isAC)
+    {
+        if (!r.next(node.A.im))
+            return count;
+        count++;
+    } else {
+        node.A.im = 0;
+    }
+    if (isIncremental)
+    {
+        int bc;
+        if (!r.next(bc))
+            return count;
+        if (!r.next(node.Aprev))
+            return count+1;
+        count += 2;
+    }
+    return count;
+}
+
+/**
+ * @brief Decode a record of the element list of the solution section.
+ * @return the number of values that were read (like sscanf)
+ */
+int scanMeshElement(SolutionTable::Record &r, femmpostproc::CPostProcMElement &elm, bool isIncremental)
+{
+    for (int j=0; j<3; j++)
+    {
+        if (!r.next(elm.p[j]))
+            return j;
+    }
+    if (!r.next(elm.lbl))
+        return 3;
+    if (!isIncremental)
+        return 4;
+    // the current density of the previous solution is not needed for post-processing
+    double Jprev;
+    if (!r.next(Jprev))
+        return 4;
+    return 5;
+}
 } // anonymous namespace
 
 /**
@@ -104,7 +163,9 @@ FPProc::FPProc()
     ConList = NULL;
     WeightingScheme = 0;
     bHasMask = false;
+    bHasPlotBounds = false;
     bIncremental = MS_LEGACY_FALSE;
+    lastElement = 0;
     LengthConv = (double *)calloc(6,sizeof(double));
     LengthConv[0] = 0.0254;   //inches
     LengthConv[1] = 0.001;    //millimeters
@@ -189,6 +250,19 @@ void FPProc::ClearDocument()
     contour.shrink_to_fit();
     agelist.clear();
     agelist.shrink_to_fit();
+    nodalBValid.clear();
+    nodalB1.clear();
+    nodalB1.shrink_to_fit();
+    nodalB2.clear();
+    nodalB2.shrink_to_fit();
+    elementB1p.clear();
+    elementB1p.shrink_to_fit();
+    elementB2p.clear();
+    elementB2p.shrink_to_fit();
+    bHasPlotBounds = false;
+    elementQuantities.clear();
+    maskCache.clear();
+    maskProblem.reset();
 
 }
 
@@ -226,7 +300,7 @@ bool FPProc::OpenDocument(string pathname)
     int i,j,k,t, sscnt;
     char s[1024],q[1024];
     char *v;
-    double b,bi,br;
+    double b;
     double zr,zi;
     bool flag = false;
     CMPointProp    PProp;
@@ -245,7 +319,8 @@ bool FPProc::OpenDocument(string pathname)
     NewDocument();
 
     // attempt to open the file for reading
-    if ((fp = fopen(pathname.c_str(),"rt")) == NULL)
+    SolutionFormat format;
+    if ((fp = openSolutionFile(pathname,format)) == NULL)
     {
         WarnMessage("Couldn't read from specified .ans file\n");
         return false;
@@ -1112,191 +1187,85 @@ bool FPProc::OpenDocument(string pathname)
         return false;
     }
 
+    // read the whole solution section at once;
+    // the node and element lists are decoded in parallel
+    SolutionBuffer solution;
+    if (!solution.readFrom(fp,format))
+    {
+        WarnMessage("An error occured while reading file.\n"); /* Error */
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    SolutionTable table;
+
     // read in meshnodes;
-    fscanf(fp,"%i\n",&k);
+    if (!solution.nextTable(table))
+    {
+        // There was some read error while trying to read the file
+        WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
+        return false;
+    }
 #ifdef DEBUG_FPPROC
-    printf("numnodes: %d\n", k);
+    printf("numnodes: %d\n", table.size());
 #endif // DEBUG_FPPROC
-    meshnode.resize(k);
-    for(i=0; i<k; i++)
+    meshnode.resize(table.size());
+    const bool isAC = (Frequency!=0);
+    const int nodeFields = (isAC ? 4 : 3) + (bIncremental ? 2 : 0);
+    i = decodeRecords(table, [this,isAC,nodeFields](int n, SolutionTable::Record &r) {
+        return scanMeshNode(r, meshnode[n], isAC, bIncremental) == nodeFields;
+    });
+    if (i>=0)
     {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (Frequency!=0)
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &mnode.A.im) ;
-
-                    if (sscnt != 4)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 4).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-
-                    sscanf(s,"%lf\t%lf\t%lf\t%lf\t%i\t%lf",
-                           &mnode.x,
-                           &mnode.y,
-                           &mnode.A.re,
-                           &mnode.A.im,
-                           &bc,
-                           &mnode.Aprev);
-
-                    if (sscnt != 6)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 6).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-            }
-            else
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re);
-
-
-                    if (sscnt != 3)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 3).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-
-                    sscnt = sscanf(s, "%lf\t%lf\t%lf\t%i\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &bc,
-                                   &mnode.Aprev);
-
-                    if (sscnt != 5)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 5).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
-
-                }
-                mnode.A.im=0;
-            }
-            meshnode[i] = mnode;
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
-            fclose(fp);
-            return false;
-        }
-
+        SolutionTable::Record r = table.record(i);
+        sscnt = scanMeshNode(r, mnode, isAC, bIncremental);
+        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                + std::to_string(sscnt) + ") for node " + std::to_string(i)
+                + " (expected " + std::to_string(nodeFields) + ").\n";
+        WarnMessage(msg.c_str()); /* Error */
+        return false;
     }
 
     // read in elements;
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    //fscanf(fp,"%i\n",&k);
-    meshelem.resize(k);
-#ifdef DEBUG_FPPROC
-    printf("numelement: %d\n", k);
-#endif // DEBUG_FPPROC
-    for(i=0; i<k; i++)
+    if (!solution.nextTable(table))
     {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (!bIncremental)
-            {
-                sscnt = sscanf(s,"%i\t%i\t%i\t%i",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl);
-#ifdef DEBUG_FPPROC
-                printf("s[%d]: %s", i,s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 4)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-            else
-            {
-                sscanf(s,"%i	%i	%i	%i	%lf",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl,&elm.Jprev);
-
-#ifdef DEBUG_FPPROC
-                printf("s: %s\n", s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 5)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-
-            elm.blk=blocklist[elm.lbl].BlockType;
-            meshelem[i] = elm;
+        // There was some read error while trying to read the file
+        WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
+        return false;
+    }
 #ifdef DEBUG_FPPROC
-            //printf("numelement: %d\n", k); //###note: this debug line make no sense here, is already before the loop...
+    printf("numelement: %d\n", table.size());
 #endif // DEBUG_FPPROC
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
-            fclose(fp);
+    meshelem.resize(table.size());
+    const int elementFields = bIncremental ? 5 : 4;
+    i = decodeRecords(table, [this,elementFields](int n, SolutionTable::Record &r) {
+        femmpostproc::CPostProcMElement &e = meshelem[n];
+        if (scanMeshElement(r, e, bIncremental) != elementFields)
             return false;
-        }
+        e.blk=blocklist[e.lbl].BlockType;
+        return true;
+    });
+    if (i>=0)
+    {
+        SolutionTable::Record r = table.record(i);
+        sscnt = scanMeshElement(r, elm, bIncremental);
+        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
+        WarnMessage(msg.c_str()); /* Error */
+        return false;
     }
-    
+
     // read in circuit data;
-    fscanf(fp,"%i\n",&k);
+    k=0;
+    solution.getLine(s,1024);
+    sscanf(s,"%i",&k);
     #ifdef DEBUG_FPPROC
     printf("numcircuits: %d\n",k);
     fflush(stdout);
     #endif
     for(i=0; i<k; i++)
     {
-        fgets(s,1024,fp);
+        solution.getLine(s,1024);
         if (Frequency==0)
         {
             sscanf(s,"%i\t%lf",&j,&zr);
@@ -1319,15 +1288,15 @@ bool FPProc::OpenDocument(string pathname)
     printf("PBC data skip\n");
     fflush(stdout);
     #endif
-	if (fgets(s,1024,fp)!=NULL)
+	if (solution.getLine(s,1024)!=NULL)
 	{
 		sscanf(s,"%i",&k);
 		for(i=0;i<k;i++)
-			fgets(s,1024,fp);
+			solution.getLine(s,1024);
 	}
 
 	// Read in Air Gap Element information
-	fgets(s,1024,fp);
+	solution.getLine(s,1024);
     sscanf(s,"%i",&k);
     #ifdef DEBUG_FPPROC
     printf("airgaps: %d\n",k);
@@ -1336,7 +1305,7 @@ bool FPProc::OpenDocument(string pathname)
 	for(i=0;i<k;i++){
 		CAirGapElement age;
 
-		fgets(s,1024,fp);
+		solution.getLine(s,1024);
         #ifdef DEBUG_FPPROC
         printf("airgap[%d]: %s",i,s);
         fflush(stdout);
@@ -1344,7 +1313,7 @@ bool FPProc::OpenDocument(string pathname)
 		age.BdryName = std::string(s);
 		age.BdryName = std::regex_replace (age.BdryName, std::regex("\""), "");
 		age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
-		fgets(s,1024,fp);
+		solution.getLine(s,1024);
 		sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
 			&age.BdryFormat,&age.InnerAngle,&age.OuterAngle,
 			&age.ri,&age.ro,&age.totalArcLength,
@@ -1370,7 +1339,7 @@ bool FPProc::OpenDocument(string pathname)
         {
 			CQuadPoint q;
 
-			fgets(s,1024,fp);
+			solution.getLine(s,1024);
 			sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
 				&q.n0, &q.w0,
 				&q.n1, &q.w1,
@@ -1393,7 +1362,6 @@ bool FPProc::OpenDocument(string pathname)
                             + std::string("\n");
                 WarnMessage(msg.c_str()); /* Error */
                 //WarnMessage("quadNode has negative node number j: %i, n0: %i, n1: %i, n2: %i,n3: %i.\n", j, q.n0, q.n1, q.n2, q.n3); /* Error */
-                fclose(fp);
                 return false;
             }
 			age.quadNode.push_back(q);
@@ -1404,8 +1372,6 @@ bool FPProc::OpenDocument(string pathname)
             agelist.push_back (age);
         }
 	}
-
-	fclose(fp);
     
     #ifdef DEBUG_FPPROC
     printf("Loading ANS file done!\n");
@@ -1725,7 +1691,9 @@ bool FPProc::OpenDocument(string pathname)
     printf("Find flux density in each element\n");
     fflush(stdout);
     #endif
-    for(i=0; i<(int)meshelem.size(); i++) GetElementB(meshelem[i]);
+    elementB1p.assign(bIncremental ? meshelem.size() : 0, 0.);
+    elementB2p.assign(bIncremental ? meshelem.size() : 0, 0.);
+    for(i=0; i<(int)meshelem.size(); i++) GetElementB(i);
 
     // Find extreme values of A;
     #ifdef DEBUG_FPPROC
@@ -1845,70 +1813,238 @@ bool FPProc::OpenDocument(string pathname)
             NumList[k]++;
         }
 
-    // find extreme values of J;
+    // xfemm: smoothing the flux density and finding the extreme values for plots
+    // is deferred until they are needed, see ensureNodalB() and computePlotBounds()
+    nodalBValid.assign(meshelem.size(), 0);
+    nodalB1.clear();
+    nodalB2.clear();
+    bHasPlotBounds = false;
+    elementQuantities.clear();
+    maskCache.clear();
+    maskProblem.reset();
+
+//    // Choose bounds based on the type of contour plot
+//    // currently in play
+//    POSITION pos = GetFirstViewPosition();
+//    CFemmviewView *theView=(CFemmviewView *)GetNextView(pos);
+//
+//    if(Frequency==0)
+//    {
+//        if (theView->DensityPlot==2) theView->DensityPlot=1;
+//        if (theView->DensityPlot>1)  theView->DensityPlot=0;
+//    }
+
+    // compute total resulting current for circuits with an a priori defined
+    // voltage gradient;  Need this to display circuit results & impedance.
+    #ifdef DEBUG_FPPROC
+    printf("circproplist.size: %d\n",circproplist.size());
+    fflush(stdout);
+    #endif
+    for(i=0; i<(int)circproplist.size(); i++)
     {
-        #ifdef DEBUG_FPPROC
-        printf("find extreme values of J\n");
-        fflush(stdout);
-        #endif
-    
         CComplex Jelm[3],Aelm[3];
+        double a;
 
-        double J_Low, J_High;
-        double Jr_Low, Jr_High;
-        double Ji_Low, Ji_High;
+        if(circproplist[i].CircType>1)
+            for(j=0,circproplist[i].Amps=0.; j<(int)meshelem.size(); j++)
+            {
+                if(blocklist[meshelem[j].lbl].InCircuit==i)
+                {
 
-        GetJA(0,Jelm,Aelm);
-        Jr_Low=fabs(Jelm[0].re);
-        Jr_High=Jr_Low;
-        Ji_Low=fabs(Jelm[0].im);
-        Ji_High=Ji_Low;
-        J_Low=abs(Jelm[0]);
-        J_High=J_Low;
-        for(i=0; i<(int)meshelem.size(); i++)
+                    GetJA(j,Jelm,Aelm);
+                    // Convert area units to metres
+                    a = ElmArea(j) * sqr(LengthConv[LengthUnits]);
+                    // Add the current in the element (J * Elemnet Area) to the total
+                    for(k=0; k<3; k++) circproplist[i].Amps += a * Jelm[k]/3;
+                }
+            }
+    }
+
+    // Build adjacency information for each element.
+    #ifdef DEBUG_FPPROC
+    printf("Build adjacency information for each element.\n");
+    fflush(stdout);
+    #endif
+    FindBoundaryEdges();
+    buildElementIndex();
+
+    // Check to see if any regions are multiply defined
+    // (i.e. tagged by more than one block label). If so,
+    // display an error message and mark the problem blocks.
+    #ifdef DEBUG_FPPROC
+    printf("Check to see if any regions are multiply defined.\n");
+    fflush(stdout);
+    #endif
+    for(k=0,bMultiplyDefinedLabels=false; k<(int)blocklist.size(); k++)
+    {
+        // test if the label is inside the meshed region, by attempting to find
+        // which triangle it is in, if it's outside the problem region it will
+        // be ignored anyway
+        if( (i = InTriangle(blocklist[k].x,blocklist[k].y)) >= 0 )
         {
-            GetJA(i,Jelm,Aelm);
-            for(j=0; j<3; j++)
+            // the label is in the problem domain, test if the label assigned
+            // to the element which the label is in has the same value as the
+            // label number
+            if(meshelem[i].lbl != k)
             {
-                br=fabs(Jelm[j].re);
-                bi=fabs(Jelm[j].im);
-                b=abs(Jelm[j]);
+                // if the label number assigned to the element is not the same as
+                // the block label numer, there must be multiply defined labels for
+                // the region
 
-                if(b>J_High) J_High=b;
-                if(b<J_Low) J_Low=b;
-                if(br>Jr_High) Jr_High=br;
-                if(br<Jr_Low) Jr_Low=br;
-                if(bi>Ji_High) Ji_High=bi;
-                if(bi<Ji_Low) Ji_Low=bi;
+                // select the offending region
+                blocklist[meshelem[i].lbl].IsSelected=true;
+
+                // if it the first multiply defined label we have found, issue a warning
+                // and set the appropriate flag to true
+                if (!bMultiplyDefinedLabels)
+                {
+                    string msg = "Some regions in the problem have been defined\n";
+                    msg +=       "by more than one block label.\n";
+                    SNPRINTF(warnBuf, sizeof(warnBuf),
+                                 "%sThe offending labels are numbers %i and %i with block types:\n%s\nand\n%s\nand at locations (%g,%g) and (%g,%g)",
+                             msg.c_str(),
+                             k,
+                             meshelem[i].lbl,
+                             blocklist[k].BlockTypeName.c_str (),
+                             blocklist[meshelem[i].lbl].BlockTypeName.c_str (),
+                             blocklist[k].x,
+                             blocklist[k].y,
+                             blocklist[meshelem[i].lbl].x,
+                             blocklist[meshelem[i].lbl].y );
+                    WarnMessage(warnBuf);
+                    bMultiplyDefinedLabels = true;
+                }
             }
         }
+    }
 
-        J_Low*=1.e-6;
-        J_High*=1e-6;
-        Jr_Low*=1.e-6;
-        Jr_High*=1e-6;
-        Ji_Low*=1.e-6;
-        Ji_High*=1e-6;
 
-        if (Frequency==0)
-        {
-            d_PlotBounds[2][0]=PlotBounds[2][0]=J_Low;
-            d_PlotBounds[2][1]=PlotBounds[2][1]=J_High;
-        }
-        else
+    // Get some information needed to compute energy stored in
+    // permanent magnets with a nonlinear demagnetization curve
+    #ifdef DEBUG_FPPROC
+    printf("Get some information needed to compute energy stored in permanent magnets with a nonlinear demagnetization curve.\n");
+    fflush(stdout);
+    #endif
+    if (Frequency==0)
+    {
+        for(k=0; k<(int)blockproplist.size(); k++)
         {
-            d_PlotBounds[6][0]=PlotBounds[6][0]=J_Low;
-            d_PlotBounds[6][1]=PlotBounds[6][1]=J_High;
-            d_PlotBounds[7][0]=PlotBounds[7][0]=Jr_Low;
-            d_PlotBounds[7][1]=PlotBounds[7][1]=Jr_High;
-            d_PlotBounds[8][0]=PlotBounds[8][0]=Ji_Low;
-            d_PlotBounds[8][1]=PlotBounds[8][1]=Ji_High;
+            if ((blockproplist[k].H_c>0) && (blockproplist[k].BHpoints>0))
+            {
+                blockproplist[k].Nrg = blockproplist[k].GetCoEnergy(blockproplist[k].GetB(blockproplist[k].H_c));
+            }
         }
     }
+    
+    #ifdef DEBUG_FPPROC
+    printf("FPProc::OpenDocument() done!\n");
+    fflush(stdout);
+    #endif
 
-    // Find extreme values of B and H;
-    {
-        #ifdef DEBUG_FPPROC
+    return true;
+}
+
+//bool FPProc::LoadPBCFromSolution(FILE* fp)
+//{
+//    char s[1024];
+//
+//    if (fgets(s,1024,fp)!=0)
+//    {
+//        sscanf(s,"%i",&NumPBCs);
+//
+//        // clear the existing pbc list
+//        pbclist.clear();
+//
+//        // remove any previously reserved capacity
+//        pbclist.shrink_to_fit();
+//
+//        // reserve enough capacity for the declared number of pbc's in the file
+//        pbclist.reserve(NumPBCs);
+//
+//        for(int i=0;i<NumPBCs;i++)
+//        {
+//            CCommonPoint pbc;
+//            fgets(s,1024,fp);
+//            sscanf(s,"%i    %i      %i\n",&pbc.x,&pbc.y,&pbc.t);
+//            pbclist.push_back(pbc);
+//        }
+//    }
+//
+//    return true;
+//}
+
+void FPProc::computePlotBounds()
+{
+    if (bHasPlotBounds || meshelem.empty())
+        return;
+
+    int i,j,k;
+    double b,bi,br;
+
+    // find extreme values of J;
+    {
+        #ifdef DEBUG_FPPROC
+        printf("find extreme values of J\n");
+        fflush(stdout);
+        #endif
+    
+        CComplex Jelm[3],Aelm[3];
+
+        double J_Low, J_High;
+        double Jr_Low, Jr_High;
+        double Ji_Low, Ji_High;
+
+        GetJA(0,Jelm,Aelm);
+        Jr_Low=fabs(Jelm[0].re);
+        Jr_High=Jr_Low;
+        Ji_Low=fabs(Jelm[0].im);
+        Ji_High=Ji_Low;
+        J_Low=abs(Jelm[0]);
+        J_High=J_Low;
+        for(i=0; i<(int)meshelem.size(); i++)
+        {
+            GetJA(i,Jelm,Aelm);
+            for(j=0; j<3; j++)
+            {
+                br=fabs(Jelm[j].re);
+                bi=fabs(Jelm[j].im);
+                b=abs(Jelm[j]);
+
+                if(b>J_High) J_High=b;
+                if(b<J_Low) J_Low=b;
+                if(br>Jr_High) Jr_High=br;
+                if(br<Jr_Low) Jr_Low=br;
+                if(bi>Ji_High) Ji_High=bi;
+                if(bi<Ji_Low) Ji_Low=bi;
+            }
+        }
+
+        J_Low*=1.e-6;
+        J_High*=1e-6;
+        Jr_Low*=1.e-6;
+        Jr_High*=1e-6;
+        Ji_Low*=1.e-6;
+        Ji_High*=1e-6;
+
+        if (Frequency==0)
+        {
+            d_PlotBounds[2][0]=PlotBounds[2][0]=J_Low;
+            d_PlotBounds[2][1]=PlotBounds[2][1]=J_High;
+        }
+        else
+        {
+            d_PlotBounds[6][0]=PlotBounds[6][0]=J_Low;
+            d_PlotBounds[6][1]=PlotBounds[6][1]=J_High;
+            d_PlotBounds[7][0]=PlotBounds[7][0]=Jr_Low;
+            d_PlotBounds[7][1]=PlotBounds[7][1]=Jr_High;
+            d_PlotBounds[8][0]=PlotBounds[8][0]=Ji_Low;
+            d_PlotBounds[8][1]=PlotBounds[8][1]=Ji_High;
+        }
+    }
+
+    // Find extreme values of B and H;
+    {
+        #ifdef DEBUG_FPPROC
         printf("find extreme values of B and H\n");
         fflush(stdout);
         #endif
@@ -1989,13 +2125,13 @@ bool FPProc::OpenDocument(string pathname)
 
         for(i=0; i<(int)meshelem.size(); i++)
         {
-            GetNodalB(meshelem[i].b1,meshelem[i].b2,meshelem[i]);
+            ensureNodalB(i);
             for(j=0; j<3; j++)
             {
-                br=sqrt(sqr(meshelem[i].b1[j].re) +
-                        sqr(meshelem[i].b2[j].re));
-                bi=sqrt(sqr(meshelem[i].b1[j].im) +
-                        sqr(meshelem[i].b2[j].im));
+                br=sqrt(sqr(nodalB1[3*i+j].re) +
+                        sqr(nodalB2[3*i+j].re));
+                bi=sqrt(sqr(nodalB1[3*i+j].im) +
+                        sqr(nodalB2[3*i+j].im));
                 b=sqrt(br*br+bi*bi);
 
                 // used to be: if(b>B_High)   B_High=b;
@@ -2059,154 +2195,27 @@ bool FPProc::OpenDocument(string pathname)
         }
     }
 
-//    // Choose bounds based on the type of contour plot
-//    // currently in play
-//    POSITION pos = GetFirstViewPosition();
-//    CFemmviewView *theView=(CFemmviewView *)GetNextView(pos);
-//
-//    if(Frequency==0)
-//    {
-//        if (theView->DensityPlot==2) theView->DensityPlot=1;
-//        if (theView->DensityPlot>1)  theView->DensityPlot=0;
-//    }
-
-    // compute total resulting current for circuits with an a priori defined
-    // voltage gradient;  Need this to display circuit results & impedance.
-    #ifdef DEBUG_FPPROC
-    printf("circproplist.size: %d\n",circproplist.size());
-    fflush(stdout);
-    #endif
-    for(i=0; i<(int)circproplist.size(); i++)
-    {
-        CComplex Jelm[3],Aelm[3];
-        double a;
-
-        if(circproplist[i].CircType>1)
-            for(j=0,circproplist[i].Amps=0.; j<(int)meshelem.size(); j++)
-            {
-                if(blocklist[meshelem[j].lbl].InCircuit==i)
-                {
-
-                    GetJA(j,Jelm,Aelm);
-                    // Convert area units to metres
-                    a = ElmArea(j) * sqr(LengthConv[LengthUnits]);
-                    // Add the current in the element (J * Elemnet Area) to the total
-                    for(k=0; k<3; k++) circproplist[i].Amps += a * Jelm[k]/3;
-                }
-            }
-    }
-
-    // Build adjacency information for each element.
-    #ifdef DEBUG_FPPROC
-    printf("Build adjacency information for each element.\n");
-    fflush(stdout);
-    #endif
-    FindBoundaryEdges();
-
-    // Check to see if any regions are multiply defined
-    // (i.e. tagged by more than one block label). If so,
-    // display an error message and mark the problem blocks.
-    #ifdef DEBUG_FPPROC
-    printf("Check to see if any regions are multiply defined.\n");
-    fflush(stdout);
-    #endif
-    for(k=0,bMultiplyDefinedLabels=false; k<(int)blocklist.size(); k++)
-    {
-        // test if the label is inside the meshed region, by attempting to find
-        // which triangle it is in, if it's outside the problem region it will
-        // be ignored anyway
-        if( (i = InTriangle(blocklist[k].x,blocklist[k].y)) >= 0 )
-        {
-            // the label is in the problem domain, test if the label assigned
-            // to the element which the label is in has the same value as the
-            // label number
-            if(meshelem[i].lbl != k)
-            {
-                // if the label number assigned to the element is not the same as
-                // the block label numer, there must be multiply defined labels for
-                // the region
-
-                // select the offending region
-                blocklist[meshelem[i].lbl].IsSelected=true;
-
-                // if it the first multiply defined label we have found, issue a warning
-                // and set the appropriate flag to true
-                if (!bMultiplyDefinedLabels)
-                {
-                    string msg = "Some regions in the problem have been defined\n";
-                    msg +=       "by more than one block label.\n";
-                    SNPRINTF(warnBuf, sizeof(warnBuf),
-                                 "%sThe offending labels are numbers %i and %i with block types:\n%s\nand\n%s\nand at locations (%g,%g) and (%g,%g)",
-                             msg.c_str(),
-                             k,
-                             meshelem[i].lbl,
-                             blocklist[k].BlockTypeName.c_str (),
-                             blocklist[meshelem[i].lbl].BlockTypeName.c_str (),
-                             blocklist[k].x,
-                             blocklist[k].y,
-                             blocklist[meshelem[i].lbl].x,
-                             blocklist[meshelem[i].lbl].y );
-                    WarnMessage(warnBuf);
-                    bMultiplyDefinedLabels = true;
-                }
-            }
-        }
-    }
-
+    bHasPlotBounds = true;
+}
 
-    // Get some information needed to compute energy stored in
-    // permanent magnets with a nonlinear demagnetization curve
-    #ifdef DEBUG_FPPROC
-    printf("Get some information needed to compute energy stored in permanent magnets with a nonlinear demagnetization curve.\n");
-    fflush(stdout);
-    #endif
-    if (Frequency==0)
+void FPProc::ensureNodalB(int i)
+{
+    if (nodalBValid[i])
+        return;
+    if (nodalB1.empty())
     {
-        for(k=0; k<(int)blockproplist.size(); k++)
-        {
-            if ((blockproplist[k].H_c>0) && (blockproplist[k].BHpoints>0))
-            {
-                blockproplist[k].Nrg = blockproplist[k].GetCoEnergy(blockproplist[k].GetB(blockproplist[k].H_c));
-            }
-        }
+        nodalB1.resize(3*meshelem.size());
+        nodalB2.resize(3*meshelem.size());
     }
-    
-    #ifdef DEBUG_FPPROC
-    printf("FPProc::OpenDocument() done!\n");
-    fflush(stdout);
-    #endif
-
-    return true;
+    GetNodalB(&nodalB1[3*i],&nodalB2[3*i],meshelem[i]);
+    nodalBValid[i] = 1;
 }
 
-//bool FPProc::LoadPBCFromSolution(FILE* fp)
-//{
-//    char s[1024];
-//
-//    if (fgets(s,1024,fp)!=0)
-//    {
-//        sscanf(s,"%i",&NumPBCs);
-//
-//        // clear the existing pbc list
-//        pbclist.clear();
-//
-//        // remove any previously reserved capacity
-//        pbclist.shrink_to_fit();
-//
-//        // reserve enough capacity for the declared number of pbc's in the file
-//        pbclist.reserve(NumPBCs);
-//
-//        for(int i=0;i<NumPBCs;i++)
-//        {
-//            CCommonPoint pbc;
-//            fgets(s,1024,fp);
-//            sscanf(s,"%i    %i      %i\n",&pbc.x,&pbc.y,&pbc.t);
-//            pbclist.push_back(pbc);
-//        }
-//    }
-//
-//    return true;
-//}
+void FPProc::computeNodalB()
+{
+    for (int i=0; i<(int)meshelem.size(); i++)
+        ensureNodalB(i);
+}
 
 int FPProc::numElements() const
 {
@@ -2280,59 +2289,78 @@ int FPProc::numNodes() const
 
 int FPProc::InTriangle(double x, double y) const
 {
-    static int k;
-    int j,hi,lo,sz;
-    double z;
+    return InTriangle(x, y, lastElement);
+}
 
-    sz = meshelem.size();
+int FPProc::InTriangle(double x, double y, int &hint) const
+{
+    const int sz = meshelem.size();
 
+    int k = hint;
     if ((k < 0) || (k >= sz)) k = 0;
 
     // In most applications, the triangle we're looking
-    // for is nearby the last one we found.  Since the elements
-    // are ordered in a banded structure, we want to check the
-    // elements nearby the last one selected first.
+    // for is nearby the last one we found.
     if (InTriangleTest(x,y,k)) return k;
 
-    // wasn't in the last searched triangle, so look through all the
-    // elements
-    hi = k;
-    lo = k;
-
-    for(j=0; j<sz; j+=2)
+    // xfemm: instead of scanning through all the elements, only check those
+    // whose bounding box contains the point
+    std::vector<int> candidates;
+    if (elementIndex.size() == sz)
+        elementIndex.query(CComplex(x,y), CComplex(x,y), candidates);
+    else
+        for (int i=0; i<sz; i++)
+            candidates.push_back(i);
+
+    // Points on edges or nodes are contained in several elements.
+    // In that case, return the element that the femm42 search would have found:
+    // femm42 alternately checks the elements above and below k, moving away from k.
+    int found = -1;
+    int foundRank = 0;
+    for (int i: candidates)
     {
-        hi++;
-        if (hi >= sz) hi = 0;
-        lo--;
-        if (lo < 0)   lo = sz - 1;
-
-        z = (meshelem[hi].ctr.re - x) * (meshelem[hi].ctr.re - x) +
-            (meshelem[hi].ctr.im - y) * (meshelem[hi].ctr.im - y);
-
-        if (z <= meshelem[hi].rsqr)
+        const CComplex ctr = meshelem[i].ctr;
+        const double z = (ctr.re-x)*(ctr.re-x) + (ctr.im-y)*(ctr.im-y);
+        if (z > meshelem[i].rsqr || !InTriangleTest(x,y,i))
+            continue;
+        const int rank = std::min(2*((i-k+sz)%sz)-1, 2*((k-i+sz)%sz));
+        if (found < 0 || rank < foundRank)
         {
-            if (InTriangleTest(x,y,hi))
-            {
-                k = hi;
-                return k;
-            }
+            found = i;
+            foundRank = rank;
         }
+    }
 
-        z = (meshelem[lo].ctr.re-x)*(meshelem[lo].ctr.re-x) +
-            (meshelem[lo].ctr.im-y)*(meshelem[lo].ctr.im-y);
+    if (found >= 0)
+        hint = found;
+    return found;
+}
 
-        if (z <= meshelem[lo].rsqr)
+void FPProc::buildElementIndex()
+{
+    std::vector<CComplex> boxes;
+    boxes.reserve(2*meshelem.size());
+    // use the average element extent as bucket size
+    double size = 0;
+    for (const auto &elem: meshelem)
+    {
+        CComplex bmin = meshnode[elem.p[0]].CC();
+        CComplex bmax = bmin;
+        for (int j=1; j<3; j++)
         {
-            if (InTriangleTest(x,y,lo))
-            {
-                k = lo;
-                return k;
-            }
+            const CComplex p = meshnode[elem.p[j]].CC();
+            bmin.re = std::min(bmin.re, p.re); bmin.im = std::min(bmin.im, p.im);
+            bmax.re = std::max(bmax.re, p.re); bmax.im = std::max(bmax.im, p.im);
         }
-
+        boxes.push_back(bmin);
+        boxes.push_back(bmax);
+        size += std::max(bmax.re-bmin.re, bmax.im-bmin.im);
     }
 
-    return (-1);
+    elementIndex.clear(meshelem.empty() ? 1. : size/meshelem.size());
+    for (int i=0; i<(int)meshelem.size(); i++)
+        elementIndex.appendBox(boxes[2*i], boxes[2*i+1]);
+    lastElement = 0;
 }
 
 bool FPProc::GetPointValues(double x, double y, CMPointVals &u)
@@ -2355,6 +2383,40 @@ bool FPProc::GetPointValues(double x, double y, CMPointVals &u)
     return true;
 }
 
+void FPProc::GetPointValues(int numPoints, const double *x, const double *y, CMPointValsArray &values, int numThreads)
+{
+    values.resize(numPoints);
+    if (numPoints <= 0)
+        return;
+
+    numThreads = threadsForItems(numPoints, 1000, numThreads);
+
+    // like PostProcessor::forEachPointInMesh()
+    std::vector<int> elements(numPoints);
+    runInChunks(numPoints, numThreads, [this,x,y,&elements](int first, int last) {
+        int hint = lastElement;
+        for (int i=first; i<last; i++)
+            elements[i] = InTriangle(x[i], y[i], hint);
+    });
+
+    // the nodal flux densities are computed on demand, which must not happen concurrently
+    if (Smooth)
+        for (int k: elements)
+            if (k >= 0)
+                ensureNodalB(k);
+
+    runInChunks(numPoints, numThreads, [this,x,y,&elements,&values](int first, int last) {
+        CMPointVals u;
+        for (int i=first; i<last; i++)
+        {
+            if (elements[i] < 0)
+                continue;
+            GetPointValues(x[i], y[i], elements[i], u);
+            values.set(i, u);
+        }
+    });
+}
+
 bool FPProc::GetPointValues(double x, double y, int k, CMPointVals &u)
 {
     int i,j,n[3],lbl;
@@ -2378,11 +2440,14 @@ bool FPProc::GetPointValues(double x, double y, int k, CMPointVals &u)
 
     da = ( b[0]*c[1] - b[1]*c[0] );
 
+    if (Smooth)
+        ensureNodalB(k);
+
     ravg = LengthConv[LengthUnits]*
            (meshnode[n[0]].x + meshnode[n[1]].x + meshnode[n[2]].x)/3.;
 
     // interpolate the flux density B at the given point in the element
-    GetPointB(x,y,u.B1,u.B2,meshelem[k]);
+    GetPointB(x,y,u.B1,u.B2,k);
 
     u.Hc=0;
 //    if(blockproplist[meshelem[k].blk].LamType>2)
@@ -2488,8 +2553,8 @@ bool FPProc::GetPointValues(double x, double y, int k, CMPointVals &u)
 			double muinc, murel;
 			double B, B1p, B2p;
 
-			B1p = meshelem[k].B1p;
-			B2p = meshelem[k].B2p;
+			B1p = elementB1p[k];
+			B2p = elementB2p[k];
 			B = sqrt(B1p*B1p + B2p*B2p);
 
 			GetMu(B1p, B2p, muinc, murel, k);
@@ -2668,8 +2733,8 @@ bool FPProc::GetPointValues(double x, double y, int k, CMPointVals &u)
 			CComplex muinc,murel;
 			double B,B1p,B2p;
 
-			B1p=meshelem[k].B1p;
-			B2p=meshelem[k].B2p;
+			B1p=elementB1p[k];
+			B2p=elementB2p[k];
 			B=sqrt(B1p*B1p + B2p*B2p);
 
 			GetMu(B1p,B2p,muinc,murel,k);
@@ -2767,10 +2832,10 @@ bool FPProc::GetPointValues(double x, double y, int k, CMPointVals &u)
     return false;
 }
 
-void FPProc::GetPointB(const double x, const double y, CComplex &B1, CComplex &B2,
-                       const femmpostproc::CPostProcMElement &elm)
+void FPProc::GetPointB(const double x, const double y, CComplex &B1, CComplex &B2, int k) const
 {
-    // elm is a reference to the element that contains the point of interest.
+    // k is the element that contains the point of interest.
+    const femmpostproc::CPostProcMElement &elm = meshelem[k];
     int i,n[3];
     double da,a[3],b[3],c[3];
 
@@ -2797,8 +2862,8 @@ void FPProc::GetPointB(const double x, const double y, CComplex &B1, CComplex &B
     B2.Set(0,0);
     for(i=0; i<3; i++)
     {
-        B1+=(elm.b1[i]*(a[i]+b[i]*x+c[i]*y)/da);
-        B2+=(elm.b2[i]*(a[i]+b[i]*x+c[i]*y)/da);
+        B1+=(nodalB1[3*k+i]*(a[i]+b[i]*x+c[i]*y)/da);
+        B2+=(nodalB2[3*k+i]*(a[i]+b[i]*x+c[i]*y)/da);
     }
 }
 
@@ -3068,8 +3133,9 @@ void FPProc::GetNodalB(CComplex *b1, CComplex *b2, femmpostproc::CPostProcMEleme
     }
 }
 
-void FPProc::GetElementB(femmpostproc::CPostProcMElement &elm)
+void FPProc::GetElementB(int k)
 {
+    femmpostproc::CPostProcMElement &elm = meshelem[k];
     int i,n[3];
     double b[3],c[3],da;
 
@@ -3097,8 +3163,8 @@ void FPProc::GetElementB(femmpostproc::CPostProcMElement &elm)
 		{
 			for(i=0;i<3;i++)
 			{
-				elm.B1p += meshnode[n[i]].Aprev*c[i] / (da * LengthConv[LengthUnits]);
-				elm.B2p -= meshnode[n[i]].Aprev*b[i] / (da * LengthConv[LengthUnits]);
+				elementB1p[k] += meshnode[n[i]].Aprev*c[i] / (da * LengthConv[LengthUnits]);
+				elementB2p[k] -= meshnode[n[i]].Aprev*b[i] / (da * LengthConv[LengthUnits]);
 			}
 		}
 
@@ -3170,12 +3236,8 @@ void FPProc::GetElementB(femmpostproc::CPostProcMElement &elm)
 			// now, compute flux.
 			da=(b[0]*c[1]-b[1]*c[0]);
 			da*=2.*PI*r*LengthConv[LengthUnits]*LengthConv[LengthUnits];
-			elm.B1p=Re(-(c[1]*dp+c[2]*dq)/da);
-			elm.B2p=Re( (b[1]*dp+b[2]*dq)/da);
-		}
-		else{
-			elm.B1p=0;
-			elm.B2p=0;
+			elementB1p[k]=Re(-(c[1]*dp+c[2]*dq)/da);
+			elementB2p[k]=Re( (b[1]*dp+b[2]*dq)/da);
 		}
 
         return;
@@ -3694,7 +3756,7 @@ CComplex FPProc::PlnInt(double a, CComplex *u, CComplex *v) const
 CComplex FPProc::AxiInt(double a, CComplex *u, CComplex *v,double *r) const
 {
     int i;
-    static CComplex M[3][3];
+    CComplex M[3][3];
     CComplex x, z[3];
 
     M[0][0]=6.*r[0]+2.*r[1]+2.*r[2];
@@ -3742,451 +3804,528 @@ CComplex FPProc::HenrotteVector(int k) const
 
 CComplex FPProc::BlockIntegral(const int inttype)
 {
-    int i,k;
-    CComplex c,y,z,J,mu1,mu2,B1,B2,H1,H2,F1,F2;
-    CComplex A[3],Jn[3],U[3],V[3];
-    double a,sig,R = 0;
-    double r[3] = {0, 0, 0};
-
-    z=0;
-    y.re = 0.; y.im = 0.;
-    for(i=0; i<3; i++) U[i]=1.;
+    std::vector<CComplex> z;
+    BlockIntegrals(std::vector<int>(1,inttype), z);
+    return z[0];
+}
 
-    if(inttype==6)
-    {
-        z = BlockIntegral(3) + BlockIntegral(4); //total losses
-    }
-    else
+void FPProc::BlockIntegrals(const std::vector<int> &inttypes, std::vector<CComplex> &results, int numThreads)
+{
+    // the integrals that are actually summed up over the elements;
+    // total losses and the shape centroid are derived from other integrals
+    std::vector<int> types;
+    auto slot = [&types](int inttype) {
+        for (int j=0; j<(int)types.size(); j++)
+            if (types[j] == inttype)
+                return j;
+        types.push_back(inttype);
+        return (int)types.size()-1;
+    };
+    for (int inttype: inttypes)
     {
-        for(i=0; i<(int)meshelem.size(); i++)
+        if (inttype == 6)
         {
-            if(blocklist[meshelem[i].lbl].IsSelected==true)
-            {
+            slot(3);
+            slot(4);
+        } else if (inttype == 25) {
+            slot(25);
+            slot(5);
+        } else {
+            slot(inttype);
+        }
+    }
 
-                // compute some useful quantities employed by most integrals...
-                J=GetJA(i,Jn,A);
-                a=ElmArea(i)*std::pow(LengthConv[LengthUnits],2.);
-                if(problemType==AXISYMMETRIC)
+    const int numElements = meshelem.size();
+    numThreads = threadsForItems(numElements, 5000, numThreads);
+    updateElementQuantities(numThreads);
+
+    // Each batch of elements is summed up separately, and the partial sums are added in a fixed order.
+    // That way, the result doesn't depend on the number of threads.
+    const int batchSize = 1024;
+    const int numBatches = (numElements+batchSize-1)/batchSize;
+    const int numTypes = types.size();
+    std::vector<CComplex> partialSums(numBatches*numTypes, CComplex(0,0));
+    runInChunks(numBatches, numThreads, [&](int firstBatch, int lastBatch) {
+        for (int batch=firstBatch; batch<lastBatch; batch++)
+        {
+            CComplex *z = &partialSums[batch*numTypes];
+            const int last = std::min((batch+1)*batchSize, numElements);
+            for (int i=batch*batchSize; i<last; i++)
+            {
+                const bool isSelected = blocklist[meshelem[i].lbl].IsSelected;
+                for (int j=0; j<numTypes; j++)
                 {
-                    for(k=0; k<3; k++)
-                        r[k]=meshnode[meshelem[i].p[k]].x*LengthConv[LengthUnits];
-                    R=(r[0]+r[1]+r[2])/3.;
+                    // weighted stress tensor integrals are evaluated over all elements,
+                    // regardless of which elements are actually selected.
+                    if (isSelected || (types[j]>=18 && types[j]<=23))
+                        z[j] += blockIntegralTerm(types[j], i, elementQuantities[i]);
                 }
+            }
+        }
+    });
 
-                // now, compute the desired integral;
-                switch(inttype)
-                {
-                case 0: //  A.J
-                    for(k=0; k<3; k++) V[k]=Jn[k].Conj();
-                    if(problemType==PLANAR)
-                        y=PlnInt(a,A,V)*Depth;
-                    else
-                        y=AxiInt(a,A,V,r);
-                    z+=y;
+    std::vector<CComplex> sums(numTypes, CComplex(0,0));
+    for (int batch=0; batch<numBatches; batch++)
+        for (int j=0; j<numTypes; j++)
+            sums[j] += partialSums[batch*numTypes+j];
 
-                    break;
+    results.clear();
+    for (int inttype: inttypes)
+    {
+        if (inttype == 6) // total losses
+        {
+            results.push_back(sums[slot(3)] + sums[slot(4)]);
+        } else if (inttype == 25) { // 2D shape centroid
+            // divide sum of Cx*A and Cy*A by sum of A
+            const CComplex y = sums[slot(25)];
+            const double area = sums[slot(5)].re;
+            results.push_back(CComplex(y.re/area, y.im/area));
+        } else {
+            results.push_back(sums[slot(inttype)]);
+        }
+    }
+}
 
-                case 11: // x (or r) direction Lorentz force, SS part.
-                    B2=meshelem[i].B2;
-                    y= -(B2.re*J.re + B2.im*J.im);
-                    if (problemType==AXISYMMETRIC) y=0;
-                    else y*=Depth;
-                    if(Frequency!=0) y*=0.5;
-                    z+=(a*y);
-                    break;
+void FPProc::updateElementQuantities(int numThreads)
+{
+    if (elementQuantities.size() == meshelem.size())
+        return;
 
-                case 12: // y (or z) direction Lorentz force, SS part.
-                    for(k=0; k<3; k++) V[k]=Re(meshelem[i].B1*Jn[k].Conj());
-                    if(problemType==PLANAR)
-                        y=PlnInt(a,U,V)*Depth;
-                    else
-                        y=AxiInt(-a,U,V,r);
-                    if(Frequency!=0) y*=0.5;
-                    z+=y;
+    elementQuantities.resize(meshelem.size());
+    runInChunks(meshelem.size(), numThreads, [this](int first, int last) {
+        for (int i=first; i<last; i++)
+        {
+            ElementQuantities &q = elementQuantities[i];
+            q.J = GetJA(i,q.Jn,q.A);
+            q.a = ElmArea(i)*std::pow(LengthConv[LengthUnits],2.);
+            q.R = 0;
+            for (int k=0; k<3; k++)
+                q.r[k] = 0;
+            if(problemType==AXISYMMETRIC)
+            {
+                for(int k=0; k<3; k++)
+                    q.r[k]=meshnode[meshelem[i].p[k]].x*LengthConv[LengthUnits];
+                q.R=(q.r[0]+q.r[1]+q.r[2])/3.;
+            }
+        }
+    });
+}
 
-                    break;
+CComplex FPProc::blockIntegralTerm(const int inttype, const int i, const ElementQuantities &q)
+{
+    int k;
+    CComplex c,y,z,J,mu1,mu2,B1,B2,H1,H2,F1,F2;
+    CComplex A[3],Jn[3],U[3],V[3];
+    double a,sig,R;
+    double r[3];
 
-                case 13: // x (or r) direction Lorentz force, 2x part.
-                    if((Frequency!=0) && (problemType==PLANAR))
-                    {
-                        B2=meshelem[i].B2;
-                        y= -(B2.re*J.re - B2.im*J.im) - I*(B2.re*J.im+B2.im*J.re);
-                        z+=0.5*(a*y*Depth);
-                    }
-                    break;
+    z=0;
+    y=0;
+    for(k=0; k<3; k++)
+    {
+        U[k]=1.;
+        A[k]=q.A[k];
+        Jn[k]=q.Jn[k];
+        r[k]=q.r[k];
+    }
+    J=q.J;
+    a=q.a;
+    R=q.R;
 
-                case 14: // y (or z) direction Lorentz force, 2x part.
-                    if (Frequency!=0)
-                    {
-                        B1=meshelem[i].B1;
-                        B2=meshelem[i].B2;
-                        y= (B1.re*J.re - B1.im*J.im) + I*(B1.re*J.im+B1.im*J.re);
-                        if(problemType==AXISYMMETRIC) y=(-y*2.*PI*R);
-                        else y*=Depth;
-                        z+=(a*y)/2.;
-                    }
-                    break;
+    if((inttype>=18) && (inttype<=23))
+    {
+        if(problemType==AXISYMMETRIC)
+            a*=(2.*PI*R);
+        else a*=Depth;
 
-                case 16: // Lorentz Torque, 2x
-                    if ((Frequency!=0) && (problemType==PLANAR))
-                    {
-                        B1=meshelem[i].B1;
-                        B2=meshelem[i].B2;
-                        c=Ctr(i)*LengthConv[LengthUnits];
-                        y= c.re*((B1.re*J.re - B1.im*J.im) + I*(B1.re*J.im+B1.im*J.re))
-                           +c.im*((B2.re*J.re - B2.im*J.im) + I*(B2.re*J.im+B2.im*J.re));
-                        z+=0.5*(a*y*Depth);
-                    }
-                    break;
+        switch(inttype)
+        {
 
-                case 15: // Lorentz Torque, SS part.
-                    if(problemType==PLANAR)
-                    {
-                        B1=meshelem[i].B1;
-                        B2=meshelem[i].B2;
-                        c=Ctr(i)*LengthConv[LengthUnits];
-                        y= c.im*(B2.re*J.re + B2.im*J.im) + c.re*(B1.re*J.re + B1.im*J.im);
-                        if(Frequency!=0) y*=0.5;
-                        z+=(a*y*Depth);
-                    }
-                    break;
+        case 18: // x (or r) direction Henrotte force, SS part.
+            if(problemType!=0) break;
 
-                case 1: // integrate A over the element;
-                    if(problemType==AXISYMMETRIC)
-                        y=AxiInt(a,U,A,r);
-                    else
-                        for(k=0,y=0; k<3; k++) y+=a*Depth*A[k]/3.;
+            B1 = meshelem[i].B1;
 
-                    z+=y;
-                    break;
+            B2 = meshelem[i].B2;
 
-                case 2: // stored energy
-                    if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                    else a*=Depth;
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    if(Frequency!=0)
-                    {
-                        // have to compute the energy stored in a special way for
-                        // wound regions subject to prox and skin effects
-                        if (blockproplist[meshelem[i].blk].LamType>2)
-                        {
-                            CComplex mu;
-                            mu=muo*blocklist[meshelem[i].lbl].mu;
-                            double u=Im(1./blocklist[meshelem[i].lbl].o)/(2.e6*PI*Frequency);
-                            y=a*Re(B1*conj(B1)+B2*conj(B2))*Re(1./mu)/4.;
-                            y+=a*Re(J*conj(J))*u/4.;
-                        }
-                        else y=a*blockproplist[meshelem[i].blk].DoEnergy(B1,B2);
-                    }
-                    else
-                    {
-                        // correct H and energy stored in magnet for second-quadrant
-                        // representation of a PM.
-                        if (blockproplist[meshelem[i].blk].H_c!=0)
-                        {
-                            int bk=meshelem[i].blk;
+            c = HenrotteVector(i);
 
-                            // in the linear case:
-                            if (blockproplist[bk].BHpoints==0)
-                            {
-                                CComplex Hc;
-                                mu1=blockproplist[bk].mu_x;
-                                mu2=blockproplist[bk].mu_y;
-                                H1=B1/(mu1*muo);
-                                H2=B2/(mu2*muo);
-                                Hc = blockproplist[bk].H_c*exp(I*PI*meshelem[i].magdir/180.);
-                                H1=H1-Re(Hc);
-                                H2=H2-Im(Hc);
-                                y = a*0.5*muo*(mu1.re*H1.re*H1.re + mu2.re*H2.re*H2.re);
-                            }
-                            else  // the material is nonlinear
-                            {
-                                y=blockproplist[bk].DoEnergy(B1.re,B2.re);
-                                y = y + blockproplist[bk].Nrg
-                                    - blockproplist[bk].H_c*Re((B1.re+I*B2.re)/exp(I*PI*meshelem[i].magdir/180.));
-                                y*=a;
-                            }
-                        }
-                        else y=a*blockproplist[meshelem[i].blk].DoEnergy(B1.re,B2.re);
+            y = (((B1*conj(B1)) - (B2*conj(B2)))*Re(c) + 2.*Re(B1*conj(B2))*Im(c))/(2.*muo);
 
-                        // add in "local" stored energy for wound that would be subject to
-                        // prox and skin effect for nonzero frequency cases.
-                        if (blockproplist[meshelem[i].blk].LamType>2)
-                        {
-                            double u=Im(blocklist[meshelem[i].lbl].o);
-                            y+=a*Re(J*J)*u/2.;
-                        }
-                    }
-                    y*=AECF(i); // correction for axisymmetric external region;
+            if(Frequency!=0)
+            {
+                y/=2.;
+            }
 
-                    z+=y;
-                    break;
+            y*=AECF(i); // correction for axisymmetric external region;
 
-                case 3:  // Hysteresis & Laminated eddy current losses
-                    if(Frequency!=0)
-                    {
-                        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                        else a*=Depth;
-                        B1=meshelem[i].B1;
-                        B2=meshelem[i].B2;
-                        GetMu(B1,B2,mu1,mu2,i);
-                        H1=B1/(mu1*muo);
-                        H2=B2/(mu2*muo);
-
-                        y=a*PI*Frequency*Im(H1*B1.Conj() + H2*B2.Conj());
-                        z+=y;
-                    }
-                    break;
+            z+=(a*y);
+            break;
 
-                case 4: // Resistive Losses
-                    sig=1.e06/Re(1./blocklist[meshelem[i].lbl].o);
-                    if((blockproplist[meshelem[i].blk].Lam_d!=0) &&
-                            (blockproplist[meshelem[i].blk].LamType==0)) sig=0;
-                    if(sig!=0)
-                    {
+        case 19: // y (or z) direction Henrotte force, SS part.
 
-                        if (problemType==PLANAR)
-                        {
-                            for(k=0; k<3; k++) V[k]=Jn[k].Conj()/sig;
-                            y=PlnInt(a,Jn,V)*Depth;
-                        }
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=HenrotteVector(i);
 
-                        if(problemType==AXISYMMETRIC)
-                            y=2.*PI*R*a*J*conj(J)/sig;
+            y=(((B2*conj(B2)) - (B1*conj(B1)))*Im(c) + 2.*Re(B1*conj(B2))*Re(c))/(2.*muo);
 
-                        if(Frequency!=0) y/=2.;
-                        z+=y;
-                    }
-                    break;
+            y*=AECF(i); // correction for axisymmetric external region;
 
-                case 5: // cross-section area
-                    z+=a;
-                    break;
+            if(Frequency!=0) y/=2.;
+            z+=(a*y);
 
-                case 10: // volume
-                    if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                    else a*=Depth;
-                    z+=a;
-                    break;
+            break;
 
-                case 7: // total current in block;
-                    z+=a*J;
+        case 20: // x (or r) direction Henrotte force, 2x part.
 
-                    break;
+            if(problemType!=0) break;
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=HenrotteVector(i);
+            z+=a*((((B1*B1) - (B2*B2))*Re(c) + 2.*B1*B2*Im(c))/(4.*muo)) * AECF(i);
 
-                case 8: // integrate x or r part of b over the block
-                    if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                    else a*=Depth;
-                    z+=(a*meshelem[i].B1);
-                    break;
+            break;
 
-                case 9: // integrate y or z part of b over the block
-                    if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                    else a*=Depth;
-                    z+=(a*meshelem[i].B2);
-                    break;
+        case 21: // y (or z) direction Henrotte force, 2x part.
 
-                case 17: // Coenergy
-                    if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
-                    else a*=Depth;
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    if(Frequency!=0)
-                    {
-                        // have to compute the energy stored in a special way for
-                        // wound regions subject to prox and skin effects
-                        if (blockproplist[meshelem[i].blk].LamType>2)
-                        {
-                            CComplex mu;
-                            mu=muo*blocklist[meshelem[i].lbl].mu;
-                            double u=Im(1./blocklist[meshelem[i].lbl].o)/(2.e6*PI*Frequency);
-                            y=a*Re(B1*conj(B1)+B2*conj(B2))*Re(1./mu)/4.;
-                            y+=a*Re(J*conj(J))*u/4.;
-                        }
-                        else y=a*blockproplist[meshelem[i].blk].DoCoEnergy(B1,B2);
-                    }
-                    else
-                    {
-                        y=a*blockproplist[meshelem[i].blk].DoCoEnergy(B1.re,B2.re);
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=HenrotteVector(i);
+            z+= a*((((B2*B2) - (B1*B1))*Im(c) + 2.*B1*B2*Re(c))/(4.*muo)) * AECF(i);
 
-                        // add in "local" stored energy for wound that would be subject to
-                        // prox and skin effect for nonzero frequency cases.
-                        if (blockproplist[meshelem[i].blk].LamType>2)
-                        {
-                            double u=Im(blocklist[meshelem[i].lbl].o);
-                            y+=a*Re(J*J)*u/2.;
-                        }
-                    }
-                    y*=AECF(i); // correction for axisymmetric external region;
+            break;
 
-                    z+=y;
-                    break;
+        case 22: // Henrotte torque, SS part.
+            if(problemType!=PLANAR) break;
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=HenrotteVector(i);
 
-                case 24: // Moment of Inertia-like integral
+            F1 = (((B1*conj(B1)) - (B2*conj(B2)))*Re(c) +
+                  2.*Re(B1*conj(B2))*Im(c))/(2.*muo);
+            F2 = (((B2*conj(B2)) - (B1*conj(B1)))*Im(c) +
+                  2.*Re(B1*conj(B2))*Re(c))/(2.*muo);
 
-                    // For axisymmetric problems, compute the moment
-                    // of inertia about the r=0 axis.
-                    if(problemType==AXISYMMETRIC)
-                    {
-                        for(k=0; k<3; k++) V[k]=r[k];
-                        y=AxiInt(a,V,V,r);
-                    }
+            for(c=0,k=0; k<3; k++)
+                c+=meshnode[meshelem[i].p[k]].CC()*LengthConv[LengthUnits]/3.;
 
-                    // For planar problems, compute the moment of
-                    // inertia about the z=axis.
-                    else
-                    {
-                        for(k=0; k<3; k++)
-                        {
-                            U[k]=meshnode[meshelem[i].p[k]].x*LengthConv[LengthUnits];
-                            V[k]=meshnode[meshelem[i].p[k]].y*LengthConv[LengthUnits];
-                        }
-                        y =U[0]*U[0] + U[1]*U[1] + U[2]*U[2];
-                        y+=U[0]*U[1] + U[0]*U[2] + U[1]*U[2];
-                        y+=V[0]*V[0] + V[1]*V[1] + V[2]*V[2];
-                        y+=V[0]*V[1] + V[0]*V[2] + V[1]*V[2];
-                        y*=(a*Depth/6.);
-                    }
+            y=Re(c)*F2 -Im(c)*F1;
+            if(Frequency!=0) y/=2.;
+            y*=AECF(i);
+            z+=(a*y);
 
-                    z+=y;
-                    break;
+            break;
 
-                case 25: // 2D Shape centroid
+        case 23: // Henrotte torque, 2x part.
 
-                    y.re += meshelem[i].ctr.re * a;
-                    y.im += meshelem[i].ctr.im * a;
+            if(problemType!=PLANAR) break;
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=HenrotteVector(i);
+            F1 = (((B1*B1) - (B2*B2))*Re(c) + 2.*B1*B2*Im(c))/(4.*muo);
+            F2 = (((B2*B2) - (B1*B1))*Im(c) + 2.*B1*B2*Re(c))/(4.*muo);
 
-                    break;
+            for(c=0,k=0; k<3; k++)
+                c+=meshnode[meshelem[i].p[k]].CC()*LengthConv[LengthUnits]/3;
 
-                default:
-                    break;
-                }
-            }
+            z+=a*(Re(c)*F2 -Im(c)*F1)*AECF(i);
 
-CComplex temp;
-            // integrals that need to be evaluated over all elements,
-            // regardless of which elements are actually selected.
-            if((inttype>=18) || (inttype<=23))
-            {
-                a=ElmArea(i)*std::pow(LengthConv[LengthUnits],2.);
-                if(problemType==AXISYMMETRIC)
-                {
-                    for(k=0; k<3; k++)
-                        r[k]=meshnode[meshelem[i].p[k]].x*LengthConv[LengthUnits];
-                    R=(r[0]+r[1]+r[2])/3.;
-                    a*=(2.*PI*R);
-                }
-                else a*=Depth;
+            break;
 
-                switch(inttype)
-                {
+        default:
+            break;
+        }
+        return z;
+    }
 
-                case 18: // x (or r) direction Henrotte force, SS part.
-                    if(problemType!=0) break;
+    switch(inttype)
+    {
+    case 0: //  A.J
+        for(k=0; k<3; k++) V[k]=Jn[k].Conj();
+        if(problemType==PLANAR)
+            y=PlnInt(a,A,V)*Depth;
+        else
+            y=AxiInt(a,A,V,r);
+        z+=y;
+
+        break;
 
-                    B1 = meshelem[i].B1;
+    case 11: // x (or r) direction Lorentz force, SS part.
+        B2=meshelem[i].B2;
+        y= -(B2.re*J.re + B2.im*J.im);
+        if (problemType==AXISYMMETRIC) y=0;
+        else y*=Depth;
+        if(Frequency!=0) y*=0.5;
+        z+=(a*y);
+        break;
 
-                    B2 = meshelem[i].B2;
+    case 12: // y (or z) direction Lorentz force, SS part.
+        for(k=0; k<3; k++) V[k]=Re(meshelem[i].B1*Jn[k].Conj());
+        if(problemType==PLANAR)
+            y=PlnInt(a,U,V)*Depth;
+        else
+            y=AxiInt(-a,U,V,r);
+        if(Frequency!=0) y*=0.5;
+        z+=y;
 
-                    c = HenrotteVector(i);
+        break;
 
-                    y = (((B1*conj(B1)) - (B2*conj(B2)))*Re(c) + 2.*Re(B1*conj(B2))*Im(c))/(2.*muo);
+    case 13: // x (or r) direction Lorentz force, 2x part.
+        if((Frequency!=0) && (problemType==PLANAR))
+        {
+            B2=meshelem[i].B2;
+            y= -(B2.re*J.re - B2.im*J.im) - I*(B2.re*J.im+B2.im*J.re);
+            z+=0.5*(a*y*Depth);
+        }
+        break;
 
-                    if(Frequency!=0)
-                    {
-                        y/=2.;
-                    }
+    case 14: // y (or z) direction Lorentz force, 2x part.
+        if (Frequency!=0)
+        {
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            y= (B1.re*J.re - B1.im*J.im) + I*(B1.re*J.im+B1.im*J.re);
+            if(problemType==AXISYMMETRIC) y=(-y*2.*PI*R);
+            else y*=Depth;
+            z+=(a*y)/2.;
+        }
+        break;
 
-                    y*=AECF(i); // correction for axisymmetric external region;
+    case 16: // Lorentz Torque, 2x
+        if ((Frequency!=0) && (problemType==PLANAR))
+        {
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=Ctr(i)*LengthConv[LengthUnits];
+            y= c.re*((B1.re*J.re - B1.im*J.im) + I*(B1.re*J.im+B1.im*J.re))
+               +c.im*((B2.re*J.re - B2.im*J.im) + I*(B2.re*J.im+B2.im*J.re));
+            z+=0.5*(a*y*Depth);
+        }
+        break;
 
-                    z+=(a*y);
-                    break;
+    case 15: // Lorentz Torque, SS part.
+        if(problemType==PLANAR)
+        {
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            c=Ctr(i)*LengthConv[LengthUnits];
+            y= c.im*(B2.re*J.re + B2.im*J.im) + c.re*(B1.re*J.re + B1.im*J.im);
+            if(Frequency!=0) y*=0.5;
+            z+=(a*y*Depth);
+        }
+        break;
+
+    case 1: // integrate A over the element;
+        if(problemType==AXISYMMETRIC)
+            y=AxiInt(a,U,A,r);
+        else
+            for(k=0,y=0; k<3; k++) y+=a*Depth*A[k]/3.;
 
-                case 19: // y (or z) direction Henrotte force, SS part.
+        z+=y;
+        break;
 
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    c=HenrotteVector(i);
+    case 2: // stored energy
+        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+        else a*=Depth;
+        B1=meshelem[i].B1;
+        B2=meshelem[i].B2;
+        if(Frequency!=0)
+        {
+            // have to compute the energy stored in a special way for
+            // wound regions subject to prox and skin effects
+            if (blockproplist[meshelem[i].blk].LamType>2)
+            {
+                CComplex mu;
+                mu=muo*blocklist[meshelem[i].lbl].mu;
+                double u=Im(1./blocklist[meshelem[i].lbl].o)/(2.e6*PI*Frequency);
+                y=a*Re(B1*conj(B1)+B2*conj(B2))*Re(1./mu)/4.;
+                y+=a*Re(J*conj(J))*u/4.;
+            }
+            else y=a*blockproplist[meshelem[i].blk].DoEnergy(B1,B2);
+        }
+        else
+        {
+            // correct H and energy stored in magnet for second-quadrant
+            // representation of a PM.
+            if (blockproplist[meshelem[i].blk].H_c!=0)
+            {
+                int bk=meshelem[i].blk;
 
-                    y=(((B2*conj(B2)) - (B1*conj(B1)))*Im(c) + 2.*Re(B1*conj(B2))*Re(c))/(2.*muo);
+                // in the linear case:
+                if (blockproplist[bk].BHpoints==0)
+                {
+                    CComplex Hc;
+                    mu1=blockproplist[bk].mu_x;
+                    mu2=blockproplist[bk].mu_y;
+                    H1=B1/(mu1*muo);
+                    H2=B2/(mu2*muo);
+                    Hc = blockproplist[bk].H_c*exp(I*PI*meshelem[i].magdir/180.);
+                    H1=H1-Re(Hc);
+                    H2=H2-Im(Hc);
+                    y = a*0.5*muo*(mu1.re*H1.re*H1.re + mu2.re*H2.re*H2.re);
+                }
+                else  // the material is nonlinear
+                {
+                    y=blockproplist[bk].DoEnergy(B1.re,B2.re);
+                    y = y + blockproplist[bk].Nrg
+                        - blockproplist[bk].H_c*Re((B1.re+I*B2.re)/exp(I*PI*meshelem[i].magdir/180.));
+                    y*=a;
+                }
+            }
+            else y=a*blockproplist[meshelem[i].blk].DoEnergy(B1.re,B2.re);
 
-                    y*=AECF(i); // correction for axisymmetric external region;
+            // add in "local" stored energy for wound that would be subject to
+            // prox and skin effect for nonzero frequency cases.
+            if (blockproplist[meshelem[i].blk].LamType>2)
+            {
+                double u=Im(blocklist[meshelem[i].lbl].o);
+                y+=a*Re(J*J)*u/2.;
+            }
+        }
+        y*=AECF(i); // correction for axisymmetric external region;
 
-                    if(Frequency!=0) y/=2.;
-                    z+=(a*y);
+        z+=y;
+        break;
 
-                    break;
+    case 3:  // Hysteresis & Laminated eddy current losses
+        if(Frequency!=0)
+        {
+            if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+            else a*=Depth;
+            B1=meshelem[i].B1;
+            B2=meshelem[i].B2;
+            GetMu(B1,B2,mu1,mu2,i);
+            H1=B1/(mu1*muo);
+            H2=B2/(mu2*muo);
 
-                case 20: // x (or r) direction Henrotte force, 2x part.
+            y=a*PI*Frequency*Im(H1*B1.Conj() + H2*B2.Conj());
+            z+=y;
+        }
+        break;
 
-                    if(problemType!=0) break;
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    c=HenrotteVector(i);
-                    z+=a*((((B1*B1) - (B2*B2))*Re(c) + 2.*B1*B2*Im(c))/(4.*muo)) * AECF(i);
+    case 4: // Resistive Losses
+        sig=1.e06/Re(1./blocklist[meshelem[i].lbl].o);
+        if((blockproplist[meshelem[i].blk].Lam_d!=0) &&
+                (blockproplist[meshelem[i].blk].LamType==0)) sig=0;
+        if(sig!=0)
+        {
 
-                    break;
+            if (problemType==PLANAR)
+            {
+                for(k=0; k<3; k++) V[k]=Jn[k].Conj()/sig;
+                y=PlnInt(a,Jn,V)*Depth;
+            }
 
-                case 21: // y (or z) direction Henrotte force, 2x part.
+            if(problemType==AXISYMMETRIC)
+                y=2.*PI*R*a*J*conj(J)/sig;
 
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    c=HenrotteVector(i);
-                    z+= a*((((B2*B2) - (B1*B1))*Im(c) + 2.*B1*B2*Re(c))/(4.*muo)) * AECF(i);
+            if(Frequency!=0) y/=2.;
+            z+=y;
+        }
+        break;
 
-                    break;
+    case 5: // cross-section area
+        z+=a;
+        break;
 
-                case 22: // Henrotte torque, SS part.
-                    if(problemType!=PLANAR) break;
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    c=HenrotteVector(i);
+    case 10: // volume
+        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+        else a*=Depth;
+        z+=a;
+        break;
 
-                    F1 = (((B1*conj(B1)) - (B2*conj(B2)))*Re(c) +
-                          2.*Re(B1*conj(B2))*Im(c))/(2.*muo);
-                    F2 = (((B2*conj(B2)) - (B1*conj(B1)))*Im(c) +
-                          2.*Re(B1*conj(B2))*Re(c))/(2.*muo);
+    case 7: // total current in block;
+        z+=a*J;
 
-                    for(c=0,k=0; k<3; k++)
-                        c+=meshnode[meshelem[i].p[k]].CC()*LengthConv[LengthUnits]/3.;
+        break;
 
-                    y=Re(c)*F2 -Im(c)*F1;
-                    if(Frequency!=0) y/=2.;
-                    y*=AECF(i);
-                    z+=(a*y);
+    case 8: // integrate x or r part of b over the block
+        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+        else a*=Depth;
+        z+=(a*meshelem[i].B1);
+        break;
 
-                    break;
+    case 9: // integrate y or z part of b over the block
+        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+        else a*=Depth;
+        z+=(a*meshelem[i].B2);
+        break;
 
-                case 23: // Henrotte torque, 2x part.
+    case 17: // Coenergy
+        if(problemType==AXISYMMETRIC) a*=(2.*PI*R);
+        else a*=Depth;
+        B1=meshelem[i].B1;
+        B2=meshelem[i].B2;
+        if(Frequency!=0)
+        {
+            // have to compute the energy stored in a special way for
+            // wound regions subject to prox and skin effects
+            if (blockproplist[meshelem[i].blk].LamType>2)
+            {
+                CComplex mu;
+                mu=muo*blocklist[meshelem[i].lbl].mu;
+                double u=Im(1./blocklist[meshelem[i].lbl].o)/(2.e6*PI*Frequency);
+                y=a*Re(B1*conj(B1)+B2*conj(B2))*Re(1./mu)/4.;
+                y+=a*Re(J*conj(J))*u/4.;
+            }
+            else y=a*blockproplist[meshelem[i].blk].DoCoEnergy(B1,B2);
+        }
+        else
+        {
+            y=a*blockproplist[meshelem[i].blk].DoCoEnergy(B1.re,B2.re);
 
-                    if(problemType!=PLANAR) break;
-                    B1=meshelem[i].B1;
-                    B2=meshelem[i].B2;
-                    c=HenrotteVector(i);
-                    F1 = (((B1*B1) - (B2*B2))*Re(c) + 2.*B1*B2*Im(c))/(4.*muo);
-                    F2 = (((B2*B2) - (B1*B1))*Im(c) + 2.*B1*B2*Re(c))/(4.*muo);
+            // add in "local" stored energy for wound that would be subject to
+            // prox and skin effect for nonzero frequency cases.
+            if (blockproplist[meshelem[i].blk].LamType>2)
+            {
+                double u=Im(blocklist[meshelem[i].lbl].o);
+                y+=a*Re(J*J)*u/2.;
+            }
+        }
+        y*=AECF(i); // correction for axisymmetric external region;
 
-                    for(c=0,k=0; k<3; k++)
-                        c+=meshnode[meshelem[i].p[k]].CC()*LengthConv[LengthUnits]/3;
+        z+=y;
+        break;
 
-                    z+=a*(Re(c)*F2 -Im(c)*F1)*AECF(i);
+    case 24: // Moment of Inertia-like integral
 
-                    break;
+        // For axisymmetric problems, compute the moment
+        // of inertia about the r=0 axis.
+        if(problemType==AXISYMMETRIC)
+        {
+            for(k=0; k<3; k++) V[k]=r[k];
+            y=AxiInt(a,V,V,r);
+        }
 
-                default:
-                    break;
-                }
+        // For planar problems, compute the moment of
+        // inertia about the z=axis.
+        else
+        {
+            for(k=0; k<3; k++)
+            {
+                U[k]=meshnode[meshelem[i].p[k]].x*LengthConv[LengthUnits];
+                V[k]=meshnode[meshelem[i].p[k]].y*LengthConv[LengthUnits];
             }
+            y =U[0]*U[0] + U[1]*U[1] + U[2]*U[2];
+            y+=U[0]*U[1] + U[0]*U[2] + U[1]*U[2];
+            y+=V[0]*V[0] + V[1]*V[1] + V[2]*V[2];
+            y+=V[0]*V[1] + V[0]*V[2] + V[1]*V[2];
+            y*=(a*Depth/6.);
         }
-    }
 
-    if (inttype == 25) // 2D shape centroid
-    {
-        // divide sum of Cx*A and Cy*A by sum of A
-        CComplex temp = BlockIntegral(5);
-        z.re = y.Re() / temp.Re();
-        z.im = y.Im() / temp.Re();
+        z+=y;
+        break;
+
+    case 25: // 2D Shape centroid, divided by the area later on
+
+        z.re += meshelem[i].ctr.re * a;
+        z.im += meshelem[i].ctr.im * a;
+
+        break;
+
+    default:
+        break;
     }
 
     return z;
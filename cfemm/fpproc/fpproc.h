@@ -49,7 +49,9 @@
 #include "CPointProp.h"
 #include "CSegment.h"
 #include "PostProcessor.h"
+#include "SpatialGrid.h"
 
+#include <memory>
 #include <vector>
 
 //#ifndef PLANAR
@@ -78,6 +80,8 @@ enum class FPProcError {
     NoError
 };
 
+class CBigLinProb;
+
 class FPProc : public femm::PProcIface
 {
 
@@ -123,6 +127,7 @@ public:
     int  d_LineIntegralPoints;
     bool d_ShiftH;
     bool bHasMask;
+    bool bHasPlotBounds;
     int bIncremental;
 
     // lists of nodes, segments, and block labels
@@ -153,6 +158,28 @@ public:
     std::vector< femmsolver::CMMeshNode >  *pmeshnode;
     std::vector< femmpostproc::CPostProcMElement >   *pmeshelem;
 
+    // bounding boxes of the mesh elements
+    femm::SpatialGrid elementIndex;
+    // the element found by the last call to InTriangle()
+    mutable int lastElement;
+    // whether the nodal flux densities of an element have been computed
+    std::vector<char> nodalBValid;
+    // smoothed nodal flux densities, 3 per element; allocated by the first call to ensureNodalB()
+    std::vector<CComplex> nodalB1;
+    std::vector<CComplex> nodalB2;
+    // flux density of the previous solution per element (incremental problems only)
+    std::vector<double> elementB1p;
+    std::vector<double> elementB2p;
+
+    // masks computed by MakeMask(), keyed by the weighting scheme and the selected block labels
+    struct CachedMask {
+        std::vector<int> key;
+        std::vector<double> mask;
+    };
+    std::vector<CachedMask> maskCache;
+    // linear problem of the last MakeMask() call; its matrix pattern is reused for other selections
+    std::unique_ptr<CBigLinProb> maskProblem;
+
 //    TriEdge recenttri;
 //    int samples;
 //    unsigned long randomseed;
@@ -160,21 +187,97 @@ public:
 //    int numberofbdrylink;
 
     // member functions
+    /**
+     * @brief Find the mesh element that contains a point.
+     * @param x
+     * @param y
+     * @return the element index, or -1 if the point is outside of the mesh
+     */
     int InTriangle(double x, double y) const;
+    /**
+     * @brief Find the mesh element that contains a point, starting the search at a given element.
+     * In contrast to InTriangle(x,y), this method doesn't modify the post-processor.
+     * @param x
+     * @param y
+     * @param hint the element to check first; set to the found element (input and output variable)
+     * @return the element index, or -1 if the point is outside of the mesh
+     */
+    int InTriangle(double x, double y, int &hint) const;
     bool InTriangleTest(double x, double y, int i) const;
     bool GetPointValues(double x, double y, CMPointVals &u);
     bool GetPointValues(double x, double y, int k, CMPointVals &u);
+    /**
+     * @brief Get the point values for many points at once.
+     *
+     * The points are split into consecutive chunks that are evaluated concurrently.
+     * Apart from computing the missing nodal flux densities (see ensureNodalB()) before the
+     * evaluation starts, this method doesn't modify the post-processor.
+     * In particular, the search position of InTriangle(x,y) is left untouched.
+     *
+     * \note Points that lie exactly on an element edge may be assigned to a different
+     * (adjacent) element than in a sequence of single point calls.
+     *
+     * @param numPoints number of points
+     * @param x x coordinates of the points
+     * @param y y coordinates of the points
+     * @param values the point values (output variable)
+     * @param numThreads number of threads to use; 0 to use the number of available cores
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void GetPointValues(int numPoints, const double *x, const double *y, CMPointValsArray &values, int numThreads = 0);
     // void GetLineValues(CXYPlot &p, int PlotType, int npoints);
     // void GetGapValues(CXYPlot &p, int PlotType, int npoints, int myAGE);
-    void GetElementB(femmpostproc::CPostProcMElement &elm);
+    void GetElementB(int k);
     void FindBoundaryEdges();
+    /**
+     * @brief Build the spatial index that is used by InTriangle().
+     * Needs to be called whenever the mesh has been loaded.
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void buildElementIndex();
     CComplex Ctr(int i) const;
     double ElmArea(int i) const;
     double ElmArea(femmpostproc::CPostProcMElement *elm) const;
     double ElmVolume(int i) const;
     //double ElmVolume(CElement *elm);
-    void GetPointB(const double x, const double y, CComplex &B1, CComplex &B2, const femmpostproc::CPostProcMElement &elm);
+    /**
+     * @brief Interpolate the flux density at a point within an element.
+     * If smoothing is enabled, the nodal flux densities of the element must be available (see ensureNodalB()).
+     */
+    void GetPointB(const double x, const double y, CComplex &B1, CComplex &B2, int k) const;
     void GetNodalB(CComplex *b1, CComplex *b2,femmpostproc::CPostProcMElement &elm);
+    /**
+     * @brief Compute the smoothed nodal flux densities (nodalB1, nodalB2) of element \p i, unless that has already been done.
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * femm42 computes the nodal flux densities of all elements when loading the solution.
+     * \endinternal
+     */
+    void ensureNodalB(int i);
+    /**
+     * @brief Compute the smoothed nodal flux densities of all elements.
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void computeNodalB();
+    /**
+     * @brief Compute the extreme values of B, H, and J used for plotting (PlotBounds, B_Low, B_High, H_High).
+     * This is only done once per document.
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * femm42 computes the extreme values when loading the solution.
+     * \endinternal
+     */
+    void computePlotBounds();
     /**
      * @brief Compute the block integral over selected blocks.
      *
@@ -219,6 +322,22 @@ public:
      * @return the requested block integral
      */
     CComplex BlockIntegral(const int inttype);
+    /**
+     * @brief Compute several block integrals over the selected blocks in a single pass over the elements.
+     *
+     * The elements are processed in fixed-size batches, which are distributed across \p numThreads threads.
+     * The partial sums of the batches are added up in a fixed order, so the results don't depend on the number of threads.
+     * The per-element quantities (J, A, element area) are cached until a different document is opened.
+     *
+     * @param inttypes the identifiers of the block integrals (see BlockIntegral())
+     * @param results the integrals, in the same order as \p inttypes (output variable)
+     * @param numThreads number of threads to use; 0 to use the number of available cores
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void BlockIntegrals(const std::vector<int> &inttypes, std::vector<CComplex> &results, int numThreads = 0);
     void LineIntegral(int inttype, CComplex *z);
 
     int ClosestNode(const double x, const double y) const;
@@ -290,6 +409,19 @@ private:
 
     char warnBuf [1028];
 
+    /// element quantities that are used by most block integrals
+    struct ElementQuantities {
+        CComplex J;     ///< average current density
+        CComplex Jn[3]; ///< nodal current density
+        CComplex A[3];  ///< nodal vector potential
+        double a;       ///< element area in m^2
+        double r[3];    ///< nodal radius in m (axisymmetric problems only)
+        double R;       ///< average radius in m (axisymmetric problems only)
+    };
+    std::vector<ElementQuantities> elementQuantities;
+    void updateElementQuantities(int numThreads);
+    CComplex blockIntegralTerm(const int inttype, const int i, const ElementQuantities &q);
+
 //#ifdef _DEBUG
     //virtual void AssertValid() const;
     //virtual void Dump(CDumpContext& dc) const;
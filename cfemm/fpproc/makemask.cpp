@@ -17,6 +17,9 @@
 
 // #define SIMPLE
 
+// number of masks that are kept for reuse when the selection changes
+#define MaxCachedMasks 8
+
 using namespace femm;
 
 #ifdef SIMPLE
@@ -50,7 +53,6 @@ bool FPProc::MakeMask()
     if(bHasMask) return true;
 
 	int i,j,k,d;
-	CBigLinProb L;
 	//CMaskProgress dlg;
 	double bsq,dbsq,v;
 	double Me[3][3],be[3];		// element matrix;
@@ -64,6 +66,21 @@ bool FPProc::MakeMask()
 	int NumEls=meshelem.size();
     bool bOnAxis=false;
 
+    // xfemm: reuse the mask of a previous selection, if possible
+    std::vector<int> maskKey;
+    maskKey.push_back(WeightingScheme);
+    for(i=0;i<(int)blocklist.size();i++)
+        if(blocklist[i].IsSelected) maskKey.push_back(i);
+    for (const auto &cached: maskCache)
+    {
+        if (cached.key == maskKey)
+        {
+            for(i=0;i<NumNodes;i++) meshnode[i].msk=cached.mask[i];
+            bHasMask=true;
+            return true;
+        }
+    }
+
 	static int plus1mod3[3] = {1, 2, 0};
 	static int minus1mod3[3] = {2, 0, 1};
 
@@ -76,20 +93,29 @@ bool FPProc::MakeMask()
 //		L.Pump();
 //	}
 
-	// figure out bandwidth--helps speed somethings up;
-	int bw=0;
-	for(i=0;i<NumEls;i++)
+	// xfemm: the matrix pattern only depends on the mesh, so we keep the
+	// linear problem and only reset its values when the selection changes
+	if (maskProblem && maskProblem->n==NumNodes)
 	{
-		for(j=0;j<3;j++)
+		maskProblem->Wipe();
+	} else {
+		// figure out bandwidth--helps speed somethings up;
+		int bw=0;
+		for(i=0;i<NumEls;i++)
 		{
-			k=j+1; if (k==3) k=0;
-			d=abs(meshelem[i].p[j]-meshelem[i].p[k]);
-			if (d>bw) bw=d;
+			for(j=0;j<3;j++)
+			{
+				k=j+1; if (k==3) k=0;
+				d=abs(meshelem[i].p[j]-meshelem[i].p[k]);
+				if (d>bw) bw=d;
+			}
 		}
-	}
-	bw++;
+		bw++;
 
-	L.Create(NumNodes,bw);
+		maskProblem.reset(new CBigLinProb);
+		maskProblem->Create(NumNodes,bw);
+	}
+	CBigLinProb &L = *maskProblem;
 
 	 // if the problem is axisymmetric, does the selection lie along r=0?
 	if(problemType==AXISYMMETRIC)
@@ -268,12 +294,13 @@ bool FPProc::MakeMask()
 			case 3:
 				// determine a weighting for the element
 				// based on an error measure;
+				ensureNodalB(i);
 				for(j=0,bsq=0,dbsq=0;j<3;j++)
 				{
-					dbsq+=Re((meshelem[i].B1-meshelem[i].b1[j])*
-						 conj(meshelem[i].B1-meshelem[i].b1[j]) +
-							 (meshelem[i].B2-meshelem[i].b2[j])*
-						 conj(meshelem[i].B2-meshelem[i].b2[j]));
+					dbsq+=Re((meshelem[i].B1-nodalB1[3*i+j])*
+						 conj(meshelem[i].B1-nodalB1[3*i+j]) +
+							 (meshelem[i].B2-nodalB2[3*i+j])*
+						 conj(meshelem[i].B2-nodalB2[3*i+j]));
 					bsq +=Re(meshelem[i].B1*conj(meshelem[i].B1) +
 							 meshelem[i].B2*conj(meshelem[i].B2));
 				}
@@ -375,6 +402,14 @@ bool FPProc::MakeMask()
 	free(lblflag);
     bHasMask=true;
 
+    // remember the mask for this selection
+    if (maskCache.size() >= MaxCachedMasks)
+        maskCache.erase(maskCache.begin());
+    maskCache.push_back(CachedMask());
+    maskCache.back().key = maskKey;
+    maskCache.back().mask.resize(NumNodes);
+    for(i=0;i<NumNodes;i++) maskCache.back().mask[i]=meshnode[i].msk;
+
     return true;
 }
 
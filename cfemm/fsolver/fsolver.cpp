@@ -35,6 +35,8 @@
 #include <fparse.h>
 #include <fsolver.h>
 #include <LuaInstance.h>
+#include <MemoryFiles.h>
+#include <Profiler.h>
 #include <spars.h>
 
 #include <algorithm>
@@ -86,6 +88,7 @@ FSolver::FSolver()
 {
     Frequency = 0.0;
     Relax = 0.0;
+    warmStart = false;
     ACSolver=0;
     NumCircPropsOrig = 0;
 
@@ -349,6 +352,7 @@ bool FSolver::LoadProblemFile ()
 
 LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 {
+    femm::ProfileScope profile("load");
     int i,j,k,q,n0,n1;
     char infile[256];
     FILE *fp;
@@ -361,7 +365,7 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
     //read meshnodes;
     sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADNODEFILE;
     }
@@ -393,7 +397,7 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
     //read in periodic boundary conditions;
     sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADPBCFILE;
     }
@@ -524,7 +528,7 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
         WarnMessage(buf);
     }
 #endif // DEBUG
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADELEMENTFILE;
     }
@@ -572,15 +576,15 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
             }
             return MISSINGMATPROPS;
         }
@@ -594,15 +598,15 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
             }
             return ELMLABELTOOBIG;
         }
@@ -660,7 +664,7 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
         }
 
     sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         return BADEDGEFILE;
     }
@@ -708,13 +712,13 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
     {
         // clear out temporary files
         sprintf(infile,"%s.ele",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.node",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.pbc",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.poly",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
     }
 
     return NOERROR;
@@ -801,88 +805,82 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 //    return true;
 //}
 
-bool FSolver::LoadMeshNodesFromSolution(bool loadAprev, FILE* fp)
+bool FSolver::LoadMeshNodesFromSolution(bool loadAprev, femm::SolutionBuffer &solution)
 {
-    double tmpAprev;
-    char s[1024];
-
     // read in nodes
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&NumNodes);
+    femm::SolutionTable table;
+    NumNodes=0;
+    if (!solution.nextTable(table))
+        return false;
+    NumNodes = table.size();
 
     Aprev.clear();
     Aprev.shrink_to_fit();
 
     if (loadAprev)
     {
-        Aprev.reserve(NumNodes);
+        Aprev.resize(NumNodes);
     }
 
     meshnode.clear ();
     meshnode.shrink_to_fit();
-    meshnode.reserve(NumNodes);
-    CNode node;
-    for(int i=0;i<NumNodes;i++)
-    {
-        fgets(s,1024,fp);
-        sscanf(s,"%lf   %lf     %lf     %i\n",&node.x,&node.y,&tmpAprev,&node.BoundaryMarker);
+    meshnode.resize(NumNodes);
+    const double cf = 100 * LengthConvMeters[LengthUnits];
+    femm::decodeRecords(table, [this,loadAprev,cf](int i, femm::SolutionTable::Record &r) {
+        CNode &node = meshnode[i];
+        double tmpAprev = 0;
+        if (r.next(node.x) && r.next(node.y) && r.next(tmpAprev))
+            r.next(node.BoundaryMarker);
 
         // convert all lengths to centimeters (better conditioning this way...)
-        node.x *= 100 * LengthConvMeters[LengthUnits];
-        node.y *= 100 * LengthConvMeters[LengthUnits];
+        node.x *= cf;
+        node.y *= cf;
 
         if (loadAprev)
         {
-            Aprev.push_back(tmpAprev);
+            Aprev[i] = tmpAprev;
         }
-
-        meshnode.push_back(node);
-    }
+        return true;
+    });
 
     return true;
 }
 
-bool FSolver::LoadMeshElementsFromSolution(FILE* fp)
+bool FSolver::LoadMeshElementsFromSolution(femm::SolutionBuffer &solution)
 {
-    char s[1024];
-
-    fgets (s, 1024, fp);
-
-    sscanf (s,"%i", &NumEls);
+    femm::SolutionTable table;
+    NumEls=0;
+    if (!solution.nextTable(table))
+        return false;
+    NumEls = table.size();
 
     using CMElement = femmsolver::CMElement;
 
     meshele.clear();
     meshele.shrink_to_fit();
-    meshele.reserve (NumEls);
+    meshele.resize (NumEls);
 
-    for(int i=0; i<NumEls; i++)
-    {
-        CMElement elm;
+    femm::decodeRecords(table, [this](int i, femm::SolutionTable::Record &r) {
+        CMElement &elm = meshele[i];
 
-        fgets(s,1024,fp);
-
-        sscanf ( s,
-                 "%i    %i      %i      %i      %i      %i      %i      %lf\n",
-                 &elm.p[0],
-                 &elm.p[1],
-                 &elm.p[2],
-                 &elm.lbl,
-                 &elm.e[0],
-                 &elm.e[1],
-                 &elm.e[2],
-                 &elm.Jprev );
+        if (r.next(elm.p[0])
+                && r.next(elm.p[1])
+                && r.next(elm.p[2])
+                && r.next(elm.lbl)
+                && r.next(elm.e[0])
+                && r.next(elm.e[1])
+                && r.next(elm.e[2]))
+            r.next(elm.Jprev);
 
         // look up block type out of the list of block labels
         elm.blk = labellist[elm.lbl].BlockType;
-
-        meshele.push_back(elm);
-    }
+        return true;
+    });
 
     return true;
 }
 
-bool FSolver::LoadPBCFromSolution(FILE* fp)
+bool FSolver::LoadPBCFromSolution(femm::SolutionBuffer &solution)
 {
     char s[1024];
 
@@ -892,7 +890,7 @@ bool FSolver::LoadPBCFromSolution(FILE* fp)
     // remove any previously reserved capacity
     pbclist.shrink_to_fit();
 
-    if (fgets(s,1024,fp)!=0)
+    if (solution.getLine(s,1024)!=0)
     {
         sscanf(s,"%i",&NumPBCs);
 
@@ -902,7 +900,7 @@ bool FSolver::LoadPBCFromSolution(FILE* fp)
         for(int i=0;i<NumPBCs;i++)
         {
             CCommonPoint pbc;
-            fgets(s,1024,fp);
+            solution.getLine(s,1024);
             sscanf(s,"%i    %i      %i\n",&pbc.x,&pbc.y,&pbc.t);
             pbclist.push_back(pbc);
         }
@@ -911,12 +909,12 @@ bool FSolver::LoadPBCFromSolution(FILE* fp)
     return true;
 }
 
-bool FSolver::LoadAGEsFromSolution(FILE* fp)
+bool FSolver::LoadAGEsFromSolution(femm::SolutionBuffer &solution)
 {
     char s[1024];
     CAirGapElement age;
 
-    fgets(s,1024,fp);
+    solution.getLine(s,1024);
     sscanf(s,"%i",&NumAirGapElems);
 
     agelist.clear();
@@ -926,11 +924,11 @@ bool FSolver::LoadAGEsFromSolution(FILE* fp)
     for(int i=0; i<NumAirGapElems; i++)
     {
 
-        fgets(s,80,fp);
+        solution.getLine(s,80);
 
         age.BdryName = std::string (s);
 
-        fgets(s,1024,fp);
+        solution.getLine(s,1024);
 
         sscanf( s, "%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
                 &age.BdryFormat,
@@ -953,7 +951,7 @@ bool FSolver::LoadAGEsFromSolution(FILE* fp)
         {
             CQuadPoint qp;
 
-            fgets(s,1024,fp);
+            solution.getLine(s,1024);
             sscanf ( s,"%i %lf %i %lf %i %lf %i %lf",
                      &qp.n0,
                      &qp.w0,
@@ -1001,7 +999,8 @@ bool FSolver::loadPreviousSolution(bool loadAprev)
     }
 
     FILE *fp;
-    if ((fp=fopen(previousSolutionFile.c_str(),"rt"))==NULL){
+    femm::SolutionFormat format;
+    if ((fp=femm::openSolutionFile(previousSolutionFile,format))==NULL){
         SNPRINTF (warnbuf, sizeof(warnbuf),
                   "Failed to open the specified previous solution file, file path was:\n%s\n",
                   previousSolutionFile.c_str());
@@ -1058,25 +1057,28 @@ bool FSolver::loadPreviousSolution(bool loadAprev)
     // read in the previous solution!!!
     ///////////////////////////
 
+    // read the whole solution section at once
+    femm::SolutionBuffer solution;
+    solution.readFrom(fp,format);
+    fclose(fp);
+
     // read in nodes
-    LoadMeshNodesFromSolution(loadAprev, fp);
+    LoadMeshNodesFromSolution(loadAprev, solution);
 
     // read elements
-    LoadMeshElementsFromSolution(fp);
+    LoadMeshElementsFromSolution(solution);
 
     // scroll through block label info
-    fgets(s,1024,fp);
-    int numLabels;
+    solution.getLine(s,1024);
+    int numLabels=0;
     sscanf(s,"%i",&numLabels);
-    for(int i=0;i<numLabels;i++) fgets(s,1024,fp);
+    for(int i=0;i<numLabels;i++) solution.getLine(s,1024);
 
     // read in PBC list
-    LoadPBCFromSolution(fp);
+    LoadPBCFromSolution(solution);
 
     // read in air gap elements
-    LoadAGEsFromSolution(fp);
-
-    fclose(fp);
+    LoadAGEsFromSolution(solution);
 
     meshLoadedFromPrevSolution = true;
 
@@ -1340,6 +1342,172 @@ bool FSolver::runSolver(bool verbose)
     return true;
 }
 
+bool FSolver::updateAirGapCoupling(CAirGapElement &age) const
+{
+    const int n = age.totalArcElements;
+    if (n < 1 || (int)age.quadNode.size() != n+1)
+        return false;
+
+    const double dtta = age.totalArcLength/n;
+    const int n0 = (int) round(360./dtta); // total elements in a 360deg annular ring
+    const int n1 = (int) round(360./age.totalArcLength); // number of copied segments
+    if (n*n1 != n0)
+        return false;
+
+    // any n consecutive points on a ring hold each boundary node exactly once
+    std::vector<int> innerNodes(n);
+    std::vector<int> outerNodes(n);
+    for (int i=0; i<n; i++)
+    {
+        innerNodes[i] = age.quadNode[i].n1;
+        outerNodes[i] = age.quadNode[i].n3;
+    }
+
+    // mesh nodes are stored in centimeters, but agc is in drawing units
+    const CComplex agc = age.agc * (100 * LengthConvMeters[LengthUnits]);
+    auto ringAngle = [&](CComplex rot, int node) {
+        CComplex a0 = rot*(meshnode[node].CC()-agc); // position of the shifted mesh node
+        double t = (Im(a0)>=0) ? arg(a0) : (arg(a0) + 2.*PI);
+        return t*(180./PI)/dtta;
+    };
+
+    // map each bdry point onto points on the ring
+    std::vector<CQuadPoint> InnerRing (n0);
+    std::vector<CQuadPoint> OuterRing (n0);
+    for (int j=0, kk=0; j<n1; j++) // do each slice
+    {
+        const double dL = ((age.BdryFormat==1) && (j % 2 != 0)) ? -1 : 1; // antiperiodic
+        const CComplex a1 = exp(I*(j*age.totalArcLength+age.InnerAngle)*DEGREE);
+        const CComplex a2 = exp(I*(j*age.totalArcLength+age.OuterAngle)*DEGREE);
+        for (int i=0; i<n; i++, kk++)
+        {
+            InnerRing[kk].n0 = innerNodes[i];
+            InnerRing[kk].w0 = ringAngle(a1, innerNodes[i]);
+            InnerRing[kk].w1 = dL;
+
+            OuterRing[kk].n0 = outerNodes[i];
+            OuterRing[kk].w0 = ringAngle(a2, outerNodes[i]);
+            OuterRing[kk].w1 = dL;
+        }
+    }
+
+    // sort the rings based on the angle of the points in the ring
+    auto byAngle = [](const CQuadPoint &a, const CQuadPoint &b) { return a.w0 < b.w0; };
+    std::stable_sort(InnerRing.begin(), InnerRing.end(), byAngle);
+    std::stable_sort(OuterRing.begin(), OuterRing.end(), byAngle);
+
+    age.InnerShift = InnerRing[0].w0;
+    age.OuterShift = OuterRing[0].w0;
+    for (int i=0; i<=n; i++)
+    {
+        int p1 = i; if (p1==n0) p1=0;
+        int p0 = p1-1; if (p0<0) p0=n0+p0;
+
+        // ring points that bracket points in the annulus mesh
+        // and their sign, for the purposes of periodicity/antiperiodicity
+        CQuadPoint &qp = age.quadNode[i];
+        qp.n0 = InnerRing[p0].n0; qp.w0 = InnerRing[p0].w1;
+        qp.n1 = InnerRing[p1].n0; qp.w1 = InnerRing[p1].w1;
+        qp.n2 = OuterRing[p0].n0; qp.w2 = OuterRing[p0].w1;
+        qp.n3 = OuterRing[p1].n0; qp.w3 = OuterRing[p1].w1;
+    }
+    return true;
+}
+
+bool FSolver::setAirGapInnerAngle(const string &bdryName, double innerAngle)
+{
+    bool found = false;
+    for (CAirGapElement &age: agelist)
+    {
+        // the name is stored as read from the .pbc file, i.e. with quotes and line break
+        std::string name = age.BdryName;
+        name.erase(std::remove_if(name.begin(), name.end(),
+                                  [](char c) { return c=='"' || c=='\r' || c=='\n'; }), name.end());
+        if (!bdryName.empty() && name != bdryName)
+            continue;
+
+        age.InnerAngle = innerAngle;
+        if (!updateAirGapCoupling(age))
+        {
+            WarnMessage(("Inconsistent ring nodes in air gap element " + name + "\n").c_str());
+            return false;
+        }
+        found = true;
+    }
+    return found;
+}
+
+string FSolver::sweepSolutionFile(int k) const
+{
+    return PathName + "_" + to_string(k) + ".ans";
+}
+
+bool FSolver::runRotorSweep(const string &bdryName, const std::vector<double> &angles, std::function<bool (int)> stepDone, bool verbose)
+{
+    if (Frequency != 0 || ProblemType != PLANAR || !previousSolutionFile.empty())
+    {
+        WarnMessage("Rotor sweeps are only supported for planar magnetostatic problems.\n");
+        return false;
+    }
+
+    // the mesh is loaded and renumbered only once for all rotor positions
+    LoadMeshErr err = LoadMesh();
+    if (err != NOERROR)
+    {
+        WarnMessage(getErrorString(err).c_str());
+        return false;
+    }
+
+    if (verbose) PrintMessage("renumbering nodes using Cuthill-McKee method\n");
+    if (!Cuthill())
+    {
+        WarnMessage("problem renumbering node points\n");
+        return false;
+    }
+
+    CBigLinProb L;
+    L.Precision = Precision;
+    if (L.Create(NumNodes, BandWidth) == false)
+    {
+        WarnMessage("couldn't allocate enough space for matrices\n");
+        return false;
+    }
+
+    warmStart = false;
+    for (int k=0; k<(int)angles.size(); k++)
+    {
+        if (!setAirGapInnerAngle(bdryName, angles[k]))
+        {
+            WarnMessage(("Couldn't turn air gap element " + bdryName + "\n").c_str());
+            warmStart = false;
+            return false;
+        }
+        if (verbose)
+            PrintMessage(("solving for InnerAngle=" + to_string(angles[k]) + "\n").c_str());
+
+        // the solution of the previous rotor position is a good starting point
+        Relax = 1.;
+        bool ok = Static2D(L);
+        warmStart = true;
+        if (!ok)
+        {
+            WarnMessage("Couldn't solve the problem\n");
+            warmStart = false;
+            return false;
+        }
+        if (WriteStatic2D(L, sweepSolutionFile(k)) == false)
+        {
+            WarnMessage("couldn't write results to disk\n");
+            warmStart = false;
+            return false;
+        }
+        if (stepDone && !stepDone(k))
+            break;
+    }
+    warmStart = false;
+    return true;
+}
+
 // SortNodes: sorts mesh nodes based on a new numbering
 void FSolver::SortNodes (std::vector<int> newnum)
 {
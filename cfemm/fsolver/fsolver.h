@@ -32,6 +32,7 @@
 #ifndef FSOLVER_H
 #define FSOLVER_H
 
+#include <functional>
 #include <string>
 #include <vector>
 #include "feasolver.h"
@@ -42,6 +43,7 @@
 #include "CMaterialProp.h"
 #include "CNode.h"
 #include "CPointProp.h"
+#include "SolutionFile.h"
 
 namespace femm {
 class LuaInstance;
@@ -86,22 +88,23 @@ public:
      */
     bool loadPreviousSolution(bool loadAprev);
     //bool LoadMeshFromPrevSolution(bool loadAprev);
-    bool LoadMeshNodesFromSolution(bool loadA, FILE* fp);
-    bool LoadMeshElementsFromSolution(FILE* fp);
-    bool LoadPBCFromSolution(FILE* fp);
-    bool LoadAGEsFromSolution(FILE* fp);
+    bool LoadMeshNodesFromSolution(bool loadA, femm::SolutionBuffer &solution);
+    bool LoadMeshElementsFromSolution(femm::SolutionBuffer &solution);
+    bool LoadPBCFromSolution(femm::SolutionBuffer &solution);
+    bool LoadAGEsFromSolution(femm::SolutionBuffer &solution);
     bool LoadProblemFile();
     int Static2D(CBigLinProb &L);
     /**
      * @brief WriteStatic2D
      * @param L
+     * @param ansFile name of the solution file; if empty, PathName.ans is used
      * @return \c true on success, \c false otherwise.
      * \internal
      * ### FEMM reference source
      *  - \femm42{fkn/prob1big.cpp,CFemmeDocCore::WriteStatic2D()}
      * \endinternal
      */
-    int WriteStatic2D(CBigLinProb &L);
+    int WriteStatic2D(CBigLinProb &L, const std::string &ansFile = std::string());
     int Harmonic2D(CBigComplexLinProb &L,bool verbose=false);
     int WriteHarmonic2D(CBigComplexLinProb &L);
     int StaticAxisymmetric(CBigLinProb &L);
@@ -111,6 +114,39 @@ public:
 
     virtual bool runSolver(bool verbose=false) override;
 
+    /**
+     * @brief Turn the inner ring (rotor side) of air gap elements.
+     * The mesh is not changed. Only the coupling between the annulus of the air gap element
+     * and the mesh nodes on its rings is recomputed.
+     * @param bdryName name of the air gap boundary, or an empty string for all air gap elements
+     * @param innerAngle the new InnerAngle in degrees
+     * @return \c true, if at least one air gap element was updated, \c false otherwise.
+     */
+    bool setAirGapInnerAngle(const std::string &bdryName, double innerAngle);
+
+    /**
+     * @brief Solve a planar magnetostatic problem for a sequence of rotor positions.
+     * The mesh is loaded and renumbered only once.
+     * For each angle, the air gap elements are turned using setAirGapInnerAngle(),
+     * and the problem is solved again using the previous solution as starting point.
+     *
+     * The solution for the k-th angle is written to sweepSolutionFile(k).
+     * @param bdryName name of the air gap boundary, or an empty string for all air gap elements
+     * @param angles values for InnerAngle in degrees
+     * @param stepDone if set, this is called with the index of the angle after its solution has been written.
+     * If it returns \c false, the sweep is stopped.
+     * @param verbose
+     * @return \c true on success, \c false otherwise.
+     */
+    bool runRotorSweep(const std::string &bdryName, const std::vector<double> &angles,
+                       std::function<bool(int)> stepDone = nullptr, bool verbose=false);
+    /**
+     * @brief The name of the solution file written by runRotorSweep() for the k-th angle.
+     * @param k
+     * @return PathName_k.ans
+     */
+    std::string sweepSolutionFile(int k) const;
+
 private:
 
     virtual void CleanUp() override;
@@ -138,6 +174,14 @@ private:
      */
     void getPrev2DB(int k, double &B1p, double &B2p) const;
 
+    /**
+     * @brief Compute the coupling between air gap element and mesh from InnerAngle and OuterAngle.
+     * This recomputes quadNode, InnerShift and OuterShift in the same way as fmesher does when writing the .pbc file.
+     * @param age
+     * @return \c false, if the ring nodes are inconsistent with the arc length of the air gap element.
+     */
+    bool updateAirGapCoupling(femmsolver::CAirGapElement &age) const;
+
     // override parent class virtual method
     void SortNodes (std::vector<int> newnum) override;
 
@@ -147,6 +191,9 @@ private:
 
     /// Vector containing previous solution for incremental permeability analysis
     std::vector <double> Aprev;
+
+    /// If set, Static2D() continues from the solution that is already present in L.V
+    bool warmStart;
 };
 
 /////////////////////////////////////////////////////////////////////////////
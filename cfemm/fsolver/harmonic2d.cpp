@@ -23,6 +23,8 @@
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fsolver.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
 #include "spars.h"
 
 #include <algorithm>
@@ -37,6 +39,7 @@ double Power(double x, int y);
 
 int FSolver::Harmonic2D(CBigComplexLinProb &L,bool verbose)
 {
+    femm::ProfileScope profile("assemble");
     int i,j,k,ww,s;
     CComplex Mx[3][3],My[3][3],Mxy[3][3];
     CComplex Me[3][3],be[3];		// element matrices;
@@ -896,6 +899,7 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L,bool verbose)
 
 int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
 {
+    femm::ProfileScope profile("write");
     // write solution to disk;
 
     char c[1024];
@@ -906,7 +910,7 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
 
     // first, echo input .fem file to the .ans file;
     sprintf(c,"%s.fem",PathName.c_str());
-    fz = fopen(c,"rt");
+    fz = femm::openFile(c,"rt");
     if(fz==NULL)
     {
         //MsgBox("Couldn't open %s.fem\n",PathName);
@@ -915,7 +919,7 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
     }
 
     sprintf(c,"%s.ans",PathName.c_str());
-    fp = fopen(c,"wt");
+    fp = femm::openFile(c,BinarySolution ? "wb" : "wt");
     if(fp==NULL)
     {
         if (fz != NULL) fclose(fz);
@@ -923,35 +927,44 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
         printf("Couldn't write to %s.ans\n",PathName.c_str());
         return false;
     }
+    femm::SolutionWriter writer(fp,BinarySolution,CompressSolution);
 
     while(fgets(c,1024,fz)!=NULL) fputs(c,fp);
     fclose(fz);
 
     // then print out node, line, and element information
     fprintf(fp,"[Solution]\n");
+    writer.beginSolution();
     cf=unitconv[LengthUnits];
-    fprintf(fp,"%i\n",NumNodes);
+    // include A from previous solution if this is an incremental permeability problem
+    writer.beginTable(NumNodes, Aprev.empty() ? "ddddi" : "ddddid");
     for(i=0; i<NumNodes; i++)
     {
-        fprintf(fp,"%.17g\t%.17g\t%.17g\t%.17g\t%i",meshnode[i].x/cf,
-                meshnode[i].y/cf,L.b[i].re,L.b[i].im,
-                meshnode[i].BoundaryMarker
-                );
-        // include A from previous solution if this is an incremental permeability problem
-        if (!Aprev.empty ()) fprintf(fp,"\t%.17g\n",Aprev[i]);
-        else fprintf(fp,"\n");
+        writer.add(meshnode[i].x/cf);
+        writer.add(meshnode[i].y/cf);
+        writer.add(L.b[i].re);
+        writer.add(L.b[i].im);
+        writer.add(meshnode[i].BoundaryMarker);
+        if (!Aprev.empty ()) writer.add(Aprev[i]);
+        writer.endRecord();
     }
-    fprintf(fp,"%i\n",NumEls);
+    writer.endTable();
+    // include J from previous problem if this is an incremental permeability problem
+    writer.beginTable(NumEls, Aprev.empty() ? "iiiiiii" : "iiiiiiid");
     for(i=0; i<NumEls; i++)
     {
-        fprintf(fp,"%i\t%i\t%i\t%i\t%i\t%i\t%i",
-                meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl,
-                meshele[i].e[0],meshele[i].e[1],meshele[i].e[2]
-                );
-        // include J from previous problem if this is an incremental permeability problem
-        if (!Aprev.empty ()) fprintf(fp,"\t%.17g\n",meshele[i].Jprev);
-        else fprintf(fp,"\n");
+        writer.add(meshele[i].p[0]);
+        writer.add(meshele[i].p[1]);
+        writer.add(meshele[i].p[2]);
+        writer.add(meshele[i].lbl);
+        writer.add(meshele[i].e[0]);
+        writer.add(meshele[i].e[1]);
+        writer.add(meshele[i].e[2]);
+        if (!Aprev.empty ()) writer.add(meshele[i].Jprev);
+        writer.endRecord();
     }
+    writer.endTable();
+    writer.beginText();
 
     /*
     	// print out circuit info
@@ -1036,6 +1049,7 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
 		}
 	}
 
+    writer.finish();
     fclose(fp);
     return true;
 }
@@ -28,11 +28,13 @@
 #include "CElement.h"
 #include "spars.h"
 #include "fsolver.h"
+#include "Profiler.h"
 
 // #define NEWTON
 
 int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L,bool verbose)
 {
+    femm::ProfileScope profile("assemble");
     int i,j,k,s,flag,ww,Iter=0;
     int pctr;
     CComplex Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3],Me[3][3],be[3];		// element matrices;
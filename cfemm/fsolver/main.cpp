@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <vector>
 #include "femmcomplex.h"
 //#include "spars.h"
 //#include "mmesh.h"
@@ -41,6 +42,8 @@ int main(int argc, char** argv)
 {
     FSolver theFSolver;
     char PathName[512];
+    std::vector<double> sweepAngles;
+    std::string sweepBoundary;
 //    int i;
 
     if (argc < 2)
@@ -60,9 +63,28 @@ int main(int argc, char** argv)
         //PathName = tempFilePath;
 
     }
+    else if(argc == 7 && strcmp(argv[2], "--rotor-sweep") == 0)
+    {
+        // fsolver <name> --rotor-sweep <boundary> <start> <step> <count>
+        // solves for each rotor position and writes <name>_<k>.ans
+        strcpy(PathName, argv[1]);
+        sweepBoundary = argv[3];
+        double start = atof(argv[4]);
+        double step = atof(argv[5]);
+        int count = atoi(argv[6]);
+        for (int k = 0; k < count; k++)
+            sweepAngles.push_back(start + k*step);
+        if (sweepAngles.empty())
+        {
+            printf("Rotor sweep needs at least one angle\n");
+            return 1;
+        }
+    }
     else if(argc > 2)
     {
-        printf("Too many arguments");
+        printf("Too many arguments\n");
+        printf("Usage: fsolver <name> [--rotor-sweep <boundary> <start> <step> <count>]\n");
+        return 1;
     }
     else
     {
@@ -77,6 +99,13 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (!sweepAngles.empty())
+    {
+        if ( !theFSolver.runRotorSweep(sweepBoundary, sweepAngles, nullptr, true))
+            return 2;
+        return 0;
+    }
+
     if ( !theFSolver.runSolver(true))
         return 2;
 
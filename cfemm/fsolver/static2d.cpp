@@ -26,6 +26,8 @@
 #include "fsolver.h"
 #include "lua.h"
 #include "LuaInstance.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -52,6 +54,7 @@ double Power(double x, int y)
 
 int FSolver::Static2D(CBigLinProb &L)
 {
+    femm::ProfileScope profile("assemble");
 
     int i,j,k,w,s;
     double Me[3][3],be[3];      // element matrices;
@@ -175,6 +178,16 @@ int FSolver::Static2D(CBigLinProb &L)
 
     // build element matrices using the matrices derived in Allaire's book.
 
+    // when continuing from a previous solution, the permeabilities of
+    // nonlinear blocks are updated from L.V right from the start
+    if (warmStart)
+    {
+        for(k = 0; k < (int)blockproplist.size(); k++)
+        {
+            if (blockproplist[k].BHpoints != 0) LinearFlag = false;
+        }
+    }
+
     do
     {
 
@@ -184,7 +197,7 @@ int FSolver::Static2D(CBigLinProb &L)
 
 //        pctr = 0;
 
-        if(Iter > 0)
+        if(Iter > 0 || warmStart)
         {
             L.Wipe();
         }
@@ -601,7 +614,7 @@ int FSolver::Static2D(CBigLinProb &L)
 //////// Nonlinear Part
 
             // update permeability for the element;
-            if (Iter==0)
+            if (Iter==0 && !warmStart)
             {
                 k = meshele[i].blk;
 
@@ -946,7 +959,7 @@ int FSolver::Static2D(CBigLinProb &L)
             V_old[j]=L.V[j];
         }
 
-        if (L.PCGSolve(Iter)==false)
+        if (L.PCGSolve(Iter > 0 || warmStart)==false)
         {
             return false;
         }
@@ -1006,7 +1019,7 @@ int FSolver::Static2D(CBigLinProb &L)
         // nonlinear iteration has to have a looser tolerance
         // than the linear solver--otherwise, things can't ever
         // converge.  Arbitrarily choose 100*tolerance.
-        if((res<100.*Precision) && (Iter>0))
+        if((res<100.*Precision) && (Iter>0 || warmStart))
         {
             LinearFlag = true;
         }
@@ -1036,8 +1049,9 @@ int FSolver::Static2D(CBigLinProb &L)
 //=========================================================================
 //=========================================================================
 
-int FSolver::WriteStatic2D(CBigLinProb &L)
+int FSolver::WriteStatic2D(CBigLinProb &L, const std::string &ansFile)
 {
+    femm::ProfileScope profile("write");
     // write solution to disk;
 
     char c[1024];
@@ -1049,7 +1063,7 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
 
     // first, echo input .fem file to the .ans file;
     sprintf(c,"%s.fem",PathName.c_str());
-    fz = fopen(c,"rt");
+    fz = femm::openFile(c,"rt");
     if(fz==NULL)
     {
         //MsgBox("Couldn't open %s.fem\n", PathName.c_str());
@@ -1058,16 +1072,17 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
         return false;
     }
 
-    sprintf(c,"%s.ans",PathName.c_str());
-    fp = fopen(c,"wt");
+    std::string outFile = ansFile.empty() ? PathName + ".ans" : ansFile;
+    fp = femm::openFile(outFile,BinarySolution ? "wb" : "wt");
     if(fp==NULL)
     {
         if (fz != NULL) fclose(fz);
         //MsgBox("Couldn't write to %s.ans\n",PathName.c_str());
-        sprintf(msgbuff,"Couldn't write to %s.ans\n",PathName.c_str());
+        sprintf(msgbuff,"Couldn't write to %s\n",outFile.c_str());
         WarnMessage(msgbuff);
         return false;
     }
+    femm::SolutionWriter writer(fp,BinarySolution,CompressSolution);
 
     while(fgets(c,1024,fz)!=NULL)
     {
@@ -1078,36 +1093,39 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
 
     // then print out node, line, and element information
     fprintf(fp,"[Solution]\n");
+    writer.beginSolution();
 
     cf = unitconv[LengthUnits];
 
-    fprintf(fp,"%i\n",NumNodes);
+    // include A from previous solution if this is an incremental permeability problem
+    writer.beginTable(NumNodes, Aprev.empty() ? "dddi" : "dddid");
 
     for(i = 0; i<NumNodes; i++)
     {
-        fprintf( fp, "%.17g\t%.17g\t%.17g\t%i",
-                 meshnode[i].x/cf,
-                 meshnode[i].y/cf,
-                 L.b[i],
-                 meshnode[i].BoundaryMarker );
-
-        // include A from previous solution if this is an incremental permeability problem
+        writer.add(meshnode[i].x/cf);
+        writer.add(meshnode[i].y/cf);
+        writer.add(L.b[i]);
+        writer.add(meshnode[i].BoundaryMarker);
 		if (!Aprev.empty ())
         {
-            fprintf(fp, "%.17g\n", Aprev[i]);
-        }
-		else
-        {
-            fprintf(fp, "\n");
+            writer.add(Aprev[i]);
         }
+        writer.endRecord();
     }
+    writer.endTable();
 
-    fprintf(fp,"%i\n",NumEls);
+    writer.beginTable(NumEls, "iiii");
 
     for(i = 0; i<NumEls; i++)
     {
-        fprintf(fp,"%i\t%i\t%i\t%i\n",meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+        writer.add(meshele[i].p[0]);
+        writer.add(meshele[i].p[1]);
+        writer.add(meshele[i].p[2]);
+        writer.add(meshele[i].lbl);
+        writer.endRecord();
     }
+    writer.endTable();
+    writer.beginText();
 
     /*
     	// print out circuit info
@@ -1191,6 +1209,7 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
 		}
 	}
 
+    writer.finish();
     fclose(fp);
     return true;
 }
@@ -25,6 +25,7 @@
 #include "fsolver.h"
 #include "lua.h"
 #include "LuaInstance.h"
+#include "Profiler.h"
 #include "spars.h"
 
 #include <cstdio>
@@ -44,6 +45,7 @@
 
 int FSolver::StaticAxisymmetric(CBigLinProb &L)
 {
+    femm::ProfileScope profile("assemble");
     int i,j,k,s,w;
     double Me[3][3],Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3];
     double l[3],p[3]={0.,0.,0.},q[3]={0.,0.,0.},g[3],be[3],u[3],v[3],res,lastres=0.,dv,vol;
@@ -33,3 +33,22 @@ CHPointVals::CHPointVals()
     , G(0)
 {
 }
+
+void CHPointValsArray::resize(int n)
+{
+    const CHPointVals u;
+    valid.assign(n, 0);
+    T.assign(n, u.T);
+    F.assign(n, u.F);
+    K.assign(n, u.K);
+    G.assign(n, u.G);
+}
+
+void CHPointValsArray::set(int i, const CHPointVals &u)
+{
+    valid[i] = 1;
+    T[i] = u.T;
+    F[i] = u.F;
+    K[i] = u.K;
+    G[i] = u.G;
+}
@@ -29,6 +29,8 @@
 
 #include "femmcomplex.h"
 
+#include <vector>
+
 class CHPointVals
 {
 public:
@@ -41,4 +43,36 @@ public:
 private:
 };
 
+/**
+ * @brief The CHPointValsArray class holds the point values of several points as a structure of arrays.
+ * All arrays have the same size.
+ * For points outside of the mesh, \c valid is 0 and the other values are left at their defaults.
+ *
+ * \internal
+ * (not present in femm42; xfemm extension)
+ * \endinternal
+ */
+class CHPointValsArray
+{
+public:
+    /**
+     * @brief Set the number of points and reset all values.
+     * @param n
+     */
+    void resize(int n);
+    /**
+     * @brief Store the values of a point.
+     * @param i the point index
+     * @param u
+     */
+    void set(int i, const CHPointVals &u);
+    int size() const { return (int)valid.size(); }
+
+    std::vector<char> valid;    // 1, if the point lies within the mesh
+    std::vector<double> T;      // temperature
+    std::vector<CComplex> F;    // heat flux density
+    std::vector<CComplex> K;    // thermal conductivity
+    std::vector<CComplex> G;    // temperature gradient
+};
+
 #endif
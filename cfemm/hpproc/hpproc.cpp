@@ -36,6 +36,7 @@
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fparse.h"
+#include "SolutionFile.h"
 #include "stringTools.h"
 #include "make_unique.h"
 
@@ -286,6 +287,7 @@ bool HPProc::OpenDocument(string solutionFile)
 
 	// Build adjacency information for each element.
 	FindBoundaryEdges();
+	buildElementIndex();
 
 	// Check to see if any regions are multiply defined
 	// (i.e. tagged by more than one block label). If so,
@@ -365,6 +367,16 @@ bool HPProc::getPointValues(double x, double y, int k, CHPointVals &u)
     return true;
 }
 
+void HPProc::getPointValues(int numPoints, const double *x, const double *y, CHPointValsArray &values, int numThreads)
+{
+    values.resize(numPoints);
+    forEachPointInMesh(numPoints, x, y, [this,x,y,&values](int i, int k) {
+        CHPointVals u;
+        getPointValues(x[i], y[i], k, u);
+        values.set(i, u);
+    }, numThreads);
+}
+
 void HPProc::getElementD(int k)
 {
     auto elem = reinterpret_cast<CHSElement*>(meshelems[k].get());
@@ -799,40 +811,69 @@ void HPProc::lineIntegral(int inttype, double *z)
     return;
 }
 
-ParserResult HPProc::parseSolution(std::istream &input, std::ostream &err)
+ParserResult HPProc::parseSolution(std::istream &input, const SolutionFormat &format, std::ostream &err)
 {
     using femmsolver::CHMeshNode;
     using femmsolver::CHSElement;
 
-    int k;
+    // read the whole solution section at once;
+    // the node and element lists are decoded in parallel
+    SolutionBuffer solution;
+    if (!solution.readFrom(input,format,problem->pathName))
+    {
+        err << "Could not read the solution section\n";
+        return F_FILE_MALFORMED;
+    }
+    SolutionTable table;
+    char s[1024];
+    const char *p;
+
     // read in meshnodes;
-    parseValue(input, k, err);
-    meshnodes.reserve(k);
-    for(int i=0;i<k;i++)
+    if (!solution.nextTable(table))
     {
-        meshnodes.push_back(MAKE_UNIQUE<CHMeshNode>(CHMeshNode::fromStream(input,err)));
+        err << "Could not read the mesh nodes\n";
+        return F_FILE_MALFORMED;
     }
+    meshnodes.resize(table.size());
+    decodeRecords(table, [this](int n, SolutionTable::Record &r) {
+        // like CHMeshNode::fromStream, values missing at the end of the line keep their defaults
+        CHMeshNode node;
+        if (r.next(node.x) && r.next(node.y) && r.next(node.T))
+            r.next(node.Q);
+        meshnodes[n] = MAKE_UNIQUE<CHMeshNode>(node);
+        return true;
+    });
 
     // read in elements;
-    parseValue(input, k, err);
-    meshelems.reserve(k);
-    auto &labellist = problem->labellist;
-    for(int i=0;i<k;i++)
+    if (!solution.nextTable(table))
     {
-        CHSElement elm = CHSElement::fromStream(input,err);
-        elm.blk = labellist[elm.lbl]->BlockType;
-        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
+        err << "Could not read the mesh elements\n";
+        return F_FILE_MALFORMED;
     }
+    meshelems.resize(table.size());
+    const auto &labellist = problem->labellist;
+    decodeRecords(table, [this,&labellist](int n, SolutionTable::Record &r) {
+        CHSElement elm;
+        if (r.next(elm.p[0]) && r.next(elm.p[1]) && r.next(elm.p[2]))
+            r.next(elm.lbl);
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems[n] = MAKE_UNIQUE<CHSElement>(elm);
+        return true;
+    });
 
     // read in circuit data;
     auto &circproplist = problem->circproplist;
-    parseValue(input, k, err);
+    int k=0;
+    p = solution.getLine(s,1024);
+    if (p)
+        parseNumber(p,k);
     for(int i=0;i<k;i++)
     {
         auto circuit = reinterpret_cast<CHConductor*>(circproplist[i].get());
         // partially overwrite circuit data:
-        input >> circuit->V;
-        input >> circuit->q;
+        p = solution.getLine(s,1024);
+        if (p && parseNumber(p,circuit->V))
+            parseNumber(p,circuit->q);
     }
     return femm::F_FILE_OK;
 }
@@ -64,11 +64,31 @@ public:
 
     bool getPointValues(double x, double y, CHPointVals &u);
     bool getPointValues(double x, double y, int k, CHPointVals &u);
+    /**
+     * @brief Get the point values for many points at once.
+     *
+     * The points are split into consecutive chunks that are evaluated concurrently.
+     * This method doesn't modify the post-processor.
+     *
+     * \note Points that lie exactly on an element edge may be assigned to a different
+     * (adjacent) element than in a sequence of single point calls.
+     *
+     * @param numPoints number of points
+     * @param x x coordinates of the points
+     * @param y y coordinates of the points
+     * @param values the point values (output variable)
+     * @param numThreads number of threads to use; 0 to use the number of available cores
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void getPointValues(int numPoints, const double *x, const double *y, CHPointValsArray &values, int numThreads = 0);
 
     void lineIntegral(int inttype, double *z);
 
     bool OpenDocument(std::string solutionFile) override;
-    femm::ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult parseSolution( std::istream &input, const femm::SolutionFormat &format, std::ostream &err = std::cerr ) override;
 
 protected:
     // General problem attributes
@@ -37,6 +37,9 @@
 #include "spars.h"
 #include "fparse.h"
 #include "hsolver.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
+#include "SolutionFile.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -137,11 +140,11 @@ int HSolver::LoadPrev()
     }
 
 	FILE *fp;
-    double x,y;
     int k;
 	char s[1024],q[256];
 
-    if ((fp=fopen(previousSolutionFile.c_str(),"rt"))==NULL)
+    femm::SolutionFormat format;
+    if ((fp=femm::openSolutionFile(previousSolutionFile,format))==NULL)
 	{
 		return BADELEMENTFILE;
 	}
@@ -165,27 +168,31 @@ int HSolver::LoadPrev()
 	}
 
 	// read in the solution
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k);
-	if(k!=NumNodes)
+	femm::SolutionBuffer solution;
+	femm::SolutionTable table;
+	const bool ok = solution.readFrom(fp,format) && solution.nextTable(table);
+	fclose(fp);
+	if(!ok || table.size()!=NumNodes)
 	{
-		fclose(fp);
 		return BADELEMENTFILE;
 	}
 
     Tprev=new double[NumNodes];
 
-	for(k=0;k<NumNodes;k++)
-	{
-		fgets(s,1024,fp);
-		sscanf(s,"%lf	%lf	%lf",&x,&y,&Tprev[k]);
-	}
+	femm::decodeRecords(table, [this](int n, femm::SolutionTable::Record &r) {
+		double x,y;
+		Tprev[n]=0;
+		if (r.next(x) && r.next(y))
+			r.next(Tprev[n]);
+		return true;
+	});
 
 	return 0;
 }
 
 LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 {
+	femm::ProfileScope profile("load");
 	int i,j,k,q,n0,n1,n;
 	char infile[256];
 	FILE *fp;
@@ -195,7 +202,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 	//read meshnodes;
 	sprintf(infile,"%s.node",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
+	if((fp=femm::openFile(infile,"rt"))==NULL){
 		return BADELEMENTFILE;
 	}
 	fgets(s,1024,fp);
@@ -242,7 +249,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 	//read in periodic boundary conditions;
 	sprintf(infile,"%s.pbc",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
+	if((fp=femm::openFile(infile,"rt"))==NULL){
 		return BADPBCFILE;
 	}
 	fgets(s,1024,fp);
@@ -262,7 +269,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 	// read in elements;
 	sprintf(infile,"%s.ele",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
+	if((fp=femm::openFile(infile,"rt"))==NULL){
 		return BADELEMENTFILE;
 	}
 	fgets(s,1024,fp);
@@ -293,15 +300,15 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
                 sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::removeFile(infile);
             }
             return MISSINGMATPROPS;
 		}
@@ -325,7 +332,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 		int **mbr;
 
 		// nmbr=(int *)calloc(NumNodes,sizeof(int));
-		nmbr=new int[NumNodes];
+		nmbr=new int[NumNodes]();
 
 		// Make a list of how many elements that tells how
 		// many elements to which each node belongs.
@@ -353,7 +360,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 			}
 
 	sprintf(infile,"%s.edge",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL)
+	if((fp=femm::openFile(infile,"rt"))==NULL)
 	{
 		return BADEDGEFILE;
 	}
@@ -421,13 +428,13 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
     {
         // clear out temporary files
         sprintf(infile,"%s.ele",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.node",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.pbc",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
         sprintf(infile,"%s.poly",PathName.c_str());
-        remove(infile);
+        femm::removeFile(infile);
     }
 
     return NOERROR;
@@ -460,6 +467,7 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 int HSolver::AnalyzeProblem(CBigLinProb &L)
 {
+	femm::ProfileScope profile("assemble");
 	int i,j,k,bf,pctr=0;
 	double Me[3][3],be[3];		// element matrices;
 	double l[3],p[3],q[3];		// element shape parameters;
@@ -924,6 +932,7 @@ bool HSolver::runSolver(bool verbose)
 
 int HSolver::WriteResults(CBigLinProb &L)
 {
+	femm::ProfileScope profile("write");
 	// write solution to disk;
 
 	char c[1024];
@@ -933,7 +942,7 @@ int HSolver::WriteResults(CBigLinProb &L)
 	// first, echo input .feh file to the .anh file;
 	sprintf(c,"%s.feh",PathName.c_str());
 
-	fz=fopen(c,"rt");
+	fz=femm::openFile(c,"rt");
 	if(fz==NULL)
     {
 		printf("Couldn't open %s.feh\n", PathName.c_str());
@@ -941,12 +950,13 @@ int HSolver::WriteResults(CBigLinProb &L)
 	}
 
     sprintf(c,"%s.anh",PathName.c_str());
-    fp=fopen(c,"wt");
+    fp=femm::openFile(c,BinarySolution ? "wb" : "wt");
 	if(fp==NULL)
     {
 		printf("Couldn't write to %s.anh",PathName.c_str());
         return false;
 	}
+	femm::SolutionWriter writer(fp,BinarySolution,CompressSolution);
 
 	while(fgets(c,1024,fz)!=NULL)
     {
@@ -956,22 +966,32 @@ int HSolver::WriteResults(CBigLinProb &L)
 
 	// then print out node, line, and element information
 	fprintf(fp,"[Solution]\n");
+	writer.beginSolution();
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
+	writer.beginTable(NumNodes,"dddi");
 	for(i=0;i<NumNodes;i++)
     {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
+		writer.add(meshnode[i].x/cf);
+		writer.add(meshnode[i].y/cf);
+		writer.add(L.V[i]);
+		writer.add(L.Q[i]);
+		writer.endRecord();
     }
+	writer.endTable();
 
-	fprintf(fp,"%i\n",NumEls);
-
+	writer.beginTable(NumEls,"iiii");
 	for(i=0;i<NumEls;i++)
     {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+		writer.add(meshele[i].p[0]);
+		writer.add(meshele[i].p[1]);
+		writer.add(meshele[i].p[2]);
+		writer.add(meshele[i].lbl);
+		writer.endRecord();
     }
+	writer.endTable();
+	writer.beginText();
 
 	// print out circuit info
 	fprintf(fp,"%i\n",NumCircProps);
@@ -980,6 +1000,7 @@ int HSolver::WriteResults(CBigLinProb &L)
 		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
     }
 
+	writer.finish();
 	fclose(fp);
     return true;
 }
@@ -1,8 +1,10 @@
 #include "FemmProblem.h"
 
 #include "femmconstants.h"
+#include "GeometrySnapshot.h"
 #include "make_unique.h"
 
+#include <algorithm>
 #include <cassert>
 #include <ctgmath>
 #include <fstream>
@@ -14,6 +16,40 @@
 #include "mex.h"
 #endif // DEBUG_MEX
 
+namespace {
+
+/**
+ * @brief Compute the margin by which a spatial query around a point is extended.
+ * The margin is slightly bigger than the distance of interest,
+ * so that rounding errors in the exact tests can't cause candidates to be missed.
+ * @param d distance of interest
+ * @param p the point
+ * @return the margin
+ */
+double queryMargin(double d, CComplex p)
+{
+    return fabs(d)*(1.+1.e-06) + 1.e-10*(fabs(p.re)+fabs(p.im));
+}
+
+/**
+ * @brief Find the start of a run of selected entries at the end of a list.
+ * @param list
+ * @return the index of the first selected entry, if all entries after it are selected, too. Otherwise -1.
+ */
+template <class T>
+int selectedTail(const std::vector<std::unique_ptr<T>> &list)
+{
+    int first = (int)list.size();
+    while (first > 0 && list[first-1]->IsSelected)
+        first--;
+    for (int i=0; i<first; i++)
+        if (list[i]->IsSelected)
+            return -1;
+    return first;
+}
+
+}
+
 femm::FemmProblem::~FemmProblem()
 {
 }
@@ -327,14 +363,27 @@ void femm::FemmProblem::updateNodeMap()
     }
 }
 
+int femm::FemmProblem::propertyIndex(const std::map<std::string, int> &map, const std::string &name)
+{
+    auto it = map.find(name);
+    return (it == map.end()) ? -1 : it->second;
+}
+
 bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
 {
     // don't add if line is degenerate
     if (asegm.n0==asegm.n1)
         return false;
 
+    std::vector<int> candidates;
+    CComplex bbMin, bbMax;
+
     // don't add if the arc is already in the list;
-    for(int i=0; i<(int)arclist.size(); i++){
+    // (only arcs whose bounding box contains the start point need to be checked)
+    const CComplex start = nodelist[asegm.n0]->CC();
+    CComplex margin (queryMargin(0,start), queryMargin(0,start));
+    geometryIndex().arcs.query(start-margin, start+margin, candidates);
+    for(int i: candidates){
         if ((arclist[i]->n0==asegm.n0) && (arclist[i]->n1==asegm.n1) &&
                 (fabs(arclist[i]->ArcLength-asegm.ArcLength)<1.e-02)) return false;
         // arcs are ``the same'' if start and end points are the same, and if
@@ -345,17 +394,30 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
     // add proposed arc to the linelist
     asegm.IsSelected = false;
 
+    if (d_geometryBatch)
+    {
+        // intersections are resolved by endGeometryBatch()
+        arclist.push_back(MAKE_UNIQUE<CArcSegment>(asegm));
+        indexLastArc();
+        return true;
+    }
+
     CComplex p[2];
     std::vector < CComplex > newnodes;
     // check to see if there are intersections
-    for(int i=0; i<(int)linelist.size(); i++)
+    // (only entities with a bounding box overlapping that of the arc can intersect)
+    getArcBoundingBox(asegm, bbMin, bbMax);
+    margin = CComplex(queryMargin(0,bbMin), queryMargin(0,bbMax));
+    geometryIndex().lines.query(bbMin-margin, bbMax+margin, candidates);
+    for(int i: candidates)
     {
         int j = getLineArcIntersection(*linelist[i],asegm,p);
         if (j>0)
             for(int k=0; k<j; k++)
                 newnodes.push_back(p[k]);
     }
-    for (int i=0; i<(int)arclist.size(); i++)
+    geometryIndex().arcs.query(bbMin-margin, bbMax+margin, candidates);
+    for (int i: candidates)
     {
         int j = getArcArcIntersection(asegm,*arclist[i],p);
         if (j>0)
@@ -366,22 +428,7 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
     // add nodes at intersections
     double t;
     if (tol==0)
-    {
-        if (nodelist.size()<2) t=1.e-08;
-        else{
-            CComplex p0,p1;
-            p0 = nodelist[0]->CC();
-            p1 = p0;
-            for (int i=1; i<(int)nodelist.size(); i++)
-            {
-                if(nodelist[i]->x<p0.re) p0.re = nodelist[i]->x;
-                if(nodelist[i]->x>p1.re) p1.re = nodelist[i]->x;
-                if(nodelist[i]->y<p0.im) p0.im = nodelist[i]->y;
-                if(nodelist[i]->y>p1.im) p1.im = nodelist[i]->y;
-            }
-            t = abs(p1-p0)*CLOSE_ENOUGH;
-        }
-    }
+        t = defaultTolerance();
     else t = tol;
 
     for (int i=0; i<(int)newnodes.size(); i++)
@@ -389,6 +436,7 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
 
     // add proposed arc segment;
     arclist.push_back(MAKE_UNIQUE<CArcSegment>(asegm));
+    indexLastArc();
 
     // check to see if proposed arc passes through other points;
     // if so, delete arc and create arcs that link intermediate points;
@@ -404,7 +452,9 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
         dmin = fabs(R*PI*asegm.ArcLength/180.)*1.e-05;
 
     int k = (int)arclist.size()-1;
-    for(int i=0; i<(int)nodelist.size(); i++)
+    margin = CComplex(queryMargin(dmin,bbMin), queryMargin(dmin,bbMax));
+    geometryIndex().nodes.query(bbMin-margin, bbMax+margin, candidates);
+    for(int i: candidates)
     {
         if( (i!=asegm.n0) && (i!=asegm.n1) )
         {
@@ -435,7 +485,7 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
                 newarc.ArcLength = arg((a1-c)/(a2-c))*180./PI;
                 addArcSegment(newarc,dmin);
 
-                i = nodelist.size();
+                break;
             }
         }
     }
@@ -444,6 +494,11 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
 }
 
 bool femm::FemmProblem::addBlockLabel(double x, double y, double d)
+{
+    return addBlockLabel(createBlockLabel(x,y), d);
+}
+
+std::unique_ptr<femm::CBlockLabel> femm::FemmProblem::createBlockLabel(double x, double y) const
 {
     std::unique_ptr<CBlockLabel> pt;
     switch (filetype) {
@@ -462,8 +517,7 @@ bool femm::FemmProblem::addBlockLabel(double x, double y, double d)
     }
     pt->x = x;
     pt->y = y;
-
-    return addBlockLabel(std::move(pt), d);
+    return pt;
 }
 
 bool femm::FemmProblem::addBlockLabel(std::unique_ptr<femm::CBlockLabel> &&label, double d)
@@ -471,17 +525,26 @@ bool femm::FemmProblem::addBlockLabel(std::unique_ptr<femm::CBlockLabel> &&label
     double x = label->x;
     double y = label->y;
 
+    // only entities close to the label need to be checked
+    std::vector<int> candidates;
+    const CComplex p (x,y);
+    const CComplex margin (queryMargin(d,p), queryMargin(d,p));
+    const GeometryIndex &index = geometryIndex();
+
     // can't put a block label on top of an existing node...
-    for (int i=0; i<(int)nodelist.size(); i++)
+    index.nodes.query(p-margin, p+margin, candidates);
+    for (int i: candidates)
         if(nodelist[i]->GetDistance(x,y)<d) return false;
 
     // can't put a block label on a line, either...
-    for (int i=0; i<(int)linelist.size(); i++)
+    index.lines.query(p-margin, p+margin, candidates);
+    for (int i: candidates)
         if(shortestDistanceFromSegment(x,y,i)<d) return false;
 
     // test to see if ``too close'' to existing node...
     bool exists=false;
-    for (int i=0; i<(int)labellist.size(); i++)
+    index.labels.query(p-margin, p+margin, candidates);
+    for (int i: candidates)
         if(labellist[i]->GetDistance(x,y)<d) {
             exists=true;
             break;
@@ -490,6 +553,7 @@ bool femm::FemmProblem::addBlockLabel(std::unique_ptr<femm::CBlockLabel> &&label
     // if all is OK, add point in to the node list...
     if(!exists){
         labellist.push_back(std::move(label));
+        indexLastLabel();
     }
 
     return true;
@@ -511,21 +575,34 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
     double x = node->x;
     double y = node->y;
 
+    // only entities close to the node need to be checked
+    std::vector<int> candidates;
+    const CComplex p (x,y);
+    const CComplex margin (queryMargin(d,p), queryMargin(d,p));
+
     // test to see if ``too close'' to existing node...
-    for (int i=0; i<(int)nodelist.size(); i++)
+    geometryIndex().nodes.query(p-margin, p+margin, candidates);
+    for (int i: candidates)
         if(nodelist[i]->GetDistance(x,y)<d) return false;
 
     // can't put a node on top of a block label; do same sort of test.
-    for (int i=0;i<(int)labellist.size();i++)
+    geometryIndex().labels.query(p-margin, p+margin, candidates);
+    for (int i: candidates)
         if(labellist[i]->GetDistance(x,y)<d) return false;
 
     // if all is OK, add point in to the node list...
     nodelist.push_back(std::move(node));
+    indexLastNode();
+
+    // lines and arcs are split by endGeometryBatch()
+    if (d_geometryBatch)
+        return true;
 
     // test to see if node is on an existing line; if so,
     // break into two lines;
-
-    for(int i=0, k=(int)linelist.size(); i<k; i++)
+    // (the index entry of a split line is kept, because the remaining part is covered by it)
+    geometryIndex().lines.query(p-margin, p+margin, candidates);
+    for(int i: candidates)
     {
         if (fabs(shortestDistanceFromSegment(x,y,i))<d)
         {
@@ -534,12 +611,14 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
             linelist[i]->n1=nodelist.size()-1;
             segm->n0=nodelist.size()-1;
             linelist.push_back(std::move(segm));
+            indexLastLine();
         }
     }
 
     // test to see if node is on an existing arc; if so,
     // break into two arcs;
-    for(int i=0, k=(int)arclist.size(); i<k; i++)
+    geometryIndex().arcs.query(p-margin, p+margin, candidates);
+    for(int i: candidates)
     {
         if (shortestDistanceFromArc(CComplex(x,y),*arclist[i])<d)
         {
@@ -555,6 +634,7 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
             asegm->n0 = nodelist.size()-1;
             asegm->ArcLength = arg((a1-c)/(a2-c))*180./PI;
             arclist.push_back(std::move(asegm));
+            indexLastArc();
         }
     }
     return true;
@@ -575,8 +655,15 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     // don't add if line is degenerate
     if (n0==n1) return false;
 
+    std::vector<int> candidates;
+    const CComplex a0 = nodelist[n0]->CC();
+    const CComplex a1 = nodelist[n1]->CC();
+
     // don't add if the line is already in the list;
-    for (int i=0; i<(int)linelist.size(); i++){
+    // (only lines passing through the start point need to be checked)
+    CComplex margin (queryMargin(0,a0), queryMargin(0,a0));
+    geometryIndex().lines.query(a0-margin, a0+margin, candidates);
+    for (int i: candidates){
         if ((linelist[i]->n0==n0) && (linelist[i]->n1==n1)) return false;
         if ((linelist[i]->n0==n1) && (linelist[i]->n1==n0)) return false;
     }
@@ -587,12 +674,27 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     segm.IsSelected=false;
     segm.n0=n0; segm.n1=n1;
 
+    if (d_geometryBatch)
+    {
+        // intersections are resolved by endGeometryBatch()
+        linelist.push_back(segm.clone());
+        indexLastLine();
+        return true;
+    }
+
+    // only entities overlapping the bounding box of the line can intersect it
+    const CComplex bbMin (std::min(a0.re,a1.re), std::min(a0.im,a1.im));
+    const CComplex bbMax (std::max(a0.re,a1.re), std::max(a0.im,a1.im));
+    margin = CComplex(queryMargin(0,bbMin), queryMargin(0,bbMax));
+
     // check to see if there are intersections with segments
-    for (int i=0; i<(int)linelist.size(); i++)
+    geometryIndex().lines.query(bbMin-margin, bbMax+margin, candidates);
+    for (int i: candidates)
         if(getIntersection(n0,n1,i,&xi,&yi)) newnodes.push_back(CComplex(xi,yi));
 
     // check to see if there are intersections with arcs
-    for (int i=0; i<(int)arclist.size(); i++){
+    geometryIndex().arcs.query(bbMin-margin, bbMax+margin, candidates);
+    for (int i: candidates){
         int j = getLineArcIntersection(segm,*arclist[i],p);
         if (j>0)
             for(int k=0;k<j;k++)
@@ -601,23 +703,7 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
 
     // add nodes at intersections
     if (tol==0)
-    {
-        if (nodelist.size()<2)
-            t = 1.e-08;
-        else{
-            CComplex p0,p1;
-            p0 = nodelist[0]->CC();
-            p1 = p0;
-            for (int i=1; i<(int)nodelist.size(); i++)
-            {
-                if(nodelist[i]->x<p0.re) p0.re=nodelist[i]->x;
-                if(nodelist[i]->x>p1.re) p1.re=nodelist[i]->x;
-                if(nodelist[i]->y<p0.im) p0.im=nodelist[i]->y;
-                if(nodelist[i]->y>p1.im) p1.im=nodelist[i]->y;
-            }
-            t=abs(p1-p0)*CLOSE_ENOUGH;
-        }
-    }
+        t = defaultTolerance();
     else t=tol;
 
     for (int i=0; i<(int)newnodes.size(); i++)
@@ -625,6 +711,7 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
 
     // Add proposed line segment
     linelist.push_back(segm.clone());
+    indexLastLine();
 
     // check to see if proposed line passes through other points;
     // if so, delete line and create lines that link intermediate points;
@@ -635,7 +722,10 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
         dmin = abs(nodelist[n1]->CC()-nodelist[n0]->CC())*1.e-05;
     else dmin = tol;
 
-    for (int i=0, k=linelist.size()-1; i<(int)nodelist.size(); i++)
+    const int k = linelist.size()-1;
+    margin = CComplex(queryMargin(dmin,bbMin), queryMargin(dmin,bbMax));
+    geometryIndex().nodes.query(bbMin-margin, bbMax+margin, candidates);
+    for (int i: candidates)
     {
         if( (i!=n0) && (i!=n1) )
         {
@@ -654,7 +744,7 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
                     addSegment(n0,i,&segm,dmin);
                     addSegment(i,n1,&segm,dmin);
                 }
-                i=nodelist.size();
+                break;
             }
         }
     }
@@ -662,6 +752,24 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     return true;
 }
 
+void femm::FemmProblem::beginGeometryBatch()
+{
+    d_geometryBatch = true;
+}
+
+void femm::FemmProblem::endGeometryBatch(double tol)
+{
+    if (!d_geometryBatch)
+        return;
+    d_geometryBatch = false;
+    enforcePSLG(tol);
+}
+
+bool femm::FemmProblem::geometryBatchActive() const
+{
+    return d_geometryBatch;
+}
+
 void femm::FemmProblem::clearNotationTags()
 {
     for (auto &line : linelist)
@@ -682,38 +790,19 @@ int femm::FemmProblem::closestArcSegment(double x, double y) const
 {
     if(arclist.size()==0) return -1;
 
-    double d0=shortestDistanceFromArc(CComplex(x,y),*arclist[0]);
-    int idx=0;
-    for(int i=0; i<(int)arclist.size(); i++)
-    {
-        double d1=shortestDistanceFromArc(CComplex(x,y),*arclist[i]);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    const CComplex p (x,y);
+    return geometryIndex().arcs.closest(p, [&](int i) {
+        return shortestDistanceFromArc(p,*arclist[i]);
+    });
 }
 
 int femm::FemmProblem::closestBlockLabel(double x, double y) const
 {
     if(labellist.size()==0) return -1;
 
-    int idx=0;
-    double d0=labellist[0]->GetDistance(x,y);
-    for(int i=0; i<(int)labellist.size(); i++)
-    {
-        double d1=labellist[i]->GetDistance(x,y);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    return geometryIndex().labels.closest(CComplex(x,y), [&](int i) {
+        return labellist[i]->GetDistance(x,y);
+    });
 }
 
 // identical in fmesher, FPProc, and HPProc
@@ -721,19 +810,9 @@ int femm::FemmProblem::closestNode(double x, double y) const
 {
     if(nodelist.size()==0) return -1;
 
-    int idx=0;
-    double d0=nodelist[0]->GetDistance(x,y);
-    for(int i=0; i<(int)nodelist.size(); i++)
-    {
-        double d1=nodelist[i]->GetDistance(x,y);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    return geometryIndex().nodes.closest(CComplex(x,y), [&](int i) {
+        return nodelist[i]->GetDistance(x,y);
+    });
 }
 
 // identical in fmesher, hpproc
@@ -741,19 +820,9 @@ int femm::FemmProblem::closestSegment(double x, double y) const
 {
     if(linelist.size()==0) return -1;
 
-    int idx=0;
-    double d0=shortestDistanceFromSegment(x,y,0);
-    for(int i=0; i<(int)linelist.size(); i++)
-    {
-        double d1=shortestDistanceFromSegment(x,y,i);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    return geometryIndex().lines.closest(CComplex(x,y), [&](int i) {
+        return shortestDistanceFromSegment(x,y,i);
+    });
 }
 
 bool femm::FemmProblem::consistencyCheckOK() const
@@ -1227,6 +1296,16 @@ bool femm::FemmProblem::createRadius(int n, double r)
     return false;
 }
 
+double femm::FemmProblem::defaultTolerance() const
+{
+    if (nodelist.size()<2)
+        return 1.e-08;
+
+    // the index keeps track of the bounding box of all nodes
+    const GeometryIndex &index = geometryIndex();
+    return abs(index.nodeMax-index.nodeMin)*CLOSE_ENOUGH;
+}
+
 femm::EditMode femm::FemmProblem::defaultEditMode() const
 {
     return d_EditMode;
@@ -1240,6 +1319,7 @@ void femm::FemmProblem::setDefaultEditMode(femm::EditMode mode)
 bool femm::FemmProblem::deleteSelectedArcSegments()
 {
     size_t oldsize = arclist.size();
+    const int tail = selectedTail(arclist);
 
     if (!arclist.empty())
     {
@@ -1251,6 +1331,7 @@ bool femm::FemmProblem::deleteSelectedArcSegments()
                     );
     }
     arclist.shrink_to_fit();
+    updateIndexAfterRemoval(d_index.arcs, oldsize, tail);
 
     return arclist.size() != oldsize;
 }
@@ -1258,6 +1339,7 @@ bool femm::FemmProblem::deleteSelectedArcSegments()
 bool femm::FemmProblem::deleteSelectedBlockLabels()
 {
     size_t oldsize = labellist.size();
+    const int tail = selectedTail(labellist);
 
     if (!labellist.empty())
     {
@@ -1269,6 +1351,7 @@ bool femm::FemmProblem::deleteSelectedBlockLabels()
                     );
     }
     labellist.shrink_to_fit();
+    updateIndexAfterRemoval(d_index.labels, oldsize, tail);
 
     return labellist.size() != oldsize;
 }
@@ -1319,12 +1402,15 @@ bool femm::FemmProblem::deleteSelectedNodes()
     }
 
     nodelist.shrink_to_fit();
+    if (changed)
+        invalidateGeometryIndex();
     return changed;
 }
 
 bool femm::FemmProblem::deleteSelectedSegments()
 {
     size_t oldsize = linelist.size();
+    const int tail = selectedTail(linelist);
 
     if (!linelist.empty())
     {
@@ -1336,6 +1422,7 @@ bool femm::FemmProblem::deleteSelectedSegments()
                     );
     }
     linelist.shrink_to_fit();
+    updateIndexAfterRemoval(d_index.lines, oldsize, tail);
 
     return linelist.size() != oldsize;
 }
@@ -1352,6 +1439,10 @@ void femm::FemmProblem::enforcePSLG(double tol)
     newlinelist.swap(linelist);
     newarclist.swap(arclist);
     newlabellist.swap(labellist);
+    invalidateGeometryIndex();
+    // the rebuild must split intersecting entities, even while a batch is active
+    const bool batch = d_geometryBatch;
+    d_geometryBatch = false;
 
     // find out what tolerance is so that there are not nodes right on
     // top of each other;
@@ -1422,6 +1513,7 @@ void femm::FemmProblem::enforcePSLG(double tol)
     }
 
     unselectAll();
+    d_geometryBatch = batch;
 }
 
 
@@ -2267,24 +2359,7 @@ void femm::FemmProblem::translateMove(double dx, double dy, femm::EditMode selec
 
 int femm::FemmProblem::ClosestNode(const double x, const double y) const
 {
-    int i,j;
-    double d0,d1;
-
-    if(nodelist.size()==0) return -1;
-
-    j=0;
-    d0=nodelist[0]->GetDistance(x,y);
-    for(i=0; i<(int)nodelist.size(); i++)
-    {
-        d1=nodelist[i]->GetDistance(x,y);
-        if(d1<d0)
-        {
-            d0=d1;
-            j=i;
-        }
-    }
-
-    return j;
+    return closestNode(x,y);
 }
 
 
@@ -2381,6 +2456,7 @@ void femm::FemmProblem::unselectAll()
 
 void femm::FemmProblem::undo()
 {
+    invalidateGeometryIndex();
     for(int i=0; i<(int)undolinelist.size(); i++)
         linelist[i].swap(undolinelist[i]);
     for(int i=0; i<(int)undoarclist.size(); i++)
@@ -2393,6 +2469,7 @@ void femm::FemmProblem::undo()
 
 void femm::FemmProblem::undoLines()
 {
+    invalidateGeometryIndex();
     for(int i=0; i<(int)undolinelist.size(); i++)
         linelist[i].swap(undolinelist[i]);
 }
@@ -2408,20 +2485,202 @@ void femm::FemmProblem::undoArcs()
 
 void femm::FemmProblem::updateUndo()
 {
-    undonodelist.clear();
-    undolinelist.clear();
-    undoarclist.clear();
-    undolabellist.clear();
+    // copy each entry; the entries of the previous undo point are overwritten in place
+    copyEntities(undonodelist, nodelist);
+    copyEntities(undolinelist, linelist);
+    copyEntities(undoarclist, arclist);
+    copyEntities(undolabellist, labellist);
+}
+
+void femm::FemmProblem::invalidateGeometryIndex()
+{
+    d_index.valid = false;
+}
+
+const femm::FemmProblem::GeometryIndex &femm::FemmProblem::geometryIndex() const
+{
+    GeometryIndex &index = d_index;
+    const int total = (int)(nodelist.size() + labellist.size() + linelist.size() + arclist.size());
+    if (index.valid
+            && index.nodes.size() == (int)nodelist.size()
+            && index.labels.size() == (int)labellist.size()
+            && index.lines.size() == (int)linelist.size()
+            && index.arcs.size() == (int)arclist.size()
+            && total <= 2*index.builtSize + 64)
+        return index;
+
+    // collect bounding boxes, and find a suitable bucket size:
+    // roughly one entity per bucket, but not smaller than the typical (arc) segment
+    std::vector<CComplex> arcMin (arclist.size());
+    std::vector<CComplex> arcMax (arclist.size());
+    CComplex lo, hi;
+    bool empty = true;
+    auto extend = [&](CComplex p0, CComplex p1) {
+        if (empty)
+        {
+            lo = CComplex(std::min(p0.re,p1.re), std::min(p0.im,p1.im));
+            hi = CComplex(std::max(p0.re,p1.re), std::max(p0.im,p1.im));
+            empty = false;
+            return;
+        }
+        lo.re = std::min(lo.re, std::min(p0.re,p1.re));
+        lo.im = std::min(lo.im, std::min(p0.im,p1.im));
+        hi.re = std::max(hi.re, std::max(p0.re,p1.re));
+        hi.im = std::max(hi.im, std::max(p0.im,p1.im));
+    };
+    index.nodeMin = CComplex(0,0);
+    index.nodeMax = CComplex(0,0);
+    for (const auto &node: nodelist)
+        extend(node->CC(), node->CC());
+    if (!empty)
+    {
+        index.nodeMin = lo;
+        index.nodeMax = hi;
+    }
+    for (const auto &label: labellist)
+        extend(CComplex(label->x,label->y), CComplex(label->x,label->y));
+    double extentSum = 0;
+    for (const auto &line: linelist)
+    {
+        const CComplex p0 = nodelist[line->n0]->CC();
+        const CComplex p1 = nodelist[line->n1]->CC();
+        extend(p0, p1);
+        extentSum += std::max(fabs(p1.re-p0.re), fabs(p1.im-p0.im));
+    }
+    for (int i=0; i<(int)arclist.size(); i++)
+    {
+        getArcBoundingBox(*arclist[i], arcMin[i], arcMax[i]);
+        if (std::isfinite(arcMin[i].re+arcMin[i].im+arcMax[i].re+arcMax[i].im))
+        {
+            extend(arcMin[i], arcMax[i]);
+            extentSum += std::max(arcMax[i].re-arcMin[i].re, arcMax[i].im-arcMin[i].im);
+        }
+    }
+
+    double cellSize = 1.;
+    if (!empty)
+    {
+        const double size = std::max(hi.re-lo.re, hi.im-lo.im);
+        cellSize = size / std::sqrt((double)total);
+        if (!linelist.empty() || !arclist.empty())
+            cellSize = std::max(cellSize, extentSum / (double)(linelist.size()+arclist.size()));
+        cellSize = std::min(cellSize, size);
+    }
+
+    index.nodes.clear(cellSize);
+    index.labels.clear(cellSize);
+    index.lines.clear(cellSize);
+    index.arcs.clear(cellSize);
+    for (const auto &node: nodelist)
+        index.nodes.appendBox(node->CC(), node->CC());
+    for (const auto &label: labellist)
+        index.labels.appendBox(CComplex(label->x,label->y), CComplex(label->x,label->y));
+    for (const auto &line: linelist)
+        index.lines.appendLine(nodelist[line->n0]->CC(), nodelist[line->n1]->CC());
+    for (int i=0; i<(int)arclist.size(); i++)
+        index.arcs.appendBox(arcMin[i], arcMax[i]);
+
+    index.valid = true;
+    index.builtSize = total;
+    return index;
+}
+
+void femm::FemmProblem::indexLastNode()
+{
+    const int i = (int)nodelist.size()-1;
+    if (!d_index.valid || d_index.nodes.size() != i)
+    {
+        d_index.valid = false;
+        return;
+    }
+    const CComplex p = nodelist[i]->CC();
+    d_index.nodes.appendBox(p, p);
+    if (i==0)
+    {
+        d_index.nodeMin = d_index.nodeMax = p;
+    } else {
+        d_index.nodeMin = CComplex(std::min(d_index.nodeMin.re,p.re), std::min(d_index.nodeMin.im,p.im));
+        d_index.nodeMax = CComplex(std::max(d_index.nodeMax.re,p.re), std::max(d_index.nodeMax.im,p.im));
+    }
+}
+
+void femm::FemmProblem::indexLastLabel()
+{
+    const int i = (int)labellist.size()-1;
+    if (!d_index.valid || d_index.labels.size() != i)
+    {
+        d_index.valid = false;
+        return;
+    }
+    const CComplex p (labellist[i]->x, labellist[i]->y);
+    d_index.labels.appendBox(p, p);
+}
+
+void femm::FemmProblem::indexLastLine()
+{
+    const int i = (int)linelist.size()-1;
+    if (!d_index.valid || d_index.lines.size() != i)
+    {
+        d_index.valid = false;
+        return;
+    }
+    d_index.lines.appendLine(nodelist[linelist[i]->n0]->CC(), nodelist[linelist[i]->n1]->CC());
+}
+
+void femm::FemmProblem::indexLastArc()
+{
+    const int i = (int)arclist.size()-1;
+    if (!d_index.valid || d_index.arcs.size() != i)
+    {
+        d_index.valid = false;
+        return;
+    }
+    CComplex min, max;
+    getArcBoundingBox(*arclist[i], min, max);
+    d_index.arcs.appendBox(min, max);
+}
+
+void femm::FemmProblem::updateIndexAfterRemoval(SpatialGrid &grid, int oldSize, int firstRemoved)
+{
+    if (!d_index.valid)
+        return;
+    if (firstRemoved < 0 || grid.size() != oldSize)
+    {
+        d_index.valid = false;
+        return;
+    }
+    grid.truncate(firstRemoved);
+}
+
+void femm::FemmProblem::getArcBoundingBox(const femm::CArcSegment &arc, CComplex &min, CComplex &max) const
+{
+    const CComplex a0 = nodelist[arc.n0]->CC();
+    const CComplex a1 = nodelist[arc.n1]->CC();
+    min = CComplex(std::min(a0.re,a1.re), std::min(a0.im,a1.im));
+    max = CComplex(std::max(a0.re,a1.re), std::max(a0.im,a1.im));
 
-    // copy each entry
-    for(const auto& node: nodelist)
-        undonodelist.push_back(node->clone());
-    for(const auto& line: linelist)
-        undolinelist.push_back(line->clone());
-    for(const auto& arc: arclist)
-        undoarclist.push_back(MAKE_UNIQUE<CArcSegment>(*arc));
-    for(const auto& label: labellist)
-        undolabellist.push_back(label->clone());
+    CComplex c;
+    double R;
+    getCircle(arc,c,R);
+
+    // include the extreme points of the circle that are part of the arc
+    const CComplex directions[4] = { CComplex(1,0), CComplex(0,1), CComplex(-1,0), CComplex(0,-1) };
+    for (const CComplex &dir: directions)
+    {
+        double z = arg(dir/(a0-c))*180./PI;
+        if (z<0)
+            z += 360.;
+        if (z < arc.ArcLength)
+        {
+            const CComplex q = c + R*dir;
+            min = CComplex(std::min(min.re,q.re), std::min(min.im,q.im));
+            max = CComplex(std::max(max.re,q.re), std::max(max.im,q.im));
+        }
+    }
+    // guard against rounding errors
+    const double margin = 1.e-06*R;
+    min -= CComplex(margin,margin);
+    max += CComplex(margin,margin);
 }
 
 femm::FemmProblem::FemmProblem(FileType ftype)
@@ -2458,6 +2717,8 @@ femm::FemmProblem::FemmProblem(FileType ftype)
     , blockMap()
     , circuitMap()
     , d_EditMode( EditMode::Invalid )
+    , d_index()
+    , d_geometryBatch(false)
     , undonodelist()
     , undolinelist()
     , undoarclist()
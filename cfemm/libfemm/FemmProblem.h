@@ -31,6 +31,7 @@
 #include "CSegment.h"
 #include "femmenums.h"
 #include "fparse.h"
+#include "SpatialGrid.h"
 
 #include <map>
 #include <memory>
@@ -122,6 +123,13 @@ public:
      * Call this function whenever the node properties change (i.e. whenever a new element is added or a PointName changes).
      */
     void updateNodeMap();
+    /**
+     * @brief Look up the index of a property name in one of the property maps.
+     * @param map blockMap, circuitMap, lineMap or nodeMap
+     * @param name the property name
+     * @return the index, or -1 if there is no such property
+     */
+    static int propertyIndex(const std::map<std::string,int> &map, const std::string &name);
 
     /**
      * @brief Add an arc segment to the problem description.
@@ -156,6 +164,17 @@ public:
      * @return \c true if the label could be added or a block label already exists at that position, \c false otherwise.
      */
     bool addBlockLabel(std::unique_ptr<femm::CBlockLabel> &&label, double d);
+    /**
+     * @brief Create a block label of the class that matches the file type, without adding it.
+     * @param x x-coordinate
+     * @param y y-coordinate
+     * @return a CMBlockLabel, CSBlockLabel or CHBlockLabel
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    std::unique_ptr<femm::CBlockLabel> createBlockLabel(double x, double y) const;
 
     /**
      * @brief Add a CNode to the problem description.
@@ -205,6 +224,27 @@ public:
      */
     bool addSegment(int n0, int n1, const femm::CSegment *parsegm, double tol=0.);
 
+    /**
+     * @brief Start adding geometry in batch mode.
+     * While a batch is active, addNode(), addSegment() and addArcSegment() only reject
+     * coincident nodes and duplicate or degenerate segments.
+     * Lines and arcs are neither split at intersections nor at nodes lying on them;
+     * this is done by a single call to enforcePSLG() in endGeometryBatch().
+     *
+     * Use this when adding a large number of entities, e.g. for generated geometries.
+     */
+    void beginGeometryBatch();
+    /**
+     * @brief Finish batch mode and resolve all intersections and coincident points.
+     * @param tol tolerance passed to enforcePSLG()
+     */
+    void endGeometryBatch(double tol=0);
+    /**
+     * @brief Check whether batch mode is active.
+     * @return \c true between beginGeometryBatch() and endGeometryBatch()
+     */
+    bool geometryBatchActive() const;
+
     /**
      * @brief Clear the \c cnt tags of (arc) segments.
      * The cnt fields in (arc) segments are used to store notation data by the mesher and other places.
@@ -277,6 +317,13 @@ public:
      */
     bool createRadius(int n, double r);
 
+    /**
+     * @brief Compute the default tolerance used when adding entities to the problem.
+     * The tolerance is a small fraction (CLOSE_ENOUGH) of the diagonal of the bounding box of all nodes.
+     * @return the tolerance, or 1.e-08 if there are less than two nodes
+     */
+    double defaultTolerance() const;
+
     femm::EditMode defaultEditMode() const;
     void setDefaultEditMode( femm::EditMode mode);
 
@@ -465,6 +512,17 @@ public:
      */
     void translateMove(double dx, double dy, femm::EditMode selector);
 
+    /**
+     * @brief Discard the spatial index of the geometry.
+     * The index is rebuilt when it is needed next.
+     *
+     * All methods of FemmProblem keep the index up to date.
+     * Appending to the geometry lists is detected automatically,
+     * but if you modify the coordinates or connectivity of existing entries
+     * directly, you need to call this method afterwards.
+     */
+    void invalidateGeometryIndex();
+
     int ClosestNode(const double x, const double y) const;
     int ClosestArcSegment(double x, double y) const;
     void GetCircle(const femm::CArcSegment &asegm,CComplex &c, double &R) const;
@@ -538,7 +596,56 @@ public: // data members
     std::map<std::string, int> nodeMap; ///< \brief a map from PointName to node index. \sa updateNodeMap
 
 private:
+    /**
+     * @brief The GeometryIndex struct holds the spatial index of nodes, block labels, segments and arc segments.
+     * It is used to speed up the proximity and intersection checks when adding entities,
+     * and to look up the closest entity to a point.
+     * The ids stored in each grid are the indices into the corresponding list.
+     */
+    struct GeometryIndex {
+        SpatialGrid nodes;
+        SpatialGrid labels;
+        SpatialGrid lines;
+        SpatialGrid arcs;
+        CComplex nodeMin; ///< lower left corner of the bounding box of all nodes
+        CComplex nodeMax; ///< upper right corner of the bounding box of all nodes
+        bool valid = false;
+        int builtSize = 0; ///< number of entities when the index was last built
+    };
+
+    /**
+     * @brief Get the spatial index, (re)building it if necessary.
+     * The index is rebuilt if it has been invalidated, if the lists have been modified behind its back,
+     * or if the geometry has grown considerably (so that the bucket size can be adapted).
+     */
+    const GeometryIndex &geometryIndex() const;
+    /**
+     * @brief Add the last node/label/segment/arc to the spatial index.
+     * If the index is not up to date, it is invalidated instead.
+     */
+    void indexLastNode();
+    void indexLastLabel();
+    void indexLastLine();
+    void indexLastArc();
+    /**
+     * @brief Update the spatial index after selected entities have been removed from a list.
+     * If only entities at the end of the list were removed, the index is kept. Otherwise it is invalidated.
+     * @param grid the grid of the list
+     * @param oldSize the list size before removal
+     * @param firstRemoved the index of the first removed entity, if all following entities were removed too, or -1
+     */
+    void updateIndexAfterRemoval(SpatialGrid &grid, int oldSize, int firstRemoved);
+    /**
+     * @brief Compute the bounding box of an arc segment.
+     * @param arc
+     * @param min lower left corner (output variable)
+     * @param max upper right corner (output variable)
+     */
+    void getArcBoundingBox(const femm::CArcSegment &arc, CComplex &min, CComplex &max) const;
+
     femm::EditMode d_EditMode;
+    mutable GeometryIndex d_index;
+    bool d_geometryBatch;
     // lists of nodes, segments, and block labels for undo purposes...
     std::vector< std::unique_ptr<femm::CNode> >       undonodelist;
     std::vector< std::unique_ptr<femm::CSegment> >    undolinelist;
@@ -84,14 +84,15 @@ template< class PointPropT
 ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT>
 ::parse(const std::string &file)
 {
-    std::ifstream input;
-
-    input.open(file.c_str(), std::ifstream::in);
-    if (!input.is_open())
+    // solution files may be binary files
+    SolutionFormat format;
+    std::unique_ptr<std::istream> inputFile = openSolutionStream(file, format);
+    if (!inputFile)
     {
         err << "Couldn't read from file " << file<< "\n";
         return F_FILE_NOT_OPENED;
     }
+    std::istream &input = *inputFile;
     problem->pathName = file;
 
     // parse the file
@@ -615,7 +616,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
     if (readSolutionData && success)
     {
         if (solutionReader)
-            return solutionReader->parseSolution(input,err);
+            return solutionReader->parseSolution(input,format,err);
         else
             err << "Ignoring solution data...\n";
     } else {
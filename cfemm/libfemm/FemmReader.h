@@ -19,6 +19,7 @@
 #define FEMMREADER_H
 
 #include "FemmProblem.h"
+#include "SolutionFile.h"
 
 #include <iostream>
 #include <string>
@@ -33,7 +34,13 @@ enum ParserResult { F_FILE_OK, F_FILE_UNKNOWN_TYPE, F_FILE_NOT_OPENED, F_FILE_MA
  */
 class SolutionReader {
 public:
-    virtual ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) = 0;
+    /**
+     * @brief Parse the solution section.
+     * @param input the input stream, positioned after the "[Solution]" line
+     * @param format the format of the solution file (text or binary)
+     * @param err output stream for error messages
+     */
+    virtual ParserResult parseSolution( std::istream &input, const SolutionFormat &format, std::ostream &err = std::cerr ) = 0;
 protected:
     virtual ~SolutionReader(){}
 };
@@ -0,0 +1,70 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "GeometrySnapshot.h"
+
+#include "FemmProblem.h"
+
+std::shared_ptr<const femm::GeometrySnapshot> femm::GeometrySnapshot::take(const femm::FemmProblem &problem)
+{
+    std::shared_ptr<GeometrySnapshot> snapshot(new GeometrySnapshot());
+    snapshot->filetype = problem.filetype;
+    copyEntities(snapshot->nodes, problem.nodelist);
+    copyEntities(snapshot->lines, problem.linelist);
+    copyEntities(snapshot->arcs, problem.arclist);
+    copyEntities(snapshot->labels, problem.labellist);
+    return snapshot;
+}
+
+bool femm::GeometrySnapshot::restore(femm::FemmProblem &problem) const
+{
+    if (problem.filetype != filetype)
+        return false;
+
+    copyEntities(problem.nodelist, nodes);
+    copyEntities(problem.linelist, lines);
+    copyEntities(problem.arclist, arcs);
+    copyEntities(problem.labellist, labels);
+
+    // The property indices are only valid for the property lists at the time the snapshot was taken.
+    // Resolve them by name, so that the snapshot can be restored into another problem,
+    // or after the properties of this problem have changed.
+    problem.updateBlockMap();
+    problem.updateCircuitMap();
+    problem.updateLineMap();
+    problem.updateNodeMap();
+    for (auto &node: problem.nodelist)
+    {
+        node->BoundaryMarker = FemmProblem::propertyIndex(problem.nodeMap, node->BoundaryMarkerName);
+        node->InConductor = FemmProblem::propertyIndex(problem.circuitMap, node->InConductorName);
+    }
+    for (auto &segm: problem.linelist)
+    {
+        segm->BoundaryMarker = FemmProblem::propertyIndex(problem.lineMap, segm->BoundaryMarkerName);
+        segm->InConductor = FemmProblem::propertyIndex(problem.circuitMap, segm->InConductorName);
+    }
+    for (auto &asegm: problem.arclist)
+    {
+        asegm->BoundaryMarker = FemmProblem::propertyIndex(problem.lineMap, asegm->BoundaryMarkerName);
+        asegm->InConductor = FemmProblem::propertyIndex(problem.circuitMap, asegm->InConductorName);
+    }
+    for (auto &label: problem.labellist)
+    {
+        if (label->hasBlockType())
+            label->BlockType = FemmProblem::propertyIndex(problem.blockMap, label->BlockTypeName);
+        label->InCircuit = FemmProblem::propertyIndex(problem.circuitMap, label->InCircuitName);
+    }
+    problem.invalidateGeometryIndex();
+    return true;
+}
+
+std::size_t femm::GeometrySnapshot::size() const
+{
+    return nodes.size() + lines.size() + arcs.size() + labels.size();
+}
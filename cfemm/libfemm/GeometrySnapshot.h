@@ -0,0 +1,115 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_GEOMETRYSNAPSHOT_H
+#define FEMM_GEOMETRYSNAPSHOT_H
+
+#include "CArcSegment.h"
+#include "CBlockLabel.h"
+#include "CNode.h"
+#include "CSegment.h"
+#include "femmenums.h"
+#include "make_unique.h"
+
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+namespace femm {
+
+class FemmProblem;
+
+/**
+ * @brief Copy \p source into \p target, reusing the allocation of \p target if possible.
+ * Block labels have different subclasses and are always cloned.
+ */
+template <class Entity>
+void copyEntity(std::unique_ptr<Entity> &target, const Entity &source)
+{
+    if (target && typeid(*target) == typeid(Entity) && typeid(source) == typeid(Entity))
+        *target = source;
+    else
+        target = source.clone();
+}
+
+template <>
+inline void copyEntity(std::unique_ptr<CArcSegment> &target, const CArcSegment &source)
+{
+    if (target)
+        *target = source;
+    else
+        target = MAKE_UNIQUE<CArcSegment>(source);
+}
+
+/**
+ * @brief Make \p target a copy of \p source.
+ * In contrast to clearing the target and cloning each entry,
+ * the existing entries of the target are overwritten in place.
+ */
+template <class Entity>
+void copyEntities(std::vector<std::unique_ptr<Entity>> &target, const std::vector<std::unique_ptr<Entity>> &source)
+{
+    target.resize(source.size());
+    for (std::size_t i=0; i<source.size(); i++)
+        copyEntity(target[i], *source[i]);
+}
+
+/**
+ * @brief The GeometrySnapshot class is an immutable copy of the nodes, segments, arc segments and block labels of a FemmProblem.
+ *
+ * A snapshot is created once and handed out as \c shared_ptr<const GeometrySnapshot>,
+ * i.e. any number of owners (e.g. the named snapshots of femmcli, or a list of problem variants) share the same storage.
+ * Restoring a snapshot overwrites the geometry of a problem in place, so that a loop that restores a base geometry
+ * and perturbs it does not allocate the entities again and again.
+ *
+ * Properties (materials, boundary conditions, circuits) and problem settings are not part of the snapshot.
+ */
+class GeometrySnapshot
+{
+public:
+    /**
+     * @brief Create a snapshot of the current geometry of a problem.
+     * This is a deep copy of all nodes, segments, arc segments and block labels.
+     * @param problem
+     * @return the snapshot
+     */
+    static std::shared_ptr<const GeometrySnapshot> take(const FemmProblem &problem);
+
+    /**
+     * @brief Replace the geometry of a problem with the geometry of the snapshot.
+     * References to properties (boundary conditions, materials, circuits) are resolved by name,
+     * i.e. the indices are set to the matching properties of \p problem, or to -1 if there is no such property.
+     * @param problem a problem of the same file type
+     * @return \c false, if the file types differ
+     */
+    bool restore(FemmProblem &problem) const;
+
+    /**
+     * @brief The file type of the problem the snapshot was taken from.
+     */
+    FileType fileType() const { return filetype; }
+
+    /**
+     * @brief The number of nodes, segments, arc segments and block labels in the snapshot.
+     */
+    std::size_t size() const;
+
+private:
+    GeometrySnapshot() = default;
+
+    FileType filetype = FileType::Unknown;
+    std::vector<std::unique_ptr<CNode>> nodes;
+    std::vector<std::unique_ptr<CSegment>> lines;
+    std::vector<std::unique_ptr<CArcSegment>> arcs;
+    std::vector<std::unique_ptr<CBlockLabel>> labels;
+};
+
+} // namespace femm
+
+#endif
@@ -20,12 +20,19 @@
 #include "femmcomplex.h"
 #include "femmversion.h"
 #include "FemmStateBase.h"
+#include "locationTools.h"
+#include "Profiler.h"
 
 #include <lua.h>
 #include <lualib.h>
 #include <luadebug.h>
 
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <iostream>
 
@@ -37,11 +44,99 @@
 
 #define PI 3.141592653589793238462643383
 
+namespace {
+
+/// the first byte of a precompiled chunk
+constexpr char precompiledChunkMark = '\033';
+
+bool readFile(const std::string &filename, std::string &content)
+{
+    std::ifstream input(filename.c_str(), std::ios::binary);
+    if (!input.is_open())
+        return false;
+    std::ostringstream buffer;
+    buffer << input.rdbuf();
+    content = buffer.str();
+    return !input.bad();
+}
+
+/**
+ * @brief Write a file, such that readers never see a partially written file.
+ */
+bool writeFile(const std::string &filename, const std::string &content)
+{
+    // concurrent femmcli processes may write the same cache file
+    const std::string tmpName = location::temporaryFileName(filename);
+    {
+        std::ofstream output(tmpName.c_str(), std::ios::binary);
+        if (!output.is_open())
+            return false;
+        output.write(content.data(), content.size());
+        if (!output)
+        {
+            output.close();
+            std::remove(tmpName.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpName.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/// lua_Writer that appends to a std::string
+void appendToString(const void *p, size_t size, void *ud)
+{
+    static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+}
+
+/**
+ * @brief Dump the function on top of the Lua stack.
+ * @return \c true on success
+ */
+bool dumpFunction(lua_State *L, std::string &bytecode)
+{
+    bytecode.clear();
+    return lua_dumpfunction(L, appendToString, &bytecode) == 0;
+}
+
+/**
+ * @brief The file name of a cached chunk.
+ * The FNV-1a hash of the chunk name and content is the same on every platform and in every build,
+ * so the word size and number size are part of the hash; they determine the precompiled format.
+ */
+std::string chunkCacheFile(const std::string &dir, const std::string &chunk, const std::string &chunkName)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const char *data, size_t size) {
+        for (size_t i=0; i<size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+    };
+    const char sizes[] = { static_cast<char>(sizeof(int)), static_cast<char>(sizeof(size_t)), static_cast<char>(sizeof(CComplex)) };
+    add(sizes, sizeof(sizes));
+    add(chunkName.c_str(), chunkName.size()+1);
+    add(chunk.data(), chunk.size());
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.luac", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+} // anonymous namespace
+
 femm::LuaInstance::LuaInstance(int stackSize)
     : fs ()
     , compatMode(false)
     , debugGeometry(false)
     , pedanticMode(false)
+    , tracing(false)
+    , profiling(false)
 {
     initializeLua(stackSize);
 }
@@ -51,6 +146,8 @@ femm::LuaInstance::LuaInstance(std::shared_ptr<FemmStateBase> state, int stackSi
     , compatMode(false)
     , debugGeometry(false)
     , pedanticMode(false)
+    , tracing(false)
+    , profiling(false)
 {
     initializeLua(stackSize);
 }
@@ -68,7 +165,9 @@ std::shared_ptr<femm::FemmStateBase> femm::LuaInstance::femmState() const
 int femm::LuaInstance::doBuffer(const std::string &luaString, const std::string &chunkName, LuaStackMode mode)
 {
     int stackTop = lua_gettop(lua);
-    int result = lua_dobuffer(lua, luaString.c_str(), luaString.size(), chunkName.c_str());
+    int result = chunkCacheDir.empty()
+            ? lua_dobuffer(lua, luaString.c_str(), luaString.size(), chunkName.c_str())
+            : doCachedChunk(luaString, chunkName);
     if (mode==LuaStackMode::Safe)
     {
         // ensure that no values are left on the stack
@@ -80,7 +179,12 @@ int femm::LuaInstance::doBuffer(const std::string &luaString, const std::string
 int femm::LuaInstance::doFile(const std::string &filename, femm::LuaInstance::LuaStackMode mode)
 {
     int stackTop = lua_gettop(lua);
-    int result = lua_dofile(lua, filename.c_str());
+    int result;
+    std::string chunk;
+    if (!chunkCacheDir.empty() && readFile(filename, chunk))
+        result = doCachedChunk(chunk, "@" + filename);
+    else
+        result = lua_dofile(lua, filename.c_str());
     if (mode==LuaStackMode::Safe)
     {
         // ensure that no values are left on the stack
@@ -102,6 +206,53 @@ int femm::LuaInstance::doString(const std::string &luaString, femm::LuaInstance:
 
 }
 
+int femm::LuaInstance::compileFile(const std::string &filename, const std::string &outputFile)
+{
+    std::string chunk;
+    if (!readFile(filename, chunk))
+        return LUA_ERRFILE;
+    int stackTop = lua_gettop(lua);
+    const std::string chunkName = "@" + filename;
+    int result = lua_loadbuffer(lua, chunk.data(), chunk.size(), chunkName.c_str());
+    std::string bytecode;
+    if (result == 0)
+    {
+        if (!dumpFunction(lua, bytecode) || !writeFile(outputFile, bytecode))
+            result = LUA_ERRFILE;
+    }
+    lua_settop(lua, stackTop);
+    return result;
+}
+
+void femm::LuaInstance::setChunkCacheDir(const std::string &dir)
+{
+    chunkCacheDir = dir;
+}
+
+int femm::LuaInstance::doCachedChunk(const std::string &chunk, const std::string &chunkName)
+{
+    // precompiled chunks are not worth caching
+    if (chunk.empty() || chunk[0] == precompiledChunkMark)
+        return lua_dobuffer(lua, chunk.data(), chunk.size(), chunkName.c_str());
+
+    const std::string cacheFile = chunkCacheFile(chunkCacheDir, chunk, chunkName);
+    std::string bytecode;
+    int result = -1;
+    if (readFile(cacheFile, bytecode) && !bytecode.empty() && bytecode[0] == precompiledChunkMark)
+        result = lua_loadbuffer(lua, bytecode.data(), bytecode.size(), chunkName.c_str());
+    if (result != 0)
+    {
+        // not cached yet, or the cache file is unusable:
+        result = lua_loadbuffer(lua, chunk.data(), chunk.size(), chunkName.c_str());
+        if (result != 0)
+            return result;
+        // the cache is only an optimization, so failing to write it is not an error
+        if (dumpFunction(lua, bytecode))
+            writeFile(cacheFile, bytecode);
+    }
+    return lua_call(lua, 0, LUA_MULTRET);
+}
+
 CComplex femm::LuaInstance::getGlobal(const std::string &varName, bool *ok)
 {
     lua_getglobal(lua, varName.c_str()); //+1
@@ -127,12 +278,15 @@ bool femm::LuaInstance::compatibilityMode() const
 
 void femm::LuaInstance::enableTracing(bool enable)
 {
-    if (enable)
-    {
-        lua_setcallhook(lua, luaStackHook);
-    } else {
-        lua_setcallhook(lua, nullptr);
-    }
+    tracing = enable;
+    lua_setcallhook(lua, (tracing || profiling) ? luaCallHook : nullptr);
+}
+
+void femm::LuaInstance::enableProfiling(bool enable)
+{
+    profiling = enable;
+    profiler::enable(enable);
+    lua_setcallhook(lua, (tracing || profiling) ? luaCallHook : nullptr);
 }
 
 femm::LuaInstance *femm::LuaInstance::instance(lua_State *L)
@@ -333,6 +487,45 @@ void femm::LuaInstance::luaStackInfo(lua_State *L, int level, femm::LuaInstance:
     } while (info == StackInfoMode::FullStackInfo);
 }
 
+/**
+ * @brief The call hook for tracing and profiling.
+ * @param L
+ * @param ar
+ */
+void femm::LuaInstance::luaCallHook(lua_State *L, lua_Debug *ar)
+{
+    LuaInstance *li = instance(L);
+    if (li->tracing)
+        luaStackHook(L, ar);
+    if (li->profiling)
+        luaProfileHook(L, ar);
+}
+
+/**
+ * @brief Records calls of C functions (i.e. of the registered commands) with the profiler.
+ * @param L
+ * @param ar
+ */
+void femm::LuaInstance::luaProfileHook(lua_State *L, lua_Debug *ar)
+{
+    lua_getinfo(L, "nS", ar);
+    if (!ar->what || std::strcmp(ar->what, "C") != 0)
+        return;
+    // the call depth identifies the matching return event
+    int depth = 0;
+    lua_Debug frame;
+    while (lua_getstack(L, depth, &frame))
+        depth++;
+    if (std::strcmp(ar->event, "call") == 0)
+    {
+        // a Lua error skips the return event of the failing commands
+        profiler::dropStaleLuaCalls(depth);
+        profiler::begin(ar->name ? ar->name : "?", "lua", depth);
+    } else {
+        profiler::endLuaCall(depth);
+    }
+}
+
 /**
  * @brief Prints info on the given activation record (aka stack frame).
  * @param L
@@ -100,6 +100,25 @@ public:
      */
     int doString( const std::string &luaString, LuaStackMode mode=LuaStackMode::Safe );
 
+    /**
+     * @brief Compile a Lua source file to a precompiled chunk, without running it.
+     * The precompiled chunk can be run by doFile() or doBuffer() (or by passing it to femmcli as script).
+     * Precompiled chunks can only be read by builds with the same number format and word size.
+     * @param filename the file name of the Lua source file
+     * @param outputFile the file name of the precompiled chunk
+     * @return 0 on success, LUA_ERRFILE if a file could not be read or written, or LUA_ERRSYNTAX
+     */
+    int compileFile(const std::string &filename, const std::string &outputFile);
+
+    /**
+     * @brief Cache the precompiled chunks of the Lua sources run by doFile() and doBuffer().
+     * The cache file name is derived from a hash of the chunk name and the chunk content,
+     * so an edited file is compiled again, and the stale cache file is simply not used any more.
+     * Cache files are never removed; the cache directory may be emptied at any time.
+     * @param dir an existing directory, or an empty string to disable the cache
+     */
+    void setChunkCacheDir(const std::string &dir);
+
     /**
      * @brief Get a global lua variable.
      * @param varName the name of the global variable
@@ -140,6 +159,14 @@ public:
      */
     void enableTracing(bool enable);
 
+    /**
+     * @brief enableProfiling
+     * Enable or disable profiling of the lua commands (see Profiler.h).
+     * Enabling profiling drops the previously recorded events.
+     * @param enable
+     */
+    void enableProfiling(bool enable);
+
     /**
     * @brief Extract the LuaInstance object from the LuaState
     * @param L
@@ -202,8 +229,19 @@ private:
     bool compatMode;
     bool debugGeometry;
     bool pedanticMode;
+    bool tracing;
+    bool profiling;
 
     std::string baseDir;
+    std::string chunkCacheDir;
+
+    /**
+     * @brief Run a Lua chunk through the chunk cache (see setChunkCacheDir()).
+     * @param chunk a Lua source string or a precompiled chunk
+     * @param chunkName the name of the chunk
+     * @return the Lua error code
+     */
+    int doCachedChunk(const std::string &chunk, const std::string &chunkName);
 
     /**
      * @brief initialize lua
@@ -217,6 +255,8 @@ private:
     static int luaTrace(lua_State *L);
     static void luaStackInfo(lua_State *L, int startLevel, StackInfoMode info );
     static void luaStackHook(lua_State *L, lua_Debug *ar);
+    static void luaCallHook(lua_State *L, lua_Debug *ar);
+    static void luaProfileHook(lua_State *L, lua_Debug *ar);
 };
 
 std::string luaCurrentFunctionName(lua_State *L);
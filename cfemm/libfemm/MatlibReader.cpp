@@ -18,17 +18,151 @@
 #include "MatlibReader.h"
 
 #include "CMaterialProp.h"
+#include "locationTools.h"
 #include "make_unique.h"
 #include "stringTools.h"
 
+#include <sys/stat.h>
 #include <cassert>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 
 using namespace femm;
 
+namespace {
+
+/// first line of an index file; change the version whenever the format changes
+const std::string indexHeader = "xfemm material library index 1";
+
+/**
+ * @brief The position of each material in a library file.
+ * The index is valid as long as size and modification time of the library file match.
+ */
+struct MatlibIndex
+{
+    long long size = -1;
+    long long mtime = -1;
+    std::unordered_map<std::string,std::streamoff> offsets;
+};
+
+std::mutex indexMutex;
+/// key: library file name
+std::unordered_map<std::string,MatlibIndex> indexCache;
+
+bool fileStamp(const std::string &file, long long &size, long long &mtime)
+{
+    struct stat info;
+    if (stat(file.c_str(), &info) != 0)
+        return false;
+    size = static_cast<long long>(info.st_size);
+    mtime = static_cast<long long>(info.st_mtime);
+    return true;
+}
+
+bool isFolderLine(const std::string &line)
+{
+    return begins_with(line,"<beginfolder>")
+            || begins_with(line, "<foldername>")
+            || begins_with(line, "<folderurl>")
+            || begins_with(line, "<foldervendor>")
+            || begins_with(line, "<endfolder>");
+}
+
+/**
+ * @brief Scan a library for the \c <BlockName> of each material, without parsing the materials.
+ * @param input the library, opened in binary mode
+ * @param index the offsets of the "<BeginBlock>" lines (output variable)
+ * @return \c false, if the file is not a valid material library
+ */
+bool buildIndex(std::istream &input, MatlibIndex &index)
+{
+    bool inBlock = false;
+    std::streamoff blockStart = 0;
+    std::string blockName;
+    while (input)
+    {
+        const std::streamoff lineStart = input.tellg();
+        std::string line;
+        if (!std::getline(input, line))
+            break;
+        trim(line);
+        std::string lowerLine = line;
+        to_lower(lowerLine);
+        const std::string token = lowerLine.substr(0, lowerLine.find('>')+1);
+        if (token == "<beginblock>")
+        {
+            inBlock = true;
+            blockStart = lineStart;
+            blockName.clear();
+        } else if (inBlock && token == "<blockname>") {
+            // same as parseString(): the name ends at the last quote of the line
+            const size_t first = line.find('"');
+            const size_t last = line.find_last_of('"');
+            if (first != std::string::npos && last > first)
+                blockName = line.substr(first+1, last-first-1);
+        } else if (inBlock && token == "<endblock>") {
+            inBlock = false;
+            // later materials with the same name replace earlier ones, just like in MatlibReader::parse()
+            index.offsets[blockName] = blockStart;
+        } else if (!inBlock && !line.empty() && !isFolderLine(lowerLine)) {
+            return false;
+        }
+    }
+    return !inBlock;
+}
+
+bool readIndexFile(const std::string &indexFile, MatlibIndex &index)
+{
+    std::ifstream input(indexFile.c_str(), std::ios::binary);
+    std::string line;
+    if (!std::getline(input, line) || line != indexHeader)
+        return false;
+    long long size, mtime;
+    input >> size >> mtime;
+    if (!input || size != index.size || mtime != index.mtime)
+        return false;
+    long long offset;
+    while (input >> offset)
+    {
+        // a single space separates offset and name
+        input.get();
+        std::getline(input, line);
+        index.offsets[line] = static_cast<std::streamoff>(offset);
+    }
+    return input.eof();
+}
+
+/**
+ * @brief Write the index next to the library, so that other processes can use it.
+ * Failure is not an error, e.g. if the library is in a read-only directory.
+ */
+void writeIndexFile(const std::string &indexFile, const MatlibIndex &index)
+{
+    const std::string tmpFile = location::temporaryFileName(indexFile);
+    {
+        std::ofstream output(tmpFile.c_str(), std::ios::binary);
+        output << indexHeader << "\n" << index.size << " " << index.mtime << "\n";
+        for (const auto &entry: index.offsets)
+            output << static_cast<long long>(entry.second) << " " << entry.first << "\n";
+        if (!output)
+        {
+            output.close();
+            std::remove(tmpFile.c_str());
+            return;
+        }
+    }
+    // readers see either the old or the new index, never a partial one
+    // (where rename() doesn't replace existing files, the outdated index is kept and ignored)
+    if (std::rename(tmpFile.c_str(), indexFile.c_str()) != 0)
+        std::remove(tmpFile.c_str());
+}
+
+} // anonymous namespace
+
 MatlibReader::MatlibReader(FileType filetype)
     : type(filetype)
 {
@@ -37,6 +171,13 @@ MatlibReader::MatlibReader(FileType filetype)
 
 MatlibParseResult MatlibReader::parse(const std::string &libraryFile, std::ostream &err, const std::string &filter)
 {
+    if (!filter.empty())
+    {
+        MatlibParseResult result;
+        if (parseIndexed(libraryFile, filter, result))
+            return result;
+    }
+
     std::ifstream input;
     input.open(libraryFile.c_str(), std::ifstream::in);
     if (!input.is_open())
@@ -54,11 +195,7 @@ MatlibParseResult MatlibReader::parse(const std::string &libraryFile, std::ostre
         if (line.empty())
             continue;
         to_lower(line);
-        if ( begins_with(line,"<beginfolder>")
-             || begins_with(line, "<foldername>")
-             || begins_with(line, "<folderurl>")
-             || begins_with(line, "<foldervendor>")
-             || begins_with(line, "<endfolder>"))
+        if (isFolderLine(line))
             continue;
 
         if ( line != "<beginblock>" )
@@ -67,29 +204,13 @@ MatlibParseResult MatlibReader::parse(const std::string &libraryFile, std::ostre
                 << line << "'!\n";
             return MatlibParseResult::ParseFolderError;
         }
-        std::unique_ptr<CMaterialProp> prop;
-        // in .fem files, material properties are identified by context;
-        // in matlib.dat files, we need to read the beginBlock line, requiring the fromStream method to go without that line.
-        switch (type) {
-        case FileType::ElectrostaticsFile:
-                prop = MAKE_UNIQUE<CSMaterialProp>(CSMaterialProp::fromStream(input, err_internal, PropertyParseMode::NoBeginBlock));
-                break;
-        case FileType::HeatFlowFile:
-                prop = MAKE_UNIQUE<CHMaterialProp>(CHMaterialProp::fromStream(input, err_internal, PropertyParseMode::NoBeginBlock));
-                break;
-        case FileType::MagneticsFile:
-                prop = MAKE_UNIQUE<CMSolverMaterialProp>(CMSolverMaterialProp::fromStream(input, err_internal, PropertyParseMode::NoBeginBlock));
-                break;
-        default:
-                err << "MatlibReader: File type not implemented!\n";
-                break;
-        }
+        std::unique_ptr<CMaterialProp> prop = parseMaterial(input, err_internal);
         if ( ! err_internal.str().empty() )
         {
             err << err_internal.str();
             return  MatlibParseResult::ParseMaterialError;
         }
-        if (filter.empty() || prop->BlockName == filter)
+        if (prop && (filter.empty() || prop->BlockName == filter))
         {
             m_library[prop->BlockName] = std::move(prop);
         }
@@ -97,6 +218,88 @@ MatlibParseResult MatlibReader::parse(const std::string &libraryFile, std::ostre
     return  MatlibParseResult::OK;
 }
 
+std::string MatlibReader::indexFileName(const std::string &libraryFile)
+{
+    return libraryFile + ".idx";
+}
+
+std::unique_ptr<CMaterialProp> MatlibReader::parseMaterial(std::istream &input, std::ostream &err) const
+{
+    // in .fem files, material properties are identified by context;
+    // in matlib.dat files, we need to read the beginBlock line, requiring the fromStream method to go without that line.
+    switch (type) {
+    case FileType::ElectrostaticsFile:
+        return MAKE_UNIQUE<CSMaterialProp>(CSMaterialProp::fromStream(input, err, PropertyParseMode::NoBeginBlock));
+    case FileType::HeatFlowFile:
+        return MAKE_UNIQUE<CHMaterialProp>(CHMaterialProp::fromStream(input, err, PropertyParseMode::NoBeginBlock));
+    case FileType::MagneticsFile:
+        return MAKE_UNIQUE<CMSolverMaterialProp>(CMSolverMaterialProp::fromStream(input, err, PropertyParseMode::NoBeginBlock));
+    default:
+        err << "MatlibReader: File type not implemented!\n";
+        return nullptr;
+    }
+}
+
+bool MatlibReader::parseIndexed(const std::string &libraryFile, const std::string &materialName, MatlibParseResult &result)
+{
+    MatlibIndex index;
+    if (!fileStamp(libraryFile, index.size, index.mtime))
+        return false;
+
+    std::ifstream input(libraryFile.c_str(), std::ios::binary);
+    if (!input.is_open())
+        return false;
+
+    std::streamoff offset;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        auto cached = indexCache.find(libraryFile);
+        if (cached == indexCache.end()
+                || cached->second.size != index.size
+                || cached->second.mtime != index.mtime)
+        {
+            const std::string indexFile = indexFileName(libraryFile);
+            if (!readIndexFile(indexFile, index))
+            {
+                index.offsets.clear();
+                if (!buildIndex(input, index))
+                    return false; // let the full parser report the error
+                writeIndexFile(indexFile, index);
+                input.clear();
+            }
+            cached = indexCache.insert(std::make_pair(libraryFile, MatlibIndex())).first;
+            cached->second = std::move(index);
+        }
+        const auto entry = cached->second.offsets.find(materialName);
+        // the index may be stale without a visible change of the stamp;
+        // a full parse of the library costs no more than without the index
+        if (entry == cached->second.offsets.end())
+            return false;
+        offset = entry->second;
+    }
+
+    std::string line;
+    input.seekg(offset);
+    std::getline(input, line);
+    trim(line);
+    to_lower(line);
+    if (!input || line != "<beginblock>")
+        return false;
+
+    std::stringstream err_internal;
+    std::unique_ptr<CMaterialProp> prop = parseMaterial(input, err_internal);
+    // a stale index (e.g. the library was changed twice within a second) is detected by the name:
+    if (!err_internal.str().empty() || !prop || prop->BlockName != materialName)
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        indexCache.erase(libraryFile);
+        return false;
+    }
+    m_library[prop->BlockName] = std::move(prop);
+    result = MatlibParseResult::OK;
+    return true;
+}
+
 const CMaterialProp *MatlibReader::getMaterial(const std::string &materialName) const
 {
     const auto entry = m_library.find(materialName);
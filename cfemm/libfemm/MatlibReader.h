@@ -19,7 +19,9 @@
 
 #include "femmenums.h"
 
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 
@@ -51,13 +53,28 @@ public:
      * @brief parse the given material library file and optionally apply a filter.
      * Before parsing, any existing material data is cleared.
      *
-     * If a filter is given, only the matching material is stored while other materials are discarded.
+     * If a filter is given, only the matching material is parsed and stored.
+     * The material is located using an index of the library (see indexFileName()),
+     * which is built on first use and rebuilt whenever size or modification time of the library change.
      * @param libraryFile a file name
      * @param filter the name of a material
      * @return
      */
     MatlibParseResult parse(const std::string &libraryFile, std::ostream &err, const std::string &filter="");
 
+    /**
+     * @brief The file name of the index of a material library.
+     * The index maps the material names to their positions in the library file,
+     * and is kept next to the library (if the directory is writable).
+     * @param libraryFile the material library
+     * @return the index file name
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    static std::string indexFileName(const std::string &libraryFile);
+
     /**
      * @brief Get the material matching \c materialName.
      * @param materialName
@@ -71,6 +88,18 @@ public:
      */
     CMaterialProp *takeMaterial(const std::string &materialName);
 private:
+    /**
+     * @brief Parse a material, after its "<BeginBlock>" line has been read.
+     */
+    std::unique_ptr<CMaterialProp> parseMaterial(std::istream &input, std::ostream &err) const;
+    /**
+     * @brief Parse only the material \c materialName, using the index of the library file.
+     * Errors are not reported here: if anything is wrong, the full parser runs and reports them.
+     * @param result the parse result (output variable)
+     * @return \c false, if the index can not be used or does not list the material, and the whole library needs to be parsed.
+     */
+    bool parseIndexed(const std::string &libraryFile, const std::string &materialName, MatlibParseResult &result);
+
     const FileType type;
     std::unordered_map<std::string,std::unique_ptr<CMaterialProp>> m_library;
 };
@@ -0,0 +1,319 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "MemoryFiles.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief A memory file.
+ * The contents are shared with the streams that read them,
+ * so that replacing or removing the file doesn't affect open streams.
+ */
+struct MemoryFile
+{
+    std::shared_ptr<const std::string> content = std::make_shared<const std::string>();
+    unsigned long writer = 0; ///< the stream whose contents are stored by fclose(), or 0
+};
+
+std::mutex memoryMutex;
+std::set<std::string> memoryBaseNames;
+std::map<std::string, MemoryFile> memoryFiles;
+unsigned long lastWriter = 0;
+
+/**
+ * @brief Check whether a file is a memory file.
+ * memoryMutex must be locked.
+ */
+bool isMemoryFileLocked(const std::string &file)
+{
+    if (memoryBaseNames.empty())
+        return false;
+    const std::size_t dot = file.find_last_of('.');
+    // the extension must not be part of a directory name
+    if (dot == std::string::npos || file.find_first_of("/\\", dot) != std::string::npos)
+        return false;
+    return memoryBaseNames.count(file.substr(0,dot)) > 0;
+}
+
+#if defined(XFEMM_HAVE_FOPENCOOKIE) || defined(XFEMM_HAVE_FUNOPEN)
+#define XFEMM_HAVE_MEMORY_FILES
+#endif
+
+#ifdef XFEMM_HAVE_MEMORY_FILES
+/**
+ * @brief The state of a FILE stream opened on a memory file.
+ * A reader holds a reference to the contents at the time it was opened,
+ * a writer collects its output and stores it into the memory file when it is closed.
+ */
+struct MemoryStream
+{
+    std::shared_ptr<const std::string> input;
+    std::string output;
+    std::string file;
+    unsigned long writer = 0;
+    std::size_t pos = 0;
+
+    const std::string &data() const { return writer ? output : *input; }
+};
+
+long long readMemoryStream(void *cookie, char *buf, std::size_t size)
+{
+    MemoryStream *stream = static_cast<MemoryStream*>(cookie);
+    const std::string &data = stream->data();
+    if (stream->pos >= data.size())
+        return 0;
+    size = std::min(size, data.size() - stream->pos);
+    std::memcpy(buf, data.data() + stream->pos, size);
+    stream->pos += size;
+    return static_cast<long long>(size);
+}
+
+long long writeMemoryStream(void *cookie, const char *buf, std::size_t size)
+{
+    MemoryStream *stream = static_cast<MemoryStream*>(cookie);
+    if (!stream->writer)
+        return -1;
+    if (stream->pos > stream->output.size())
+        stream->output.resize(stream->pos);
+    stream->output.replace(stream->pos, std::min(size, stream->output.size() - stream->pos), buf, size);
+    stream->pos += size;
+    return static_cast<long long>(size);
+}
+
+long long seekMemoryStream(void *cookie, long long offset, int whence)
+{
+    MemoryStream *stream = static_cast<MemoryStream*>(cookie);
+    long long base = 0;
+    if (whence == SEEK_CUR)
+        base = static_cast<long long>(stream->pos);
+    else if (whence == SEEK_END)
+        base = static_cast<long long>(stream->data().size());
+    if (base + offset < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    stream->pos = static_cast<std::size_t>(base + offset);
+    return base + offset;
+}
+
+int closeMemoryStream(void *cookie)
+{
+    MemoryStream *stream = static_cast<MemoryStream*>(cookie);
+    if (stream->writer)
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        // if the file was removed or opened for writing again meanwhile, the output is discarded
+        auto it = memoryFiles.find(stream->file);
+        if (it != memoryFiles.end() && it->second.writer == stream->writer)
+        {
+            it->second.content = std::make_shared<const std::string>(std::move(stream->output));
+            it->second.writer = 0;
+        }
+    }
+    delete stream;
+    return 0;
+}
+
+#ifdef XFEMM_HAVE_FOPENCOOKIE
+#ifdef __GLIBC__
+typedef off64_t cookie_off_t;
+#else
+typedef off_t cookie_off_t;
+#endif
+
+ssize_t readCookie(void *cookie, char *buf, size_t size)
+{
+    return readMemoryStream(cookie, buf, size);
+}
+
+ssize_t writeCookie(void *cookie, const char *buf, size_t size)
+{
+    // glibc expects 0 on error
+    const long long written = writeMemoryStream(cookie, buf, size);
+    return (written < 0) ? 0 : written;
+}
+
+int seekCookie(void *cookie, cookie_off_t *offset, int whence)
+{
+    const long long pos = seekMemoryStream(cookie, *offset, whence);
+    if (pos < 0)
+        return -1;
+    *offset = pos;
+    return 0;
+}
+
+FILE *openMemoryStream(MemoryStream *stream, const char *mode)
+{
+    cookie_io_functions_t functions = { readCookie, writeCookie, seekCookie, closeMemoryStream };
+    FILE *fp = fopencookie(stream, mode, functions);
+    if (fp == nullptr)
+        delete stream;
+    return fp;
+}
+#else
+int readCookie(void *cookie, char *buf, int size)
+{
+    return static_cast<int>(readMemoryStream(cookie, buf, static_cast<std::size_t>(size)));
+}
+
+int writeCookie(void *cookie, const char *buf, int size)
+{
+    return static_cast<int>(writeMemoryStream(cookie, buf, static_cast<std::size_t>(size)));
+}
+
+fpos_t seekCookie(void *cookie, fpos_t offset, int whence)
+{
+    return static_cast<fpos_t>(seekMemoryStream(cookie, offset, whence));
+}
+
+FILE *openMemoryStream(MemoryStream *stream, const char *)
+{
+    FILE *fp = funopen(stream, readCookie, writeCookie, seekCookie, closeMemoryStream);
+    if (fp == nullptr)
+        delete stream;
+    return fp;
+}
+#endif
+#endif
+
+} // anonymous namespace
+
+bool femm::haveMemoryFiles()
+{
+#ifdef XFEMM_HAVE_MEMORY_FILES
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool femm::addMemoryFiles(const std::string &baseName)
+{
+    if (!haveMemoryFiles())
+        return false;
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    memoryBaseNames.insert(baseName);
+    return true;
+}
+
+void femm::removeMemoryFiles(const std::string &baseName)
+{
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    if (memoryBaseNames.erase(baseName) == 0)
+        return;
+    for (auto it = memoryFiles.begin(); it != memoryFiles.end(); )
+    {
+        if (!isMemoryFileLocked(it->first))
+            it = memoryFiles.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool femm::isMemoryFile(const std::string &file)
+{
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return isMemoryFileLocked(file);
+}
+
+FILE *femm::openFile(const std::string &file, const char *mode)
+{
+#ifdef XFEMM_HAVE_MEMORY_FILES
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        if (isMemoryFileLocked(file))
+        {
+            if (mode[0] == 'r')
+            {
+                auto it = memoryFiles.find(file);
+                if (it == memoryFiles.end())
+                {
+                    errno = ENOENT;
+                    return nullptr;
+                }
+                MemoryStream *stream = new MemoryStream;
+                stream->input = it->second.content;
+                return openMemoryStream(stream, "r");
+            }
+            if (mode[0] == 'w')
+            {
+                // like fopen(), truncate the file right away
+                MemoryFile &memFile = memoryFiles[file];
+                memFile.content = std::make_shared<const std::string>();
+                memFile.writer = ++lastWriter;
+                MemoryStream *stream = new MemoryStream;
+                stream->file = file;
+                stream->writer = memFile.writer;
+                return openMemoryStream(stream, "w");
+            }
+            errno = EINVAL;
+            return nullptr;
+        }
+    }
+#endif
+    return fopen(file.c_str(), mode);
+}
+
+std::unique_ptr<std::istream> femm::openInputFile(const std::string &file, std::ios_base::openmode mode)
+{
+    mode |= std::ios_base::in;
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        if (isMemoryFileLocked(file))
+        {
+            auto it = memoryFiles.find(file);
+            if (it == memoryFiles.end())
+                return std::unique_ptr<std::istream>();
+            return std::unique_ptr<std::istream>(
+                        new std::istringstream(*it->second.content, mode));
+        }
+    }
+    std::unique_ptr<std::ifstream> input(new std::ifstream(file.c_str(), mode));
+    if (!input->is_open())
+        return std::unique_ptr<std::istream>();
+    return std::unique_ptr<std::istream>(input.release());
+}
+
+bool femm::writeFile(const std::string &file, const std::string &content)
+{
+    FILE *fp = openFile(file, "wb");
+    if (fp == nullptr)
+        return false;
+    const bool ok = (fwrite(content.data(), 1, content.size(), fp) == content.size());
+    return (fclose(fp) == 0) && ok;
+}
+
+int femm::removeFile(const std::string &file)
+{
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        if (isMemoryFileLocked(file))
+        {
+            if (memoryFiles.erase(file) == 0)
+            {
+                errno = ENOENT;
+                return -1;
+            }
+            return 0;
+        }
+    }
+    return remove(file.c_str());
+}
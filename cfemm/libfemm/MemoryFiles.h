@@ -0,0 +1,101 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_MEMORYFILES_H
+#define FEMM_MEMORYFILES_H
+
+#include <cstdio>
+#include <istream>
+#include <memory>
+#include <string>
+
+/**
+ * \file MemoryFiles.h
+ * Keeping the intermediate files of an analysis in memory (not present in femm42; xfemm extension).
+ *
+ * The mesher, the solvers and the post processors pass their data through files:
+ * the problem description (.fem, .feh, .fee), the mesh files (.node, .edge, .ele, .pbc, .poly)
+ * and the solution file (.ans, .anh, .res).
+ * After addMemoryFiles(baseName), all files named baseName.<extension> are kept in memory instead:
+ * they are created, read and removed with openFile(), openInputFile() and removeFile(),
+ * which work on regular files for any other name.
+ * This way, scripts that run many small analyses don't write to the disk at all.
+ * Note that this only removes the disk I/O: the stages still exchange their data as text,
+ * i.e. the problem description, the mesh and the solution are formatted and parsed as before.
+ *
+ * Memory files are only available if the build found fopencookie() (glibc, musl) or funopen() (BSD, macOS);
+ * see haveMemoryFiles().
+ * All functions are thread safe. Each open stream works on its own copy of the file:
+ * readers see the contents at the time they were opened, and a writer stores its contents when it is closed,
+ * unless the file has been removed or opened for writing again in the meantime.
+ */
+namespace femm {
+
+/**
+ * @brief Check whether memory files are available.
+ * @return \c false, if addMemoryFiles() is not supported on this system
+ */
+bool haveMemoryFiles();
+
+/**
+ * @brief Keep all files with the given base name in memory.
+ * @param baseName the file name without extension, e.g. "/tmp/motor" for "/tmp/motor.fem", "/tmp/motor.ans", ...
+ * @return \c false, if memory files are not available
+ */
+bool addMemoryFiles(const std::string &baseName);
+
+/**
+ * @brief Stop keeping the files with the given base name in memory, and drop their memory files.
+ * @param baseName the file name without extension
+ */
+void removeMemoryFiles(const std::string &baseName);
+
+/**
+ * @brief Check whether a file name belongs to a base name registered with addMemoryFiles().
+ * @param file the file name
+ * @return \c true, if the file is kept in memory
+ */
+bool isMemoryFile(const std::string &file);
+
+/**
+ * @brief Open a file like fopen().
+ * Memory files can be opened for reading ("r", "rt", "rb") or writing ("w", "wt", "wb").
+ * Writing to a memory file replaces its contents; the new contents are visible after fclose().
+ * @param file the file name
+ * @param mode the fopen() mode
+ * @return the opened file, or \c nullptr if the file could not be opened
+ */
+FILE *openFile(const std::string &file, const char *mode);
+
+/**
+ * @brief Open a file for reading as input stream; this is the std::istream version of openFile().
+ * @param file the file name
+ * @param mode the open mode; std::ios_base::in is always added
+ * @return the opened stream, or an empty pointer if the file could not be opened
+ */
+std::unique_ptr<std::istream> openInputFile(const std::string &file, std::ios_base::openmode mode = std::ios_base::in);
+
+/**
+ * @brief Write a file in one go.
+ * @param file the file name
+ * @param content the new file contents
+ * @return \c true on success
+ */
+bool writeFile(const std::string &file, const std::string &content);
+
+/**
+ * @brief Remove a file like remove().
+ * @param file the file name
+ * @return 0 on success
+ */
+int removeFile(const std::string &file);
+
+} // namespace femm
+
+#endif
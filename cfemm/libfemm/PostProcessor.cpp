@@ -31,7 +31,9 @@
 #include "femmconstants.h"
 #include "fparse.h"
 #include "spars.h"
+#include "threadTools.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -78,6 +80,7 @@ femm::PostProcessor::PostProcessor()
     NumList = nullptr;
     ConList = nullptr;
     bHasMask = false;
+    lastElement = 0;
     LengthConv = (double *)calloc(6,sizeof(double));
     LengthConv[0] = 0.0254;   //inches
     LengthConv[1] = 0.001;    //millimeters
@@ -299,59 +302,70 @@ void PostProcessor::addContourPointFromNode(double mx, double my)
 // identical in EPProc, FPProc and HPProc
 int femm::PostProcessor::InTriangle(double x, double y) const
 {
-    static int k=0;
-    int j,hi,lo,sz;
-    double z;
+    return InTriangle(x, y, lastElement);
+}
 
-    sz = meshelems.size();
+int femm::PostProcessor::InTriangle(double x, double y, int &hint) const
+{
+    const int sz = meshelems.size();
 
+    int k = hint;
     if ((k < 0) || (k >= sz)) k = 0;
 
     // In most applications, the triangle we're looking
-    // for is nearby the last one we found.  Since the elements
-    // are ordered in a banded structure, we want to check the
-    // elements nearby the last one selected first.
+    // for is nearby the last one we found.
     if (InTriangleTest(x,y,k)) return k;
 
-    // wasn't in the last searched triangle, so look through all the
-    // elements
-    hi = k;
-    lo = k;
-
-    for(j=0; j<sz; j+=2)
+    // xfemm: instead of scanning through all the elements, only check those
+    // whose bounding box contains the point
+    std::vector<int> candidates;
+    if (elementIndex.size() == sz)
+        elementIndex.query(CComplex(x,y), CComplex(x,y), candidates);
+    else
+        for (int i=0; i<sz; i++)
+            candidates.push_back(i);
+
+    // Points on edges or nodes are contained in several elements.
+    // In that case, return the element that the femm42 search would have found:
+    // femm42 alternately checks the elements above and below k, moving away from k.
+    int found = -1;
+    int foundRank = 0;
+    for (int i: candidates)
     {
-        hi++;
-        if (hi >= sz) hi = 0;
-        lo--;
-        if (lo < 0)   lo = sz - 1;
-
-        CComplex hiCtr = meshelems[hi]->ctr;
-        z = (hiCtr.re - x) * (hiCtr.re - x) + (hiCtr.im - y) * (hiCtr.im - y);
-
-        if (z <= meshelems[hi]->rsqr)
+        const CComplex ctr = meshelems[i]->ctr;
+        const double z = (ctr.re-x)*(ctr.re-x) + (ctr.im-y)*(ctr.im-y);
+        if (z > meshelems[i]->rsqr || !InTriangleTest(x,y,i))
+            continue;
+        const int rank = std::min(2*((i-k+sz)%sz)-1, 2*((k-i+sz)%sz));
+        if (found < 0 || rank < foundRank)
         {
-            if (InTriangleTest(x,y,hi))
-            {
-                k = hi;
-                return k;
-            }
+            found = i;
+            foundRank = rank;
         }
+    }
 
-        CComplex loCtr = meshelems[lo]->ctr;
-        z = (loCtr.re-x)*(loCtr.re-x) + (loCtr.im-y)*(loCtr.im-y);
+    if (found >= 0)
+        hint = found;
+    return found;
+}
+
+void femm::PostProcessor::forEachPointInMesh(int numPoints, const double *x, const double *y,
+                                             const std::function<void (int, int)> &evaluate, int numThreads) const
+{
+    if (numPoints <= 0)
+        return;
 
-        if (z <= meshelems[lo]->rsqr)
+    // each thread handles a consecutive range of points and uses its own search hint,
+    // so that neighbouring points are found quickly and no shared state is modified
+    runInChunks(numPoints, threadsForItems(numPoints, 1000, numThreads), [this,x,y,&evaluate](int first, int last) {
+        int hint = lastElement;
+        for (int i=first; i<last; i++)
         {
-            if (InTriangleTest(x,y,lo))
-            {
-                k = lo;
-                return k;
-            }
+            const int k = InTriangle(x[i], y[i], hint);
+            if (k >= 0)
+                evaluate(i, k);
         }
-
-    }
-
-    return (-1);
+    });
 }
 
 // EPProc  and FPProc are identical
@@ -1149,6 +1163,33 @@ void femm::PostProcessor::FindBoundaryEdges()
     } // End of Main Loop
 }
 
+void femm::PostProcessor::buildElementIndex()
+{
+    std::vector<CComplex> boxes;
+    boxes.reserve(2*meshelems.size());
+    // use the average element extent as bucket size
+    double size = 0;
+    for (const auto &elem: meshelems)
+    {
+        CComplex bmin = meshnodes[elem->p[0]]->CC();
+        CComplex bmax = bmin;
+        for (int j=1; j<3; j++)
+        {
+            const CComplex p = meshnodes[elem->p[j]]->CC();
+            bmin.re = std::min(bmin.re, p.re); bmin.im = std::min(bmin.im, p.im);
+            bmax.re = std::max(bmax.re, p.re); bmax.im = std::max(bmax.im, p.im);
+        }
+        boxes.push_back(bmin);
+        boxes.push_back(bmax);
+        size += std::max(bmax.re-bmin.re, bmax.im-bmin.im);
+    }
+
+    elementIndex.clear(meshelems.empty() ? 1. : size/meshelems.size());
+    for (int i=0; i<(int)meshelems.size(); i++)
+        elementIndex.appendBox(boxes[2*i], boxes[2*i+1]);
+    lastElement = 0;
+}
+
 // identical in hpproc and epproc
 void PostProcessor::getPointD(double x, double y, CComplex &D, const femmsolver::CElement &element) const
 {
@@ -30,7 +30,9 @@
 #include "femmcomplex.h"
 #include "fparse.h"
 #include "FemmProblem.h"
+#include "SpatialGrid.h"
 
+#include <functional>
 #include <vector>
 
 namespace femm {
@@ -299,7 +301,22 @@ protected:
      */
     void getPointD(double x, double y, CComplex &D, const femmsolver::CElement &element) const;
 
+    /**
+     * @brief Find the mesh element that contains a point.
+     * @param x
+     * @param y
+     * @return the element index, or -1 if the point is outside of the mesh
+     */
     int InTriangle(double x, double y) const;
+    /**
+     * @brief Find the mesh element that contains a point, starting the search at a given element.
+     * In contrast to InTriangle(x,y), this method doesn't modify the post-processor.
+     * @param x
+     * @param y
+     * @param hint the element to check first; set to the found element (input and output variable)
+     * @return the element index, or -1 if the point is outside of the mesh
+     */
+    int InTriangle(double x, double y, int &hint) const;
     // currently virtual until we merge hpproc version of it:
     virtual bool InTriangleTest(double x, double y, int i) const;
 
@@ -346,6 +363,16 @@ protected:
     CComplex HenrotteVector(int k) const;
     void FindBoundaryEdges();
 
+    /**
+     * @brief Build the spatial index that is used by InTriangle().
+     * Needs to be called whenever the mesh has been loaded.
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void buildElementIndex();
+
     // pointer to function to call when issuing warning messages
     MessageCB WarnMessage;
     //	void MsgBox(const char* message);
@@ -353,6 +380,33 @@ protected:
 protected:
     PostProcessor();
     std::shared_ptr<femm::FemmProblem> problem;
+
+    /**
+     * @brief Locate many points in the mesh and evaluate them concurrently.
+     *
+     * The points are split into consecutive chunks that are processed in separate threads.
+     * Each chunk has its own search hint for InTriangle(), so the post-processor is not modified.
+     * \note Points that lie exactly on an element edge may be assigned to a different
+     * (adjacent) element than in a sequence of single point calls.
+     *
+     * @param numPoints number of points
+     * @param x x coordinates of the points
+     * @param y y coordinates of the points
+     * @param evaluate called as evaluate(i,k) for each point i that lies within element k
+     * @param numThreads number of threads to use; 0 to use the number of available cores
+     *
+     * \internal
+     * (not present in femm42; xfemm extension)
+     * \endinternal
+     */
+    void forEachPointInMesh(int numPoints, const double *x, const double *y,
+                            const std::function<void(int,int)> &evaluate, int numThreads = 0) const;
+
+private:
+    // bounding boxes of the mesh elements
+    SpatialGrid elementIndex;
+    // the element found by the last call to InTriangle()
+    mutable int lastElement;
 };
 
 } //namespace
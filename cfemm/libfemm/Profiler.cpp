@@ -0,0 +1,291 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define FEMM_HAVE_MALLINFO2
+#endif
+
+namespace {
+
+/// more events are only summarized, but not written to the trace file
+constexpr std::size_t maxTraceEvents = 1000000;
+
+struct Event
+{
+    std::string name;
+    const char *category;
+    int depth;
+    double start; ///< wall time in µs since profiling was enabled
+    std::clock_t startCpu;
+    long long startHeap; ///< only sampled for phases (depth < 0)
+    double childWall = 0; ///< wall time of the nested events in µs
+};
+
+struct TraceEvent
+{
+    std::string name;
+    const char *category;
+    double start;
+    double wall;
+    double cpu;
+    long long heap;
+    bool hasHeap;
+};
+
+struct Summary
+{
+    int calls = 0;
+    double wall = 0;
+    double self = 0;
+    double cpu = 0;
+    long long heap = 0;
+};
+
+std::mutex profilerMutex;
+std::atomic<bool> isEnabled(false);
+// read by worker threads (phases of the mesher and the solvers) without holding profilerMutex
+std::atomic<std::thread::id> owner;
+std::chrono::steady_clock::time_point origin;
+std::vector<Event> openEvents;
+std::vector<TraceEvent> traceEvents;
+std::size_t droppedTraceEvents = 0;
+// key: (category, name)
+std::map<std::pair<std::string,std::string>, Summary> summaries;
+
+double now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+/**
+ * @brief The number of bytes allocated on the heap, if it is known.
+ */
+long long heapInUse()
+{
+#ifdef FEMM_HAVE_MALLINFO2
+    const struct mallinfo2 info = mallinfo2();
+    return static_cast<long long>(info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+bool isRecording()
+{
+    return isEnabled && std::this_thread::get_id() == owner;
+}
+
+/**
+ * @brief Close the innermost open event.
+ * profilerMutex must be locked.
+ */
+void closeInnermost()
+{
+    const double wall = now() - openEvents.back().start;
+    const std::clock_t cpuEnd = std::clock();
+    Event event = std::move(openEvents.back());
+    openEvents.pop_back();
+
+    const double cpu = 1e6 * (cpuEnd - event.startCpu) / CLOCKS_PER_SEC;
+    const long long heap = (event.depth < 0) ? heapInUse() - event.startHeap : 0;
+    if (!openEvents.empty())
+        openEvents.back().childWall += wall;
+
+    Summary &summary = summaries[std::make_pair(std::string(event.category), event.name)];
+    summary.calls++;
+    summary.wall += wall;
+    summary.self += wall - event.childWall;
+    summary.cpu += cpu;
+    summary.heap += heap;
+
+    if (traceEvents.size() < maxTraceEvents)
+        traceEvents.push_back(TraceEvent{std::move(event.name), event.category, event.start, wall, cpu, heap, event.depth < 0});
+    else
+        droppedTraceEvents++;
+}
+
+std::string jsonString(const std::string &s)
+{
+    std::string result = "\"";
+    for (char c: s)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            continue;
+        result += c;
+    }
+    return result + "\"";
+}
+
+void writeSummaryTable(std::ostream &out, const std::string &category, const char *title, bool withHeap)
+{
+    std::vector<std::pair<std::string, Summary>> rows;
+    for (const auto &entry: summaries)
+    {
+        if (entry.first.first == category)
+            rows.push_back(std::make_pair(entry.first.second, entry.second));
+    }
+    if (rows.empty())
+        return;
+    std::sort(rows.begin(), rows.end(), [](const std::pair<std::string, Summary> &a, const std::pair<std::string, Summary> &b) {
+        return a.second.self > b.second.self;
+    });
+    char line[256];
+    snprintf(line, sizeof(line), "%-28s %8s %12s %12s %12s", title, "calls", "total [ms]", "self [ms]", "cpu [ms]");
+    out << line;
+    if (withHeap)
+    {
+        snprintf(line, sizeof(line), " %12s", "heap [KiB]");
+        out << line;
+    }
+    out << "\n";
+    for (const auto &row: rows)
+    {
+        snprintf(line, sizeof(line), "%-28s %8d %12.3f %12.3f %12.3f",
+                 row.first.c_str(), row.second.calls, row.second.wall/1e3, row.second.self/1e3,
+                 row.second.cpu/1e3);
+        out << line;
+        if (withHeap)
+        {
+            snprintf(line, sizeof(line), " %12.1f", row.second.heap/1024.);
+            out << line;
+        }
+        out << "\n";
+    }
+}
+
+} // anonymous namespace
+
+void femm::profiler::enable(bool enable)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    openEvents.clear();
+    traceEvents.clear();
+    droppedTraceEvents = 0;
+    summaries.clear();
+    owner = std::this_thread::get_id();
+    origin = std::chrono::steady_clock::now();
+    isEnabled = enable;
+}
+
+bool femm::profiler::enabled()
+{
+    return isEnabled;
+}
+
+int femm::profiler::begin(const std::string &name, const char *category, int depth)
+{
+    if (!isRecording())
+        return -1;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.depth = depth;
+    event.startHeap = (depth < 0) ? heapInUse() : 0;
+    event.startCpu = std::clock();
+    event.start = now();
+    openEvents.push_back(std::move(event));
+    return static_cast<int>(openEvents.size()) - 1;
+}
+
+void femm::profiler::end(int id)
+{
+    if (!isRecording() || id < 0)
+        return;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    while ((int)openEvents.size() > id)
+        closeInnermost();
+}
+
+void femm::profiler::endLuaCall(int depth)
+{
+    if (!isRecording())
+        return;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    for (int i=(int)openEvents.size()-1; i>=0; i--)
+    {
+        if (openEvents[i].depth == depth)
+        {
+            while ((int)openEvents.size() > i)
+                closeInnermost();
+            return;
+        }
+        // don't close an outer Lua call
+        if (openEvents[i].depth >= 0 && openEvents[i].depth < depth)
+            return;
+    }
+}
+
+void femm::profiler::dropStaleLuaCalls(int depth)
+{
+    if (!isRecording())
+        return;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    for (int i=0; i<(int)openEvents.size(); i++)
+    {
+        if (openEvents[i].depth >= depth)
+        {
+            while ((int)openEvents.size() > i)
+                closeInnermost();
+            return;
+        }
+    }
+}
+
+void femm::profiler::writeSummary(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    writeSummaryTable(out, "lua", "lua command", false);
+    writeSummaryTable(out, "phase", "phase", true);
+#ifndef FEMM_HAVE_MALLINFO2
+    out << "(heap usage is not available on this system)\n";
+#endif
+}
+
+bool femm::profiler::writeChromeTrace(const std::string &file)
+{
+    std::ofstream out(file.c_str());
+    if (!out.is_open())
+        return false;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    out << "{\"traceEvents\":[\n";
+    char buf[128];
+    for (std::size_t i=0; i<traceEvents.size(); i++)
+    {
+        const TraceEvent &event = traceEvents[i];
+        snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1", event.start, event.wall);
+        out << "{\"name\":" << jsonString(event.name) << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\"" << buf;
+        snprintf(buf, sizeof(buf), ",\"args\":{\"cpu_us\":%.3f", event.cpu);
+        out << buf;
+        if (event.hasHeap)
+        {
+            snprintf(buf, sizeof(buf), ",\"heap_bytes\":%lld", event.heap);
+            out << buf;
+        }
+        out << "}}" << ((i+1 < traceEvents.size()) ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << droppedTraceEvents << "}}\n";
+    return static_cast<bool>(out);
+}
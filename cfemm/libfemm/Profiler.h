@@ -0,0 +1,116 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_PROFILER_H
+#define FEMM_PROFILER_H
+
+#include <ostream>
+#include <string>
+
+/**
+ * \file Profiler.h
+ * Timing of the Lua commands and of the phases of an analysis (not present in femm42; xfemm extension).
+ *
+ * When profiling is enabled, LuaInstance records every call of a C function (i.e. of a registered command),
+ * and the mesher and solvers record their phases with ProfileScope:
+ * "save", "mesh", "load", "renumber", "assemble", "solve" and "write".
+ * For each event, the wall time and the CPU time of the process are recorded;
+ * for the phases, the growth of the heap is recorded, too.
+ * (Measuring the heap takes a lock on every malloc arena, which would distort the timings of cheap commands.)
+ * The results can be printed as summary table, or written as Chrome trace file
+ * (JSON, see chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Only the thread that enabled profiling is recorded.
+ */
+namespace femm {
+namespace profiler {
+
+/**
+ * @brief Enable or disable profiling; enabling it drops all recorded events.
+ * @param enable
+ */
+void enable(bool enable);
+
+/**
+ * @brief Check whether profiling is enabled.
+ */
+bool enabled();
+
+/**
+ * @brief Start an event.
+ * @param name the name of the event, e.g. the Lua command
+ * @param category the kind of event, e.g. "lua" or "phase"
+ * @param depth the Lua call depth of a Lua command, or -1 for other events
+ * @return an id for end()
+ */
+int begin(const std::string &name, const char *category, int depth=-1);
+
+/**
+ * @brief End an event, and all events started after it that have not been ended.
+ * @param id the return value of begin()
+ */
+void end(int id);
+
+/**
+ * @brief End the most recent Lua command event with the given Lua call depth.
+ * Events that are left open because a Lua error skipped their end are closed, too.
+ * @param depth the Lua call depth
+ */
+void endLuaCall(int depth);
+
+/**
+ * @brief Close the events that are left open because a Lua error skipped their end.
+ * @param depth the Lua call depth of a new call; open Lua command events at this depth or deeper are stale
+ */
+void dropStaleLuaCalls(int depth);
+
+/**
+ * @brief Print the summary table of the recorded events.
+ * For each name, it lists the number of calls, the total and self wall time
+ * (without nested events), the CPU time and, for the phases, the heap growth.
+ * @param out
+ */
+void writeSummary(std::ostream &out);
+
+/**
+ * @brief Write the recorded events in the Chrome trace event format.
+ * @param file the file name
+ * @return \c true on success
+ */
+bool writeChromeTrace(const std::string &file);
+
+} // namespace profiler
+
+/**
+ * @brief Record an event for the lifetime of this object, if profiling is enabled.
+ */
+class ProfileScope
+{
+public:
+    /**
+     * @brief Start an event in the "phase" category.
+     * @param name the phase name
+     */
+    explicit ProfileScope(const char *name)
+        : id(profiler::enabled() ? profiler::begin(name, "phase") : -1)
+    {}
+    ~ProfileScope()
+    {
+        if (id >= 0)
+            profiler::end(id);
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+private:
+    int id;
+};
+
+} // namespace femm
+
+#endif
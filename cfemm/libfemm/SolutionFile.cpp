@@ -0,0 +1,1460 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "SolutionFile.h"
+#include "MemoryFiles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <thread>
+
+#ifdef XFEMM_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// tables with fewer records per thread are decoded without starting threads
+#define MinLinesPerThread 20000
+
+namespace {
+
+bool isBlank(char c)
+{
+    return c==' ' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+bool isDelimiter(char c)
+{
+    return c=='\0' || c=='\n' || isBlank(c);
+}
+
+bool isDigit(char c)
+{
+    return c>='0' && c<='9';
+}
+
+#if LDBL_MANT_DIG == 64
+#define MaxFastExponent 27
+// 10^27 = 2^27*5^27 with 5^27 < 2^64, so all of these are exact
+const long double powersOfTen[MaxFastExponent+1] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+#else
+#define MaxFastExponent 22
+// 10^22 = 2^22*5^22 with 5^22 < 2^53, so all of these are exact
+const double powersOfTen[MaxFastExponent+1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22
+};
+#endif
+
+/**
+ * @brief Convert a plain decimal number without calling strtod().
+ * Only numbers with up to 19 significant digits and a small exponent are handled,
+ * and only if the result is guaranteed to be the correctly rounded value.
+ * @return \c false, if the number has to be converted by strtod().
+ */
+bool fastParseDouble(const char *s, const char *&end, double &val)
+{
+    const char *c = s;
+    bool negative = false;
+    if (*c=='+' || *c=='-')
+    {
+        negative = (*c=='-');
+        c++;
+    }
+
+    std::uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; isDigit(*c); c++)
+    {
+        hasDigits = true;
+        if (mantissa==0 && *c=='0')
+            continue;
+        if (++significantDigits > 19)
+            return false;
+        mantissa = 10*mantissa + (*c-'0');
+    }
+    if (*c=='.')
+    {
+        for (c++; isDigit(*c); c++)
+        {
+            hasDigits = true;
+            exponent--;
+            if (mantissa==0 && *c=='0')
+                continue;
+            if (++significantDigits > 19)
+                return false;
+            mantissa = 10*mantissa + (*c-'0');
+        }
+    }
+    if (!hasDigits)
+        return false;
+    if (*c=='e' || *c=='E')
+    {
+        c++;
+        bool negativeExponent = false;
+        if (*c=='+' || *c=='-')
+        {
+            negativeExponent = (*c=='-');
+            c++;
+        }
+        if (!isDigit(*c))
+            return false;
+        int e = 0;
+        for (; isDigit(*c); c++)
+        {
+            if (e < 10000)
+                e = 10*e + (*c-'0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    if (!isDelimiter(*c))
+        return false;
+
+    if (mantissa == 0)
+    {
+        val = negative ? -0.0 : 0.0;
+        end = c;
+        return true;
+    }
+    if (exponent < -MaxFastExponent || exponent > MaxFastExponent)
+        return false;
+
+#if LDBL_MANT_DIG == 64
+    // mantissa and power of ten are exact, so r is the exact value correctly rounded to 64 bits.
+    // Rounding r to double gives the correctly rounded value,
+    // unless r is (close to) the midpoint between two doubles.
+    long double r = mantissa;
+    if (exponent < 0)
+        r /= powersOfTen[-exponent];
+    else
+        r *= powersOfTen[exponent];
+    int e;
+    const std::uint64_t bits = (std::uint64_t)std::ldexp(std::frexp(r,&e), 64);
+    const unsigned int roundingBits = bits & 0x7ff;
+    if (roundingBits >= 0x3ff && roundingBits <= 0x401)
+        return false;
+    val = (double)r;
+#elif defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    // Clinger's fast path: a single operation on two exact doubles is correctly rounded
+    if (mantissa > (std::uint64_t(1) << 53))
+        return false;
+    val = (double)mantissa;
+    if (exponent < 0)
+        val /= powersOfTen[-exponent];
+    else
+        val *= powersOfTen[exponent];
+#else
+    return false;
+#endif
+    if (negative)
+        val = -val;
+    end = c;
+    return true;
+}
+
+
+// binary file header: magic bytes, byte order mark, version
+const char BinaryMagic[8] = {'\211','x','f','s','\r','\n','\032','\n'};
+const std::uint32_t ByteOrderMark = 0x01020304;
+const std::uint32_t BinaryVersion = 1;
+const std::uint32_t CompressedVersion = 2;
+const std::size_t HeaderSize = 16;
+
+// chunk types
+const std::uint32_t TableChunk = 1;
+const std::uint32_t TextChunk = 2;
+const std::uint32_t CompressedTableChunk = 3;
+const std::size_t ChunkHeaderSize = 16;
+
+// column codecs of compressed tables
+const std::uint32_t RawCodec = 0;
+const std::uint32_t DeltaCodec = 1;
+const std::uint32_t ShuffleDeflateCodec = 2;
+const std::uint32_t DeltaDeflateCodec = 3;
+const std::size_t ColumnEntrySize = 16;
+
+std::uint32_t swap32(std::uint32_t v)
+{
+    return (v>>24) | ((v>>8)&0xff00) | ((v<<8)&0xff0000) | (v<<24);
+}
+
+std::uint64_t swap64(std::uint64_t v)
+{
+    return ((std::uint64_t)swap32((std::uint32_t)v) << 32) | swap32((std::uint32_t)(v>>32));
+}
+
+std::size_t padded(std::size_t n)
+{
+    return (n+7) & ~(std::size_t)7;
+}
+
+std::size_t columnBytes(char type, std::size_t rows)
+{
+    return rows * (type=='d' ? sizeof(double) : sizeof(std::int32_t));
+}
+
+/**
+ * @brief Check the 16 header bytes of a binary file.
+ * @return -1 if the file is no binary solution file, 0 if the binary version is not supported, 1 on success
+ */
+int checkHeader(const char *header, std::size_t n, femm::SolutionFormat &format)
+{
+    if (n < HeaderSize || std::memcmp(header, BinaryMagic, sizeof(BinaryMagic)) != 0)
+        return -1;
+    std::uint32_t bom, version;
+    std::memcpy(&bom, header+8, 4);
+    std::memcpy(&version, header+12, 4);
+    if (bom == swap32(ByteOrderMark))
+    {
+        format.swapBytes = true;
+        version = swap32(version);
+    } else if (bom != ByteOrderMark)
+        return 0;
+    if (version != BinaryVersion && version != CompressedVersion)
+        return 0;
+    format.binary = true;
+    return 1;
+}
+
+// number of zero bytes following the "[Solution]" line at file offset pos
+std::size_t paddingAt(long pos)
+{
+    return padded(pos) - pos;
+}
+
+/**
+ * @brief Run fn(i) for i=0..n-1, using one thread per column for large tables.
+ */
+void forEachColumn(std::size_t n, std::size_t rows, const std::function<void(std::size_t)> &fn)
+{
+    if (n < 2 || rows < MinLinesPerThread || std::thread::hardware_concurrency() < 2)
+    {
+        for (std::size_t i=0; i<n; i++)
+            fn(i);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (std::size_t i=0; i<n; i++)
+        threads.emplace_back(fn, i);
+    for (auto &thread: threads)
+        thread.join();
+}
+
+/**
+ * @brief Encode the differences of consecutive values as zigzag varints (7 bits per byte, low bits first).
+ */
+void deltaEncode(const std::int32_t *values, std::size_t n, std::vector<char> &out)
+{
+    out.clear();
+    out.reserve(n+n/2);
+    std::uint32_t prev = 0;
+    for (std::size_t i=0; i<n; i++)
+    {
+        const std::uint32_t d = (std::uint32_t)values[i] - prev;
+        prev = (std::uint32_t)values[i];
+        std::uint32_t z = (d << 1) ^ (0u - (d >> 31));
+        while (z >= 0x80)
+        {
+            out.push_back((char)(z | 0x80));
+            z >>= 7;
+        }
+        out.push_back((char)z);
+    }
+}
+
+/**
+ * @brief Decode n values encoded by deltaEncode().
+ * @return \c false, if the data does not hold exactly n values
+ */
+bool deltaDecode(const char *data, std::size_t size, std::size_t n, std::int32_t *values)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char *end = p + size;
+    std::uint32_t prev = 0;
+    for (std::size_t i=0; i<n; i++)
+    {
+        std::uint32_t z = 0;
+        for (int shift=0; ; shift+=7)
+        {
+            if (p == end || shift > 28)
+                return false;
+            const unsigned char c = *p++;
+            z |= (std::uint32_t)(c & 0x7f) << shift;
+            if (c < 0x80)
+                break;
+        }
+        prev += (z >> 1) ^ (0u - (z & 1));
+        values[i] = (std::int32_t)prev;
+    }
+    return p == end;
+}
+
+/**
+ * @brief Group the bytes of n values of the given width: all first bytes, all second bytes, and so on.
+ */
+void shuffleBytes(const char *in, std::size_t n, std::size_t width, char *out)
+{
+    for (std::size_t i=0; i<n; i++)
+        for (std::size_t b=0; b<width; b++)
+            out[b*n+i] = in[i*width+b];
+}
+
+void unshuffleBytes(const char *in, std::size_t n, std::size_t width, char *out)
+{
+    for (std::size_t b=0; b<width; b++)
+        for (std::size_t i=0; i<n; i++)
+            out[i*width+b] = in[b*n+i];
+}
+
+/**
+ * @brief Deflate \p in; the result starts with the uint64 size of \p in.
+ * @return \c false, if zlib is not available or the compression failed
+ */
+bool deflateColumn(const char *in, std::size_t size, std::vector<char> &out)
+{
+#ifdef XFEMM_WITH_ZLIB
+    uLongf outSize = compressBound((uLong)size);
+    if ((std::size_t)(uLong)size != size)
+        return false;
+    out.resize(sizeof(std::uint64_t) + outSize);
+    const std::uint64_t rawSize = size;
+    std::memcpy(out.data(), &rawSize, sizeof(rawSize));
+    if (compress2(reinterpret_cast<Bytef*>(out.data()+sizeof(rawSize)), &outSize,
+                  reinterpret_cast<const Bytef*>(in), (uLong)size, Z_BEST_SPEED) != Z_OK)
+        return false;
+    out.resize(sizeof(rawSize) + outSize);
+    return true;
+#else
+    (void)in;
+    (void)size;
+    (void)out;
+    return false;
+#endif
+}
+
+/**
+ * @brief Inflate data written by deflateColumn().
+ * The size stored in the data is checked against the bounds before anything is allocated.
+ * @param minSize the minimum size of the inflated data
+ * @param maxSize the maximum size of the inflated data
+ * @return \c false, if zlib is not available or the data is corrupt
+ */
+bool inflateColumn(const char *in, std::size_t size, bool swapBytes, std::size_t minSize, std::size_t maxSize, std::vector<char> &out)
+{
+#ifdef XFEMM_WITH_ZLIB
+    std::uint64_t rawSize;
+    if (size < sizeof(rawSize))
+        return false;
+    std::memcpy(&rawSize, in, sizeof(rawSize));
+    if (swapBytes)
+        rawSize = swap64(rawSize);
+    if (rawSize < minSize || rawSize > maxSize)
+        return false;
+    uLongf outSize = (uLongf)rawSize;
+    if (outSize != rawSize || size-sizeof(rawSize) != (uLong)(size-sizeof(rawSize)))
+        return false;
+    out.resize(rawSize);
+    return uncompress(reinterpret_cast<Bytef*>(out.data()), &outSize,
+                      reinterpret_cast<const Bytef*>(in+sizeof(rawSize)), (uLong)(size-sizeof(rawSize))) == Z_OK
+            && outSize == rawSize;
+#else
+    (void)in;
+    (void)size;
+    (void)swapBytes;
+    (void)minSize;
+    (void)maxSize;
+    (void)out;
+    return false;
+#endif
+}
+
+/**
+ * @brief Encode a column of a compressed table with the codec that gives the smallest result.
+ * @param type the column type
+ * @param values the column values
+ * @param rows the number of values
+ * @param out receives the encoded column
+ * @return the codec
+ */
+std::uint32_t encodeColumn(char type, const char *values, std::size_t rows, std::vector<char> &out)
+{
+    const std::size_t rawSize = columnBytes(type, rows);
+    std::vector<char> encoded;
+    std::uint32_t codec = RawCodec;
+    if (type == 'i')
+    {
+        deltaEncode(reinterpret_cast<const std::int32_t*>(values), rows, encoded);
+        std::vector<char> deflated;
+        if (deflateColumn(encoded.data(), encoded.size(), deflated) && deflated.size() < encoded.size())
+        {
+            encoded.swap(deflated);
+            codec = DeltaDeflateCodec;
+        } else {
+            codec = DeltaCodec;
+        }
+    } else {
+        std::vector<char> shuffled(rawSize);
+        shuffleBytes(values, rows, sizeof(double), shuffled.data());
+        if (deflateColumn(shuffled.data(), rawSize, encoded))
+            codec = ShuffleDeflateCodec;
+    }
+    if (codec == RawCodec || encoded.size() >= rawSize)
+    {
+        out.assign(values, values+rawSize);
+        return RawCodec;
+    }
+    out.swap(encoded);
+    return codec;
+}
+
+/**
+ * @brief Decode a column of a compressed table into \p out, in native byte order.
+ * @return \c false, if the column is malformed or the codec is not available
+ */
+bool decodeColumn(std::uint32_t codec, char type, const char *data, std::size_t size, std::size_t rows, bool swapBytes, std::vector<char> &out)
+{
+    const std::size_t width = (type=='d') ? sizeof(double) : sizeof(std::int32_t);
+    const std::size_t rawSize = columnBytes(type, rows);
+    std::vector<char> inflated;
+    switch (codec)
+    {
+    case RawCodec:
+        if (size != rawSize)
+            return false;
+        out.assign(data, data+size);
+        break;
+    case DeltaDeflateCodec:
+        // each value takes 1 to 5 varint bytes
+        if (!inflateColumn(data, size, swapBytes, rows, 5*rows, inflated))
+            return false;
+        data = inflated.data();
+        size = inflated.size();
+        // fall through
+    case DeltaCodec:
+        if (type != 'i' || size < rows || size > 5*rows)
+            return false;
+        out.resize(rawSize);
+        // varints do not depend on the byte order
+        return deltaDecode(data, size, rows, reinterpret_cast<std::int32_t*>(out.data()));
+    case ShuffleDeflateCodec:
+        if (type != 'd' || !inflateColumn(data, size, swapBytes, rawSize, rawSize, inflated))
+            return false;
+        out.resize(rawSize);
+        unshuffleBytes(inflated.data(), rows, width, out.data());
+        break;
+    default:
+        return false;
+    }
+    if (swapBytes)
+    {
+        for (std::size_t i=0; i<rows; i++)
+        {
+            char *v = out.data() + i*width;
+            std::reverse(v, v+width);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Determine the column types of a text table: 'i' if all values of the column are plain int literals, 'd' otherwise.
+ * @return \c false, if the records have different numbers of values
+ */
+bool inferColumnTypes(const femm::SolutionTable &table, std::string &types)
+{
+    types.clear();
+    for (int i=0; i<table.size(); i++)
+    {
+        const char *p = table.line(i);
+        std::size_t col = 0;
+        for (;;)
+        {
+            while (isBlank(*p))
+                p++;
+            const char *number = p;
+            double val;
+            if (!femm::parseNumber(p, val))
+                break;
+            const char *digits = number;
+            if (*digits=='+' || *digits=='-')
+                digits++;
+            const std::size_t numDigits = p-digits;
+            bool isInt = numDigits>0 && numDigits<=10
+                    && !(digits[0]=='0' && numDigits>1)
+                    && !(*number=='-' && val==0)
+                    && val >= INT32_MIN && val <= INT32_MAX;
+            for (std::size_t k=0; isInt && k<numDigits; k++)
+                isInt = isDigit(digits[k]);
+            if (i == 0)
+                types += isInt ? 'i' : 'd';
+            else if (col >= types.size())
+                return false;
+            else if (!isInt)
+                types[col] = 'd';
+            col++;
+        }
+        if (col != types.size())
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool femm::haveSolutionDeflate()
+{
+#ifdef XFEMM_WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+FILE *femm::openSolutionFile(const std::string &file, femm::SolutionFormat &format)
+{
+    format = SolutionFormat();
+    FILE *fp = openFile(file, "rb");
+    if (fp == nullptr)
+        return nullptr;
+    char header[HeaderSize];
+    const std::size_t n = fread(header, 1, HeaderSize, fp);
+    switch (checkHeader(header, n, format))
+    {
+    case 1:
+        return fp;
+    case 0:
+        fclose(fp);
+        return nullptr;
+    default:
+        fclose(fp);
+        return openFile(file, "rt");
+    }
+}
+
+std::unique_ptr<std::istream> femm::openSolutionStream(const std::string &file, femm::SolutionFormat &format)
+{
+    format = SolutionFormat();
+    std::unique_ptr<std::istream> input = openInputFile(file, std::ios_base::binary);
+    if (!input)
+        return input;
+    char header[HeaderSize];
+    input->read(header, HeaderSize);
+    switch (checkHeader(header, input->gcount(), format))
+    {
+    case 1:
+        return input;
+    case 0:
+        return std::unique_ptr<std::istream>();
+    default:
+        input.reset();
+        return openInputFile(file);
+    }
+}
+
+femm::SolutionTable::Record::Record(const femm::SolutionTable &table, int row)
+    : table(table)
+    , line(table.binary ? nullptr : table.lines[row])
+    , row(row)
+    , column(0)
+{
+}
+
+bool femm::SolutionTable::Record::next(double &val)
+{
+    if (!table.binary)
+        return parseNumber(line, val);
+    if (column >= (int)table.types.size())
+        return false;
+    const char *values = table.columnData[column];
+    if (table.types[column++] == 'd')
+    {
+        std::memcpy(&val, values + sizeof(double)*row, sizeof(double));
+    } else {
+        std::int32_t v;
+        std::memcpy(&v, values + sizeof(std::int32_t)*row, sizeof(std::int32_t));
+        val = v;
+    }
+    return true;
+}
+
+bool femm::SolutionTable::Record::next(int &val)
+{
+    if (!table.binary)
+        return parseNumber(line, val);
+    if (column >= (int)table.types.size())
+        return false;
+    const char *values = table.columnData[column];
+    if (table.types[column++] == 'd')
+    {
+        double v;
+        std::memcpy(&v, values + sizeof(double)*row, sizeof(double));
+        val = (int)v;
+    } else {
+        std::int32_t v;
+        std::memcpy(&v, values + sizeof(std::int32_t)*row, sizeof(std::int32_t));
+        val = v;
+    }
+    return true;
+}
+
+femm::SolutionTable::SolutionTable()
+    : binary(false)
+    , rows(0)
+{
+}
+
+int femm::SolutionTable::size() const
+{
+    return binary ? rows : (int)lines.size();
+}
+
+femm::SolutionTable::Record femm::SolutionTable::record(int i) const
+{
+    return Record(*this, i);
+}
+
+int femm::SolutionTable::columns() const
+{
+    return binary ? (int)types.size() : -1;
+}
+
+const std::string &femm::SolutionTable::columnTypes() const
+{
+    return types;
+}
+
+const char *femm::SolutionTable::line(int i) const
+{
+    return binary ? nullptr : lines[i];
+}
+
+femm::SolutionBuffer::SolutionBuffer()
+    : binary(false)
+    , swapBytes(false)
+    , data(1,'\0')
+    , mapping(nullptr)
+    , mappingSize(0)
+    , base(data.data())
+    , size(0)
+    , chunks()
+    , chunk(0)
+    , pos(0)
+    , decoded()
+{
+}
+
+femm::SolutionBuffer::~SolutionBuffer()
+{
+    clear();
+}
+
+void femm::SolutionBuffer::clear()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    data.clear();
+    chunks.clear();
+    chunk = 0;
+    pos = 0;
+    decoded.clear();
+}
+
+bool femm::SolutionBuffer::mapFile(int fd, std::size_t offset)
+{
+#ifndef _WIN32
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= (off_t)offset)
+        return false;
+    void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
+        return false;
+    // the whole solution section is decoded right away
+    posix_madvise(m, st.st_size, POSIX_MADV_WILLNEED);
+    mapping = m;
+    mappingSize = st.st_size;
+    base = static_cast<const char*>(mapping) + offset;
+    size = mappingSize - offset;
+    return true;
+#else
+    (void)fd;
+    (void)offset;
+    return false;
+#endif
+}
+
+bool femm::SolutionBuffer::readFrom(FILE *fp, const femm::SolutionFormat &format)
+{
+    clear();
+    if (format.binary)
+    {
+        // skip the padding after the "[Solution]" line
+        const long offset = ftell(fp);
+        if (offset < 0)
+            return false;
+#ifndef _WIN32
+        if (!format.swapBytes && mapFile(fileno(fp), offset+paddingAt(offset)))
+            return parseChunks(format);
+#endif
+        for (std::size_t i=paddingAt(offset); i>0; i--)
+            fgetc(fp);
+    }
+    char block[65536];
+    std::size_t n;
+    while ((n = fread(block, 1, sizeof(block), fp)) > 0)
+        data.insert(data.end(), block, block+n);
+    data.push_back('\0');
+    base = data.data();
+    size = data.size()-1;
+    if (ferror(fp))
+        return false;
+    return parseChunks(format);
+}
+
+bool femm::SolutionBuffer::readFrom(std::istream &input, const femm::SolutionFormat &format, const std::string &file)
+{
+    clear();
+    if (format.binary)
+    {
+        // skip the padding after the "[Solution]" line
+        const std::streamoff offset = input.tellg();
+        if (offset < 0)
+            return false;
+#ifndef _WIN32
+        if (!format.swapBytes && !file.empty() && !isMemoryFile(file))
+        {
+            const int fd = open(file.c_str(), O_RDONLY);
+            const bool mapped = mapFile(fd, offset+paddingAt(offset));
+            if (fd >= 0)
+                close(fd);
+            if (mapped)
+                return parseChunks(format);
+        }
+#else
+        (void)file;
+#endif
+        input.ignore(paddingAt(offset));
+    }
+    char block[65536];
+    do {
+        input.read(block, sizeof(block));
+        data.insert(data.end(), block, block+input.gcount());
+    } while (input.gcount() > 0);
+    data.push_back('\0');
+    base = data.data();
+    size = data.size()-1;
+    if (input.bad())
+        return false;
+    return parseChunks(format);
+}
+
+bool femm::SolutionBuffer::parseChunks(const femm::SolutionFormat &format)
+{
+    binary = format.binary;
+    swapBytes = format.swapBytes;
+    if (!format.binary)
+    {
+        chunks.push_back(Chunk{false, false, 0, size, std::string()});
+        return true;
+    }
+
+    std::size_t offset = 0;
+    while (offset < size)
+    {
+        if (size-offset < ChunkHeaderSize)
+            return false;
+        std::uint32_t type, columns;
+        std::uint64_t length;
+        std::memcpy(&type, base+offset, 4);
+        std::memcpy(&columns, base+offset+4, 4);
+        std::memcpy(&length, base+offset+8, 8);
+        if (format.swapBytes)
+        {
+            type = swap32(type);
+            columns = swap32(columns);
+            length = swap64(length);
+        }
+        offset += ChunkHeaderSize;
+
+        if (type == TextChunk)
+        {
+            if (length > size-offset)
+                return false;
+            chunks.push_back(Chunk{false, false, offset, (std::size_t)length, std::string()});
+            offset += padded(length);
+        } else if (type == TableChunk) {
+            if (columns > size-offset || length > INT_MAX)
+                return false;
+            Chunk table{true, false, 0, (std::size_t)length, std::string(base+offset, columns)};
+            for (char c: table.types)
+                if (c!='i' && c!='d')
+                    return false;
+            offset += padded(columns);
+            table.offset = offset;
+            for (char c: table.types)
+            {
+                const std::size_t bytes = columnBytes(c, table.size);
+                if (offset > size || bytes > size-offset)
+                    return false;
+                if (format.swapBytes)
+                {
+                    // byte swapped files are never mapped
+                    char *values = &data[offset];
+                    for (std::size_t i=0; i<table.size; i++)
+                    {
+                        if (c == 'd')
+                        {
+                            std::uint64_t v;
+                            std::memcpy(&v, values+8*i, 8);
+                            v = swap64(v);
+                            std::memcpy(values+8*i, &v, 8);
+                        } else {
+                            std::uint32_t v;
+                            std::memcpy(&v, values+4*i, 4);
+                            v = swap32(v);
+                            std::memcpy(values+4*i, &v, 4);
+                        }
+                    }
+                }
+                offset += padded(bytes);
+            }
+            chunks.push_back(table);
+        } else if (type == CompressedTableChunk) {
+            if (columns > size-offset || length > INT_MAX)
+                return false;
+            if (!parseCompressedTable(offset, columns, (std::size_t)length))
+                return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool femm::SolutionBuffer::parseCompressedTable(std::size_t &offset, std::size_t columns, std::size_t rows)
+{
+    // only the structure is checked here, the columns are decoded by nextTable()
+    Chunk table{true, true, 0, rows, std::string(base+offset, columns)};
+    for (char c: table.types)
+        if (c!='i' && c!='d')
+            return false;
+    offset += padded(columns);
+    if (offset > size || columns*ColumnEntrySize > size-offset)
+        return false;
+    table.offset = offset;
+    const char *directory = base+offset;
+    offset += columns*ColumnEntrySize;
+    for (std::size_t i=0; i<columns; i++)
+    {
+        std::uint64_t bytes;
+        std::memcpy(&bytes, directory + i*ColumnEntrySize + 8, 8);
+        if (swapBytes)
+            bytes = swap64(bytes);
+        if (offset > size || bytes > size-offset)
+            return false;
+        offset += padded(bytes);
+    }
+    chunks.push_back(table);
+    return true;
+}
+
+bool femm::SolutionBuffer::decompressTable(const femm::SolutionBuffer::Chunk &c, femm::SolutionTable &table)
+{
+    const std::size_t columns = c.types.size();
+    const char *directory = base + c.offset;
+    std::vector<std::uint32_t> codecs(columns);
+    std::vector<const char*> data(columns);
+    std::vector<std::size_t> bytes(columns);
+    const char *values = directory + columns*ColumnEntrySize;
+    for (std::size_t i=0; i<columns; i++)
+    {
+        std::uint64_t n;
+        std::memcpy(&codecs[i], directory + i*ColumnEntrySize, 4);
+        std::memcpy(&n, directory + i*ColumnEntrySize + 8, 8);
+        if (swapBytes)
+        {
+            codecs[i] = swap32(codecs[i]);
+            n = swap64(n);
+        }
+        data[i] = values;
+        bytes[i] = (std::size_t)n;
+        values += padded(bytes[i]);
+    }
+
+    const std::size_t first = decoded.size();
+    decoded.resize(first+columns);
+    std::vector<char> ok(columns, 0);
+    forEachColumn(columns, c.size, [&](std::size_t i) {
+        if (codecs[i] == RawCodec && !swapBytes)
+        {
+            // use the values in place
+            ok[i] = (bytes[i] == columnBytes(c.types[i], c.size));
+            return;
+        }
+        ok[i] = decodeColumn(codecs[i], c.types[i], data[i], bytes[i], c.size, swapBytes, decoded[first+i]);
+    });
+    for (std::size_t i=0; i<columns; i++)
+    {
+        if (!ok[i])
+            return false;
+        table.columnData.push_back(decoded[first+i].empty() ? data[i] : decoded[first+i].data());
+    }
+    return true;
+}
+
+void femm::SolutionBuffer::skipConsumedText()
+{
+    while (chunk < chunks.size() && !chunks[chunk].isTable && pos >= chunks[chunk].size)
+    {
+        chunk++;
+        pos = 0;
+    }
+}
+
+char *femm::SolutionBuffer::getLine(char *s, int n)
+{
+    skipConsumedText();
+    if (n <= 0 || chunk >= chunks.size() || chunks[chunk].isTable)
+        return nullptr;
+    const char *text = base + chunks[chunk].offset;
+    const std::size_t size = chunks[chunk].size;
+    int k = 0;
+    while (k < n-1 && pos < size)
+    {
+        const char c = text[pos++];
+        s[k++] = c;
+        if (c == '\n')
+            break;
+    }
+    s[k] = '\0';
+    return s;
+}
+
+bool femm::SolutionBuffer::nextTable(femm::SolutionTable &table)
+{
+    skipConsumedText();
+    if (chunk >= chunks.size())
+        return false;
+    table = SolutionTable();
+
+    const Chunk &c = chunks[chunk];
+    if (binary && !c.isTable)
+        return false;
+    if (c.isTable && c.compressed)
+    {
+        table.binary = true;
+        table.rows = (int)c.size;
+        table.types = c.types;
+        if (!decompressTable(c, table))
+            return false;
+        chunk++;
+        pos = 0;
+        return true;
+    }
+    if (c.isTable)
+    {
+        table.binary = true;
+        table.rows = (int)c.size;
+        table.types = c.types;
+        const char *values = base + c.offset;
+        for (char type: c.types)
+        {
+            table.columnData.push_back(values);
+            values += padded(columnBytes(type, c.size));
+        }
+        chunk++;
+        pos = 0;
+        return true;
+    }
+
+    char s[1024];
+    int k = 0;
+    if (getLine(s, sizeof(s)) == nullptr || sscanf(s, "%i", &k) != 1)
+        return false;
+    return nextLines(k, table.lines);
+}
+
+bool femm::SolutionBuffer::nextLines(int numLines, std::vector<const char *> &lines)
+{
+    lines.clear();
+    lines.reserve(std::max(numLines,0));
+    if (chunk >= chunks.size() || chunks[chunk].isTable)
+        return numLines <= 0;
+    const char *text = base + chunks[chunk].offset;
+    const std::size_t size = chunks[chunk].size;
+    for (int i=0; i<numLines; i++)
+    {
+        if (pos >= size)
+            return false;
+        lines.push_back(text+pos);
+        const void *newline = std::memchr(text+pos, '\n', size-pos);
+        pos = newline ? static_cast<const char*>(newline) - text + 1 : size;
+    }
+    return true;
+}
+
+bool femm::SolutionBuffer::atEnd() const
+{
+    for (std::size_t i=chunk; i<chunks.size(); i++)
+    {
+        if (chunks[i].isTable || pos < chunks[i].size)
+            return false;
+    }
+    return true;
+}
+
+int femm::decodeRecords(const femm::SolutionTable &table, const std::function<bool (int, femm::SolutionTable::Record &)> &decode, int numThreads)
+{
+    const int numRecords = table.size();
+    if (numThreads <= 0)
+        numThreads = std::thread::hardware_concurrency();
+    numThreads = std::max(1, std::min(numThreads, numRecords/MinLinesPerThread));
+
+    // first malformed record of each block
+    std::vector<int> failed(numThreads, -1);
+    auto decodeBlock = [&table,&decode,&failed](int block, int first, int last) {
+        for (int i=first; i<last; i++)
+        {
+            SolutionTable::Record record = table.record(i);
+            if (!decode(i, record))
+            {
+                failed[block] = i;
+                return;
+            }
+        }
+    };
+
+    if (numThreads == 1)
+    {
+        decodeBlock(0, 0, numRecords);
+    } else {
+        std::vector<std::thread> threads;
+        const int blockSize = (numRecords+numThreads-1)/numThreads;
+        for (int block=0; block<numThreads; block++)
+            threads.emplace_back(decodeBlock, block, block*blockSize, std::min((block+1)*blockSize, numRecords));
+        for (auto &thread: threads)
+            thread.join();
+    }
+
+    for (int i: failed)
+        if (i >= 0)
+            return i;
+    return -1;
+}
+
+femm::SolutionWriter::SolutionWriter(FILE *fp, bool binary, bool compress)
+    : fp(fp)
+    , binary(binary)
+    , compress(binary && compress)
+    , types()
+    , rows(0)
+    , row(0)
+    , column(0)
+    , doubleColumns()
+    , intColumns()
+    , textStart(-1)
+{
+    if (binary)
+    {
+        fwrite(BinaryMagic, 1, sizeof(BinaryMagic), fp);
+        fwrite(&ByteOrderMark, sizeof(ByteOrderMark), 1, fp);
+        fwrite(compress ? &CompressedVersion : &BinaryVersion, sizeof(BinaryVersion), 1, fp);
+    }
+}
+
+void femm::SolutionWriter::beginSolution()
+{
+    if (!binary)
+        return;
+    const long offset = ftell(fp);
+    for (std::size_t i=paddingAt(offset); i>0; i--)
+        fputc(0, fp);
+}
+
+void femm::SolutionWriter::beginTable(int rows, const std::string &columnTypes)
+{
+    types = columnTypes;
+    this->rows = rows;
+    row = 0;
+    column = 0;
+    if (!binary)
+    {
+        fprintf(fp, "%i\n", rows);
+        return;
+    }
+    endText();
+    doubleColumns.assign(types.size(), std::vector<double>());
+    intColumns.assign(types.size(), std::vector<std::int32_t>());
+    for (std::size_t i=0; i<types.size(); i++)
+    {
+        if (types[i] == 'd')
+            doubleColumns[i].reserve(rows);
+        else
+            intColumns[i].reserve(rows);
+    }
+}
+
+void femm::SolutionWriter::add(double val)
+{
+    if (column >= (int)types.size())
+        return;
+    if (binary)
+    {
+        if (types[column] == 'd')
+            doubleColumns[column].push_back(val);
+        else
+            intColumns[column].push_back((std::int32_t)val);
+    } else {
+        if (column > 0)
+            fputc('\t', fp);
+        if (types[column] == 'd')
+            fprintf(fp, "%.17g", val);
+        else
+            fprintf(fp, "%i", (int)val);
+    }
+    column++;
+}
+
+void femm::SolutionWriter::add(int val)
+{
+    if (column >= (int)types.size())
+        return;
+    if (binary)
+    {
+        if (types[column] == 'd')
+            doubleColumns[column].push_back(val);
+        else
+            intColumns[column].push_back(val);
+    } else {
+        if (column > 0)
+            fputc('\t', fp);
+        if (types[column] == 'd')
+            fprintf(fp, "%.17g", (double)val);
+        else
+            fprintf(fp, "%i", val);
+    }
+    column++;
+}
+
+void femm::SolutionWriter::endRecord()
+{
+    if (!binary)
+        fputc('\n', fp);
+    column = 0;
+    row++;
+}
+
+void femm::SolutionWriter::endTable()
+{
+    if (!binary)
+        return;
+    if (compress)
+    {
+        writeCompressedTable();
+        return;
+    }
+    const char zeros[8] = {0};
+    const std::uint32_t header[2] = {TableChunk, (std::uint32_t)types.size()};
+    const std::uint64_t numRows = row;
+    fwrite(header, sizeof(header), 1, fp);
+    fwrite(&numRows, sizeof(numRows), 1, fp);
+    fwrite(types.data(), 1, types.size(), fp);
+    fwrite(zeros, 1, padded(types.size())-types.size(), fp);
+    for (std::size_t i=0; i<types.size(); i++)
+    {
+        std::size_t bytes;
+        if (types[i] == 'd')
+        {
+            doubleColumns[i].resize(row);
+            bytes = fwrite(doubleColumns[i].data(), sizeof(double), row, fp) * sizeof(double);
+        } else {
+            intColumns[i].resize(row);
+            bytes = fwrite(intColumns[i].data(), sizeof(std::int32_t), row, fp) * sizeof(std::int32_t);
+        }
+        fwrite(zeros, 1, padded(bytes)-bytes, fp);
+    }
+    doubleColumns.clear();
+    intColumns.clear();
+}
+
+void femm::SolutionWriter::writeCompressedTable()
+{
+    const std::size_t columns = types.size();
+    std::vector<std::vector<char>> encoded(columns);
+    std::vector<std::uint32_t> codecs(columns);
+    forEachColumn(columns, row, [&](std::size_t i) {
+        const char *values;
+        if (types[i] == 'd')
+        {
+            doubleColumns[i].resize(row);
+            values = reinterpret_cast<const char*>(doubleColumns[i].data());
+        } else {
+            intColumns[i].resize(row);
+            values = reinterpret_cast<const char*>(intColumns[i].data());
+        }
+        codecs[i] = encodeColumn(types[i], values, row, encoded[i]);
+    });
+
+    const char zeros[8] = {0};
+    const std::uint32_t header[2] = {CompressedTableChunk, (std::uint32_t)columns};
+    const std::uint64_t numRows = row;
+    fwrite(header, sizeof(header), 1, fp);
+    fwrite(&numRows, sizeof(numRows), 1, fp);
+    fwrite(types.data(), 1, columns, fp);
+    fwrite(zeros, 1, padded(columns)-columns, fp);
+    for (std::size_t i=0; i<columns; i++)
+    {
+        const std::uint32_t entry[2] = {codecs[i], 0};
+        const std::uint64_t bytes = encoded[i].size();
+        fwrite(entry, sizeof(entry), 1, fp);
+        fwrite(&bytes, sizeof(bytes), 1, fp);
+    }
+    for (std::size_t i=0; i<columns; i++)
+    {
+        const std::size_t bytes = fwrite(encoded[i].data(), 1, encoded[i].size(), fp);
+        fwrite(zeros, 1, padded(bytes)-bytes, fp);
+    }
+    doubleColumns.clear();
+    intColumns.clear();
+}
+
+void femm::SolutionWriter::beginText()
+{
+    if (!binary || textStart >= 0)
+        return;
+    // the length is filled in by endText()
+    textStart = ftell(fp);
+    const std::uint32_t header[2] = {TextChunk, 0};
+    const std::uint64_t length = 0;
+    fwrite(header, sizeof(header), 1, fp);
+    fwrite(&length, sizeof(length), 1, fp);
+}
+
+void femm::SolutionWriter::endText()
+{
+    if (!binary || textStart < 0)
+        return;
+    const long end = ftell(fp);
+    const std::uint64_t length = end - textStart - ChunkHeaderSize;
+    const char zeros[8] = {0};
+    fwrite(zeros, 1, padded(length)-length, fp);
+    fseek(fp, textStart+8, SEEK_SET);
+    fwrite(&length, sizeof(length), 1, fp);
+    fseek(fp, 0, SEEK_END);
+    textStart = -1;
+}
+
+bool femm::SolutionWriter::finish()
+{
+    endText();
+    return !ferror(fp);
+}
+
+namespace {
+
+bool copyTable(const femm::SolutionTable &table, femm::SolutionWriter &writer)
+{
+    std::string types = table.columnTypes();
+    if (table.columns() < 0 && !inferColumnTypes(table, types))
+        return false;
+    writer.beginTable(table.size(), types);
+    for (int i=0; i<table.size(); i++)
+    {
+        femm::SolutionTable::Record r = table.record(i);
+        for (char type: types)
+        {
+            if (type == 'i')
+            {
+                int val = 0;
+                r.next(val);
+                writer.add(val);
+            } else {
+                double val = 0;
+                r.next(val);
+                writer.add(val);
+            }
+        }
+        writer.endRecord();
+    }
+    writer.endTable();
+    return true;
+}
+
+} // anonymous namespace
+
+bool femm::convertSolutionFile(const std::string &inFile, const std::string &outFile, bool binary, bool compress, std::ostream &err)
+{
+    SolutionFormat format;
+    FILE *in = openSolutionFile(inFile, format);
+    if (in == nullptr)
+    {
+        err << "Couldn't read from specified file " << inFile << "\n";
+        return false;
+    }
+
+    // copy the problem description, including the "[Solution]" line
+    std::string description;
+    bool hasSolution = false;
+    char s[1024];
+    bool lineStart = true;
+    while (!hasSolution && fgets(s, sizeof(s), in) != nullptr)
+    {
+        description += s;
+        if (lineStart)
+        {
+            char q[32] = {0};
+            sscanf(s, "%31s", q);
+            for (char *c=q; *c; c++)
+                *c = (char)std::tolower((unsigned char)*c);
+            hasSolution = (std::strncmp(q, "[solution]", 10) == 0);
+        }
+        lineStart = (std::strchr(s, '\n') != nullptr);
+    }
+    SolutionBuffer solution;
+    if (!hasSolution || !solution.readFrom(in, format))
+    {
+        err << "No solution section found in " << inFile << "\n";
+        fclose(in);
+        return false;
+    }
+    fclose(in);
+
+    FILE *out = openFile(outFile, binary ? "wb" : "wt");
+    if (out == nullptr)
+    {
+        err << "Couldn't write to specified file " << outFile << "\n";
+        return false;
+    }
+    SolutionWriter writer(out, binary, compress);
+    fputs(description.c_str(), out);
+    writer.beginSolution();
+
+    // text files: the node and element lists are tables, the rest is copied as text;
+    // binary files: tables and text chunks are copied in their order
+    bool ok = true;
+    SolutionTable table;
+    if (format.binary)
+    {
+        while (ok)
+        {
+            if (solution.nextTable(table))
+            {
+                ok = copyTable(table, writer);
+            } else if (solution.getLine(s, sizeof(s)) != nullptr) {
+                writer.beginText();
+                fputs(s, out);
+            } else {
+                // a table that could not be decoded stops the copy early
+                ok = solution.atEnd();
+                break;
+            }
+        }
+    } else {
+        for (int i=0; ok && i<2; i++)
+            ok = solution.nextTable(table) && copyTable(table, writer);
+        writer.beginText();
+        while (ok && solution.getLine(s, sizeof(s)) != nullptr)
+            fputs(s, out);
+    }
+    if (!ok)
+    {
+        err << "Malformed node or element list in " << inFile << "\n";
+        fclose(out);
+        return false;
+    }
+
+    ok = writer.finish();
+    if (fclose(out) != 0 || !ok)
+    {
+        err << "Couldn't write to specified file " << outFile << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool femm::parseNumber(const char *&p, double &val)
+{
+    const char *s = p;
+    while (isBlank(*s))
+        s++;
+    if (*s=='\0' || *s=='\n')
+        return false;
+    if (fastParseDouble(s, p, val))
+        return true;
+
+    char *end;
+    const double v = std::strtod(s, &end);
+    if (end == s)
+        return false;
+    val = v;
+    p = end;
+    return true;
+}
+
+bool femm::parseNumber(const char *&p, int &val)
+{
+    const char *s = p;
+    while (isBlank(*s))
+        s++;
+    if (*s=='\0' || *s=='\n')
+        return false;
+
+    // plain decimal numbers; leave octal and hexadecimal notation to strtol()
+    const char *c = s;
+    bool negative = false;
+    if (*c=='+' || *c=='-')
+    {
+        negative = (*c=='-');
+        c++;
+    }
+    if (isDigit(*c) && !(c[0]=='0' && (isDigit(c[1]) || c[1]=='x' || c[1]=='X')))
+    {
+        int value = 0;
+        int digits = 0;
+        for (; isDigit(*c) && digits<9; c++, digits++)
+            value = 10*value + (*c-'0');
+        if (isDelimiter(*c))
+        {
+            val = negative ? -value : value;
+            p = c;
+            return true;
+        }
+    }
+
+    char *end;
+    const long v = std::strtol(s, &end, 0);
+    if (end == s)
+        return false;
+    val = (int)v;
+    p = end;
+    return true;
+}
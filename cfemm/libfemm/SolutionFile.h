@@ -0,0 +1,355 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_SOLUTIONFILE_H
+#define FEMM_SOLUTIONFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \file SolutionFile.h
+ * Reading and writing the solution section of solution files (.ans, .anh, .res).
+ *
+ * Solution files are either text files or binary files.
+ * Both start with the problem description (a copy of the input file),
+ * followed by the line "[Solution]" and the solution section,
+ * which consists of the node list, the element list and some shorter, solver specific lists.
+ *
+ * Binary solution files (not present in femm42; xfemm extension) have the following layout:
+ *  - 8 bytes magic: "\211xfs\r\n\032\n"
+ *  - uint32 byte order mark 0x01020304, written in the byte order of the writer
+ *  - uint32 format version (1, or 2 for files with compressed tables)
+ *  - the problem description and the "[Solution]" line, exactly as in a text file
+ *  - zero bytes up to the next file offset that is a multiple of 8
+ *  - a sequence of chunks, each starting with
+ *    uint32 chunk type (1: table, 2: text, 3: compressed table), uint32 number of columns (tables only),
+ *    uint64 number of rows or bytes.
+ *    - A table chunk is followed by one type code per column ('i': int32, 'd': double),
+ *      and the values column by column.
+ *    - A text chunk is followed by the text of the remaining lists, exactly as in a text file.
+ *    - A compressed table chunk is followed by the type codes, a column directory
+ *      (per column: uint32 codec, uint32 zero, uint64 number of bytes), and the encoded columns.
+ *      Codecs: 0 = raw values as in table chunks,
+ *      1 = int differences to the previous row, zigzag and varint encoded,
+ *      2 = doubles, byte shuffled (all first bytes, then all second bytes, ...) and deflated,
+ *      3 = codec 1, deflated.
+ *      Deflated columns start with the uint64 size of the uncompressed data, followed by a zlib stream.
+ *    - Type codes, columns and texts are padded with zero bytes to a multiple of 8 bytes.
+ *
+ * The solvers write the node list and the element list as tables, followed by a single text chunk.
+ * Since all chunk and column sizes are stored, readers can skip over any part of the file;
+ * compressed tables are only decoded when they are taken with SolutionBuffer::nextTable().
+ * The deflate codecs are only available if xfemm was built with zlib (XFEMM_WITH_ZLIB);
+ * without zlib, compressed files use codecs 0 and 1 only, and files using codecs 2 or 3 can not be read.
+ * Readers detect the file format by the magic bytes, so both formats use the same file extension.
+ */
+namespace femm {
+
+/**
+ * @brief Format information of a solution file, as determined by openSolutionFile().
+ */
+struct SolutionFormat
+{
+    bool binary = false;    ///< \c true for binary solution files
+    bool swapBytes = false; ///< \c true if the file was written with a different byte order
+};
+
+/**
+ * @brief Check whether binary solution files can be compressed with the deflate codecs.
+ * @return \c true, if xfemm was built with zlib
+ */
+bool haveSolutionDeflate();
+
+/**
+ * @brief Open a solution file for reading.
+ * Binary files are opened in binary mode, text files in text mode.
+ * In both cases, the returned file is positioned at the start of the problem description.
+ * @param file the file name
+ * @param format receives the file format
+ * @return the opened file, or \c nullptr if the file could not be opened or has an unsupported binary version
+ */
+FILE *openSolutionFile(const std::string &file, SolutionFormat &format);
+/**
+ * @brief Open a solution file for reading; this is the std::istream version of openSolutionFile().
+ * @return the opened stream, or an empty pointer if the file could not be opened or has an unsupported binary version
+ */
+std::unique_ptr<std::istream> openSolutionStream(const std::string &file, SolutionFormat &format);
+
+/**
+ * @brief The SolutionTable class is a list of records of the solution section, e.g. the node list.
+ * In text files, each record is a line of numbers.
+ * In binary files, the values are stored column by column.
+ * A table stays valid as long as the SolutionBuffer it was taken from.
+ */
+class SolutionTable
+{
+public:
+    /**
+     * @brief The Record class reads the values of a single record in the order they were written.
+     */
+    class Record
+    {
+    public:
+        /**
+         * @brief Read the next value.
+         * Integer values can be read as double and vice versa.
+         * @return \c false, if there is no further value.
+         */
+        bool next(double &val);
+        bool next(int &val);
+    private:
+        friend class SolutionTable;
+        Record(const SolutionTable &table, int row);
+        const SolutionTable &table;
+        const char *line; ///< remaining text of the line (text tables)
+        int row;          ///< index of the record (binary tables)
+        int column;       ///< index of the next value (binary tables)
+    };
+
+    SolutionTable();
+
+    /**
+     * @brief The number of records.
+     */
+    int size() const;
+    /**
+     * @brief Start reading record \p i.
+     */
+    Record record(int i) const;
+    /**
+     * @brief The number of values per record, only known for binary tables.
+     * @return the number of columns, or -1 for text tables.
+     */
+    int columns() const;
+    /**
+     * @brief The type codes of the columns ('i' or 'd'), only known for binary tables.
+     */
+    const std::string &columnTypes() const;
+    /**
+     * @brief The text of record \p i, only known for text tables.
+     * @return the start of the line, or \c nullptr for binary tables.
+     */
+    const char *line(int i) const;
+
+private:
+    friend class SolutionBuffer;
+    bool binary;                         ///< \c true for tables of binary files
+    std::vector<const char*> lines;      ///< text tables: the start of each line
+    int rows;                            ///< binary tables: the number of rows
+    std::string types;                   ///< binary tables: type code of each column
+    std::vector<const char*> columnData; ///< binary tables: the values of each column
+};
+
+/**
+ * @brief The SolutionBuffer class holds the solution section of a solution file in memory.
+ *
+ * The node and element lists are taken with nextTable() and decoded by decodeRecords(),
+ * the remaining short lists are read as text with getLine().
+ *
+ * On POSIX systems, binary files are memory mapped instead of read,
+ * so that their tables are decoded directly from the (shared) page cache.
+ * Binary files with a different byte order are read and converted.
+ * Compressed tables are decompressed by nextTable(), tables that are not taken are never decompressed.
+ *
+ * (not present in femm42; xfemm extension)
+ */
+class SolutionBuffer
+{
+public:
+    SolutionBuffer();
+    ~SolutionBuffer();
+    SolutionBuffer(const SolutionBuffer &) = delete;
+    SolutionBuffer &operator=(const SolutionBuffer &) = delete;
+
+    /**
+     * @brief Read everything from the current position of \p fp up to the end of the file.
+     * The file must be positioned after the "[Solution]" line. It is not closed.
+     * @return \c false, if a read error occurred or a binary file is malformed.
+     */
+    bool readFrom(FILE *fp, const SolutionFormat &format = SolutionFormat());
+    /**
+     * @brief Read everything from the current position of \p input up to the end of the stream.
+     * @param input the input stream, positioned after the "[Solution]" line
+     * @param format the file format
+     * @param file the name of the file \p input reads from; if given, binary files are mapped instead of read
+     * @return \c false, if a read error occurred or a binary file is malformed.
+     */
+    bool readFrom(std::istream &input, const SolutionFormat &format = SolutionFormat(), const std::string &file = std::string());
+
+    /**
+     * @brief Read the next line of text, like fgets() does.
+     * At most n-1 characters are copied to \p s, including the newline character, and \p s is null terminated.
+     * @return \p s, or \c nullptr if there is no further text before the next table or the end of the buffer.
+     */
+    char *getLine(char *s, int n);
+
+    /**
+     * @brief Take the next table.
+     * In text files, a table is a line holding the number of records, followed by one line per record.
+     * In binary files, this takes the next table chunk, and decompresses it if necessary.
+     * @return \c false, if there is no table at the current position, if the text holds fewer lines,
+     * or if a compressed table can not be decoded.
+     */
+    bool nextTable(SolutionTable &table);
+
+    /**
+     * @brief Check whether all data has been consumed.
+     */
+    bool atEnd() const;
+
+private:
+    struct Chunk
+    {
+        bool isTable;
+        bool compressed;    ///< compressed table: \c offset is the start of the column directory
+        std::size_t offset; ///< start of the text or the table data
+        std::size_t size;   ///< length of the text / number of rows
+        std::string types;  ///< column types of a table
+    };
+    void clear();
+    bool mapFile(int fd, std::size_t offset);
+    bool parseChunks(const SolutionFormat &format);
+    bool parseCompressedTable(std::size_t &offset, std::size_t columns, std::size_t rows);
+    bool decompressTable(const Chunk &c, SolutionTable &table);
+    void skipConsumedText();
+    bool nextLines(int numLines, std::vector<const char*> &lines);
+
+    bool binary;               ///< the buffer holds the solution section of a binary file
+    bool swapBytes;            ///< the binary file was written with a different byte order
+    std::vector<char> data;    ///< the file contents, null terminated (unless the file is mapped)
+    void *mapping;             ///< the memory mapped file, or \c nullptr
+    std::size_t mappingSize;   ///< the size of the mapping
+    const char *base;          ///< start of the solution section, in \c data or in the mapping
+    std::size_t size;          ///< length of the solution section
+    std::vector<Chunk> chunks; ///< text files consist of a single text chunk
+    std::size_t chunk;         ///< the current chunk
+    std::size_t pos;           ///< the current read position within a text chunk
+    std::vector<std::vector<char>> decoded; ///< the columns of decompressed tables
+};
+
+/**
+ * @brief Call decode(i,record) for each record of the table, using several threads for large tables.
+ * The decode function must only modify data that belongs to record i.
+ * @param table the table, as returned by SolutionBuffer::nextTable()
+ * @param decode the function that decodes a single record, returns \c false if the record is malformed
+ * @param numThreads the number of threads, or 0 for the number of hardware threads
+ * @return the index of the first record that could not be decoded, or -1 on success
+ */
+int decodeRecords(const SolutionTable &table, const std::function<bool(int,SolutionTable::Record&)> &decode, int numThreads=0);
+
+/**
+ * @brief The SolutionWriter class writes the solution section in the text or binary format.
+ *
+ * Usage: create the writer right after opening the file (in binary mode for binary files),
+ * copy the problem description and write the "[Solution]" line, then call beginSolution().
+ * Tables are written record by record with beginTable(), add(), endRecord() and endTable().
+ * After beginText(), the remaining lists are printed with fprintf() as usual. finish() completes the file.
+ * In text mode, the output is the same as that of the classic fprintf() code.
+ * In compressed mode, tables are written as compressed table chunks, using the smallest codec for each column.
+ *
+ * (not present in femm42; xfemm extension)
+ */
+class SolutionWriter
+{
+public:
+    /**
+     * @brief Constructor. In binary mode, the file header is written immediately.
+     * @param fp the output file
+     * @param binary write the binary format
+     * @param compress compress the tables (binary format only)
+     */
+    SolutionWriter(FILE *fp, bool binary, bool compress=false);
+
+    /**
+     * @brief Start the solution section; the "[Solution]" line must already have been written.
+     */
+    void beginSolution();
+
+    /**
+     * @brief Start a table.
+     * @param rows the number of records
+     * @param columnTypes one type code per value of a record: 'd' for double ("%.17g"), 'i' for int ("%i").
+     */
+    void beginTable(int rows, const std::string &columnTypes);
+    /**
+     * @brief Add the next value to the current record; the type has to match the column type.
+     */
+    void add(double val);
+    void add(int val);
+    void endRecord();
+    void endTable();
+
+    /**
+     * @brief Start the free text part; it is printed to the file directly.
+     */
+    void beginText();
+
+    /**
+     * @brief Complete the file. The file is not closed.
+     * @return \c false, if a write error occurred.
+     */
+    bool finish();
+
+private:
+    FILE *fp;
+    bool binary;
+    bool compress;
+    // current binary table:
+    std::string types;
+    int rows;
+    int row;
+    int column;
+    std::vector<std::vector<double>> doubleColumns;
+    std::vector<std::vector<std::int32_t>> intColumns;
+    // start of the current text chunk, or -1
+    long textStart;
+    void endText();
+    void writeCompressedTable();
+};
+
+/**
+ * @brief Convert a solution file between the text, binary and compressed binary formats.
+ * The problem description and all lists except the node and element lists are copied verbatim.
+ * When converting from text, the column types of the tables are determined from the values.
+ * @param inFile the input file
+ * @param outFile the output file
+ * @param binary \c true to write a binary file, \c false to write a text file
+ * @param compress \c true to compress the tables of a binary file
+ * @param err output stream for error messages
+ * @return \c true on success
+ */
+bool convertSolutionFile(const std::string &inFile, const std::string &outFile, bool binary, bool compress, std::ostream &err);
+
+/**
+ * @brief Read a floating point number from \p p, like the "%lf" conversion of sscanf().
+ * Leading blanks are skipped, but a newline character ends the search.
+ * On success, \p p points to the first character after the number.
+ * The result is the same as that of strtod(), numbers with at most 19 significant digits are converted without calling it.
+ * @return \c false, if no number was found.
+ */
+bool parseNumber(const char *&p, double &val);
+/**
+ * @brief Read an int from \p p, like the "%i" conversion of sscanf().
+ * Leading blanks are skipped, but a newline character ends the search.
+ * On success, \p p points to the first character after the number.
+ * @return \c false, if no number was found.
+ */
+bool parseNumber(const char *&p, int &val);
+
+} // namespace femm
+
+#endif
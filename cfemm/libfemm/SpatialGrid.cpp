@@ -0,0 +1,228 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "SpatialGrid.h"
+
+#include <cassert>
+#include <cmath>
+
+// entities that would be put into more buckets than this are stored in the list of large entities
+#define MaxCellsPerItem 256
+// limit cell indices so that the index arithmetic can't overflow
+#define MaxCellIndex (1<<28)
+
+femm::SpatialGrid::SpatialGrid()
+    : m_cellSize(1.)
+    , items()
+    , largeItems()
+    , cells()
+    , minX(0)
+    , minY(0)
+    , maxX(-1)
+    , maxY(-1)
+{
+}
+
+void femm::SpatialGrid::clear(double cellSize)
+{
+    m_cellSize = (cellSize > 0 && std::isfinite(cellSize)) ? cellSize : 1.;
+    items.clear();
+    largeItems.clear();
+    cells.clear();
+    minX = minY = 0;
+    maxX = maxY = -1;
+}
+
+void femm::SpatialGrid::appendBox(CComplex min, CComplex max)
+{
+    append(Item{min, max, false, false});
+}
+
+void femm::SpatialGrid::appendLine(CComplex p0, CComplex p1)
+{
+    append(Item{p0, p1, true, false});
+}
+
+void femm::SpatialGrid::truncate(int newSize)
+{
+    if (newSize < 0)
+        newSize = 0;
+    // ids are appended in ascending order, so the removed ids are always at the end of their buckets
+    for (int id = (int)items.size()-1; id >= newSize; id--)
+    {
+        const Item &item = items[id];
+        if (item.isLarge)
+        {
+            assert(largeItems.back() == id);
+            largeItems.pop_back();
+        } else {
+            forEachCell(item, [this,id](int ix, int iy) {
+                auto it = cells.find(cellKey(ix,iy));
+                if (it == cells.end() || it->second.empty() || it->second.back() != id)
+                    return;
+                it->second.pop_back();
+                if (it->second.empty())
+                    cells.erase(it);
+            });
+        }
+        items.pop_back();
+    }
+    // the range of occupied cells is kept; it only needs to be a superset
+}
+
+void femm::SpatialGrid::query(CComplex min, CComplex max, std::vector<int> &result) const
+{
+    result.clear();
+
+    const double numCells = (std::floor(max.re/m_cellSize) - std::floor(min.re/m_cellSize) + 1.)
+            * (std::floor(max.im/m_cellSize) - std::floor(min.im/m_cellSize) + 1.);
+    if (!(numCells <= (double)items.size()))
+    {
+        // visiting the buckets would be more expensive than checking every entity
+        for (int id=0; id<(int)items.size(); id++)
+            if (overlaps(items[id], min, max))
+                result.push_back(id);
+        return;
+    }
+
+    for (int id: largeItems)
+        if (overlaps(items[id], min, max))
+            result.push_back(id);
+
+    const int x0 = std::max(cellIndex(min.re), minX);
+    const int x1 = std::min(cellIndex(max.re), maxX);
+    const int y0 = std::max(cellIndex(min.im), minY);
+    const int y1 = std::min(cellIndex(max.im), maxY);
+    for (int ix=x0; ix<=x1; ix++)
+    {
+        for (int iy=y0; iy<=y1; iy++)
+        {
+            auto it = cells.find(cellKey(ix,iy));
+            if (it != cells.end())
+                result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+int femm::SpatialGrid::cellIndex(double v) const
+{
+    double idx = std::floor(v / m_cellSize);
+    if (!(idx > -MaxCellIndex))
+        return -MaxCellIndex;
+    if (idx > MaxCellIndex)
+        return MaxCellIndex;
+    return (int)idx;
+}
+
+femm::SpatialGrid::key_t femm::SpatialGrid::cellKey(int ix, int iy) const
+{
+    return ((key_t)(std::uint32_t)ix << 32) | (key_t)(std::uint32_t)iy;
+}
+
+int femm::SpatialGrid::countCells(const Item &item) const
+{
+    const double nx = std::fabs(std::floor(item.p1.re/m_cellSize) - std::floor(item.p0.re/m_cellSize)) + 1.;
+    const double ny = std::fabs(std::floor(item.p1.im/m_cellSize) - std::floor(item.p0.im/m_cellSize)) + 1.;
+    // a line passes through at most nx+ny-1 buckets
+    const double n = item.isLine ? nx+ny-1. : nx*ny;
+    if (!(n <= MaxCellsPerItem))
+        return MaxCellsPerItem+1;
+    return (int)n;
+}
+
+template <class Visitor>
+void femm::SpatialGrid::forEachCell(const Item &item, Visitor visit) const
+{
+    if (!item.isLine)
+    {
+        for (int ix=cellIndex(item.p0.re); ix<=cellIndex(item.p1.re); ix++)
+            for (int iy=cellIndex(item.p0.im); iy<=cellIndex(item.p1.im); iy++)
+                visit(ix,iy);
+        return;
+    }
+
+    // walk along the line column by column
+    CComplex a = item.p0;
+    CComplex b = item.p1;
+    if (a.re > b.re)
+        std::swap(a,b);
+    const int x0 = cellIndex(a.re);
+    const int x1 = cellIndex(b.re);
+    // a small margin makes sure that rounding can't make us miss a bucket
+    const double eps = 1.e-08*m_cellSize;
+    for (int ix=x0; ix<=x1; ix++)
+    {
+        double ya, yb;
+        if (x0 == x1)
+        {
+            ya = a.im;
+            yb = b.im;
+        } else {
+            const double xa = std::max(a.re, ix*m_cellSize);
+            const double xb = std::min(b.re, (ix+1)*m_cellSize);
+            ya = a.im + (b.im-a.im)*(xa-a.re)/(b.re-a.re);
+            yb = a.im + (b.im-a.im)*(xb-a.re)/(b.re-a.re);
+        }
+        if (ya > yb)
+            std::swap(ya,yb);
+        for (int iy=cellIndex(ya-eps); iy<=cellIndex(yb+eps); iy++)
+            visit(ix,iy);
+    }
+}
+
+void femm::SpatialGrid::append(const Item &item)
+{
+    const int id = (int)items.size();
+    items.push_back(item);
+    Item &stored = items.back();
+    if (!stored.isLine)
+    {
+        // store boxes normalized
+        CComplex lo (std::min(item.p0.re,item.p1.re), std::min(item.p0.im,item.p1.im));
+        CComplex hi (std::max(item.p0.re,item.p1.re), std::max(item.p0.im,item.p1.im));
+        stored.p0 = lo;
+        stored.p1 = hi;
+    }
+
+    if (countCells(stored) > MaxCellsPerItem)
+    {
+        stored.isLarge = true;
+        largeItems.push_back(id);
+        return;
+    }
+
+    forEachCell(stored, [this,id](int ix, int iy) {
+        std::vector<int> &bucket = cells[cellKey(ix,iy)];
+        // a line may visit the same bucket twice at column boundaries
+        if (bucket.empty() || bucket.back() != id)
+            bucket.push_back(id);
+        if (maxX < minX)
+        {
+            minX = maxX = ix;
+            minY = maxY = iy;
+        } else {
+            minX = std::min(minX, ix);
+            maxX = std::max(maxX, ix);
+            minY = std::min(minY, iy);
+            maxY = std::max(maxY, iy);
+        }
+    });
+}
+
+bool femm::SpatialGrid::overlaps(const Item &item, CComplex min, CComplex max) const
+{
+    const double x0 = std::min(item.p0.re, item.p1.re);
+    const double x1 = std::max(item.p0.re, item.p1.re);
+    const double y0 = std::min(item.p0.im, item.p1.im);
+    const double y1 = std::max(item.p0.im, item.p1.im);
+    return !(x1 < min.re || x0 > max.re || y1 < min.im || y0 > max.im);
+}
@@ -0,0 +1,176 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_SPATIALGRID_H
+#define FEMM_SPATIALGRID_H
+
+#include "femmcomplex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The SpatialGrid class is a uniform grid of buckets used to find geometric entities by their location.
+ *
+ * Entities are identified by consecutive integer ids (i.e. the index of the entity in its list),
+ * and are either stored by their bounding box or as a straight line.
+ * A query returns all entities whose buckets overlap the query region, i.e. a superset of the entities within the region.
+ * The caller is expected to run the exact geometric test on the returned candidates.
+ *
+ * Entities that would occupy a large number of buckets are kept in a separate list that is checked on every query.
+ */
+class SpatialGrid
+{
+public:
+    SpatialGrid();
+
+    /**
+     * @brief Remove all entities and set the bucket size.
+     * @param cellSize the edge length of a bucket
+     */
+    void clear(double cellSize);
+
+    /**
+     * @brief Add an entity given by its bounding box.
+     * The id of the new entity is the former size() of the grid.
+     * @param min lower left corner of the bounding box
+     * @param max upper right corner of the bounding box
+     */
+    void appendBox(CComplex min, CComplex max);
+
+    /**
+     * @brief Add a straight line entity.
+     * In contrast to appendBox(), the line is only put into the buckets it actually passes through.
+     * The id of the new entity is the former size() of the grid.
+     * @param p0 start point
+     * @param p1 end point
+     */
+    void appendLine(CComplex p0, CComplex p1);
+
+    /**
+     * @brief Remove all entities with an id of \p newSize or higher.
+     * @param newSize
+     */
+    void truncate(int newSize);
+
+    /**
+     * @brief Find the entities that may be located within the given region.
+     * @param min lower left corner of the query region
+     * @param max upper right corner of the query region
+     * @param result the ids of the candidate entities in ascending order (output variable)
+     */
+    void query(CComplex min, CComplex max, std::vector<int> &result) const;
+
+    /**
+     * @brief Find the entity closest to a point.
+     * Ties are resolved in favor of the entity with the lower id, just like a linear search would do.
+     * @param p the point
+     * @param distance a function that returns the exact distance between \p p and the entity with the given id
+     * @return the id of the closest entity, or -1 if the grid is empty
+     */
+    template <class DistanceFunction>
+    int closest(CComplex p, DistanceFunction distance) const;
+
+    int size() const { return (int)items.size(); }
+    double cellSize() const { return m_cellSize; }
+
+private:
+    struct Item {
+        CComplex p0;
+        CComplex p1;
+        bool isLine;
+        bool isLarge;
+    };
+    using key_t = std::uint64_t;
+
+    int cellIndex(double v) const;
+    key_t cellKey(int ix, int iy) const;
+    int countCells(const Item &item) const;
+    template <class Visitor>
+    void forEachCell(const Item &item, Visitor visit) const;
+    void append(const Item &item);
+    bool overlaps(const Item &item, CComplex min, CComplex max) const;
+
+    double m_cellSize;
+    std::vector<Item> items;
+    std::vector<int> largeItems;
+    std::unordered_map<key_t, std::vector<int>> cells;
+    // range of occupied cells
+    int minX, minY, maxX, maxY;
+};
+
+template <class DistanceFunction>
+int SpatialGrid::closest(CComplex p, DistanceFunction distance) const
+{
+    if (items.empty())
+        return -1;
+
+    int best = -1;
+    double bestDist = 0;
+    auto check = [&](int id) {
+        double d = distance(id);
+        if (best < 0 || d < bestDist || (d == bestDist && id < best))
+        {
+            best = id;
+            bestDist = d;
+        }
+    };
+    for (int id: largeItems)
+        check(id);
+
+    if (cells.empty())
+        return best;
+
+    // search rings of cells around p, until no closer entity can be found
+    const int cx = cellIndex(p.re);
+    const int cy = cellIndex(p.im);
+    auto visit = [&](int ix, int iy) {
+        auto it = cells.find(cellKey(ix,iy));
+        if (it != cells.end())
+            for (int id: it->second)
+                check(id);
+    };
+    // rings that are closer to p than the occupied cells are empty
+    int r = std::max(std::max(minX-cx, cx-maxX), std::max(minY-cy, cy-maxY));
+    for (r = std::max(r, 0); ; r++)
+    {
+        const int x0 = cx-r;
+        const int x1 = cx+r;
+        const int y0 = cy-r;
+        const int y1 = cy+r;
+        for (int ix = std::max(x0, minX); ix <= std::min(x1, maxX); ix++)
+        {
+            if (y0 >= minY)
+                visit(ix, y0);
+            if (y1 <= maxY && r > 0)
+                visit(ix, y1);
+        }
+        for (int iy = std::max(y0+1, minY); iy <= std::min(y1-1, maxY); iy++)
+        {
+            if (x0 >= minX)
+                visit(x0, iy);
+            if (x1 <= maxX)
+                visit(x1, iy);
+        }
+        // all entities outside the searched square are at least r cells away
+        if (best >= 0 && bestDist < r*m_cellSize)
+            break;
+        if (x0 <= minX && y0 <= minY && x1 >= maxX && y1 >= maxY)
+            break;
+    }
+    return best;
+}
+
+} // namespace femm
+
+#endif
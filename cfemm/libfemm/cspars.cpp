@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include "femmcomplex.h"
 #include "cspars.h"
+#include "Profiler.h"
 
 #define MAXITER 1000000
 #define KLUDGE
@@ -1061,6 +1062,7 @@ int CBigComplexLinProb::KludgeSolve(int flag)
 // pathological starting points that can sometimes crop up.
 int CBigComplexLinProb::PBCGSolveMod(int flag,bool verbose)
 {
+    femm::ProfileScope profile("solve");
     // if this is a N-R iteration, call the appropriate solver
     if (bNewton)
         //	return BiCGSTAB(flag);
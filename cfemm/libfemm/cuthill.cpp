@@ -29,6 +29,8 @@
 #include "femmenums.h"
 //#include "spars.h"
 #include "feasolver.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
 
 template< class PointPropT
           , class BoundaryPropT
@@ -96,6 +98,7 @@ template< class PointPropT
 int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
 ::Cuthill(bool deletefiles)
 {
+    femm::ProfileScope profile("renumber");
 
     FILE *fp;
     int i, n0, n1, n, newwide;
@@ -106,7 +109,22 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
 
     // read in connectivity from nodefile
     sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+
+    // reuse the numbering of a previous analysis with the same mesh
+    if ((int)NodeNumbering.size() == NumNodes && BandWidth > 0)
+    {
+        if (deletefiles)
+        {
+            femm::removeFile(infile);
+        }
+        newnum = NodeNumbering;
+        applyNodeNumbering(newnum);
+        NodeNumberingReused = true;
+        return true;
+    }
+    NodeNumberingReused = false;
+
+    if((fp=femm::openFile(infile,"rt"))==NULL)
     {
         //MsgBox("Couldn't open %s",infile);
         printf("Couldn't open %s",infile);
@@ -213,7 +231,7 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
     fclose(fp);
     if (deletefiles)
     {
-        remove(infile);
+        femm::removeFile(infile);
     }
 
 
@@ -312,25 +330,6 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
         for(j=0; j<numcon[i]; j++)
             ocon[i][j]=newnum[ocon[i][j]];
 
-    // remap (anti)periodic boundary points
-    for(i=0; i<NumPBCs; i++)
-    {
-        pbclist[i].x=newnum[pbclist[i].x];
-        pbclist[i].y=newnum[pbclist[i].y];
-    }
-
-	// remap air gap element information
-	for(i=0; i<NumAirGapElems; i++)
-	{
-		for(int k=0; k<=agelist[i].totalArcElements; k++)
-		{
-			agelist[i].quadNode[k].n0=newnum[agelist[i].quadNode[k].n0];
-			agelist[i].quadNode[k].n1=newnum[agelist[i].quadNode[k].n1];
-			agelist[i].quadNode[k].n2=newnum[agelist[i].quadNode[k].n2];
-			agelist[i].quadNode[k].n3=newnum[agelist[i].quadNode[k].n3];
-		}
-	}
-
     // find new bandwidth;
 
     // PBCs fuck up the banding, som could have to do
@@ -358,7 +357,42 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
     //free(ocon[0]);
     //free(ocon);
 
-    // new mapping remains in newnum;
+    NodeNumbering = newnum;
+    applyNodeNumbering(newnum);
+    return true;
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+void FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::applyNodeNumbering(const std::vector<int> &newnum)
+{
+    int i, j;
+
+    // remap (anti)periodic boundary points
+    for(i=0; i<NumPBCs; i++)
+    {
+        pbclist[i].x=newnum[pbclist[i].x];
+        pbclist[i].y=newnum[pbclist[i].y];
+    }
+
+	// remap air gap element information
+	for(i=0; i<NumAirGapElems; i++)
+	{
+		for(int k=0; k<=agelist[i].totalArcElements; k++)
+		{
+			agelist[i].quadNode[k].n0=newnum[agelist[i].quadNode[k].n0];
+			agelist[i].quadNode[k].n1=newnum[agelist[i].quadNode[k].n1];
+			agelist[i].quadNode[k].n2=newnum[agelist[i].quadNode[k].n2];
+			agelist[i].quadNode[k].n3=newnum[agelist[i].quadNode[k].n3];
+		}
+	}
+
     // apply this mapping to elements first.
     for(i=0; i<NumEls; i++)
         for(j=0; j<3; j++)
@@ -388,6 +422,4 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
     //free(newnum);
 
     SortElements();
-
-    return true;
 }
@@ -32,6 +32,8 @@
 #include "spars.h"
 #include "fparse.h"
 #include "feasolver.h"
+#include "MemoryFiles.h"
+#include "Profiler.h"
 #include "stringTools.h"
 
 #include <assert.h>
@@ -95,6 +97,9 @@ FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshEleme
     , pbclist()
     , PathName()
     , PrevType(0)
+    , BinarySolution(false)
+    , CompressSolution(false)
+    , NodeNumberingReused(false)
     , nodeproplist()
     , lineproplist()
     , blockproplist()
@@ -181,14 +186,15 @@ template< class PointPropT
 bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
 ::LoadProblemFile(std::string &file)
 {
-    std::ifstream input;
+    femm::ProfileScope profile("load");
     std::stringstream err;
     err >> noskipws; // don't discard whitespace from message stream
 
     WarnMessage ("FEASolver::LoadProblemFile\n");
 
-    input.open(file.c_str(), std::ifstream::in);
-    if (!input.is_open())
+    // the problem file may be a memory file (see MemoryFiles.h)
+    std::unique_ptr<std::istream> inputFile = femm::openInputFile(file);
+    if (!inputFile)
     {
         err << "Couldn't read from specified .fem file: "
             << file.c_str()
@@ -196,6 +202,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         WarnMessage(err.str().c_str());
         return false;
     }
+    std::istream &input = *inputFile;
 
     // define some defaults
     CleanUp();
@@ -132,6 +132,16 @@ public:
 
     int PrevType; ///< \brief flag indicating type of previous solution, 0 for None, 1 for Incremental or 2 for Frozen \verbatim[prevtype]\endverbatim
     std::string previousSolutionFile; ///< \brief name of a previous solution file for hsolver and fsolver incremental permeability \verbatim[prevsoln]\endverbatim
+    bool BinarySolution; ///< \brief write the solution file in the binary format of SolutionFile.h (not present in femm42; xfemm extension)
+    bool CompressSolution; ///< \brief compress the tables of binary solution files (not present in femm42; xfemm extension)
+    /**
+     * @brief The node numbering of Cuthill(): node i of the mesh files becomes node NodeNumbering[i].
+     * If NodeNumbering and BandWidth are set before Cuthill() is called, e.g. to the results of a previous analysis
+     * with the same mesh, Cuthill() applies this numbering instead of computing it again.
+     * (not present in femm42; xfemm extension)
+     */
+    std::vector<int> NodeNumbering;
+    bool NodeNumberingReused; ///< \brief set by Cuthill(): \c true, if NodeNumbering has been applied instead of being computed (not present in femm42; xfemm extension)
 
     std::vector< PointPropT > nodeproplist;
     std::vector< BoundaryPropT > lineproplist;
@@ -205,6 +215,11 @@ protected:
 private:
 
     virtual void SortNodes (std::vector<int> newnum) = 0;
+    /**
+     * @brief Renumber the mesh nodes, and sort the elements accordingly.
+     * @param newnum node i becomes node newnum[i]
+     */
+    void applyNodeNumbering(const std::vector<int> &newnum);
 
 };
 
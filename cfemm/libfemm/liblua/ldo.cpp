@@ -350,6 +350,32 @@ LUA_API int lua_dostring (lua_State *L, const char *str)
 }
 
 
+/*
+** Parse a chunk (source or precompiled) and push it as function, without running it.
+** (xfemm extension)
+*/
+LUA_API int lua_loadbuffer (lua_State *L, const char *buff, size_t size, const char *name)
+{
+    if (size == 0) return LUA_ERRSYNTAX;
+    return parse_buffer(L, buff, size, name);
+}
+
+
+/*
+** Write the precompiled chunk of the Lua function on top of the stack.
+** The chunk can be run by lua_dobuffer or lua_dofile.
+** (xfemm extension)
+*/
+LUA_API int lua_dumpfunction (lua_State *L, lua_Writer writer, void *ud)
+{
+    StkId o = L->top-1;
+    if (o < L->Cbase || ttype(o) != LUA_TFUNCTION || clvalue(o)->isC)
+        return 1;
+    luaU_dump(clvalue(o)->f.l, writer, ud);
+    return 0;
+}
+
+
 /*
 ** {======================================================
 ** Error-recover functions (based on long jumps)
@@ -168,6 +168,13 @@ LUA_API int   lua_dofile (lua_State *L, const char *filename);
 LUA_API int   lua_dostring (lua_State *L, const char *str);
 LUA_API int   lua_dobuffer (lua_State *L, const char *buff, size_t size, const char *name);
 
+/*
+** precompiled chunks (xfemm extension)
+*/
+typedef void (*lua_Writer) (const void *p, size_t size, void *ud);
+LUA_API int   lua_loadbuffer (lua_State *L, const char *buff, size_t size, const char *name);
+LUA_API int   lua_dumpfunction (lua_State *L, lua_Writer writer, void *ud);
+
 /*
 ** Garbage-collection functions
 */
@@ -242,3 +242,131 @@ int luaU_endianess (void)
     int x=1;
     return *(char*)&x;
 }
+
+
+/*
+** save pre-compiled chunks (xfemm extension)
+** this is the inverse of LoadChunk, derived from dump.c of luac 4.0
+*/
+
+typedef struct DumpState
+{
+    lua_Writer writer;
+    void* data;
+} DumpState;
+
+static void DumpBlock (const void* b, size_t size, DumpState* D)
+{
+    (*D->writer)(b,size,D->data);
+}
+
+static void DumpByte (int c, DumpState* D)
+{
+    char x=(char)c;
+    DumpBlock(&x,sizeof(x),D);
+}
+
+static void DumpInt (int x, DumpState* D)
+{
+    DumpBlock(&x,sizeof(x),D);
+}
+
+static void DumpSize (size_t x, DumpState* D)
+{
+    DumpBlock(&x,sizeof(x),D);
+}
+
+static void DumpNumber (Number x, DumpState* D)
+{
+    DumpBlock(&x,sizeof(x),D);
+}
+
+static void DumpString (const TString* s, DumpState* D)
+{
+    if (s==NULL)
+        DumpSize(0,D);
+    else
+    {
+        size_t size=s->len+1;		/* include trailing '\0' */
+        DumpSize(size,D);
+        DumpBlock(s->str,size,D);
+    }
+}
+
+static void DumpCode (const Proto* tf, DumpState* D)
+{
+    DumpInt(tf->ncode,D);
+    DumpBlock(tf->code,tf->ncode*sizeof(*tf->code),D);
+}
+
+static void DumpLocals (const Proto* tf, DumpState* D)
+{
+    int i,n=tf->nlocvars;
+    DumpInt(n,D);
+    for (i=0; i<n; i++)
+    {
+        DumpString(tf->locvars[i].varname,D);
+        DumpInt(tf->locvars[i].startpc,D);
+        DumpInt(tf->locvars[i].endpc,D);
+    }
+}
+
+static void DumpLines (const Proto* tf, DumpState* D)
+{
+    DumpInt(tf->nlineinfo,D);
+    DumpBlock(tf->lineinfo,tf->nlineinfo*sizeof(*tf->lineinfo),D);
+}
+
+static void DumpFunction (const Proto* tf, DumpState* D);
+
+static void DumpConstants (const Proto* tf, DumpState* D)
+{
+    int i,n;
+    DumpInt(n=tf->nkstr,D);
+    for (i=0; i<n; i++)
+        DumpString(tf->kstr[i],D);
+    DumpInt(tf->nknum,D);
+    DumpBlock(tf->knum,tf->nknum*sizeof(*tf->knum),D);
+    DumpInt(n=tf->nkproto,D);
+    for (i=0; i<n; i++)
+        DumpFunction(tf->kproto[i],D);
+}
+
+static void DumpFunction (const Proto* tf, DumpState* D)
+{
+    DumpString(tf->source,D);
+    DumpInt(tf->lineDefined,D);
+    DumpInt(tf->numparams,D);
+    DumpByte(tf->is_vararg,D);
+    DumpInt(tf->maxstacksize,D);
+    DumpLocals(tf,D);
+    DumpLines(tf,D);
+    DumpConstants(tf,D);
+    DumpCode(tf,D);
+}
+
+static void DumpHeader (DumpState* D)
+{
+    Number tf=TEST_NUMBER;
+    DumpByte(ID_CHUNK,D);
+    DumpBlock(SIGNATURE,strlen(SIGNATURE),D);
+    DumpByte(VERSION,D);
+    DumpByte(luaU_endianess(),D);
+    DumpByte(sizeof(int),D);
+    DumpByte(sizeof(size_t),D);
+    DumpByte(sizeof(Instruction),D);
+    DumpByte(SIZE_INSTRUCTION,D);
+    DumpByte(SIZE_OP,D);
+    DumpByte(SIZE_B,D);
+    DumpByte(sizeof(Number),D);
+    DumpNumber(tf,D);
+}
+
+void luaU_dump (const Proto* Main, lua_Writer writer, void* ud)
+{
+    DumpState D;
+    D.writer=writer;
+    D.data=ud;
+    DumpHeader(&D);
+    DumpFunction(Main,&D);
+}
@@ -16,6 +16,9 @@ Proto* luaU_undump (lua_State* L, ZIO* Z);
 /* find byte order */
 int luaU_endianess (void);
 
+/* save one chunk (xfemm extension) */
+void luaU_dump (const Proto* Main, lua_Writer writer, void* ud);
+
 /* definitions for headers of binary files */
 #define	VERSION		0x40		/* last format change was in 4.0 */
 #define	VERSION0	0x40		/* last major  change was in 4.0 */
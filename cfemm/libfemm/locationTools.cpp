@@ -10,8 +10,15 @@
  */
 #include "locationTools.h"
 
+#include <atomic>
 #include <iostream>
 
+#ifdef WIN32
+# include <process.h>
+#else
+# include <unistd.h>
+#endif
+
 #ifdef XFEMM_HAVE_STAT
 // room for improvement: stat instead of open
 #else
@@ -101,6 +108,18 @@ std::string location::locateFile(location::LocationType type, const std::string
     return "";
 }
 
+std::string location::temporaryFileName(const std::string &path)
+{
+    // the process id separates concurrent processes, the counter separates threads
+    static std::atomic<unsigned> counter(0);
+#ifdef WIN32
+    const long pid = _getpid();
+#else
+    const long pid = getpid();
+#endif
+    return path + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
 constexpr char location::pathSeparator()
 {
 #ifdef WIN32
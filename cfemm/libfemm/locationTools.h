@@ -85,6 +85,15 @@ bool fileExists( const std::string &path);
  */
 std::string locateFile( LocationType type, const std::string &appName, const std::string &path);
 
+/**
+ * @brief Get a name for a temporary file next to \c path.
+ * The name is unique among concurrently running processes and threads,
+ * so that a file can be written under this name and then renamed to \c path.
+ * @param path
+ * @return a file name of the form "path.<pid>.<n>.tmp"
+ */
+std::string temporaryFileName( const std::string &path);
+
 /**
  * @brief The path separator separates different file names or path names in PATH-style environment variables.
  * @return the path separator for the current platform (';' on Windows, ':' everywhere else)
@@ -21,6 +21,7 @@
 
 #include "femmcomplex.h"
 #include "spars.h"
+#include "Profiler.h"
 
 #include <cmath>
 #include <cstdio>
@@ -237,6 +238,7 @@ void CBigLinProb::MultPC(const double *X, double *Y)
 
 bool CBigLinProb::PCGSolve(int flag)
 {
+    femm::ProfileScope profile("solve");
     int i;
     double res,res_o,res_new;
     double er,del,rho,pAp;
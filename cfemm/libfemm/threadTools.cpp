@@ -0,0 +1,37 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "threadTools.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+int femm::threadsForItems(int numItems, int minItemsPerThread, int numThreads)
+{
+    if (numThreads <= 0)
+        numThreads = std::thread::hardware_concurrency();
+    numThreads = std::min(numThreads, (numItems+minItemsPerThread-1)/minItemsPerThread);
+    return std::max(1, numThreads);
+}
+
+void femm::runInChunks(int numItems, int numThreads, const std::function<void (int, int)> &fn)
+{
+    if (numThreads <= 1)
+    {
+        fn(0, numItems);
+        return;
+    }
+    std::vector<std::thread> threads;
+    const int chunk = (numItems+numThreads-1)/numThreads;
+    for (int first=0; first<numItems; first+=chunk)
+        threads.emplace_back(fn, first, std::min(first+chunk, numItems));
+    for (auto &thread: threads)
+        thread.join();
+}
@@ -0,0 +1,45 @@
+/*
+ * The source code in this file is part of xfemm.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_THREADTOOLS_H
+#define FEMM_THREADTOOLS_H
+
+#include <functional>
+
+/**
+ * \file threadTools.h
+ * \brief Helpers for splitting loops across threads (not present in femm42; xfemm extension).
+ */
+
+namespace femm
+{
+
+/**
+ * @brief Choose the number of threads for a loop over \p numItems independent items.
+ * Starting a thread only pays off if it has enough work to do,
+ * so each thread gets at least \p minItemsPerThread items.
+ * @param numItems the number of items
+ * @param minItemsPerThread the smallest number of items worth a thread of its own
+ * @param numThreads the requested number of threads; 0 to use the number of available cores
+ * @return the number of threads to use, at least 1
+ */
+int threadsForItems(int numItems, int minItemsPerThread, int numThreads=0);
+
+/**
+ * @brief Split the range [0,numItems) into consecutive chunks and call fn(first,last) for each chunk in its own thread.
+ * With a single thread, fn(0,numItems) is called directly.
+ * @param numItems the number of items
+ * @param numThreads the number of threads, e.g. as returned by threadsForItems()
+ * @param fn the function that processes the items first, ..., last-1
+ */
+void runInChunks(int numItems, int numThreads, const std::function<void(int,int)> &fn);
+
+} // namespace femm
+
+#endif
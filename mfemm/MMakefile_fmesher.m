@@ -36,7 +36,8 @@ function [rules,vars] = MMakefile_fmesher (varargin)
 
     %vars.LDFLAGS = sprintf('${LDFLAGS} -l%s ''-Wl,--no-undefined''', fullfile (matlabroot, 'sys', 'os', 'glnxa64', 'libstdc++.so.6'));
     %vars.LDFLAGS = '${LDFLAGS} -lstdc++ ''-Wl,--no-undefined''';
-    vars.LDFLAGS = '${LDFLAGS} -static-libstdc++ ''-Wl,--no-undefined''';
+    % -pthread for the subdomain meshing threads and the parallel solution file reader in libfemm
+    vars.LDFLAGS = '${LDFLAGS} -pthread -static-libstdc++ ''-Wl,--no-undefined''';
 
     % flags that will be passed direct to mex
     vars.MEXFLAGS = ['${MEXFLAGS} -D_GLIBCXX_USE_CXX11_ABI=1 -I"../cfemm/fmesher" -I"../cfemm/fmesher/triangle" -I"../cfemm/libfemm" -I"../cfemm/libfemm/liblua" ', trilibraryflag, options.ExtraMEXFLAGS];
@@ -59,7 +59,8 @@ function [rules,vars] = MMakefile_fpproc (varargin)
 %     vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++14'];
 
     %vars.LDFLAGS = '${LDFLAGS} -lstdc++ ''-Wl,--no-undefined''';
-    vars.LDFLAGS = '${LDFLAGS} ''-Wl,--no-undefined''';
+    % -pthread for the batched point value evaluation and the solution file reader
+    vars.LDFLAGS = '${LDFLAGS} -pthread ''-Wl,--no-undefined''';
 
     [libluacomplex_sources, libluacomplex_headers] = getlibluasources ();
 
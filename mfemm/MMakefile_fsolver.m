@@ -29,7 +29,8 @@ function [rules,vars] = MMakefile_fsolver (varargin)
     thisfilepath = strrep (thisfilepath, '\', '/');
 
     %vars.LDFLAGS = '${LDFLAGS} -lstdc++ ''-Wl,--no-undefined''';
-    vars.LDFLAGS = '${LDFLAGS} ''-Wl,--no-undefined''';
+    % -pthread for the parallel solution file reader in libfemm
+    vars.LDFLAGS = '${LDFLAGS} -pthread ''-Wl,--no-undefined''';
 
     % flags that will be passed direct to mex
     vars.MEXFLAGS = ['${MEXFLAGS} -D_GLIBCXX_USE_CXX11_ABI=1 -I"../cfemm/fsolver" -I"../cfemm/libfemm" -I"../cfemm/libfemm/liblua" ', options.ExtraMEXFLAGS];
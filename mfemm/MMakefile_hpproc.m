@@ -59,7 +59,8 @@ function [rules,vars] = MMakefile_hpproc (varargin)
 %     vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++14'];
 
     %vars.LDFLAGS = '${LDFLAGS} -lstdc++ ''-Wl,--no-undefined''';
-    vars.LDFLAGS = '${LDFLAGS} ''-Wl,--no-undefined''';
+    % -pthread for the parallel solution file reader in libfemm
+    vars.LDFLAGS = '${LDFLAGS} -pthread ''-Wl,--no-undefined''';
 
     [libluacomplex_sources, libluacomplex_headers] = getlibluasources ();
 
@@ -50,7 +50,8 @@ function [rules,vars] = MMakefile_hsolver (varargin)
     end
 
     %vars.LDFLAGS = '${LDFLAGS} -lstdc++ ''-Wl,--no-undefined''';
-    vars.LDFLAGS = '${LDFLAGS} ''-Wl,--no-undefined''';
+    % -pthread for the parallel solution file reader in libfemm
+    vars.LDFLAGS = '${LDFLAGS} -pthread ''-Wl,--no-undefined''';
     
     vars.CXXFLAGS = '${CXXFLAGS} -std=c++11 ';
 
@@ -61,7 +62,7 @@ function [rules,vars] = MMakefile_hsolver (varargin)
 
 %     vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++14'];
 
-    vars.LDFLAGS = '${LDFLAGS} -lstdc++';
+    vars.LDFLAGS = '${LDFLAGS} -pthread -lstdc++';
 
     [libluacomplex_sources, libluacomplex_headers] = getlibluasources ();
 
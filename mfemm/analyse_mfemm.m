@@ -34,6 +34,11 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
 %  'KeepMesh' - (optional scalar logical) if true, and not using FEMM,
 %    allows the mesh files to be kept after loading by fsolver.
 %
+%  'EnforcePSLG' - (optional scalar logical) if true, and not using FEMM,
+%    intersecting segments and arcs are split and coincident nodes merged
+%    in a single pass before meshing. Use this for generated geometries
+%    whose intersections have not been resolved. Defaults to false.
+%
 % An alternative legacy syntax is documented below. This syntax is
 % deprecated and may be removed in a future release. Use the
 % parameter-value pair method for new code.
@@ -86,6 +91,7 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
         options.UseFEMM = false;
         options.Quiet = true;
         options.KeepMesh = false;
+        options.EnforcePSLG = false;
 
         options = mfemmdeps.parse_pv_pairs (options, varargin );
 
@@ -108,6 +114,8 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
         else
             options.KeepMesh = varargin{3};
         end
+        
+        options.EnforcePSLG = false;
     
     end
     
@@ -117,6 +125,8 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
         'Quiet should be a scalar logical value' );
     assert (isscalar (options.KeepMesh) && islogical (options.KeepMesh), ...
         'KeepMesh should be a scalar logical value' );
+    assert (isscalar (options.EnforcePSLG) && islogical (options.EnforcePSLG), ...
+        'EnforcePSLG should be a scalar logical value' );
     
     if isstruct(femprob)
     
@@ -162,13 +172,13 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
                 % using xfemm interface
                 if options.Quiet
                     % mesh the problem using fmesher
-                    fmesher(femfilename);
+                    fmesher(femfilename, 0, 'EnforcePSLG', options.EnforcePSLG);
                     % solve the fea problem using fsolver
                     fsolver(femfilename(1:end-4), false, ~options.KeepMesh);
                 else
                     % mesh the problem using fmesher
                     fprintf(1, 'Meshing mfemm problem ...\n');
-                    fmesher(femfilename, 1);
+                    fmesher(femfilename, 1, 'EnforcePSLG', options.EnforcePSLG);
                     fprintf(1, 'mfemm problem meshed ...\n');
                     % solve the fea problem using fsolver
                     fprintf(1, 'Solving mfemm problem ...\n');
@@ -191,13 +201,13 @@ function [ansfilename, femfilename] = analyse_mfemm(femprob, varargin)
                 % using xfemm interface
                 if options.Quiet
                     % mesh the problem using fmesher
-                    fmesher(femfilename);
+                    fmesher(femfilename, 0, 'EnforcePSLG', options.EnforcePSLG);
                     % solve the fea problem using fsolver
                     hsolver(femfilename(1:end-4), false, ~options.KeepMesh);
                 else
                     % mesh the problem using fmesher
                     fprintf(1, 'Meshing mfemm problem ...\n');
-                    fmesher(femfilename, 1);
+                    fmesher(femfilename, 1, 'EnforcePSLG', options.EnforcePSLG);
                     fprintf(1, 'mfemm problem meshed ...\n');
                     % solve the fea problem using fsolver
                     fprintf(1, 'Solving mfemm problem ...\n');
@@ -7,6 +7,7 @@ function filename = fmesher(varargin)
 % filename = fmesher(filename)
 % filename = fmesher(FemmProblem, filename)
 % filename = fmesher(..., verbosity)
+% filename = fmesher(..., 'EnforcePSLG', enforcepslg)
 % Description
 %
 % fmesher.m creates a finite element mesh of an mfemm FemmProblem structure
@@ -24,6 +25,12 @@ function filename = fmesher(varargin)
 % by filename from the supplied FemmProblem structure and meshes it,
 % creating a number of output files.
 %
+% fmesher(..., 'EnforcePSLG', true) splits intersecting segments and arcs
+% and merges coincident nodes in a single pass before meshing, and writes
+% the cleaned geometry back to the .fem file. This allows generated
+% geometries to be supplied without resolving intersections beforehand.
+% Must be the last arguments, and defaults to false.
+%
 % the actual file name of the .fem file associated with the problem is
 % returned in all cases.
 %
@@ -44,16 +51,24 @@ function filename = fmesher(varargin)
 %    See the License for the specific language governing permissions and
 %    limitations under the License.
 
+    enforcepslg = false;
+    if numel(varargin) > 2 && ischar(varargin{end-1}) ...
+            && strcmpi(varargin{end-1}, 'EnforcePSLG')
+        enforcepslg = logical(varargin{end});
+        varargin(end-1:end) = [];
+    end
+    nargs = numel(varargin);
+
     verbosity = 0;
     haveverbosity = false;
-    if nargin > 1
+    if nargs > 1
         if isscalar(varargin {end})
             verbosity = varargin {end};
             haveverbosity = true;
         end
     end
     
-    if (nargin == 1) || (nargin == 2 && haveverbosity == true)
+    if (nargs == 1) || (nargs == 2 && haveverbosity == true)
         
         if isstruct(varargin{1})
             
@@ -82,7 +97,7 @@ function filename = fmesher(varargin)
                    'of a .fem file to be meshed.']);
         end
         
-    elseif (nargin == 2 && haveverbosity == false) || (nargin == 3)
+    elseif (nargs == 2 && haveverbosity == false) || (nargs == 3)
         
         if ~isstruct(varargin{1}) || ~ischar(varargin{2})
             error(['If supplying two inputs the first must be a ', ...
@@ -100,6 +115,6 @@ function filename = fmesher(varargin)
         error('Incorrect number of arguments to fmesher.')
     end
 
-    mexfmesher(filename, verbosity);
+    mexfmesher(filename, verbosity, enforcepslg);
 
 end
\ No newline at end of file
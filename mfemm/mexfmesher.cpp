@@ -36,13 +36,14 @@ int nrhs, const mxArray *prhs[])
     int status,tristatus;
     bool hasperiodic;
     double verbose = 0.0;
+    bool enforcepslg = false;
 
     //(void) plhs;    /* unused parameters */
 
     /* Check for proper number of input and output arguments */
-    if ((nrhs > 2) | (nrhs < 1)) {
+    if ((nrhs > 3) | (nrhs < 1)) {
         mexErrMsgIdAndTxt("MFEMM:fmesher:numargs",
-                          "One or two input arguments required.");
+                          "One to three input arguments required.");
     }
 
     if (nlhs > 1) {
@@ -57,7 +58,7 @@ int nrhs, const mxArray *prhs[])
                           "Input argument must be a string.");
     }
 
-    if (nrhs == 2)
+    if (nrhs >= 2)
     {
         /*  get the dimensions of the matrix input x */
         size_t rows = mxGetM(prhs[1]);
@@ -76,6 +77,17 @@ int nrhs, const mxArray *prhs[])
        verbose = 0.0;
     }
 
+    if (nrhs == 3)
+    {
+        if ((!mxIsNumeric(prhs[2]) && !mxIsLogical(prhs[2])) || (mxGetM(prhs[2]) != 1) || (mxGetN(prhs[2]) != 1))
+        {
+            mexErrMsgIdAndTxt( "MFEMM:fmesher:inputnotscalar",
+                               "Third input must be a scalar.");
+        }
+
+        enforcepslg = (mxGetScalar(prhs[2]) != 0.0);
+    }
+
     if (verbose == 0.0)
     {
         MeshObj.Verbose = false;
@@ -165,6 +177,23 @@ int nrhs, const mxArray *prhs[])
         return;
     }
 
+    if (enforcepslg)
+    {
+        if (verbose != 0.0)
+        {
+            mexPrintf("Enforcing PSLG\n"); fflush(stdout);
+        }
+
+        // resolve intersections and coincident nodes in one pass, and write
+        // the result back, so that the solver sees the same geometry as the mesher
+        MeshObj.problem->enforcePSLG();
+        if (!MeshObj.problem->saveFEMFile(FilePath))
+        {
+            mexErrMsgIdAndTxt( "MFEMM:fmesher:badfile",
+                               "The input file %s could not be written.", FilePath.c_str ());
+        }
+    }
+
     hasperiodic = MeshObj.HasPeriodicBC();
     if (hasperiodic == true)
     {
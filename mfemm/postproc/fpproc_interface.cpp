@@ -182,12 +182,16 @@ int FPProc_interface::getpointvals(int nlhs, mxArray *plhs[], int nrhs, const mx
                            "x and y must both be column vectors.");
     }
 
-    if(myrows != myrows)
+    if(mxrows != myrows)
     {
         mexErrMsgIdAndTxt( "MFEMM:fpproc:invalidSizeInputs",
                            "x and y must be column vectors of the same size.");
     }
 
+    // evaluate all points at once
+    CMPointValsArray values;
+    theFPProc.GetPointValues((int)mxrows, px, py, values);
+
     if (theFPProc.Frequency!=0)
     {
 #ifdef _MEX_DEBUG
@@ -201,52 +205,50 @@ int FPProc_interface::getpointvals(int nlhs, mxArray *plhs[], int nrhs, const mx
 
         for(int i=0; i<(int)mxrows; i++)
         {
-            CMPointVals u;
-
-            if(theFPProc.GetPointValues(px[i], py[i], u)==true)
+            if(values.valid[i])
             {
                 // copy the point values to the matlab array at the
                 // appropriate locations
-                outpointerRe[(i*14)] = u.A.Re();
-                outpointerIm[(i*14)] = u.A.Im();
+                outpointerRe[(i*14)] = values.A[i].Re();
+                outpointerIm[(i*14)] = values.A[i].Im();
 
-                outpointerRe[(i*14)+1] = u.B1.Re();
-                outpointerIm[(i*14)+1] = u.B1.Im();
+                outpointerRe[(i*14)+1] = values.B1[i].Re();
+                outpointerIm[(i*14)+1] = values.B1[i].Im();
 
-                outpointerRe[(i*14)+2] = u.B2.Re();
-                outpointerIm[(i*14)+2] = u.B2.Im();
+                outpointerRe[(i*14)+2] = values.B2[i].Re();
+                outpointerIm[(i*14)+2] = values.B2[i].Im();
 
-                outpointerRe[(i*14)+3] = u.c;
+                outpointerRe[(i*14)+3] = values.c[i];
                 outpointerIm[(i*14)+3] = 0.0;
 
-                outpointerRe[(i*14)+4] = u.E;
+                outpointerRe[(i*14)+4] = values.E[i];
                 outpointerIm[(i*14)+4] = 0.0;
 
-                outpointerRe[(i*14)+5] = u.H1.Re();
-                outpointerIm[(i*14)+5] = u.H1.Im();
+                outpointerRe[(i*14)+5] = values.H1[i].Re();
+                outpointerIm[(i*14)+5] = values.H1[i].Im();
 
-                outpointerRe[(i*14)+6] = u.H2.Re();
-                outpointerIm[(i*14)+6] = u.H2.Im();
+                outpointerRe[(i*14)+6] = values.H2[i].Re();
+                outpointerIm[(i*14)+6] = values.H2[i].Im();
 
-                outpointerRe[(i*14)+7] = u.Je.Re();
-                outpointerIm[(i*14)+7] = u.Je.Im();
+                outpointerRe[(i*14)+7] = values.Je[i].Re();
+                outpointerIm[(i*14)+7] = values.Je[i].Im();
 
-                outpointerRe[(i*14)+8] = u.Js.Re();
-                outpointerIm[(i*14)+8] = u.Js.Im();
+                outpointerRe[(i*14)+8] = values.Js[i].Re();
+                outpointerIm[(i*14)+8] = values.Js[i].Im();
 
-                outpointerRe[(i*14)+9] = u.mu1.Re();
-                outpointerIm[(i*14)+9] = u.mu1.Im();
+                outpointerRe[(i*14)+9] = values.mu1[i].Re();
+                outpointerIm[(i*14)+9] = values.mu1[i].Im();
 
-                outpointerRe[(i*14)+10] = u.mu2.Re();
-                outpointerIm[(i*14)+10] = u.mu2.Im();
+                outpointerRe[(i*14)+10] = values.mu2[i].Re();
+                outpointerIm[(i*14)+10] = values.mu2[i].Im();
 
-                outpointerRe[(i*14)+11] = u.Pe;
+                outpointerRe[(i*14)+11] = values.Pe[i];
                 outpointerIm[(i*14)+11] = 0.0;
 
-                outpointerRe[(i*14)+12] = u.Ph;
+                outpointerRe[(i*14)+12] = values.Ph[i];
                 outpointerIm[(i*14)+12] = 0.0;
 
-                outpointerRe[(i*14)+13] = u.ff;
+                outpointerRe[(i*14)+13] = values.ff[i];
                 outpointerIm[(i*14)+13] = 0.0;
             }
             else
@@ -308,35 +310,33 @@ int FPProc_interface::getpointvals(int nlhs, mxArray *plhs[], int nrhs, const mx
 
         for(int i=0; i<(int)mxrows; i++)
         {
-            CMPointVals u;
-
-            if(theFPProc.GetPointValues(px[i], py[i], u)==true)
+            if(values.valid[i])
             {
                 // copy the point values to the matlab array at the
                 // appropriate locations
 #ifdef _MEX_DEBUG
-                mexPrintf("row %i, theFPProc.GetPointValues was true.\n", i);
+                mexPrintf("row %i, theFPProc.GetPointValues is inside the mesh.\n", i);
 #endif
-                outpointerRe[(i*14)] = u.A.Re();
-                outpointerRe[(i*14)+1] = u.B1.Re();
-                outpointerRe[(i*14)+2] = u.B2.Re();
-                outpointerRe[(i*14)+3] = u.c;
-                outpointerRe[(i*14)+4] = u.E;
-                outpointerRe[(i*14)+5] = u.H1.Re();
-                outpointerRe[(i*14)+6] = u.H2.Re();
-                outpointerRe[(i*14)+7] = u.Je.Re();
-                outpointerRe[(i*14)+8] = u.Js.Re();
-                outpointerRe[(i*14)+9] = u.mu1.Re();
-                outpointerRe[(i*14)+10] = u.mu2.Re();
-                outpointerRe[(i*14)+11] = u.Pe;
-                outpointerRe[(i*14)+12] = u.Ph;
-                outpointerRe[(i*14)+13] = u.ff;
+                outpointerRe[(i*14)] = values.A[i].Re();
+                outpointerRe[(i*14)+1] = values.B1[i].Re();
+                outpointerRe[(i*14)+2] = values.B2[i].Re();
+                outpointerRe[(i*14)+3] = values.c[i];
+                outpointerRe[(i*14)+4] = values.E[i];
+                outpointerRe[(i*14)+5] = values.H1[i].Re();
+                outpointerRe[(i*14)+6] = values.H2[i].Re();
+                outpointerRe[(i*14)+7] = values.Je[i].Re();
+                outpointerRe[(i*14)+8] = values.Js[i].Re();
+                outpointerRe[(i*14)+9] = values.mu1[i].Re();
+                outpointerRe[(i*14)+10] = values.mu2[i].Re();
+                outpointerRe[(i*14)+11] = values.Pe[i];
+                outpointerRe[(i*14)+12] = values.Ph[i];
+                outpointerRe[(i*14)+13] = values.ff[i];
             }
             else
             {
                 // we return nan values to alert the user
 #ifdef _MEX_DEBUG
-                mexPrintf("row %i, theFPProc.GetPointValues was false.\n", i);
+                mexPrintf("row %i, theFPProc.GetPointValues is outside of the mesh.\n", i);
 #endif
                 outpointerRe[(i*14)] = mxGetNaN();
                 outpointerRe[(i*14)+1] = mxGetNaN();
@@ -133,13 +133,16 @@ int HPProc_interface::getpointvals(int nlhs, mxArray *plhs[], int nrhs, const mx
                            "x and y must both be column vectors.");
     }
 
-    if(myrows != myrows)
+    if(mxrows != myrows)
     {
         mexErrMsgIdAndTxt( "MFEMM:hpproc:invalidSizeInputs",
                            "x and y must be column vectors of the same size.");
     }
 
-   
+    // evaluate all points at once
+    CHPointValsArray values;
+    theHPProc.getPointValues((int)mxrows, px, py, values);
+
 #ifdef _MEX_DEBUG
         mexPrintf("Frequency was zero.\n");
 #endif
@@ -150,22 +153,20 @@ int HPProc_interface::getpointvals(int nlhs, mxArray *plhs[], int nrhs, const mx
 
     for(int i=0; i<(int)mxrows; i++)
     {
-		 CHPointVals u;
-
-        if(theHPProc.getPointValues(px[i], py[i], u)==true)
+        if(values.valid[i])
         {
             // copy the point values to the matlab array at the
             // appropriate locations
 #ifdef _MEX_DEBUG
-            mexPrintf("row %i, theHPProc.GetPointValues was true.\n", i);
+            mexPrintf("row %i, theHPProc.GetPointValues is inside the mesh.\n", i);
 #endif
-            outpointerRe[(i*7)] = u.T;
-            outpointerRe[(i*7)+1] = u.F.Re();
-            outpointerRe[(i*7)+2] = u.F.Im();
-            outpointerRe[(i*7)+3] = u.G.Re();
-            outpointerRe[(i*7)+4] = u.G.Im();
-            outpointerRe[(i*7)+5] = u.K.Re();
-            outpointerRe[(i*7)+6] = u.K.Im();
+            outpointerRe[(i*7)] = values.T[i];
+            outpointerRe[(i*7)+1] = values.F[i].Re();
+            outpointerRe[(i*7)+2] = values.F[i].Im();
+            outpointerRe[(i*7)+3] = values.G[i].Re();
+            outpointerRe[(i*7)+4] = values.G[i].Im();
+            outpointerRe[(i*7)+5] = values.K[i].Re();
+            outpointerRe[(i*7)+6] = values.K[i].Im();
         }
         else
         {
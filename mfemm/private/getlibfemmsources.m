@@ -24,12 +24,18 @@ function libfemm_sources = getlibfemmsources ()
         'FemmStateBase.cpp', ...
         'femmversion.cpp', ...
         'fparse.cpp', ...
+        'GeometrySnapshot.cpp', ...
         'fullmatrix.cpp', ...
         'IntPoint.cpp', ...
         'LuaInstance.cpp', ...
+        'MemoryFiles.cpp', ...
         'PostProcessor.cpp', ...
+        'Profiler.cpp', ...
+        'SolutionFile.cpp', ...
+        'SpatialGrid.cpp', ...
         'spars.cpp', ...
-        'stringTools.cpp', ... 
+        'stringTools.cpp', ...
+        'threadTools.cpp', ... 
         };
 
 end
\ No newline at end of file